@@ -0,0 +1,273 @@
+#ifndef BFieldGeom_BFCompiledGrid_hh
+#define BFieldGeom_BFCompiledGrid_hh
+//
+// Precomputed interpolation coefficients for a BFGridMap, used by the compiled
+// interpolation styles.  The polynomial that the reference interpolation builds
+// from the grid values on every call is instead expanded once, per cell, into
+// monomial coefficients; a query then costs one cell lookup and a Horner
+// evaluation.  The results agree with the reference to round off.  The
+// derivatives of the same polynomials give the field gradient.
+//
+// Two expansions are supported:
+//   linear    - one cell per grid cube, 8 coefficients per component, in the
+//               fractional position (u,v,w) within the cube:
+//               1, u, v, w, uv, uw, vw, uvw.
+//   quadratic - one cell per grid point, the center of the 3x3x3 neighborhood used
+//               by the meco interpolation; 27 coefficients per component,
+//               u^a v^b w^c at index 9a+3b+c, with (u,v,w) measured from the
+//               center in units of the grid spacing.
+//
+// T is the storage precision of the coefficients.
+// Memory: 8 (linear) or 27 (quadratic) times the size of the grid values, in T.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include "BFieldGeom/inc/Container3D.hh"
+#include "CLHEP/Vector/ThreeVector.h"
+
+namespace mu2e {
+
+    template <typename T>
+    class BFCompiledGrid {
+       public:
+        enum Order { none, linear, quadratic };
+
+        BFCompiledGrid() : _order(none), _nx(0), _ny(0), _nz(0), _ncoef(0) {}
+
+        // Expand the trilinear interpolation of each grid cube.  Needs nx,ny,nz >= 2.
+        void compileLinear(Container3D<CLHEP::Hep3Vector> const& field,
+                           unsigned nx,
+                           unsigned ny,
+                           unsigned nz) {
+            init(linear, nx - 1, ny - 1, nz - 1, 8);
+            for (unsigned ix = 0; ix != _nx; ++ix) {
+                for (unsigned iy = 0; iy != _ny; ++iy) {
+                    for (unsigned iz = 0; iz != _nz; ++iz) {
+                        expandLinear(field, ix, iy, iz, &_coef[index(ix, iy, iz) * 3 * _ncoef]);
+                    }
+                }
+            }
+        }
+
+        // Expand the quadratic interpolation centered on each grid point that has
+        // all 27 neighbors defined.  Needs nx,ny,nz >= 3.
+        void compileQuadratic(Container3D<CLHEP::Hep3Vector> const& field,
+                              Container3D<bool> const& isDefined,
+                              unsigned nx,
+                              unsigned ny,
+                              unsigned nz) {
+            init(quadratic, nx, ny, nz, 27);
+            _ok.assign(std::size_t(nx) * ny * nz, 0);
+
+            for (unsigned ix = 1; ix + 1 < nx; ++ix) {
+                for (unsigned iy = 1; iy + 1 < ny; ++iy) {
+                    for (unsigned iz = 1; iz + 1 < nz; ++iz) {
+                        if (!neighborsDefined(isDefined, ix, iy, iz)) {
+                            continue;
+                        }
+                        _ok[index(ix, iy, iz)] = 1;
+                        expandQuadratic(field, ix, iy, iz, &_coef[index(ix, iy, iz) * 3 * _ncoef]);
+                    }
+                }
+            }
+        }
+
+        // The expansion of one cell, into c[3*8] (linear, the cube with lower corner
+        // ix,iy,iz) or c[3*27] (quadratic, centered on ix,iy,iz).  Also used to expand
+        // a single cell on the fly when there are no precomputed coefficients.
+        static void expandLinear(Container3D<CLHEP::Hep3Vector> const& field,
+                                 unsigned ix,
+                                 unsigned iy,
+                                 unsigned iz,
+                                 T* c) {
+            for (int k = 0; k != 3; ++k) {
+                auto f = [&](unsigned i, unsigned j, unsigned l) {
+                    return field(ix + i, iy + j, iz + l)[k];
+                };
+                const double c000 = f(0, 0, 0), c100 = f(1, 0, 0), c010 = f(0, 1, 0),
+                             c001 = f(0, 0, 1), c110 = f(1, 1, 0), c101 = f(1, 0, 1),
+                             c011 = f(0, 1, 1), c111 = f(1, 1, 1);
+                T* a = c + k * 8;
+                a[0] = c000;
+                a[1] = c100 - c000;
+                a[2] = c010 - c000;
+                a[3] = c001 - c000;
+                a[4] = c110 - c100 - c010 + c000;
+                a[5] = c101 - c100 - c001 + c000;
+                a[6] = c011 - c010 - c001 + c000;
+                a[7] = c111 - c110 - c101 - c011 + c100 + c010 + c001 - c000;
+            }
+        }
+
+        static void expandQuadratic(Container3D<CLHEP::Hep3Vector> const& field,
+                                    unsigned ix,
+                                    unsigned iy,
+                                    unsigned iz,
+                                    T* c) {
+            // Monomial coefficients of the Lagrange polynomials through -1, 0, 1:
+            // p(s) = sum over powers a and nodes i of m[a][i] f[i] s^a.
+            static const double m[3][3] = {{0., 1., 0.}, {-0.5, 0., 0.5}, {0.5, -1., 0.5}};
+
+            for (int k = 0; k != 3; ++k) {
+                // Transform one axis at a time: f[i][j][l] -> g[a][j][l] -> ...
+                double f[3][3][3], g[3][3][3], h[3][3][3];
+                for (int i = 0; i != 3; ++i) {
+                    for (int j = 0; j != 3; ++j) {
+                        for (int l = 0; l != 3; ++l) {
+                            f[i][j][l] = field(ix + i - 1, iy + j - 1, iz + l - 1)[k];
+                        }
+                    }
+                }
+                for (int a = 0; a != 3; ++a) {
+                    for (int j = 0; j != 3; ++j) {
+                        for (int l = 0; l != 3; ++l) {
+                            g[a][j][l] =
+                                m[a][0] * f[0][j][l] + m[a][1] * f[1][j][l] + m[a][2] * f[2][j][l];
+                        }
+                    }
+                }
+                for (int a = 0; a != 3; ++a) {
+                    for (int b = 0; b != 3; ++b) {
+                        for (int l = 0; l != 3; ++l) {
+                            h[a][b][l] =
+                                m[b][0] * g[a][0][l] + m[b][1] * g[a][1][l] + m[b][2] * g[a][2][l];
+                        }
+                    }
+                }
+                T* a3 = c + k * 27;
+                for (int a = 0; a != 3; ++a) {
+                    for (int b = 0; b != 3; ++b) {
+                        for (int d = 0; d != 3; ++d) {
+                            a3[9 * a + 3 * b + d] = m[d][0] * h[a][b][0] + m[d][1] * h[a][b][1] +
+                                                    m[d][2] * h[a][b][2];
+                        }
+                    }
+                }
+            }
+        }
+
+        // True if the 27 grid points centered on ix,iy,iz are all defined.
+        static bool neighborsDefined(Container3D<bool> const& isDefined,
+                                     unsigned ix,
+                                     unsigned iy,
+                                     unsigned iz) {
+            for (unsigned i = ix - 1; i != ix + 2; ++i) {
+                for (unsigned j = iy - 1; j != iy + 2; ++j) {
+                    for (unsigned l = iz - 1; l != iz + 2; ++l) {
+                        if (!isDefined(i, j, l)) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        void clear() {
+            _order = none;
+            _nx = _ny = _nz = 0;
+            _ncoef = 0;
+            std::vector<T>().swap(_coef);
+            std::vector<unsigned char>().swap(_ok);
+        }
+
+        bool empty() const { return _order == none; }
+        Order order() const { return _order; }
+
+        // Coefficients of one cell: component x, then y, then z.
+        T const* cell(unsigned ix, unsigned iy, unsigned iz) const {
+            return &_coef[index(ix, iy, iz) * 3 * _ncoef];
+        }
+
+        // Quadratic only: true if the cell can be used, i.e. all 27 neighbors are defined.
+        bool ok(unsigned ix, unsigned iy, unsigned iz) const { return _ok[index(ix, iy, iz)]; }
+
+        std::size_t sizeInBytes() const { return _coef.size() * sizeof(T) + _ok.size(); }
+
+        // Evaluate the expansions of one cell.
+        static void evalLinear(T const* c, T u, T v, T w, double b[3]) {
+            for (int k = 0; k != 3; ++k) {
+                T const* a = c + 8 * k;
+                b[k] = a[0] + w * a[3] + v * (a[2] + w * a[6]) +
+                       u * (a[1] + w * a[5] + v * (a[4] + w * a[7]));
+            }
+        }
+
+        static void evalQuadratic(T const* c, T u, T v, T w, double b[3]) {
+            for (int k = 0; k != 3; ++k) {
+                T const* a = c + 27 * k;
+                T r[3];
+                for (int i = 0; i != 3; ++i) {
+                    T const* ai = a + 9 * i;
+                    const T q0 = ai[0] + w * (ai[1] + w * ai[2]);
+                    const T q1 = ai[3] + w * (ai[4] + w * ai[5]);
+                    const T q2 = ai[6] + w * (ai[7] + w * ai[8]);
+                    r[i] = q0 + v * (q1 + v * q2);
+                }
+                b[k] = r[0] + u * (r[1] + u * r[2]);
+            }
+        }
+
+        // The same, and the derivatives g[j][k] = dB_k/du_j, where u_j is u, v or w;
+        // the derivatives of the interpolating polynomial, not finite differences.
+        static void evalLinearGrad(T const* c, T u, T v, T w, double b[3], double g[3][3]) {
+            for (int k = 0; k != 3; ++k) {
+                T const* a = c + 8 * k;
+                b[k] = a[0] + w * a[3] + v * (a[2] + w * a[6]) +
+                       u * (a[1] + w * a[5] + v * (a[4] + w * a[7]));
+                g[0][k] = a[1] + w * a[5] + v * (a[4] + w * a[7]);
+                g[1][k] = a[2] + w * a[6] + u * (a[4] + w * a[7]);
+                g[2][k] = a[3] + v * a[6] + u * (a[5] + v * a[7]);
+            }
+        }
+
+        static void evalQuadraticGrad(T const* c, T u, T v, T w, double b[3], double g[3][3]) {
+            for (int k = 0; k != 3; ++k) {
+                T const* a = c + 27 * k;
+                T r[3], rv[3], rw[3];
+                for (int i = 0; i != 3; ++i) {
+                    T const* ai = a + 9 * i;
+                    const T q0 = ai[0] + w * (ai[1] + w * ai[2]);
+                    const T q1 = ai[3] + w * (ai[4] + w * ai[5]);
+                    const T q2 = ai[6] + w * (ai[7] + w * ai[8]);
+                    const T dq0 = ai[1] + 2 * w * ai[2];
+                    const T dq1 = ai[4] + 2 * w * ai[5];
+                    const T dq2 = ai[7] + 2 * w * ai[8];
+                    r[i] = q0 + v * (q1 + v * q2);
+                    rv[i] = q1 + 2 * v * q2;
+                    rw[i] = dq0 + v * (dq1 + v * dq2);
+                }
+                b[k] = r[0] + u * (r[1] + u * r[2]);
+                g[0][k] = r[1] + 2 * u * r[2];
+                g[1][k] = rv[0] + u * (rv[1] + u * rv[2]);
+                g[2][k] = rw[0] + u * (rw[1] + u * rw[2]);
+            }
+        }
+
+       private:
+        Order _order;
+        unsigned _nx, _ny, _nz;  // number of cells
+        int _ncoef;              // coefficients per component per cell
+        std::vector<T> _coef;
+        std::vector<unsigned char> _ok;
+
+        void init(Order order, unsigned nx, unsigned ny, unsigned nz, int ncoef) {
+            clear();
+            _order = order;
+            _nx = nx;
+            _ny = ny;
+            _nz = nz;
+            _ncoef = ncoef;
+            _coef.assign(std::size_t(nx) * ny * nz * 3 * ncoef, T(0));
+        }
+
+        std::size_t index(unsigned ix, unsigned iy, unsigned iz) const {
+            return (std::size_t(ix) * _ny + iy) * _nz + iz;
+        }
+    };
+
+}  // namespace mu2e
+
+#endif /* BFieldGeom_BFCompiledGrid_hh */
@@ -12,18 +12,26 @@
 //
 
 //#include <iosfwd>
+#include <cstddef>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
+#include "BFieldGeom/inc/BFCompiledGrid.hh"
+#include "BFieldGeom/inc/BFGridSoA.hh"
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
 #include "BFieldGeom/inc/BFMap.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/BFMapType.hh"
 #include "BFieldGeom/inc/Container3D.hh"
 #include "CLHEP/Vector/ThreeVector.h"
+#include "DataProducts/inc/XYZVec.hh"
 
 namespace mu2e {
     class BFGridMap : public BFMap {
        public:
         friend class BFieldManagerMaker;
+        friend class BFMapFile;
 
         struct GridPoint {
             unsigned ix;
@@ -62,6 +70,9 @@ namespace mu2e {
               _dx(dx),
               _dy(dy),
               _dz(dz),
+              _invdx(1. / dx),
+              _invdy(1. / dy),
+              _invdz(1. / dz),
               _field(_nx, _ny, _nz),
               _isDefined(_nx, _ny, _nz, false),
               _allDefined(false),
@@ -71,6 +82,58 @@ namespace mu2e {
 
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
 
+        // The field and the derivatives of the interpolating polynomial, from one lookup.
+        // The field agrees with getBFieldWithStatus to round off; uses the precomputed
+        // coefficients of the compiled styles if there are any, else expands the cell
+        // on the fly.  For the trilinear styles, a point in the last layer of cells is
+        // extrapolated from the last cell, as in the compiled style.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector dBdx[3]) const;
+
+        // Batch evaluation of the field at n points, in the same coordinate system as the
+        // per-point interface.  Points where the interpolation is not defined get a zero
+        // field and, if status is non-null, status[i] is set to false.  Uses the component
+        // separated copy of the grid made by fillSoA; without one, falls back to the
+        // per-point code.
+        void getBField(XYZVec const* points,
+                       XYZVec* fields,
+                       std::size_t n,
+                       bool* status = 0) const;
+        void getBField(std::vector<XYZVec> const& points, std::vector<XYZVec>& fields) const;
+
+        // Make the component separated grid used by the batch interface.
+        // Must be called after the map is filled and after any modification of it.
+        // If the map was loaded from a memory mapped file that holds the grid in the
+        // requested precision, and it has not been modified since, that is used in place.
+        // Otherwise a copy of the grid is made only if makeCopy is true.
+        void fillSoA(bool useFloat, bool makeCopy = true);
+
+        // Precompute the interpolation coefficients used by the compiled interpolation
+        // styles, in float or double.  Does nothing for the other styles.  Until this
+        // is called, the compiled styles use the reference interpolation.  Must be
+        // called after the map is filled and after any modification of it.
+        void compile(bool useFloat);
+
+        // Memory used by the precomputed coefficients, in bytes.
+        std::size_t compiledSizeInBytes() const {
+            return _compiledFloat.sizeInBytes() + _compiledDouble.sizeInBytes();
+        }
+
+        BFInterpolationStyle interpolationStyle() const { return _interpStyle; }
+
+        // Change the interpolation style, for example to compare two styles on copies
+        // of one map.  Discards the precomputed coefficients.
+        void setInterpolationStyle(BFInterpolationStyle style);
+
+        // True if the field values are used in place from a memory mapped file.
+        bool isMapped() const { return _field.isView(); }
+
+        // Memory owned by the component separated copy, in bytes.
+        std::size_t soaSizeInBytes() const {
+            return _soaFloat.sizeInBytes() + _soaDouble.sizeInBytes();
+        }
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const;
         bool isValid(const GridPoint& ipoint) const {
@@ -110,6 +173,7 @@ namespace mu2e {
 
         // Distance between points.
         double _dx, _dy, _dz;
+        double _invdx, _invdy, _invdz;
 
         // Vector arrays for gridpoints and field values
         mu2e::Container3D<CLHEP::Hep3Vector> _field;
@@ -125,6 +189,21 @@ namespace mu2e {
         // yet to be defined.
         BFInterpolationStyle _interpStyle;
 
+        // Component separated copies of _field for the batch interface; at most one is filled.
+        BFGridSoA<float> _soaFloat;
+        BFGridSoA<double> _soaDouble;
+
+        // Precomputed coefficients for the compiled styles; at most one is filled.
+        BFCompiledGrid<float> _compiledFloat;
+        BFCompiledGrid<double> _compiledDouble;
+
+        // The memory mapped file the map was loaded from, if any; _field and the
+        // batch grid may point into it.
+        std::shared_ptr<const BFMapFile> _mapFile;
+
+        // Use the contents of a memory mapped file in place.
+        void attach(std::shared_ptr<const BFMapFile> file);
+
         // Functions used internally and by the code that populates the maps.
 
         // method to store the neighbors
@@ -146,6 +225,36 @@ namespace mu2e {
 
         bool interpolateTriLinear(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
         bool interpolateQuadratic(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+
+        // True for the styles that use the 3x3x3 neighborhood.
+        bool isQuadratic() const {
+            return _interpStyle == BFInterpolationStyle::meco ||
+                   _interpStyle == BFInterpolationStyle::mecoCompiled;
+        }
+
+        // The compiled styles, one instance for each storage precision.
+        template <typename T>
+        bool interpolateTriLinearCompiled(BFCompiledGrid<T> const& grid,
+                                          const CLHEP::Hep3Vector&,
+                                          CLHEP::Hep3Vector&) const;
+        template <typename T>
+        bool interpolateQuadraticCompiled(BFCompiledGrid<T> const& grid,
+                                          const CLHEP::Hep3Vector&,
+                                          CLHEP::Hep3Vector&) const;
+
+        // Batch kernels, one instance for each storage precision.
+        template <typename T>
+        void batchTriLinear(BFGridSoA<T> const& grid,
+                            XYZVec const* points,
+                            XYZVec* fields,
+                            std::size_t n,
+                            bool* status) const;
+        template <typename T>
+        void batchQuadratic(BFGridSoA<T> const& grid,
+                            XYZVec const* points,
+                            XYZVec* fields,
+                            std::size_t n,
+                            bool* status) const;
     };
 
     inline BFGridMap::GridPoint BFGridMap::point2grid(const CLHEP::Hep3Vector& pos) const {
@@ -0,0 +1,171 @@
+#ifndef BFieldGeom_BFGridSoA_hh
+#define BFieldGeom_BFGridSoA_hh
+//
+// Component-separated (structure of arrays) copy of the field values of a BFGridMap,
+// used by the batch interpolation kernels.  Each field component is stored in its own
+// contiguous array, in the same x-major order as Container3D, so that the kernels can
+// process many points at a time with arithmetic the compiler can vectorize.
+//
+// T is the storage precision: float halves the memory and doubles the SIMD width;
+// double reproduces the per-point interpolation to round off.
+//
+// The arrays are either owned, when made by fill, or live in external storage,
+// such as a memory mapped field map file, when made by view.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include "BFieldGeom/inc/Container3D.hh"
+#include "CLHEP/Vector/ThreeVector.h"
+
+namespace mu2e {
+
+    template <typename T>
+    class BFGridSoA {
+       public:
+        BFGridSoA() : _nx(0), _ny(0), _nz(0), _pb{0, 0, 0}, _pquadOK(0) {}
+
+        BFGridSoA(BFGridSoA const& rhs) { *this = rhs; }
+
+        BFGridSoA& operator=(BFGridSoA const& rhs) {
+            if (this != &rhs) {
+                _nx = rhs._nx;
+                _ny = rhs._ny;
+                _nz = rhs._nz;
+                for (int c = 0; c != 3; ++c) {
+                    _b[c] = rhs._b[c];
+                }
+                _quadOK = rhs._quadOK;
+                if (rhs.isView()) {
+                    for (int c = 0; c != 3; ++c) {
+                        _pb[c] = rhs._pb[c];
+                    }
+                    _pquadOK = rhs._pquadOK;
+                } else {
+                    point();
+                }
+            }
+            return *this;
+        }
+
+        // Copy the field values from the AoS grid.  A grid point is usable as the
+        // center of the 3x3x3 quadratic interpolation if all 27 of its neighbors
+        // are defined; precompute this once so the kernels need not look at isDefined.
+        void fill(Container3D<CLHEP::Hep3Vector> const& field,
+                  Container3D<bool> const& isDefined,
+                  unsigned nx,
+                  unsigned ny,
+                  unsigned nz) {
+            _nx = nx;
+            _ny = ny;
+            _nz = nz;
+            const std::size_t n = std::size_t(nx) * ny * nz;
+            for (int c = 0; c != 3; ++c) {
+                _b[c].assign(n, T(0));
+            }
+            _quadOK.assign(n, 0);
+
+            for (unsigned ix = 0; ix != nx; ++ix) {
+                for (unsigned iy = 0; iy != ny; ++iy) {
+                    for (unsigned iz = 0; iz != nz; ++iz) {
+                        const std::size_t i = index(ix, iy, iz);
+                        CLHEP::Hep3Vector const& b = field(ix, iy, iz);
+                        _b[0][i] = b.x();
+                        _b[1][i] = b.y();
+                        _b[2][i] = b.z();
+                    }
+                }
+            }
+
+            for (unsigned ix = 1; ix + 1 < nx; ++ix) {
+                for (unsigned iy = 1; iy + 1 < ny; ++iy) {
+                    for (unsigned iz = 1; iz + 1 < nz; ++iz) {
+                        bool ok(true);
+                        for (unsigned i = ix - 1; ok && i != ix + 2; ++i) {
+                            for (unsigned j = iy - 1; ok && j != iy + 2; ++j) {
+                                for (unsigned k = iz - 1; ok && k != iz + 2; ++k) {
+                                    ok = isDefined(i, j, k);
+                                }
+                            }
+                        }
+                        _quadOK[index(ix, iy, iz)] = ok;
+                    }
+                }
+            }
+            point();
+        }
+
+        // Use arrays owned by someone else, laid out as fill would make them.
+        // The caller must keep them alive for as long as this object is used.
+        void view(T const* bx,
+                  T const* by,
+                  T const* bz,
+                  unsigned char const* quadOK,
+                  unsigned nx,
+                  unsigned ny,
+                  unsigned nz) {
+            clear();
+            _nx = nx;
+            _ny = ny;
+            _nz = nz;
+            _pb[0] = bx;
+            _pb[1] = by;
+            _pb[2] = bz;
+            _pquadOK = quadOK;
+        }
+
+        bool isView() const { return _pb[0] != 0 && _pb[0] != _b[0].data(); }
+
+        void clear() {
+            _nx = _ny = _nz = 0;
+            for (int c = 0; c != 3; ++c) {
+                std::vector<T>().swap(_b[c]);
+            }
+            std::vector<unsigned char>().swap(_quadOK);
+            point();
+        }
+
+        bool empty() const { return _pb[0] == 0; }
+
+        // Component c = 0, 1, 2 for x, y, z.
+        T const* component(int c) const { return _pb[c]; }
+
+        // Non-zero if the grid point can be used as the center of a quadratic interpolation.
+        unsigned char const* quadOK() const { return _pquadOK; }
+
+        // Number of grid points.
+        std::size_t size() const { return std::size_t(_nx) * _ny * _nz; }
+
+        std::size_t strideX() const { return std::size_t(_ny) * _nz; }
+        std::size_t strideY() const { return _nz; }
+
+        std::size_t index(unsigned ix, unsigned iy, unsigned iz) const {
+            return ix * strideX() + iy * strideY() + iz;
+        }
+
+        // Memory owned by this object, in bytes; zero for a view.
+        std::size_t sizeInBytes() const {
+            return 3 * _b[0].size() * sizeof(T) + _quadOK.size();
+        }
+
+       private:
+        unsigned _nx, _ny, _nz;
+        std::vector<T> _b[3];
+        std::vector<unsigned char> _quadOK;
+
+        // What the kernels read: the owned arrays or the external ones.
+        T const* _pb[3];
+        unsigned char const* _pquadOK;
+
+        void point() {
+            for (int c = 0; c != 3; ++c) {
+                _pb[c] = _b[c].empty() ? 0 : _b[c].data();
+            }
+            _pquadOK = _quadOK.empty() ? 0 : _quadOK.data();
+        }
+    };
+
+}  // namespace mu2e
+
+#endif /* BFieldGeom_BFGridSoA_hh */
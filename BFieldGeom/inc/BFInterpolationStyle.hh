@@ -14,7 +14,9 @@ namespace mu2e {
 
     class BFInterpolationStyleDetail {
        public:
-        enum enum_type { unknown, meco, trilinear, fit };
+        // The compiled styles give the same results as meco and trilinear, from
+        // precomputed per-cell coefficients; see BFCompiledGrid.
+        enum enum_type { unknown, meco, trilinear, fit, mecoCompiled, trilinearCompiled };
 
         static std::string const& typeName();
 
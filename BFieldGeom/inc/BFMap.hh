@@ -50,6 +50,14 @@ namespace mu2e {
         // Accessors
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const = 0;
 
+        // The field and its derivatives at a point: dBdx[j] is the derivative of the
+        // field along axis j (x, y, z), in tesla/mm.  The default is a central difference
+        // with a 1 mm step, one sided near the edges of the map; grid maps override it
+        // with the derivatives of the interpolating polynomial.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector&,
+                                           CLHEP::Hep3Vector dBdx[3]) const;
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const = 0;
 
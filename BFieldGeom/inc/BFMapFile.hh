@@ -0,0 +1,138 @@
+#ifndef BFieldGeom_BFMapFile_hh
+#define BFieldGeom_BFMapFile_hh
+//
+// Self-describing binary format for grid magnetic field maps, designed to be
+// memory mapped and used in place.
+//
+// The file starts with a fixed size header, BFMapFileHeader, that holds the grid
+// geometry, the map type, a scale factor for the stored values, symmetry flags,
+// the location of each section and checksums.  The sections that follow start on
+// page boundaries:
+//
+//   field    - nx*ny*nz*3 doubles, (Bx,By,Bz) at each grid point, in the x-major
+//              order of Container3D.  This is the image of BFGridMap::_field.
+//   defined  - nx*ny*nz bytes, non-zero where the grid point is defined.
+//              Absent if all points are defined.
+//   batch    - optional: the component separated grid used by the batch interface,
+//              three arrays of nx*ny*nz floats or doubles followed by the
+//              nx*ny*nz quadratic interpolation flags; see BFGridSoA.
+//
+// Files are opened read only and shared, so that all processes on a node that
+// use the same map share one copy of it in the page cache.
+//
+// The format is native endian; the endian marker in the header catches a mismatch.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mu2e {
+
+    class BFGridMap;
+
+    struct BFMapFileHeader {
+        // Bits in flags.
+        enum {
+            flipy = 0x1,       // field is reflected about y=0: see BFGridMap::_flipy
+            allDefined = 0x2,  // every grid point is defined; no defined section
+            batchFloat = 0x4,  // the batch section is present and stored as float
+            batchDouble = 0x8  // the batch section is present and stored as double
+        };
+
+        char magic[8];  // "MU2EBFM"
+        uint32_t version;
+        uint32_t endian;      // 0xDEADBEEF
+        uint32_t headerSize;  // sizeof(BFMapFileHeader)
+        uint32_t mapType;     // BFMapType::enum_type
+        int32_t nx, ny, nz;
+        uint32_t flags;
+        double xmin, ymin, zmin;
+        double dx, dy, dz;
+        double scale;  // multiplies the stored field values
+
+        // Byte offsets of the sections from the start of the file; zero if absent.
+        uint64_t fieldOffset;
+        uint64_t definedOffset;
+        uint64_t batchOffset[4];  // Bx, By, Bz, quadratic interpolation flags
+
+        uint64_t fileSize;
+
+        // Checksum of everything after the header page.
+        uint64_t payloadChecksum;
+
+        // Provenance: the key of the map and a note on where it came from.
+        char key[128];
+        char source[256];
+
+        // Checksum of all of the above; must be the last member.
+        uint64_t headerChecksum;
+    };
+
+    class BFMapFile {
+       public:
+        static constexpr uint32_t currentVersion = 1;
+        static constexpr std::size_t pageSize = 4096;
+
+        // Map the file into memory and check the header.  If verifyPayload is true,
+        // also check the checksum of the payload, which reads the whole file; this is
+        // meant for validating files, not for every job.
+        // Throws cet::exception on any error.
+        explicit BFMapFile(std::string const& filename, bool verifyPayload = false);
+        ~BFMapFile();
+
+        BFMapFile(BFMapFile const&) = delete;
+        BFMapFile& operator=(BFMapFile const&) = delete;
+
+        BFMapFileHeader const& header() const { return *_header; }
+        std::string const& filename() const { return _filename; }
+
+        bool flag(uint32_t f) const { return (_header->flags & f) != 0; }
+
+        std::size_t nPoints() const {
+            return std::size_t(_header->nx) * _header->ny * _header->nz;
+        }
+
+        // The sections; 0 if absent.
+        double const* field() const { return section<double>(_header->fieldOffset); }
+        unsigned char const* defined() const {
+            return section<unsigned char>(_header->definedOffset);
+        }
+        template <typename T>
+        T const* batch(int c) const {
+            return section<T>(_header->batchOffset[c]);
+        }
+        unsigned char const* batchQuadOK() const {
+            return section<unsigned char>(_header->batchOffset[3]);
+        }
+
+        // Write a map in this format.  If batchFloat or batchDouble is true, also
+        // store the component separated grid of that precision.  Refuses to
+        // overwrite an existing file.
+        static void write(BFGridMap const& map,
+                          std::string const& filename,
+                          std::string const& source,
+                          bool batchFloat,
+                          bool batchDouble);
+
+        // The checksum used in the header: fast, not cryptographic.
+        static uint64_t checksum(void const* data, std::size_t nbytes);
+
+       private:
+        std::string _filename;
+        void* _addr;
+        std::size_t _size;
+        BFMapFileHeader const* _header;
+
+        template <typename T>
+        T const* section(uint64_t offset) const {
+            return offset ? reinterpret_cast<T const*>(static_cast<char const*>(_addr) + offset)
+                          : 0;
+        }
+
+        void check(bool verifyPayload) const;
+    };
+
+}  // namespace mu2e
+
+#endif /* BFieldGeom_BFMapFile_hh */
@@ -0,0 +1,110 @@
+#ifndef BFieldGeom_BFMapIndex_hh
+#define BFieldGeom_BFMapIndex_hh
+//
+// Flat spatial index over the inner and outer magnetic field maps.
+//
+// There are two classes of magnetic field maps in Mu2e: "Inner" and "Outer" maps.
+// No overlaps are allowed among any of the maps in the "Inner" set.
+// The maps in the "Outer" set may overlap with the "Inner" maps, and among themselves.
+// If a space point belongs to an "Inner" map, that map will be used to
+// compute the field value.   If a point is outside of the "Inner" map set,
+// then the "Outer" map list will be consulted in order, and the first map
+// that contains the point will be used.
+//
+// The bounding box of all maps is divided into a uniform grid of cells.  Each cell
+// holds the short list of maps whose bounding box touches the cell: inner maps first,
+// then outer maps in the user-specified order.  A lookup computes the cell and checks
+// only those candidates.  The index is immutable once built, so a single instance
+// can be shared by any number of threads.
+//
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include "BFieldGeom/inc/BFMap.hh"
+
+namespace mu2e {
+
+    class BFMapIndex {
+       public:
+        typedef std::vector<std::shared_ptr<BFMap>> MapContainerType;
+
+        BFMapIndex(const MapContainerType& innerMaps,
+                   const MapContainerType& outerMaps,
+                   unsigned maxCellsPerAxis = 64);
+
+        // Returns the map to be used at the point x, or 0 if no map contains it.
+        // On return, inner is true if the returned map is one of the inner maps.
+        const BFMap* findMap(const CLHEP::Hep3Vector& x, bool& inner) const {
+            inner = false;
+            const Cell* c = cell(x);
+            if (!c) {
+                return 0;
+            }
+            for (unsigned i = c->begin; i != c->end; ++i) {
+                if (candidates_[i]->isValid(x)) {
+                    inner = (i < c->innerEnd);
+                    return candidates_[i];
+                }
+            }
+            return 0;
+        }
+
+        const BFMap* findMap(const CLHEP::Hep3Vector& x) const {
+            bool inner;
+            return findMap(x, inner);
+        }
+
+        unsigned nx() const { return nx_; }
+        unsigned ny() const { return ny_; }
+        unsigned nz() const { return nz_; }
+
+        void print(std::ostream& os) const;
+
+       private:
+        // Candidate maps for one cell are candidates_[begin, end);
+        // the inner maps are candidates_[begin, innerEnd).
+        struct Cell {
+            unsigned begin;
+            unsigned innerEnd;
+            unsigned end;
+        };
+
+        // Keep the maps alive for as long as the index is.
+        std::vector<std::shared_ptr<const BFMap>> maps_;
+
+        // Bounding box of all maps and the cell grid that covers it.
+        double xmin_, ymin_, zmin_;
+        double xmax_, ymax_, zmax_;
+        double invdx_, invdy_, invdz_;
+        unsigned nx_, ny_, nz_;
+
+        std::vector<Cell> cells_;
+        std::vector<const BFMap*> candidates_;
+
+        const Cell* cell(const CLHEP::Hep3Vector& x) const {
+            if (cells_.empty()) {
+                return 0;
+            }
+            // Written so that NaN coordinates fall through to the "outside" branch.
+            const double fx = (x.x() - xmin_) * invdx_;
+            const double fy = (x.y() - ymin_) * invdy_;
+            const double fz = (x.z() - zmin_) * invdz_;
+            if (!(fx >= 0. && fx <= nx_ && fy >= 0. && fy <= ny_ && fz >= 0. && fz <= nz_)) {
+                return 0;
+            }
+            // Points exactly on the upper edge of the box belong to the last cell.
+            const unsigned ix = std::min(static_cast<unsigned>(fx), nx_ - 1);
+            const unsigned iy = std::min(static_cast<unsigned>(fy), ny_ - 1);
+            const unsigned iz = std::min(static_cast<unsigned>(fz), nz_ - 1);
+            return &cells_[(ix * ny_ + iy) * nz_ + iz];
+        }
+    };
+
+}  // namespace mu2e
+
+#endif /* BFieldGeom_BFMapIndex_hh */
@@ -58,8 +58,6 @@ namespace mu2e {
         vector<vector<double> > _Bs;
         vector<double> _Ds;
         vector<vector<double> > _kms;
-        mutable vector<vector<double> > _iv;
-        mutable vector<vector<double> > _ivp;
 
         // pre calculate additional constants needed for eval
         void calcConstants();
@@ -67,9 +67,34 @@ namespace mu2e {
 
         bool flipBFieldMaps() const { return flipBFieldMaps_; }
 
+        // Make a copy of each grid map for the batch field interface.  Without it, the
+        // batch interface only uses the grids stored in memory mapped files.
+        bool batchGrid() const { return batchGrid_; }
+
+        // Storage precision of the grid copy used by the batch field interface.
+        bool batchFloat() const { return batchFloat_; }
+
+        // Write each grid map in the memory mapped format, as <key>.bfmap.
+        bool writeMappedMaps() const { return writeMappedMaps_; }
+
+        // Check the payload checksum of memory mapped maps when loading them (reads the
+        // whole file; the header checksum is always checked).
+        bool verifyMapChecksum() const { return verifyMapChecksum_; }
+
+        // Storage precision of the coefficients of the compiled interpolation styles.
+        bool compiledFloat() const { return compiledFloat_; }
+
        private:
         BFieldConfig()
-            : scaleFactor_(1.), writeBinaries_(false), verbosityLevel_(1), flipBFieldMaps_(false) {}
+            : scaleFactor_(1.),
+              writeBinaries_(false),
+              verbosityLevel_(1),
+              flipBFieldMaps_(false),
+              batchGrid_(false),
+              batchFloat_(false),
+              writeMappedMaps_(false),
+              verifyMapChecksum_(false),
+              compiledFloat_(false) {}
 
         // GMC, G4BL or possible future types.
         BFMapType mapType_;
@@ -97,6 +122,11 @@ namespace mu2e {
         bool writeBinaries_;
         int verbosityLevel_;
         bool flipBFieldMaps_;
+        bool batchGrid_;
+        bool batchFloat_;
+        bool writeMappedMaps_;
+        bool verifyMapChecksum_;
+        bool compiledFloat_;
     };
 
 }  // namespace mu2e
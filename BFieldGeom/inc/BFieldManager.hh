@@ -13,14 +13,17 @@
 //
 
 // C++ includes
+#include <cstddef>
 #include <set>
 #include <string>
+#include <vector>
 
 // Includes from Mu2e
 #include "BFieldGeom/inc/BFCacheManager.hh"
 #include "BFieldGeom/inc/BFGridMap.hh"
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
 #include "BFieldGeom/inc/BFMap.hh"
+#include "BFieldGeom/inc/BFMapIndex.hh"
 #include "BFieldGeom/inc/BFMapType.hh"
 #include "BFieldGeom/inc/BFParamMap.hh"
 #include "DataProducts/inc/XYZVec.hh"
@@ -39,11 +42,25 @@ namespace mu2e {
         typedef std::vector<std::shared_ptr<BFMap>> MapContainerType;
 
         // Get field at an arbitrary point.
+        // The first form does not use any cache and is safe to call from any thread.
+        // The second form uses the lookup hint in the cache manager; each thread,
+        // or each fit, should own its own cache manager, see cacheManager().
         bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
         bool getBFieldWithStatus(const CLHEP::Hep3Vector&,
                                  BFCacheManager const&,
                                  CLHEP::Hep3Vector&) const;
 
+        // The field and its derivatives, dBdx[j] = dB/dx_j in tesla/mm, from one map lookup.
+        // Grid maps return the derivatives of the interpolating polynomial.  Outside of
+        // all maps the field and the derivatives are zero.  Same cache rules as above.
+        bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector dBdx[3]) const;
+        bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                   BFCacheManager const&,
+                                   CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector dBdx[3]) const;
+
         // Just return zero for out of range.
         CLHEP::Hep3Vector getBField(const CLHEP::Hep3Vector& pos) const {
             // Default c'tor sets all components to zero - which is what we need here.
@@ -71,7 +88,21 @@ namespace mu2e {
           return result;
         }
 
-        BFCacheManager cacheManager() const { return cm_; }
+        // Batch evaluation of the field at n points.  Runs of consecutive points that use
+        // the same grid map are evaluated by one call to BFGridMap::getBField, so callers
+        // get the most out of it when nearby points are adjacent in the input.  Points
+        // outside of all maps get a zero field.
+        void getBField(XYZVec const* points,
+                       XYZVec* fields,
+                       std::size_t n,
+                       BFCacheManager const& cmgr) const;
+        void getBField(std::vector<XYZVec> const& points, std::vector<XYZVec>& fields) const;
+
+        // A new cache manager, with its own lookup hint.
+        BFCacheManager cacheManager() const { return BFCacheManager(index_); }
+
+        // The spatial index used to select the map for a point.
+        const BFMapIndex& mapIndex() const { return *index_; }
 
         const MapContainerType& getInnerMaps() const { return innerMaps_; }
         MapContainerType& getInnerMaps() { return innerMaps_; }
@@ -126,8 +157,8 @@ namespace mu2e {
                                                   BFMapType::enum_type type,
                                                   double scaleFactor);
 
-        // Handles caching and overlap resolution logic
-        BFCacheManager cm_;
+        // Handles overlap resolution logic; built by BFieldManagerMaker once all maps are added.
+        std::shared_ptr<const BFMapIndex> index_;
 
     };  // end class BFieldManager
 
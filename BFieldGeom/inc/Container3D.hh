@@ -24,7 +24,8 @@ namespace mu2e {
       _nx(0u),
       _ny(0u),
       _nz(0u),
-      _vec(){
+      _vec(),
+      _data(0){
     }
 
     // Normal constructor.
@@ -32,44 +33,82 @@ namespace mu2e {
       _nx(nx),
       _ny(ny),
       _nz(nz),
-      _vec(_nx*_ny*_nz,OBJ()){
+      _vec(_nx*_ny*_nz,OBJ()),
+      _data(_vec.data()){
     }
 
-    // Use compiler-generated copy c'tor, copy assignment, and d'tor
+    // A copy of a view is a view of the same storage.
+    Container3D( Container3D const& rhs ):
+      _nx(rhs._nx),
+      _ny(rhs._ny),
+      _nz(rhs._nz),
+      _vec(rhs._vec),
+      _data(rhs.isView() ? rhs._data : _vec.data()){
+    }
+
+    Container3D& operator=( Container3D const& rhs ){
+      if ( this != &rhs ){
+        _nx   = rhs._nx;
+        _ny   = rhs._ny;
+        _nz   = rhs._nz;
+        _vec  = rhs._vec;
+        _data = rhs.isView() ? rhs._data : _vec.data();
+      }
+      return *this;
+    }
+
+    // Use compiler-generated d'tor
+
+    // Use external, read-only storage, for example a memory mapped file, instead
+    // of owning it.  The caller must keep the storage alive for as long as this
+    // object uses it.  The first modification makes a private copy.
+    void view( OBJ const* data, unsigned int nx, unsigned int ny, unsigned int nz){
+      _nx = nx;
+      _ny = ny;
+      _nz = nz;
+      std::vector<OBJ>().swap(_vec);
+      _data = data;
+    }
+
+    // True if the elements live in external storage.
+    bool isView() const { return _data != _vec.data(); }
 
     // Set element, without safety features.  Use if the caller has
     // already ensured the validity of the arguments.
     void set(unsigned int ix, unsigned int iy, unsigned int iz, OBJ const& obj ){
+      own();
       _vec[index(ix,iy,iz)] = obj;
     }
 
     // Get element, without safety features. Use if the caller has
     // already ensured the validity of the arguments.
     OBJ const& get( unsigned int ix, unsigned int iy, unsigned int iz) const {
-      return _vec[index(ix,iy,iz)];
+      return _data[index(ix,iy,iz)];
     }
 
     // Get element, without safety features. Use if the caller has
     // already ensured the validity of the arguments.
     OBJ& get( unsigned int ix, unsigned int iy, unsigned int iz){
+      own();
       return _vec[index(ix,iy,iz)];
     }
 
     // Synonym for get, without safety features.
     OBJ const& operator()( unsigned int ix, unsigned int iy, unsigned int iz) const {
-      return _vec[index(ix,iy,iz)];
+      return _data[index(ix,iy,iz)];
     }
 
     // Set, with safety features.
     void setSafe(unsigned int ix, unsigned int iy, unsigned int iz, OBJ const& obj ){
       isValidOrThrow(ix,iy,iz);
+      own();
       _vec.at(index(ix,iy,iz)) = obj;
     }
 
     // Get, with safety features.
     OBJ const& getSafe( unsigned int ix, unsigned int iy, unsigned int iz) const {
       isValidOrThrow(ix,iy,iz);
-      return _vec.at(index(ix,iy,iz));
+      return _data[index(ix,iy,iz)];
     }
 
     // Check for a valid index
@@ -100,6 +139,7 @@ namespace mu2e {
       _ny = 0;
       _nz = 0;
       std::vector<OBJ>().swap(_vec);
+      _data = _vec.data();
     }
 
 
@@ -108,9 +148,20 @@ namespace mu2e {
     // Dimensions of the grid.
     unsigned int _nx, _ny, _nz;
 
-    // Container to hold everything.
+    // Container to hold everything, unless this is a view.
     std::vector<OBJ> _vec;
 
+    // The elements: either _vec.data() or external storage.
+    OBJ const* _data;
+
+    // Copy the elements of a view into _vec, so that they can be modified.
+    void own(){
+      if ( isView() ){
+        _vec.assign(_data, _data+std::size_t(_nx)*_ny*_nz);
+        _data = _vec.data();
+      }
+    }
+
     // Compute the index into the array.
     typename std::vector<OBJ>::size_type index(unsigned int ix, unsigned int iy, unsigned int iz) const {
       return ix*_ny*_nz + iy*_nz + iz;
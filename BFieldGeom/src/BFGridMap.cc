@@ -9,6 +9,8 @@
 // methods.
 
 // C++ includes
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 
@@ -161,6 +163,24 @@ namespace mu2e {
         } else if (_interpStyle == BFInterpolationStyle::meco) {
             retval = interpolateQuadratic(testpoint, result);
 
+        } else if (_interpStyle == BFInterpolationStyle::trilinearCompiled) {
+            if (!_compiledFloat.empty()) {
+                retval = interpolateTriLinearCompiled(_compiledFloat, testpoint, result);
+            } else if (!_compiledDouble.empty()) {
+                retval = interpolateTriLinearCompiled(_compiledDouble, testpoint, result);
+            } else {
+                retval = interpolateTriLinear(testpoint, result);
+            }
+
+        } else if (_interpStyle == BFInterpolationStyle::mecoCompiled) {
+            if (!_compiledFloat.empty()) {
+                retval = interpolateQuadraticCompiled(_compiledFloat, testpoint, result);
+            } else if (!_compiledDouble.empty()) {
+                retval = interpolateQuadraticCompiled(_compiledDouble, testpoint, result);
+            } else {
+                retval = interpolateQuadratic(testpoint, result);
+            }
+
         } else {
             throw cet::exception("GEOM")
                 << "Unrecognized option for interpolation into the BField: " << _interpStyle
@@ -379,6 +399,521 @@ namespace mu2e {
         return true;
     }
 
+    // Compiled version of interpolateTriLinear: the same acceptance and, inside the grid,
+    // the same result to round off.  A point in the last layer of cells, which the
+    // reference accepts but interpolates with values from beyond the grid, is
+    // extrapolated from the last cell.
+    template <typename T>
+    bool BFGridMap::interpolateTriLinearCompiled(BFCompiledGrid<T> const& grid,
+                                                 const CLHEP::Hep3Vector& p,
+                                                 CLHEP::Hep3Vector& result) const {
+        const double py = _flipy ? std::abs(p.y()) : p.y();
+        const double fx = (p.x() - _xmin) * _invdx;
+        const double fy = (py - _ymin) * _invdy;
+        const double fz = (p.z() - _zmin) * _invdz;
+
+        // Same test as floor() in [0,n) without calling floor.
+        if (!(fx >= 0. && fx < _nx && fy >= 0. && fy < _ny && fz >= 0. && fz < _nz)) {
+            if (_warnIfOutside) {
+                mf::LogWarning("GEOM")
+                    << "Point is outside of the valid region of the map: " << _key << "\n"
+                    << "Point in input coordinates: " << p << "\n";
+            }
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            return false;
+        }
+
+        const unsigned i = std::min(static_cast<unsigned>(fx), _nx - 2);
+        const unsigned j = std::min(static_cast<unsigned>(fy), _ny - 2);
+        const unsigned k = std::min(static_cast<unsigned>(fz), _nz - 2);
+
+        double b[3];
+        BFCompiledGrid<T>::evalLinear(grid.cell(i, j, k), fx - i, fy - j, fz - k, b);
+
+        // Need the signed value of p.y() here - the variable py will not do.
+        if (_flipy && p.y() < 0) {
+            b[1] = -b[1];
+        }
+        result = CLHEP::Hep3Vector(b[0], b[1], b[2]);
+        return true;
+    }
+
+    // Compiled version of interpolateQuadratic: the same choice of the central grid
+    // point and the same result to round off.
+    template <typename T>
+    bool BFGridMap::interpolateQuadraticCompiled(BFCompiledGrid<T> const& grid,
+                                                 const CLHEP::Hep3Vector& testpoint,
+                                                 CLHEP::Hep3Vector& result) const {
+        result = CLHEP::Hep3Vector(0., 0., 0.);
+
+        const bool flip = _flipy && testpoint.y() < 0;
+        const CLHEP::Hep3Vector point(testpoint.x(), flip ? -testpoint.y() : testpoint.y(),
+                                      testpoint.z());
+
+        if (!isValid(point)) {
+            if (_warnIfOutside) {
+                mf::LogWarning("GEOM")
+                    << "Point is outside of the valid region of the map: " << _key << "\n"
+                    << "Point in input coordinates: " << testpoint << "\n";
+            }
+            return false;
+        }
+
+        // Nearest grid point, moved just inside the edges.
+        const double fx = (point.x() - _xmin) * _invdx;
+        const double fy = (point.y() - _ymin) * _invdy;
+        const double fz = (point.z() - _zmin) * _invdz;
+        unsigned ix = static_cast<int>(fx + 0.5);
+        unsigned iy = static_cast<int>(fy + 0.5);
+        unsigned iz = static_cast<int>(fz + 0.5);
+        ix = std::max(1u, std::min(ix, _nx - 2));
+        iy = std::max(1u, std::min(iy, _ny - 2));
+        iz = std::max(1u, std::min(iz, _nz - 2));
+
+        if (!grid.ok(ix, iy, iz)) {
+            if (_warnIfOutside) {
+                mf::LogWarning("GEOM")
+                    << "Point's neighboring field is not defined in the map: " << _key << "\n"
+                    << "Point in input coordinates: " << testpoint << "\n";
+                mf::LogWarning("GEOM") << "ix=" << ix << " iy=" << iy << " iz=" << iz << "\n";
+            }
+            return false;
+        }
+
+        double b[3];
+        BFCompiledGrid<T>::evalQuadratic(grid.cell(ix, iy, iz), fx - ix, fy - iy, fz - iz, b);
+        result = CLHEP::Hep3Vector(b[0], flip ? -b[1] : b[1], b[2]);
+        return true;
+    }
+
+    bool BFGridMap::getBFieldWithGradient(const CLHEP::Hep3Vector& testpoint,
+                                          CLHEP::Hep3Vector& result,
+                                          CLHEP::Hep3Vector dBdx[3]) const {
+        result = CLHEP::Hep3Vector(0., 0., 0.);
+        for (int j = 0; j != 3; ++j) {
+            dBdx[j] = CLHEP::Hep3Vector(0., 0., 0.);
+        }
+
+        const bool flip = _flipy && testpoint.y() < 0;
+        const CLHEP::Hep3Vector point(testpoint.x(), flip ? -testpoint.y() : testpoint.y(),
+                                      testpoint.z());
+        const double fx = (point.x() - _xmin) * _invdx;
+        const double fy = (point.y() - _ymin) * _invdy;
+        const double fz = (point.z() - _zmin) * _invdz;
+
+        // b and its derivatives g[j][k] = dB_k/du_j in units of the grid spacing.
+        double b[3], g[3][3];
+
+        if (_interpStyle == BFInterpolationStyle::trilinear ||
+            _interpStyle == BFInterpolationStyle::trilinearCompiled) {
+            // Same acceptance as interpolateTriLinear.
+            if (!(fx >= 0. && fx < _nx && fy >= 0. && fy < _ny && fz >= 0. && fz < _nz)) {
+                if (_warnIfOutside) {
+                    mf::LogWarning("GEOM")
+                        << "Point is outside of the valid region of the map: " << _key << "\n"
+                        << "Point in input coordinates: " << testpoint << "\n";
+                }
+                return false;
+            }
+            const unsigned i = std::min(static_cast<unsigned>(fx), _nx - 2);
+            const unsigned j = std::min(static_cast<unsigned>(fy), _ny - 2);
+            const unsigned k = std::min(static_cast<unsigned>(fz), _nz - 2);
+
+            if (_interpStyle == BFInterpolationStyle::trilinearCompiled &&
+                !_compiledFloat.empty()) {
+                BFCompiledGrid<float>::evalLinearGrad(_compiledFloat.cell(i, j, k), fx - i,
+                                                      fy - j, fz - k, b, g);
+            } else if (_interpStyle == BFInterpolationStyle::trilinearCompiled &&
+                       !_compiledDouble.empty()) {
+                BFCompiledGrid<double>::evalLinearGrad(_compiledDouble.cell(i, j, k), fx - i,
+                                                       fy - j, fz - k, b, g);
+            } else {
+                double c[3 * 8];
+                BFCompiledGrid<double>::expandLinear(_field, i, j, k, c);
+                BFCompiledGrid<double>::evalLinearGrad(c, fx - i, fy - j, fz - k, b, g);
+            }
+
+        } else if (isQuadratic()) {
+            if (!isValid(point)) {
+                if (_warnIfOutside) {
+                    mf::LogWarning("GEOM")
+                        << "Point is outside of the valid region of the map: " << _key << "\n"
+                        << "Point in input coordinates: " << testpoint << "\n";
+                }
+                return false;
+            }
+
+            // Nearest grid point, moved just inside the edges, as in interpolateQuadratic.
+            unsigned ix = static_cast<int>(fx + 0.5);
+            unsigned iy = static_cast<int>(fy + 0.5);
+            unsigned iz = static_cast<int>(fz + 0.5);
+            ix = std::max(1u, std::min(ix, _nx - 2));
+            iy = std::max(1u, std::min(iy, _ny - 2));
+            iz = std::max(1u, std::min(iz, _nz - 2));
+
+            const bool useFloat =
+                _interpStyle == BFInterpolationStyle::mecoCompiled && !_compiledFloat.empty();
+            const bool useDouble =
+                _interpStyle == BFInterpolationStyle::mecoCompiled && !_compiledDouble.empty();
+            const bool ok = useFloat    ? _compiledFloat.ok(ix, iy, iz)
+                            : useDouble ? _compiledDouble.ok(ix, iy, iz)
+                                        : BFCompiledGrid<double>::neighborsDefined(_isDefined,
+                                                                                   ix, iy, iz);
+            if (!ok) {
+                if (_warnIfOutside) {
+                    mf::LogWarning("GEOM")
+                        << "Point's neighboring field is not defined in the map: " << _key << "\n"
+                        << "Point in input coordinates: " << testpoint << "\n";
+                    mf::LogWarning("GEOM") << "ix=" << ix << " iy=" << iy << " iz=" << iz << "\n";
+                }
+                return false;
+            }
+
+            if (useFloat) {
+                BFCompiledGrid<float>::evalQuadraticGrad(_compiledFloat.cell(ix, iy, iz), fx - ix,
+                                                         fy - iy, fz - iz, b, g);
+            } else if (useDouble) {
+                BFCompiledGrid<double>::evalQuadraticGrad(_compiledDouble.cell(ix, iy, iz),
+                                                          fx - ix, fy - iy, fz - iz, b, g);
+            } else {
+                double c[3 * 27];
+                BFCompiledGrid<double>::expandQuadratic(_field, ix, iy, iz, c);
+                BFCompiledGrid<double>::evalQuadraticGrad(c, fx - ix, fy - iy, fz - iz, b, g);
+            }
+
+        } else {
+            throw cet::exception("GEOM")
+                << "Unrecognized option for interpolation into the BField: " << _interpStyle
+                << "\n";
+        }
+
+        // Below the symmetry plane By(x,y,z) = -By(x,-y,z) and the other components are
+        // even in y: the y derivatives of Bx and Bz and the x and z derivatives of By
+        // change sign, dBy/dy does not.
+        if (flip) {
+            b[1] = -b[1];
+            g[1][0] = -g[1][0];
+            g[1][2] = -g[1][2];
+            g[0][1] = -g[0][1];
+            g[2][1] = -g[2][1];
+        }
+
+        result = CLHEP::Hep3Vector(b[0], b[1], b[2]) * _scaleFactor;
+        const double inv[3] = {_invdx * _scaleFactor, _invdy * _scaleFactor, _invdz * _scaleFactor};
+        for (int j = 0; j != 3; ++j) {
+            dBdx[j] = CLHEP::Hep3Vector(g[j][0], g[j][1], g[j][2]) * inv[j];
+        }
+        return true;
+    }
+
+    void BFGridMap::compile(bool useFloat) {
+        _compiledFloat.clear();
+        _compiledDouble.clear();
+
+        const bool linear = _interpStyle == BFInterpolationStyle::trilinearCompiled;
+        const bool quadratic = _interpStyle == BFInterpolationStyle::mecoCompiled;
+        const unsigned nmin = quadratic ? 3 : 2;
+        if ((!linear && !quadratic) || _nx < nmin || _ny < nmin || _nz < nmin) {
+            return;
+        }
+
+        if (useFloat) {
+            if (linear) {
+                _compiledFloat.compileLinear(_field, _nx, _ny, _nz);
+            } else {
+                _compiledFloat.compileQuadratic(_field, _isDefined, _nx, _ny, _nz);
+            }
+        } else {
+            if (linear) {
+                _compiledDouble.compileLinear(_field, _nx, _ny, _nz);
+            } else {
+                _compiledDouble.compileQuadratic(_field, _isDefined, _nx, _ny, _nz);
+            }
+        }
+    }
+
+    void BFGridMap::setInterpolationStyle(BFInterpolationStyle style) {
+        _interpStyle = style;
+        _compiledFloat.clear();
+        _compiledDouble.clear();
+    }
+
+    namespace {
+        // Number of points processed together by the batch kernels.  The per-block
+        // scratch arrays live on the stack.
+        constexpr std::size_t batchBlock = 64;
+    }  // namespace
+
+    void BFGridMap::attach(std::shared_ptr<const BFMapFile> file) {
+        BFMapFileHeader const& h = file->header();
+        if (unsigned(h.nx) != _nx || unsigned(h.ny) != _ny || unsigned(h.nz) != _nz) {
+            throw cet::exception("GEOM")
+                << "BFGridMap::attach: grid of " << file->filename() << " (" << h.nx << " "
+                << h.ny << " " << h.nz << ") does not match the map " << _key << "\n";
+        }
+        _mapFile = file;
+        _field.view(reinterpret_cast<CLHEP::Hep3Vector const*>(file->field()), _nx, _ny, _nz);
+
+        _allDefined = file->flag(BFMapFileHeader::allDefined);
+        if (_allDefined) {
+            _isDefined = Container3D<bool>(_nx, _ny, _nz, true);
+        } else {
+            unsigned char const* defined = file->defined();
+            for (unsigned ix = 0; ix != _nx; ++ix) {
+                for (unsigned iy = 0; iy != _ny; ++iy) {
+                    for (unsigned iz = 0; iz != _nz; ++iz) {
+                        _isDefined.set(ix, iy, iz, *defined++ != 0);
+                    }
+                }
+            }
+        }
+    }
+
+    void BFGridMap::fillSoA(bool useFloat, bool makeCopy) {
+        _soaFloat.clear();
+        _soaDouble.clear();
+
+        // The batch grid in the file is only valid while _field is unmodified,
+        // which is exactly while it is still a view of the file.
+        if (_mapFile && _field.isView()) {
+            BFMapFile const& f = *_mapFile;
+            if (useFloat && f.flag(BFMapFileHeader::batchFloat)) {
+                _soaFloat.view(f.batch<float>(0), f.batch<float>(1), f.batch<float>(2),
+                               f.batchQuadOK(), _nx, _ny, _nz);
+                return;
+            }
+            if (!useFloat && f.flag(BFMapFileHeader::batchDouble)) {
+                _soaDouble.view(f.batch<double>(0), f.batch<double>(1), f.batch<double>(2),
+                                f.batchQuadOK(), _nx, _ny, _nz);
+                return;
+            }
+        }
+
+        if (!makeCopy) {
+            return;
+        }
+        if (useFloat) {
+            _soaFloat.fill(_field, _isDefined, _nx, _ny, _nz);
+        } else {
+            _soaDouble.fill(_field, _isDefined, _nx, _ny, _nz);
+        }
+    }
+
+    void BFGridMap::getBField(std::vector<XYZVec> const& points,
+                              std::vector<XYZVec>& fields) const {
+        fields.resize(points.size());
+        getBField(points.data(), fields.data(), points.size());
+    }
+
+    void BFGridMap::getBField(XYZVec const* points,
+                              XYZVec* fields,
+                              std::size_t n,
+                              bool* status) const {
+        const bool haveFloat = !_soaFloat.empty();
+        const bool haveDouble = !_soaDouble.empty();
+
+        // The kernels need at least two (trilinear) or three (quadratic) points per axis.
+        const unsigned nmin = isQuadratic() ? 3 : 2;
+        const bool gridOK = _nx >= nmin && _ny >= nmin && _nz >= nmin;
+
+        if ((haveFloat || haveDouble) && gridOK) {
+            if (_interpStyle == BFInterpolationStyle::trilinear ||
+                _interpStyle == BFInterpolationStyle::trilinearCompiled) {
+                if (haveFloat) {
+                    batchTriLinear(_soaFloat, points, fields, n, status);
+                } else {
+                    batchTriLinear(_soaDouble, points, fields, n, status);
+                }
+                return;
+            }
+            if (isQuadratic()) {
+                if (haveFloat) {
+                    batchQuadratic(_soaFloat, points, fields, n, status);
+                } else {
+                    batchQuadratic(_soaDouble, points, fields, n, status);
+                }
+                return;
+            }
+        }
+
+        // Fall back to the per-point code.
+        for (std::size_t i = 0; i != n; ++i) {
+            CLHEP::Hep3Vector b;
+            bool ok = getBFieldWithStatus(
+                CLHEP::Hep3Vector(points[i].x(), points[i].y(), points[i].z()), b);
+            fields[i] = ok ? XYZVec(b.x(), b.y(), b.z()) : XYZVec(0., 0., 0.);
+            if (status) {
+                status[i] = ok;
+            }
+        }
+    }
+
+    // Batch version of interpolateTriLinear.  The first pass over a block computes the
+    // cell and the fractional position of each point without branches; the second pass
+    // forms the weighted sum of the 8 corners for each component.  Points outside the
+    // map are given a valid cell and a weight of zero, so that the loops have no
+    // data dependent control flow.
+    template <typename T>
+    void BFGridMap::batchTriLinear(BFGridSoA<T> const& grid,
+                                   XYZVec const* points,
+                                   XYZVec* fields,
+                                   std::size_t n,
+                                   bool* status) const {
+        T const* bx = grid.component(0);
+        T const* by = grid.component(1);
+        T const* bz = grid.component(2);
+        const std::size_t sx = grid.strideX();
+        const std::size_t sy = grid.strideY();
+
+        const double xhi = _nx - 1;
+        const double yhi = _ny - 1;
+        const double zhi = _nz - 1;
+        const int ixmax = _nx - 2;
+        const int iymax = _ny - 2;
+        const int izmax = _nz - 2;
+        const T scale = _scaleFactor;
+
+        std::size_t base[batchBlock];
+        T tx[batchBlock], ty[batchBlock], tz[batchBlock];
+        T weight[batchBlock], ysign[batchBlock];
+
+        for (std::size_t start = 0; start < n; start += batchBlock) {
+            const std::size_t m = std::min(batchBlock, n - start);
+            XYZVec const* p = points + start;
+
+            for (std::size_t i = 0; i != m; ++i) {
+                const double px = p[i].x();
+                const double py = p[i].y();
+                const double pz = p[i].z();
+                const double ay = _flipy ? std::abs(py) : py;
+                const double fx = (px - _xmin) / _dx;
+                const double fy = (ay - _ymin) / _dy;
+                const double fz = (pz - _zmin) / _dz;
+                const bool inside =
+                    fx >= 0. && fx <= xhi && fy >= 0. && fy <= yhi && fz >= 0. && fz <= zhi;
+                const double cx = inside ? fx : 0.;
+                const double cy = inside ? fy : 0.;
+                const double cz = inside ? fz : 0.;
+                // A point on the upper face uses the last cell, with fraction 1.
+                const int ix = std::min(static_cast<int>(cx), ixmax);
+                const int iy = std::min(static_cast<int>(cy), iymax);
+                const int iz = std::min(static_cast<int>(cz), izmax);
+                tx[i] = cx - ix;
+                ty[i] = cy - iy;
+                tz[i] = cz - iz;
+                base[i] = ix * sx + iy * sy + iz;
+                weight[i] = inside ? scale : T(0);
+                ysign[i] = (_flipy && py < 0.) ? T(-1) : T(1);
+                if (status) {
+                    status[start + i] = inside;
+                }
+            }
+
+            for (std::size_t i = 0; i != m; ++i) {
+                const T x1 = tx[i], x0 = T(1) - x1;
+                const T y1 = ty[i], y0 = T(1) - y1;
+                const T z1 = tz[i], z0 = T(1) - z1;
+                const T w[8] = {x0 * y0 * z0, x1 * y0 * z0, x0 * y1 * z0, x1 * y1 * z0,
+                                x0 * y0 * z1, x1 * y0 * z1, x0 * y1 * z1, x1 * y1 * z1};
+                const std::size_t b = base[i];
+                const std::size_t o[8] = {b,      b + sx,      b + sy,     b + sx + sy,
+                                          b + 1,  b + sx + 1,  b + sy + 1, b + sx + sy + 1};
+                T sumx(0), sumy(0), sumz(0);
+                for (int c = 0; c != 8; ++c) {
+                    sumx += w[c] * bx[o[c]];
+                    sumy += w[c] * by[o[c]];
+                    sumz += w[c] * bz[o[c]];
+                }
+                const T s = weight[i];
+                fields[start + i] = XYZVec(s * sumx, s * ysign[i] * sumy, s * sumz);
+            }
+        }
+    }
+
+    // Batch version of interpolateQuadratic.  Same two pass structure as batchTriLinear.
+    // The 3x3x3 neighborhood is centered on the nearest grid point, moved inside the
+    // grid at the edges; the Lagrange weights for the positions 0, 1, 2 of the
+    // neighborhood are computed once per axis and combined as a tensor product.
+    template <typename T>
+    void BFGridMap::batchQuadratic(BFGridSoA<T> const& grid,
+                                   XYZVec const* points,
+                                   XYZVec* fields,
+                                   std::size_t n,
+                                   bool* status) const {
+        T const* bx = grid.component(0);
+        T const* by = grid.component(1);
+        T const* bz = grid.component(2);
+        unsigned char const* quadOK = grid.quadOK();
+        const std::size_t sx = grid.strideX();
+        const std::size_t sy = grid.strideY();
+
+        const int ixmax = _nx - 2;
+        const int iymax = _ny - 2;
+        const int izmax = _nz - 2;
+        const T scale = _scaleFactor;
+
+        std::size_t base[batchBlock];
+        T tx[batchBlock], ty[batchBlock], tz[batchBlock];
+        T weight[batchBlock], ysign[batchBlock];
+
+        for (std::size_t start = 0; start < n; start += batchBlock) {
+            const std::size_t m = std::min(batchBlock, n - start);
+            XYZVec const* p = points + start;
+
+            for (std::size_t i = 0; i != m; ++i) {
+                const double px = p[i].x();
+                const double py = p[i].y();
+                const double pz = p[i].z();
+                const double ay = _flipy ? std::abs(py) : py;
+                // Same acceptance as isValid; the extra GMC check is a no-op.
+                const bool inside = px >= _xmin && px <= _xmax && ay >= _ymin && ay <= _ymax &&
+                                    pz >= _zmin && pz <= _zmax;
+                const double cx = inside ? px : _xmin;
+                const double cy = inside ? ay : _ymin;
+                const double cz = inside ? pz : _zmin;
+                // Nearest grid point, moved inside the edges.
+                const int ix = std::min(std::max(static_cast<int>((cx - _xmin) / _dx + 0.5), 1), ixmax);
+                const int iy = std::min(std::max(static_cast<int>((cy - _ymin) / _dy + 0.5), 1), iymax);
+                const int iz = std::min(std::max(static_cast<int>((cz - _zmin) / _dz + 0.5), 1), izmax);
+                // Position within the neighborhood, which spans 0 to 2 on each axis.
+                tx[i] = (cx - (_xmin + (ix - 1) * _dx)) / _dx;
+                ty[i] = (cy - (_ymin + (iy - 1) * _dy)) / _dy;
+                tz[i] = (cz - (_zmin + (iz - 1) * _dz)) / _dz;
+                const std::size_t center = ix * sx + iy * sy + iz;
+                base[i] = center - sx - sy - 1;
+                const bool ok = inside && quadOK[center];
+                weight[i] = ok ? scale : T(0);
+                ysign[i] = (_flipy && py < 0.) ? T(-1) : T(1);
+                if (status) {
+                    status[start + i] = ok;
+                }
+            }
+
+            for (std::size_t i = 0; i != m; ++i) {
+                const T u = tx[i], v = ty[i], t = tz[i];
+                const T wx[3] = {T(0.5) * (u - T(1)) * (u - T(2)), -u * (u - T(2)),
+                                 T(0.5) * u * (u - T(1))};
+                const T wy[3] = {T(0.5) * (v - T(1)) * (v - T(2)), -v * (v - T(2)),
+                                 T(0.5) * v * (v - T(1))};
+                const T wz[3] = {T(0.5) * (t - T(1)) * (t - T(2)), -t * (t - T(2)),
+                                 T(0.5) * t * (t - T(1))};
+                const std::size_t b = base[i];
+                T sumx(0), sumy(0), sumz(0);
+                for (int a = 0; a != 3; ++a) {
+                    for (int c = 0; c != 3; ++c) {
+                        const std::size_t o = b + a * sx + c * sy;
+                        const T w = wx[a] * wy[c];
+                        sumx += w * (wz[0] * bx[o] + wz[1] * bx[o + 1] + wz[2] * bx[o + 2]);
+                        sumy += w * (wz[0] * by[o] + wz[1] * by[o + 1] + wz[2] * by[o + 2]);
+                        sumz += w * (wz[0] * bz[o] + wz[1] * bz[o + 1] + wz[2] * bz[o + 2]);
+                    }
+                }
+                const T s = weight[i];
+                fields[start + i] = XYZVec(s * sumx, s * ysign[i] * sumy, s * sumz);
+            }
+        }
+    }
+
     bool BFGridMap::getNeighborPointBF(const CLHEP::Hep3Vector& testpoint,
                                        CLHEP::Hep3Vector neighborPoints[3],
                                        CLHEP::Hep3Vector neighborBF[3][3][3]) const {
@@ -486,6 +1021,16 @@ namespace mu2e {
         cout << "Range Z:    " << _zmin << " : " << _zmax << "  Middle: " << (_zmin + _zmax) / 2.
              << endl;
         cout << "Distance:       " << _dx << " " << _dy << " " << _dz << endl;
+        if (_mapFile) {
+            cout << "Loaded from:    " << _mapFile->filename()
+                 << (isMapped() ? " (memory mapped)" : " (modified copy)") << endl;
+        }
+        cout << "Interpolation:  " << _interpStyle;
+        if (!_compiledFloat.empty() || !_compiledDouble.empty()) {
+            cout << ", compiled in " << (_compiledFloat.empty() ? "double" : "float") << ", "
+                 << compiledSizeInBytes() / 1048576. << " MB";
+        }
+        cout << endl;
 
         cout << "Field at the edges: " << _field(0, 0, 0) << ", " << _field(_nx - 1, 0, 0) << ", "
              << _field(0, _ny - 1, 0) << ", " << _field(0, 0, _nz - 1) << ", "
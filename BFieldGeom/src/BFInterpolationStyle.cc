@@ -24,6 +24,8 @@ namespace mu2e {
             nam[meco] = "meco";
             nam[trilinear] = "trilinear";
             nam[fit] = "fit";
+            nam[mecoCompiled] = "mecoCompiled";
+            nam[trilinearCompiled] = "trilinearCompiled";
         }
 
         return nam;
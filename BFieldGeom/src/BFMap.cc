@@ -0,0 +1,40 @@
+//
+// Default implementations for the virtual class that holds one magnetic field map.
+//
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFMap.hh"
+
+namespace mu2e {
+
+    bool BFMap::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                      CLHEP::Hep3Vector& result,
+                                      CLHEP::Hep3Vector dBdx[3]) const {
+        static const double h(1.0);  // mm
+
+        const bool retval = getBFieldWithStatus(point, result);
+        for (int j = 0; j != 3; ++j) {
+            dBdx[j] = CLHEP::Hep3Vector(0., 0., 0.);
+        }
+        if (!retval) {
+            return false;
+        }
+
+        for (int j = 0; j != 3; ++j) {
+            CLHEP::Hep3Vector step(0., 0., 0.);
+            step[j] = h;
+            CLHEP::Hep3Vector bplus, bminus;
+            const bool plus = isValid(point + step) && getBFieldWithStatus(point + step, bplus);
+            const bool minus = isValid(point - step) && getBFieldWithStatus(point - step, bminus);
+            if (plus && minus) {
+                dBdx[j] = (bplus - bminus) / (2. * h);
+            } else if (plus) {
+                dBdx[j] = (bplus - result) / h;
+            } else if (minus) {
+                dBdx[j] = (result - bminus) / h;
+            }
+        }
+        return true;
+    }
+
+}  // end namespace mu2e
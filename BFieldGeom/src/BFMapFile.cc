@@ -0,0 +1,358 @@
+//
+// Memory mapped binary format for grid magnetic field maps.
+//
+
+// C++ includes
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+// Includes from C ( needed for block IO ).
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFGridMap.hh"
+#include "BFieldGeom/inc/BFGridSoA.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
+
+using namespace std;
+
+namespace mu2e {
+
+    static_assert(std::is_standard_layout<BFMapFileHeader>::value,
+                  "BFMapFileHeader is written to disk as is");
+    static_assert(sizeof(BFMapFileHeader) <= BFMapFile::pageSize,
+                  "BFMapFileHeader must fit in the first page");
+    static_assert(sizeof(CLHEP::Hep3Vector) == 3 * sizeof(double),
+                  "The field section is used in place as an array of Hep3Vector");
+
+    namespace {
+
+        const char magicString[8] = "MU2EBFM";
+        const uint32_t deadbeef(0xDEADBEEF);
+
+        uint64_t roundUpToPage(uint64_t n) {
+            return (n + BFMapFile::pageSize - 1) / BFMapFile::pageSize * BFMapFile::pageSize;
+        }
+
+        // Number of bytes of the header covered by headerChecksum.
+        const std::size_t headerChecksumBytes = offsetof(BFMapFileHeader, headerChecksum);
+
+        void copyString(char* dest, std::size_t n, std::string const& s) {
+            std::memset(dest, 0, n);
+            s.copy(dest, n - 1);
+        }
+
+        std::string errnoMessage(int errsave) {
+            std::ostringstream os;
+            os << "  errno: " << errsave << " " << strerror(errsave);
+            return os.str();
+        }
+
+        // Copy the component separated grid of precision T into the file image.
+        template <typename T>
+        void fillBatch(BFGridSoA<T> const& soa, BFMapFileHeader const& h, std::vector<char>& image) {
+            for (int c = 0; c != 3; ++c) {
+                std::memcpy(&image[h.batchOffset[c]], soa.component(c), soa.size() * sizeof(T));
+            }
+            std::memcpy(&image[h.batchOffset[3]], soa.quadOK(), soa.size());
+        }
+
+    }  // namespace
+
+    uint64_t BFMapFile::checksum(void const* data, std::size_t nbytes) {
+        // FNV-1a on 64 bit words, in four independent lanes so that the
+        // multiplications can overlap, then folded together.
+        const uint64_t prime(0x100000001b3ULL);
+        uint64_t h[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9ce484222325cbf2ULL,
+                         0x2325cbf29ce48422ULL};
+
+        unsigned char const* p = static_cast<unsigned char const*>(data);
+        std::size_t off = 0;
+        for (; off + 32 <= nbytes; off += 32) {
+            for (int l = 0; l != 4; ++l) {
+                uint64_t w;
+                std::memcpy(&w, p + off + 8 * l, 8);
+                h[l] = (h[l] ^ w) * prime;
+            }
+        }
+        for (; off + 8 <= nbytes; off += 8) {
+            uint64_t w;
+            std::memcpy(&w, p + off, 8);
+            h[0] = (h[0] ^ w) * prime;
+        }
+        for (; off < nbytes; ++off) {
+            h[1] = (h[1] ^ p[off]) * prime;
+        }
+
+        uint64_t result(nbytes);
+        for (int l = 0; l != 4; ++l) {
+            result = (result ^ h[l]) * prime;
+        }
+        return result;
+    }
+
+    BFMapFile::BFMapFile(std::string const& filename, bool verifyPayload)
+        : _filename(filename), _addr(0), _size(0), _header(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw cet::exception("GEOM")
+                << "BFMapFile: Error opening " << filename << errnoMessage(errno) << "\n";
+        }
+
+        struct stat info;
+        if (fstat(fd, &info)) {
+            int errsave = errno;
+            close(fd);
+            throw cet::exception("GEOM") << "BFMapFile: Error doing fstat() on " << filename
+                                         << errnoMessage(errsave) << "\n";
+        }
+        if (std::size_t(info.st_size) < sizeof(BFMapFileHeader)) {
+            close(fd);
+            throw cet::exception("GEOM") << "BFMapFile: " << filename << " is too short ("
+                                         << info.st_size << " bytes) to be a field map file.\n";
+        }
+        _size = info.st_size;
+
+        // Read only and shared: the pages are shared with every other process that maps the file.
+        _addr = mmap(0, _size, PROT_READ, MAP_SHARED, fd, 0);
+        int errsave = errno;
+        close(fd);
+        if (_addr == MAP_FAILED) {
+            _addr = 0;
+            throw cet::exception("GEOM")
+                << "BFMapFile: Error doing mmap() on " << filename << errnoMessage(errsave) << "\n";
+        }
+        _header = static_cast<BFMapFileHeader const*>(_addr);
+
+        try {
+            check(verifyPayload);
+        } catch (...) {
+            munmap(_addr, _size);
+            throw;
+        }
+    }
+
+    BFMapFile::~BFMapFile() {
+        if (_addr) {
+            munmap(_addr, _size);
+        }
+    }
+
+    void BFMapFile::check(bool verifyPayload) const {
+        BFMapFileHeader const& h = *_header;
+
+        if (std::memcmp(h.magic, magicString, sizeof(magicString)) != 0) {
+            throw cet::exception("GEOM") << "BFMapFile: " << _filename
+                                         << " is not a Mu2e field map file.\n";
+        }
+        if (h.endian != deadbeef) {
+            throw cet::exception("GEOM")
+                << "BFMapFile: endian mismatch in " << _filename << "  returned value: " << std::hex
+                << h.endian << "  expected value: " << deadbeef << std::dec << "\n";
+        }
+        if (h.version != currentVersion || h.headerSize != sizeof(BFMapFileHeader)) {
+            throw cet::exception("GEOM")
+                << "BFMapFile: " << _filename << " has format version " << h.version
+                << " and header size " << h.headerSize << "; this code reads version "
+                << currentVersion << " with header size " << sizeof(BFMapFileHeader) << ".\n";
+        }
+        if (checksum(&h, headerChecksumBytes) != h.headerChecksum) {
+            throw cet::exception("GEOM") << "BFMapFile: header checksum mismatch in " << _filename
+                                         << "\n";
+        }
+        if (h.fileSize != _size) {
+            throw cet::exception("GEOM")
+                << "BFMapFile: the size = " << _size << " of the file " << _filename
+                << " does not match the size in its header: " << h.fileSize << "\n";
+        }
+        if (h.nx < 1 || h.ny < 1 || h.nz < 1) {
+            throw cet::exception("GEOM") << "BFMapFile: bad grid dimensions in " << _filename
+                                         << ": " << h.nx << " " << h.ny << " " << h.nz << "\n";
+        }
+
+        // Every section must lie inside the file and start on a page boundary.
+        const std::size_t n = nPoints();
+        const bool isFloat = flag(BFMapFileHeader::batchFloat);
+        const bool isDouble = flag(BFMapFileHeader::batchDouble);
+        struct Section {
+            const char* name;
+            uint64_t offset;
+            uint64_t length;
+            bool required;
+        } sections[] = {
+            {"field", h.fieldOffset, 3 * n * sizeof(double), true},
+            {"defined", h.definedOffset, n, !flag(BFMapFileHeader::allDefined)},
+            {"batch Bx", h.batchOffset[0], n * (isFloat ? sizeof(float) : sizeof(double)),
+             isFloat || isDouble},
+            {"batch By", h.batchOffset[1], n * (isFloat ? sizeof(float) : sizeof(double)),
+             isFloat || isDouble},
+            {"batch Bz", h.batchOffset[2], n * (isFloat ? sizeof(float) : sizeof(double)),
+             isFloat || isDouble},
+            {"batch flags", h.batchOffset[3], n, isFloat || isDouble},
+        };
+        for (auto const& s : sections) {
+            if (s.offset == 0 && !s.required) {
+                continue;
+            }
+            if (s.offset == 0 || s.offset % pageSize != 0 || s.offset + s.length > _size) {
+                throw cet::exception("GEOM")
+                    << "BFMapFile: the " << s.name << " section of " << _filename
+                    << " is missing or does not fit in the file: offset " << s.offset
+                    << ", length " << s.length << ", file size " << _size << "\n";
+            }
+        }
+
+        if (verifyPayload) {
+            const uint64_t sum = checksum(static_cast<char const*>(_addr) + pageSize, _size - pageSize);
+            if (sum != h.payloadChecksum) {
+                throw cet::exception("GEOM")
+                    << "BFMapFile: payload checksum mismatch in " << _filename << "\n";
+            }
+        }
+    }
+
+    void BFMapFile::write(BFGridMap const& map,
+                          std::string const& filename,
+                          std::string const& source,
+                          bool batchFloat,
+                          bool batchDouble) {
+        if (batchFloat && batchDouble) {
+            throw cet::exception("GEOM")
+                << "BFMapFile::write: at most one precision of the batch grid can be stored.\n";
+        }
+
+        cout << "Writing magnetic field map in memory mapped format to file: " << filename
+             << endl;
+
+        const std::size_t n = std::size_t(map._nx) * map._ny * map._nz;
+
+        // Is the defined section needed?
+        bool allDefined(true);
+        for (unsigned ix = 0; allDefined && ix != map._nx; ++ix) {
+            for (unsigned iy = 0; allDefined && iy != map._ny; ++iy) {
+                for (unsigned iz = 0; allDefined && iz != map._nz; ++iz) {
+                    allDefined = map._isDefined(ix, iy, iz);
+                }
+            }
+        }
+
+        // Fill the header and lay out the sections.
+        BFMapFileHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, magicString, sizeof(magicString));
+        h.version = currentVersion;
+        h.endian = deadbeef;
+        h.headerSize = sizeof(BFMapFileHeader);
+        h.mapType = map.type().id();
+        h.nx = map._nx;
+        h.ny = map._ny;
+        h.nz = map._nz;
+        h.flags = (map._flipy ? BFMapFileHeader::flipy : 0) |
+                  (allDefined ? BFMapFileHeader::allDefined : 0) |
+                  (batchFloat ? BFMapFileHeader::batchFloat : 0) |
+                  (batchDouble ? BFMapFileHeader::batchDouble : 0);
+        h.xmin = map._xmin;
+        h.ymin = map._ymin;
+        h.zmin = map._zmin;
+        h.dx = map._dx;
+        h.dy = map._dy;
+        h.dz = map._dz;
+        // The stored values are the raw map; the scale factor of the job is applied on top.
+        h.scale = 1.;
+
+        uint64_t offset = pageSize;
+        h.fieldOffset = offset;
+        offset = roundUpToPage(offset + 3 * n * sizeof(double));
+        if (!allDefined) {
+            h.definedOffset = offset;
+            offset = roundUpToPage(offset + n);
+        }
+        if (batchFloat || batchDouble) {
+            const std::size_t width = batchFloat ? sizeof(float) : sizeof(double);
+            for (int c = 0; c != 3; ++c) {
+                h.batchOffset[c] = offset;
+                offset = roundUpToPage(offset + n * width);
+            }
+            h.batchOffset[3] = offset;
+            offset = roundUpToPage(offset + n);
+        }
+        h.fileSize = offset;
+
+        copyString(h.key, sizeof(h.key), map.getKey());
+        copyString(h.source, sizeof(h.source), source);
+
+        // Build the image of the file in memory.
+        std::vector<char> image(h.fileSize, 0);
+        for (unsigned ix = 0; ix != map._nx; ++ix) {
+            for (unsigned iy = 0; iy != map._ny; ++iy) {
+                for (unsigned iz = 0; iz != map._nz; ++iz) {
+                    const std::size_t i = (std::size_t(ix) * map._ny + iy) * map._nz + iz;
+                    CLHEP::Hep3Vector const& b = map._field(ix, iy, iz);
+                    const double v[3] = {b.x(), b.y(), b.z()};
+                    std::memcpy(&image[h.fieldOffset + 3 * i * sizeof(double)], v, sizeof(v));
+                    if (!allDefined) {
+                        image[h.definedOffset + i] = map._isDefined(ix, iy, iz) ? 1 : 0;
+                    }
+                }
+            }
+        }
+        if (batchFloat) {
+            BFGridSoA<float> soa;
+            soa.fill(map._field, map._isDefined, map._nx, map._ny, map._nz);
+            fillBatch(soa, h, image);
+        } else if (batchDouble) {
+            BFGridSoA<double> soa;
+            soa.fill(map._field, map._isDefined, map._nx, map._ny, map._nz);
+            fillBatch(soa, h, image);
+        }
+
+        h.payloadChecksum = checksum(&image[pageSize], image.size() - pageSize);
+        h.headerChecksum = checksum(&h, headerChecksumBytes);
+        std::memcpy(&image[0], &h, sizeof(h));
+
+        // Open the output file; never overwrite an existing one.
+        mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        int flags = O_CREAT | O_WRONLY | O_TRUNC | O_EXCL;
+        int fd = open(filename.c_str(), flags, mode);
+        if (fd < 0) {
+            int errsave = errno;
+            if (errsave == EEXIST) {
+                throw cet::exception("GEOM") << "BFMapFile::write Error opening " << filename
+                                             << "  File already exists.\n";
+            }
+            throw cet::exception("GEOM") << "BFMapFile::write Error opening " << filename
+                                         << errnoMessage(errsave) << "\n";
+        }
+
+        std::size_t done(0);
+        while (done < image.size()) {
+            ssize_t s = ::write(fd, &image[done], image.size() - done);
+            if (s < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                int errsave = errno;
+                close(fd);
+                throw cet::exception("GEOM") << "BFMapFile::write Error writing to " << filename
+                                             << errnoMessage(errsave) << "\n";
+            }
+            done += s;
+        }
+        close(fd);
+
+        cout << "Writing complete for file: " << filename << endl;
+    }
+
+}  // namespace mu2e
@@ -0,0 +1,166 @@
+//
+// Flat spatial index over the inner and outer magnetic field maps.
+//
+
+// C++ includes
+#include <cmath>
+#include <limits>
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFMapIndex.hh"
+
+using namespace std;
+
+namespace mu2e {
+
+    namespace {
+
+        // Bounding box of one map.  Grid maps may be reflected about y=0,
+        // so take the y range to be symmetric; this may add a candidate to
+        // some cells but never loses one, since isValid has the final word.
+        struct Box {
+            double lo[3];
+            double hi[3];
+            explicit Box(const BFMap& m) {
+                lo[0] = m.xmin();
+                hi[0] = m.xmax();
+                lo[1] = std::min(m.ymin(), -m.ymax());
+                hi[1] = std::max(m.ymax(), -m.ymin());
+                lo[2] = m.zmin();
+                hi[2] = m.zmax();
+            }
+        };
+
+        // Number of cells along one axis: aim for cells no larger than half of the
+        // smallest map along that axis, within the limits [1,maxCells].
+        unsigned cellsOnAxis(double extent, double smallest, unsigned maxCells) {
+            if (!(extent > 0.) || !(smallest > 0.)) {
+                return 1;
+            }
+            const double n = std::ceil(2. * extent / smallest);
+            return n < 1. ? 1 : (n > maxCells ? maxCells : static_cast<unsigned>(n));
+        }
+
+    }  // namespace
+
+    BFMapIndex::BFMapIndex(const MapContainerType& innerMaps,
+                           const MapContainerType& outerMaps,
+                           unsigned maxCellsPerAxis)
+        : xmin_(0.),
+          ymin_(0.),
+          zmin_(0.),
+          xmax_(0.),
+          ymax_(0.),
+          zmax_(0.),
+          invdx_(0.),
+          invdy_(0.),
+          invdz_(0.),
+          nx_(0),
+          ny_(0),
+          nz_(0) {
+        maps_.insert(maps_.end(), innerMaps.begin(), innerMaps.end());
+        maps_.insert(maps_.end(), outerMaps.begin(), outerMaps.end());
+        if (maps_.empty()) {
+            return;
+        }
+
+        // Bounding box of all maps and the smallest map extent along each axis.
+        double lo[3], hi[3], smallest[3];
+        for (int a = 0; a != 3; ++a) {
+            lo[a] = numeric_limits<double>::max();
+            hi[a] = -numeric_limits<double>::max();
+            smallest[a] = numeric_limits<double>::max();
+        }
+        for (auto const& m : maps_) {
+            Box b(*m);
+            for (int a = 0; a != 3; ++a) {
+                lo[a] = std::min(lo[a], b.lo[a]);
+                hi[a] = std::max(hi[a], b.hi[a]);
+                if (b.hi[a] > b.lo[a]) {
+                    smallest[a] = std::min(smallest[a], b.hi[a] - b.lo[a]);
+                }
+            }
+        }
+
+        xmin_ = lo[0];
+        ymin_ = lo[1];
+        zmin_ = lo[2];
+        xmax_ = hi[0];
+        ymax_ = hi[1];
+        zmax_ = hi[2];
+
+        unsigned n[3];
+        double inv[3];
+        for (int a = 0; a != 3; ++a) {
+            n[a] = cellsOnAxis(hi[a] - lo[a], smallest[a], maxCellsPerAxis);
+            inv[a] = (hi[a] > lo[a]) ? n[a] / (hi[a] - lo[a]) : 0.;
+        }
+        nx_ = n[0];
+        ny_ = n[1];
+        nz_ = n[2];
+        invdx_ = inv[0];
+        invdy_ = inv[1];
+        invdz_ = inv[2];
+
+        // Range of cells touched by each map, widened by one cell on each side
+        // to be safe against round off at the cell boundaries.
+        struct CellRange {
+            unsigned lo[3];
+            unsigned hi[3];
+        };
+        vector<CellRange> ranges;
+        ranges.reserve(maps_.size());
+        for (auto const& m : maps_) {
+            Box b(*m);
+            CellRange r;
+            for (int a = 0; a != 3; ++a) {
+                const double flo = std::floor((b.lo[a] - lo[a]) * inv[a]) - 1.;
+                const double fhi = std::floor((b.hi[a] - lo[a]) * inv[a]) + 1.;
+                r.lo[a] = flo < 0. ? 0 : static_cast<unsigned>(flo);
+                r.hi[a] = fhi > n[a] - 1 ? n[a] - 1 : static_cast<unsigned>(fhi);
+            }
+            ranges.push_back(r);
+        }
+
+        // Fill the cells.  Inner maps come first, in the input order, followed by
+        // the outer maps in the user-specified order.
+        const size_t nInner = innerMaps.size();
+        cells_.resize(size_t(nx_) * ny_ * nz_);
+        for (unsigned ix = 0; ix != nx_; ++ix) {
+            for (unsigned iy = 0; iy != ny_; ++iy) {
+                for (unsigned iz = 0; iz != nz_; ++iz) {
+                    Cell& c = cells_[(ix * ny_ + iy) * nz_ + iz];
+                    c.begin = candidates_.size();
+                    for (size_t im = 0; im != maps_.size(); ++im) {
+                        if (im == nInner) {
+                            c.innerEnd = candidates_.size();
+                        }
+                        CellRange const& r = ranges[im];
+                        if (ix >= r.lo[0] && ix <= r.hi[0] && iy >= r.lo[1] && iy <= r.hi[1] &&
+                            iz >= r.lo[2] && iz <= r.hi[2]) {
+                            candidates_.push_back(maps_[im].get());
+                        }
+                    }
+                    if (nInner == maps_.size()) {
+                        c.innerEnd = candidates_.size();
+                    }
+                    c.end = candidates_.size();
+                }
+            }
+        }
+    }
+
+    void BFMapIndex::print(std::ostream& os) const {
+        size_t maxCandidates(0);
+        for (auto const& c : cells_) {
+            maxCandidates = std::max(maxCandidates, size_t(c.end - c.begin));
+        }
+        os << "BFMapIndex: " << maps_.size() << " maps, " << nx_ << " x " << ny_ << " x " << nz_
+           << " cells, " << candidates_.size() << " candidates, at most " << maxCandidates
+           << " per cell" << endl;
+        os << "Range X:    " << xmin_ << " : " << xmax_ << endl;
+        os << "Range Y:    " << ymin_ << " : " << ymax_ << endl;
+        os << "Range Z:    " << zmin_ << " : " << zmax_ << endl;
+    }
+
+}  // namespace mu2e
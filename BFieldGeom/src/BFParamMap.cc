@@ -76,7 +76,13 @@ namespace mu2e {
         double cos_nphi, cos_kmsz;
         double sin_nphi, sin_kmsz;
         double abp, abm;
-        vector<double> out(3, 0);
+        // Bessel function values go to per-thread scratch space, so that the map can be
+        // evaluated concurrently from several threads without allocating on each query.
+        // Every entry is overwritten below.
+        static thread_local vector<double> iv;
+        static thread_local vector<double> ivp;
+        iv.resize(_ns * _ms);
+        ivp.resize(_ns * _ms);
         phi = atan2(p.y(), p.x() + 3896);
         r = sqrt(pow(p.x() + 3896, 2) + pow(p.y(), 2));
         double abs_r = abs(r);
@@ -86,11 +92,11 @@ namespace mu2e {
                 tmp_rho = _kms[n][m - 1] * abs_r;
                 bessels[0] = gsl_sf_bessel_In(n, tmp_rho);
                 bessels[1] = gsl_sf_bessel_In(n + 1, tmp_rho);
-                _iv[n][m - 1] = bessels[0];
+                iv[n * _ms + m - 1] = bessels[0];
                 if (tmp_rho == 0) {
-                    _ivp[n][m - 1] = 0.5 * (gsl_sf_bessel_In(n - 1, 0) + bessels[1]);
+                    ivp[n * _ms + m - 1] = 0.5 * (gsl_sf_bessel_In(n - 1, 0) + bessels[1]);
                 } else {
-                    _ivp[n][m - 1] = (n / tmp_rho) * bessels[0] + bessels[1];
+                    ivp[n * _ms + m - 1] = (n / tmp_rho) * bessels[0] + bessels[1];
                 }
             }
         }
@@ -107,10 +113,10 @@ namespace mu2e {
                 sin_kmsz = sin(_kms[n][m] * p.z());
                 abp = _As[n][m] * cos_kmsz + _Bs[n][m] * sin_kmsz;
                 abm = -_As[n][m] * sin_kmsz + _Bs[n][m] * cos_kmsz;
-                br += cos_nphi * _ivp[n][m] * _kms[n][m] * abp;
-                bz += cos_nphi * _iv[n][m] * _kms[n][m] * abm;
+                br += cos_nphi * ivp[n * _ms + m] * _kms[n][m] * abp;
+                bz += cos_nphi * iv[n * _ms + m] * _kms[n][m] * abm;
                 if (abs_r > 1e-10) {
-                    bphi += n * sin_nphi * (1 / abs_r) * _iv[n][m] * abp;
+                    bphi += n * sin_nphi * (1 / abs_r) * iv[n * _ms + m] * abp;
                 }
             }
         }
@@ -146,13 +152,6 @@ namespace mu2e {
                 _kms[n].push_back(m * M_PI / _Reff);
             }
         }
-
-        for (int n = 0; n < _ns; ++n) {
-            vector<double> tmp_v1(_ms, 0.0);
-            vector<double> tmp_v2(_ms, 0.0);
-            _iv.push_back(tmp_v1);
-            _ivp.push_back(tmp_v2);
-        }
     }
 
 }  // end namespace mu2e
@@ -19,9 +19,18 @@ namespace mu2e {
 
     // Get field at an arbitrary point. This code figures out which map to use
     // and looks up the field in that map.
+    // The index lookup is stateless, so this is safe to call concurrently.
     bool BFieldManager::getBFieldWithStatus(const CLHEP::Hep3Vector& point,
                                             CLHEP::Hep3Vector& result) const {
-        return getBFieldWithStatus(point, cm_, result);
+        const BFMap* m = index_ ? index_->findMap(point) : 0;
+
+        if (m) {
+            m->getBFieldWithStatus(point, result);
+        } else {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+        }
+
+        return (m != 0);
     }
 
 
@@ -30,7 +39,7 @@ namespace mu2e {
     bool BFieldManager::getBFieldWithStatus(const CLHEP::Hep3Vector& point,
                                             BFCacheManager const& cmgr,
                                             CLHEP::Hep3Vector& result) const {
-        auto m = cmgr.findMap(point);
+        const BFMap* m = cmgr.findMap(point);
 
         if (m) {
             m->getBFieldWithStatus(point, result);
@@ -42,6 +51,87 @@ namespace mu2e {
     }
 
 
+    bool BFieldManager::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                              CLHEP::Hep3Vector& result,
+                                              CLHEP::Hep3Vector dBdx[3]) const {
+        const BFMap* m = index_ ? index_->findMap(point) : 0;
+
+        if (m) {
+            m->getBFieldWithGradient(point, result, dBdx);
+        } else {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            for (int j = 0; j != 3; ++j) {
+                dBdx[j] = CLHEP::Hep3Vector(0., 0., 0.);
+            }
+        }
+
+        return (m != 0);
+    }
+
+
+    bool BFieldManager::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                              BFCacheManager const& cmgr,
+                                              CLHEP::Hep3Vector& result,
+                                              CLHEP::Hep3Vector dBdx[3]) const {
+        const BFMap* m = cmgr.findMap(point);
+
+        if (m) {
+            m->getBFieldWithGradient(point, result, dBdx);
+        } else {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            for (int j = 0; j != 3; ++j) {
+                dBdx[j] = CLHEP::Hep3Vector(0., 0., 0.);
+            }
+        }
+
+        return (m != 0);
+    }
+
+
+    void BFieldManager::getBField(XYZVec const* points,
+                                  XYZVec* fields,
+                                  std::size_t n,
+                                  BFCacheManager const& cmgr) const {
+        std::size_t i = 0;
+        const BFMap* m = n > 0 ? cmgr.findMap(CLHEP::Hep3Vector(points[0].x(), points[0].y(),
+                                                                points[0].z()))
+                               : 0;
+        while (i < n) {
+            // Find the end of the run of points that use the same map as point i.
+            std::size_t j = i + 1;
+            const BFMap* next = 0;
+            for (; j < n; ++j) {
+                next = cmgr.findMap(CLHEP::Hep3Vector(points[j].x(), points[j].y(), points[j].z()));
+                if (next != m) {
+                    break;
+                }
+            }
+
+            const BFGridMap* grid = dynamic_cast<const BFGridMap*>(m);
+            if (grid) {
+                grid->getBField(points + i, fields + i, j - i);
+            } else {
+                for (std::size_t k = i; k != j; ++k) {
+                    CLHEP::Hep3Vector b;
+                    if (m) {
+                        m->getBFieldWithStatus(
+                            CLHEP::Hep3Vector(points[k].x(), points[k].y(), points[k].z()), b);
+                    }
+                    fields[k] = XYZVec(b.x(), b.y(), b.z());
+                }
+            }
+
+            i = j;
+            m = next;
+        }
+    }
+
+    void BFieldManager::getBField(std::vector<XYZVec> const& points,
+                                  std::vector<XYZVec>& fields) const {
+        fields.resize(points.size());
+        getBField(points.data(), fields.data(), points.size(), cacheManager());
+    }
+
     std::shared_ptr<BFGridMap> BFieldManager::addBFGridMap(MapContainerType* mapContainer,
                                                            const std::string& key,
                                                            int nx,
@@ -108,6 +198,10 @@ namespace mu2e {
             (*i)->print(out);
         }
 
+        if (index_) {
+            index_->print(out);
+        }
+
         out << "================     BFieldManager end    ================\n";
     }
 
@@ -0,0 +1,189 @@
+//
+// Microbenchmark of the batch magnetic field interface against the per-point interface.
+//
+// For each grid map, and then for the BFieldManager as a whole, the module generates
+// random walks of points inside the map, evaluates the field at all of them with the
+// per-point getBFieldWithStatus and with the batch getBField, and prints the time per
+// point for each and the largest difference between the two.
+//
+// The batch grid is only made with the geometry parameter bfield.batchGrid (see
+// BFieldTest/test/geom_batchGrid.txt); its precision is chosen with bfield.batchFloat.
+//
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+
+#include "BFieldGeom/inc/BFGridMap.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace mu2e {
+
+    class BFieldBatchBench : public art::EDAnalyzer {
+       public:
+        explicit BFieldBatchBench(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run);
+        void analyze(const art::Event&){};
+
+       private:
+        unsigned nPoints_;
+        double stepSize_;
+        unsigned nRepeat_;
+        unsigned seed_;
+
+        // Random walk of nPoints_ points that stays inside the box of the map.
+        std::vector<XYZVec> makePoints(BFMap const& map, std::mt19937_64& engine) const;
+
+        // Print one line of the report.
+        void report(std::string const& name,
+                    std::vector<XYZVec> const& points,
+                    double tScalar,
+                    double tBatch,
+                    std::vector<CLHEP::Hep3Vector> const& scalar,
+                    std::vector<XYZVec> const& batch) const;
+    };
+
+    BFieldBatchBench::BFieldBatchBench(const fhicl::ParameterSet& pset)
+        : art::EDAnalyzer(pset),
+          nPoints_(pset.get<unsigned>("nPoints", 1000000)),
+          stepSize_(pset.get<double>("stepSize", 10.)),
+          nRepeat_(pset.get<unsigned>("nRepeat", 5)),
+          seed_(pset.get<unsigned>("seed", 4321)) {}
+
+    std::vector<XYZVec> BFieldBatchBench::makePoints(BFMap const& map,
+                                                     std::mt19937_64& engine) const {
+        std::uniform_real_distribution<double> flat(-1., 1.);
+        const double lo[3] = {map.xmin(), map.ymin(), map.zmin()};
+        const double hi[3] = {map.xmax(), map.ymax(), map.zmax()};
+
+        std::vector<XYZVec> points;
+        points.reserve(nPoints_);
+        double x[3];
+        for (int a = 0; a != 3; ++a) {
+            x[a] = 0.5 * (lo[a] + hi[a]);
+        }
+        for (unsigned i = 0; i != nPoints_; ++i) {
+            for (int a = 0; a != 3; ++a) {
+                x[a] += stepSize_ * flat(engine);
+                // Reflect back into the box.
+                if (x[a] < lo[a]) {
+                    x[a] = std::min(2. * lo[a] - x[a], hi[a]);
+                }
+                if (x[a] > hi[a]) {
+                    x[a] = std::max(2. * hi[a] - x[a], lo[a]);
+                }
+            }
+            points.emplace_back(x[0], x[1], x[2]);
+        }
+        return points;
+    }
+
+    void BFieldBatchBench::report(std::string const& name,
+                                  std::vector<XYZVec> const& points,
+                                  double tScalar,
+                                  double tBatch,
+                                  std::vector<CLHEP::Hep3Vector> const& scalar,
+                                  std::vector<XYZVec> const& batch) const {
+        double maxdiff(0.);
+        for (size_t i = 0; i != points.size(); ++i) {
+            maxdiff = std::max({maxdiff, std::abs(scalar[i].x() - batch[i].x()),
+                                std::abs(scalar[i].y() - batch[i].y()),
+                                std::abs(scalar[i].z() - batch[i].z())});
+        }
+        const double n = points.size();
+        std::printf("%-30s %12.2f %12.2f %8.2f %14.3g\n", name.c_str(), 1e9 * tScalar / n,
+                    1e9 * tBatch / n, tBatch > 0. ? tScalar / tBatch : 0., maxdiff);
+    }
+
+    void BFieldBatchBench::beginRun(const art::Run& run) {
+        GeomHandle<BFieldManager> bfmgr;
+        std::mt19937_64 engine(seed_);
+
+        typedef std::chrono::high_resolution_clock Clock;
+        auto seconds = [](Clock::time_point a, Clock::time_point b) {
+            return std::chrono::duration<double>(b - a).count();
+        };
+
+        std::printf("BFieldBatchBench: %u points per map, best of %u repetitions\n", nPoints_,
+                    nRepeat_);
+        std::printf("%-30s %12s %12s %8s %14s\n", "map", "ns/pt scalar", "ns/pt batch",
+                    "speedup", "max |dB| (T)");
+
+        std::vector<CLHEP::Hep3Vector> scalar(nPoints_);
+        std::vector<XYZVec> batch(nPoints_);
+
+        for (auto const* maps : {&bfmgr->getInnerMaps(), &bfmgr->getOuterMaps()}) {
+            for (auto const& m : *maps) {
+                auto const* grid = dynamic_cast<BFGridMap const*>(m.get());
+                if (!grid) {
+                    continue;
+                }
+                std::vector<XYZVec> points = makePoints(*grid, engine);
+
+                double tScalar(0.), tBatch(0.);
+                for (unsigned irep = 0; irep != nRepeat_; ++irep) {
+                    auto t0 = Clock::now();
+                    for (size_t i = 0; i != points.size(); ++i) {
+                        CLHEP::Hep3Vector b;
+                        if (!grid->getBFieldWithStatus(
+                                CLHEP::Hep3Vector(points[i].x(), points[i].y(), points[i].z()),
+                                b)) {
+                            b = CLHEP::Hep3Vector();
+                        }
+                        scalar[i] = b;
+                    }
+                    auto t1 = Clock::now();
+                    grid->getBField(points, batch);
+                    auto t2 = Clock::now();
+                    if (irep == 0 || seconds(t0, t1) < tScalar) {
+                        tScalar = seconds(t0, t1);
+                    }
+                    if (irep == 0 || seconds(t1, t2) < tBatch) {
+                        tBatch = seconds(t1, t2);
+                    }
+                }
+                report(grid->getKey(), points, tScalar, tBatch, scalar, batch);
+            }
+        }
+
+        // The manager as a whole, including the map lookup: walk inside the outermost map.
+        if (!bfmgr->getOuterMaps().empty()) {
+            std::vector<XYZVec> points = makePoints(*bfmgr->getOuterMaps().back(), engine);
+            BFCacheManager cm = bfmgr->cacheManager();
+
+            double tScalar(0.), tBatch(0.);
+            for (unsigned irep = 0; irep != nRepeat_; ++irep) {
+                auto t0 = Clock::now();
+                for (size_t i = 0; i != points.size(); ++i) {
+                    scalar[i] = bfmgr->getBField(
+                        CLHEP::Hep3Vector(points[i].x(), points[i].y(), points[i].z()), cm);
+                }
+                auto t1 = Clock::now();
+                bfmgr->getBField(points.data(), batch.data(), points.size(), cm);
+                auto t2 = Clock::now();
+                if (irep == 0 || seconds(t0, t1) < tScalar) {
+                    tScalar = seconds(t0, t1);
+                }
+                if (irep == 0 || seconds(t1, t2) < tBatch) {
+                    tBatch = seconds(t1, t2);
+                }
+            }
+            report("BFieldManager", points, tScalar, tBatch, scalar, batch);
+        }
+    }
+
+}  // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::BFieldBatchBench);
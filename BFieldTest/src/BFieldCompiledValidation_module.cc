@@ -0,0 +1,187 @@
+//
+// Validate the compiled interpolation styles against the reference interpolation.
+//
+// For each selected grid map the module makes a copy of the map with the other
+// member of the pair trilinear/trilinearCompiled or meco/mecoCompiled, compiles it
+// in each requested precision, and evaluates both at random points inside the map.
+// It prints, for each map and precision:
+//   - the largest difference |dB| between the two, in Tesla, and where it occurs
+//   - the number of points where only one of the two returned a valid field
+//   - the time per point of each
+//   - the memory used by the precomputed coefficients
+//
+// The reference trilinear interpolation reads past the end of the grid in the last
+// layer of cells; those points are counted but excluded from the largest difference.
+//
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+
+#include "BFieldGeom/inc/BFGridMap.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+    class BFieldCompiledValidation : public art::EDAnalyzer {
+       public:
+        explicit BFieldCompiledValidation(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run);
+        void analyze(const art::Event&){};
+
+       private:
+        std::vector<std::string> mapKeys_;
+        unsigned nPoints_;
+        bool testDouble_;
+        bool testFloat_;
+        unsigned seed_;
+
+        void validate(BFGridMap const& map, bool useFloat, std::mt19937_64& engine) const;
+    };
+
+    BFieldCompiledValidation::BFieldCompiledValidation(const fhicl::ParameterSet& pset)
+        : art::EDAnalyzer(pset),
+          mapKeys_(pset.get<std::vector<std::string>>("mapKeys", {})),
+          nPoints_(pset.get<unsigned>("nPoints", 1000000)),
+          testDouble_(pset.get<bool>("testDouble", true)),
+          testFloat_(pset.get<bool>("testFloat", true)),
+          seed_(pset.get<unsigned>("seed", 2468)) {}
+
+    void BFieldCompiledValidation::validate(BFGridMap const& map,
+                                            bool useFloat,
+                                            std::mt19937_64& engine) const {
+        // The map as configured is one side of the comparison; a copy is the other.
+        const BFInterpolationStyle style = map.interpolationStyle();
+        BFInterpolationStyle other(BFInterpolationStyle::unknown);
+        if (style == BFInterpolationStyle::trilinear) {
+            other = BFInterpolationStyle::trilinearCompiled;
+        } else if (style == BFInterpolationStyle::meco) {
+            other = BFInterpolationStyle::mecoCompiled;
+        } else if (style == BFInterpolationStyle::trilinearCompiled) {
+            other = BFInterpolationStyle::trilinear;
+        } else if (style == BFInterpolationStyle::mecoCompiled) {
+            other = BFInterpolationStyle::meco;
+        } else {
+            std::printf("%-24s interpolation style %s has no compiled form\n",
+                        map.getKey().c_str(), style.name().c_str());
+            return;
+        }
+        const bool configuredIsCompiled = style == BFInterpolationStyle::trilinearCompiled ||
+                                          style == BFInterpolationStyle::mecoCompiled;
+
+        // The map in the geometry is compiled in the precision of the job configuration,
+        // so always compile a fresh copy for the side that is compiled.
+        BFGridMap compiledMap(map);
+        BFGridMap referenceMap(map);
+        compiledMap.setInterpolationStyle(configuredIsCompiled ? style : other);
+        compiledMap.compile(useFloat);
+        referenceMap.setInterpolationStyle(configuredIsCompiled ? other : style);
+        const bool linear = compiledMap.interpolationStyle() ==
+                            BFInterpolationStyle::trilinearCompiled;
+
+        // Random points inside the map.  Maps that start at y >= 0 are usually reflected
+        // about y=0, so cover negative y as well.
+        std::uniform_real_distribution<double> flat(0., 1.);
+        const double ylo = map.ymin() >= 0. ? -map.ymax() : map.ymin();
+        std::vector<CLHEP::Hep3Vector> points;
+        points.reserve(nPoints_);
+        for (unsigned i = 0; i != nPoints_; ++i) {
+            points.emplace_back(map.xmin() + flat(engine) * (map.xmax() - map.xmin()),
+                                ylo + flat(engine) * (map.ymax() - ylo),
+                                map.zmin() + flat(engine) * (map.zmax() - map.zmin()));
+        }
+
+        typedef std::chrono::high_resolution_clock Clock;
+        std::vector<CLHEP::Hep3Vector> bref(points.size()), bcomp(points.size());
+        std::vector<char> sref(points.size()), scomp(points.size());
+        auto t0 = Clock::now();
+        for (size_t i = 0; i != points.size(); ++i) {
+            sref[i] = referenceMap.getBFieldWithStatus(points[i], bref[i]);
+        }
+        auto t1 = Clock::now();
+        for (size_t i = 0; i != points.size(); ++i) {
+            scomp[i] = compiledMap.getBFieldWithStatus(points[i], bcomp[i]);
+        }
+        auto t2 = Clock::now();
+
+        double maxdiff(0.);
+        CLHEP::Hep3Vector where;
+        unsigned statusMismatch(0), lastLayer(0);
+        for (size_t i = 0; i != points.size(); ++i) {
+            if (sref[i] != scomp[i]) {
+                ++statusMismatch;
+                continue;
+            }
+            if (!sref[i]) {
+                continue;
+            }
+            if (linear) {
+                const double fx = (points[i].x() - map.xmin()) / map.dx();
+                const double fy = (std::abs(points[i].y()) - map.ymin()) / map.dy();
+                const double fz = (points[i].z() - map.zmin()) / map.dz();
+                if (fx >= map.nx() - 1 || fy >= map.ny() - 1 || fz >= map.nz() - 1) {
+                    ++lastLayer;
+                    continue;
+                }
+            }
+            const double d = (bref[i] - bcomp[i]).mag();
+            if (d > maxdiff) {
+                maxdiff = d;
+                where = points[i];
+            }
+        }
+
+        const double n = points.size();
+        std::printf("%-24s %-6s %12.3g (%9.1f,%9.1f,%9.1f) %9u %9u %10.1f %10.1f %10.1f\n",
+                    map.getKey().c_str(), useFloat ? "float" : "double", maxdiff, where.x(),
+                    where.y(), where.z(), statusMismatch, lastLayer,
+                    1e9 * std::chrono::duration<double>(t1 - t0).count() / n,
+                    1e9 * std::chrono::duration<double>(t2 - t1).count() / n,
+                    compiledMap.compiledSizeInBytes() / 1048576.);
+    }
+
+    void BFieldCompiledValidation::beginRun(const art::Run& run) {
+        GeomHandle<BFieldManager> bfmgr;
+        std::mt19937_64 engine(seed_);
+
+        std::printf("BFieldCompiledValidation: %u points per map\n", nPoints_);
+        std::printf("%-24s %-6s %12s %31s %9s %9s %10s %10s %10s\n", "map", "prec",
+                    "max |dB| (T)", "at (mm)", "status", "lastcell", "ns/pt ref", "ns/pt comp",
+                    "MB");
+
+        for (auto const* maps : {&bfmgr->getInnerMaps(), &bfmgr->getOuterMaps()}) {
+            for (auto const& m : *maps) {
+                auto const* grid = dynamic_cast<BFGridMap const*>(m.get());
+                if (!grid) {
+                    continue;
+                }
+                if (!mapKeys_.empty() && std::find(mapKeys_.begin(), mapKeys_.end(),
+                                                   grid->getKey()) == mapKeys_.end()) {
+                    continue;
+                }
+                if (testDouble_) {
+                    validate(*grid, false, engine);
+                }
+                if (testFloat_) {
+                    validate(*grid, true, engine);
+                }
+            }
+        }
+    }
+
+}  // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::BFieldCompiledValidation);
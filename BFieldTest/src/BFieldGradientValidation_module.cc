@@ -0,0 +1,226 @@
+//
+// Validate the field gradients of the grid maps against finite differences.
+//
+// For each selected grid map, and for each interpolation style of the pair
+// trilinear/trilinearCompiled or meco/mecoCompiled that the map uses (the compiled
+// style in each requested precision), the module evaluates getBFieldWithGradient at
+// random points inside the map and compares with:
+//   - the field from getBFieldWithStatus
+//   - central differences of getBFieldWithStatus, with a step that is a fraction of
+//     the grid spacing
+// The interpolating polynomials are at most quadratic along each axis, so central
+// differences are exact up to round off as long as both points of the difference
+// use the same polynomial and are inside the map; points where they are not are
+// counted and excluded.  So are points in the last layer of cells for the
+// trilinear styles, where the reference interpolation reads past the end of the grid.
+// It prints, for each map and style:
+//   - the largest difference |dB| of the field, in Tesla
+//   - the largest difference of the gradient, in Tesla/mm, and where it occurs
+//   - the largest gradient seen, for scale
+//   - the number of excluded points
+//   - the time per point of the gradient query and of the 7 lookups of the differences
+//
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+
+#include "BFieldGeom/inc/BFGridMap.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+    class BFieldGradientValidation : public art::EDAnalyzer {
+       public:
+        explicit BFieldGradientValidation(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run);
+        void analyze(const art::Event&){};
+
+       private:
+        std::vector<std::string> mapKeys_;
+        unsigned nPoints_;
+        double stepFraction_;
+        bool testDouble_;
+        bool testFloat_;
+        unsigned seed_;
+
+        void validate(BFGridMap const& map, std::string const& label, std::mt19937_64& engine)
+            const;
+    };
+
+    BFieldGradientValidation::BFieldGradientValidation(const fhicl::ParameterSet& pset)
+        : art::EDAnalyzer(pset),
+          mapKeys_(pset.get<std::vector<std::string>>("mapKeys", {})),
+          nPoints_(pset.get<unsigned>("nPoints", 100000)),
+          stepFraction_(pset.get<double>("stepFraction", 0.01)),
+          testDouble_(pset.get<bool>("testDouble", true)),
+          testFloat_(pset.get<bool>("testFloat", true)),
+          seed_(pset.get<unsigned>("seed", 1357)) {}
+
+    void BFieldGradientValidation::validate(BFGridMap const& map,
+                                            std::string const& label,
+                                            std::mt19937_64& engine) const {
+        const BFInterpolationStyle style = map.interpolationStyle();
+        const bool quadratic = style == BFInterpolationStyle::meco ||
+                               style == BFInterpolationStyle::mecoCompiled;
+        const double h[3] = {stepFraction_ * map.dx(), stepFraction_ * map.dy(),
+                             stepFraction_ * map.dz()};
+        const double lo[3] = {map.xmin(), map.ymin(), map.zmin()};
+        const double d[3] = {map.dx(), map.dy(), map.dz()};
+        const int n[3] = {map.nx(), map.ny(), map.nz()};
+
+        // The polynomial used along one axis: the cell for the trilinear styles, the
+        // (clamped) nearest grid point for the quadratic ones.
+        auto cell = [&](double x, int j) {
+            const double f = (x - lo[j]) / d[j];
+            if (quadratic) {
+                return std::max(1, std::min(int(f + 0.5), n[j] - 2));
+            }
+            return std::min(int(std::floor(f)), n[j] - 2);
+        };
+
+        // Random points inside the map.  Maps that start at y >= 0 are usually reflected
+        // about y=0, so cover negative y as well.
+        std::uniform_real_distribution<double> flat(0., 1.);
+        const double ylo = map.ymin() >= 0. ? -map.ymax() : map.ymin();
+        std::vector<CLHEP::Hep3Vector> points;
+        points.reserve(nPoints_);
+        for (unsigned i = 0; i != nPoints_; ++i) {
+            points.emplace_back(map.xmin() + flat(engine) * (map.xmax() - map.xmin()),
+                                ylo + flat(engine) * (map.ymax() - ylo),
+                                map.zmin() + flat(engine) * (map.zmax() - map.zmin()));
+        }
+
+        typedef std::chrono::high_resolution_clock Clock;
+        std::vector<CLHEP::Hep3Vector> bgrad(points.size()), grad(3 * points.size());
+        std::vector<CLHEP::Hep3Vector> bref(points.size()), fd(3 * points.size());
+        std::vector<char> sgrad(points.size()), sref(points.size()), sfd(points.size());
+        auto t0 = Clock::now();
+        for (size_t i = 0; i != points.size(); ++i) {
+            sgrad[i] = map.getBFieldWithGradient(points[i], bgrad[i], &grad[3 * i]);
+        }
+        auto t1 = Clock::now();
+        for (size_t i = 0; i != points.size(); ++i) {
+            sref[i] = map.getBFieldWithStatus(points[i], bref[i]);
+            sfd[i] = true;
+            for (int j = 0; j != 3; ++j) {
+                CLHEP::Hep3Vector step(0., 0., 0.), bplus, bminus;
+                step[j] = h[j];
+                sfd[i] = map.getBFieldWithStatus(points[i] + step, bplus) && sfd[i];
+                sfd[i] = map.getBFieldWithStatus(points[i] - step, bminus) && sfd[i];
+                fd[3 * i + j] = (bplus - bminus) / (2. * h[j]);
+            }
+        }
+        auto t2 = Clock::now();
+
+        double maxdB(0.), maxdG(0.), maxG(0.);
+        CLHEP::Hep3Vector where;
+        unsigned statusMismatch(0), excluded(0);
+        for (size_t i = 0; i != points.size(); ++i) {
+            if (sgrad[i] != sref[i]) {
+                ++statusMismatch;
+                continue;
+            }
+            if (!sref[i]) {
+                continue;
+            }
+
+            bool same(sfd[i]), lastLayer(false);
+            for (int j = 0; j != 3; ++j) {
+                const double x = j == 1 ? std::abs(points[i][j]) : points[i][j];
+                same = same && cell(x - h[j], j) == cell(x + h[j], j) &&
+                       (j != 1 || std::abs(points[i][j]) > h[j]);
+                lastLayer = lastLayer || (!quadratic && (x + h[j] - lo[j]) / d[j] >= n[j] - 1);
+            }
+            if (!same || lastLayer) {
+                ++excluded;
+                continue;
+            }
+            maxdB = std::max(maxdB, (bgrad[i] - bref[i]).mag());
+            for (int j = 0; j != 3; ++j) {
+                maxG = std::max(maxG, grad[3 * i + j].mag());
+                const double dG = (grad[3 * i + j] - fd[3 * i + j]).mag();
+                if (dG > maxdG) {
+                    maxdG = dG;
+                    where = points[i];
+                }
+            }
+        }
+
+        const double np = points.size();
+        std::printf(
+            "%-24s %-20s %10.3g %10.3g (%9.1f,%9.1f,%9.1f) %10.3g %8u %8u %9.1f %9.1f\n",
+            map.getKey().c_str(), label.c_str(), maxdB, maxdG, where.x(), where.y(), where.z(),
+            maxG, statusMismatch, excluded,
+            1e9 * std::chrono::duration<double>(t1 - t0).count() / np,
+            1e9 * std::chrono::duration<double>(t2 - t1).count() / np);
+    }
+
+    void BFieldGradientValidation::beginRun(const art::Run& run) {
+        GeomHandle<BFieldManager> bfmgr;
+        std::mt19937_64 engine(seed_);
+
+        std::printf("BFieldGradientValidation: %u points per map, step %g of the grid spacing\n",
+                    nPoints_, stepFraction_);
+        std::printf("%-24s %-20s %10s %10s %31s %10s %8s %8s %9s %9s\n", "map", "style",
+                    "|dB| (T)", "|dG| (T/mm)", "at (mm)", "max |G|", "status", "excluded",
+                    "ns/pt", "ns/pt fd");
+
+        for (auto const* maps : {&bfmgr->getInnerMaps(), &bfmgr->getOuterMaps()}) {
+            for (auto const& m : *maps) {
+                auto const* grid = dynamic_cast<BFGridMap const*>(m.get());
+                if (!grid) {
+                    continue;
+                }
+                if (!mapKeys_.empty() && std::find(mapKeys_.begin(), mapKeys_.end(),
+                                                   grid->getKey()) == mapKeys_.end()) {
+                    continue;
+                }
+
+                const BFInterpolationStyle style = grid->interpolationStyle();
+                BFInterpolationStyle reference(style), compiled(style);
+                if (style == BFInterpolationStyle::trilinear ||
+                    style == BFInterpolationStyle::trilinearCompiled) {
+                    reference = BFInterpolationStyle::trilinear;
+                    compiled = BFInterpolationStyle::trilinearCompiled;
+                } else if (style == BFInterpolationStyle::meco ||
+                           style == BFInterpolationStyle::mecoCompiled) {
+                    reference = BFInterpolationStyle::meco;
+                    compiled = BFInterpolationStyle::mecoCompiled;
+                } else {
+                    std::printf("%-24s interpolation style %s is not supported\n",
+                                grid->getKey().c_str(), style.name().c_str());
+                    continue;
+                }
+
+                BFGridMap copy(*grid);
+                copy.setInterpolationStyle(reference);
+                validate(copy, reference.name(), engine);
+                for (bool useFloat : {false, true}) {
+                    if ((useFloat && !testFloat_) || (!useFloat && !testDouble_)) {
+                        continue;
+                    }
+                    copy.setInterpolationStyle(compiled);
+                    copy.compile(useFloat);
+                    validate(copy, compiled.name() + (useFloat ? "/float" : "/double"), engine);
+                }
+            }
+        }
+    }
+
+}  // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::BFieldGradientValidation);
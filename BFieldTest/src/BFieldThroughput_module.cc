@@ -0,0 +1,185 @@
+//
+// Measure the throughput of magnetic field queries as a function of the number of threads.
+//
+// In beginRun the module generates a set of pseudo-trajectories: short straight segments
+// with small random kinks, so that consecutive points are close together as they are in
+// Geant4 stepping or in track extrapolation.  It then queries the field at every point
+// with 1, 2, ... threads and prints the number of queries per second and the speedup
+// relative to one thread.
+//
+// Two lookup modes are measured:
+//   cached   - each thread owns a BFCacheManager obtained from BFieldManager::cacheManager()
+//   uncached - the stateless BFieldManager::getBFieldWithStatus(point, result)
+//
+// The sum of the field values is used as a checksum; it must not depend on the number
+// of threads or on the lookup mode.
+//
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "cetlib_except/exception.h"
+
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace mu2e {
+
+    class BFieldThroughput : public art::EDAnalyzer {
+       public:
+        explicit BFieldThroughput(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run);
+        void analyze(const art::Event&){};
+
+       private:
+        std::vector<double> boxMin_;
+        std::vector<double> boxMax_;
+        unsigned nTracks_;
+        unsigned pointsPerTrack_;
+        double stepSize_;
+        unsigned nRepeat_;
+        std::vector<unsigned> nThreads_;
+        unsigned seed_;
+
+        // Each inner vector is one pseudo-trajectory.
+        std::vector<std::vector<CLHEP::Hep3Vector>> tracks_;
+
+        void makeTracks();
+
+        // Returns the wall time in seconds; sum is the checksum.
+        double run(BFieldManager const& bfmgr, unsigned nThreads, bool cached, double& sum) const;
+    };
+
+    BFieldThroughput::BFieldThroughput(const fhicl::ParameterSet& pset)
+        : art::EDAnalyzer(pset),
+          boxMin_(pset.get<std::vector<double>>("boxMin")),
+          boxMax_(pset.get<std::vector<double>>("boxMax")),
+          nTracks_(pset.get<unsigned>("nTracks", 2000)),
+          pointsPerTrack_(pset.get<unsigned>("pointsPerTrack", 1000)),
+          stepSize_(pset.get<double>("stepSize", 10.)),
+          nRepeat_(pset.get<unsigned>("nRepeat", 3)),
+          nThreads_(pset.get<std::vector<unsigned>>("nThreads", {1, 2, 4, 8})),
+          seed_(pset.get<unsigned>("seed", 12345)) {
+        if (boxMin_.size() != 3 || boxMax_.size() != 3) {
+            throw cet::exception("BFIELDTEST")
+                << "BFieldThroughput: boxMin and boxMax must have 3 elements each.\n";
+        }
+        if (nThreads_.empty()) {
+            throw cet::exception("BFIELDTEST")
+                << "BFieldThroughput: nThreads must not be empty.\n";
+        }
+    }
+
+    void BFieldThroughput::makeTracks() {
+        std::mt19937_64 engine(seed_);
+        std::uniform_real_distribution<double> flat(0., 1.);
+        std::normal_distribution<double> kink(0., 0.05);
+
+        tracks_.assign(nTracks_, std::vector<CLHEP::Hep3Vector>());
+        for (auto& track : tracks_) {
+            track.reserve(pointsPerTrack_);
+            CLHEP::Hep3Vector pos(boxMin_[0] + flat(engine) * (boxMax_[0] - boxMin_[0]),
+                                  boxMin_[1] + flat(engine) * (boxMax_[1] - boxMin_[1]),
+                                  boxMin_[2] + flat(engine) * (boxMax_[2] - boxMin_[2]));
+            const double cost = 2. * flat(engine) - 1.;
+            const double phi = 2. * M_PI * flat(engine);
+            const double sint = std::sqrt(1. - cost * cost);
+            CLHEP::Hep3Vector dir(sint * std::cos(phi), sint * std::sin(phi), cost);
+            for (unsigned i = 0; i != pointsPerTrack_; ++i) {
+                track.push_back(pos);
+                dir += CLHEP::Hep3Vector(kink(engine), kink(engine), kink(engine));
+                dir.setMag(1.);
+                pos += stepSize_ * dir;
+            }
+        }
+    }
+
+    double BFieldThroughput::run(BFieldManager const& bfmgr,
+                                 unsigned nThreads,
+                                 bool cached,
+                                 double& sum) const {
+        // One cache manager and one partial sum per thread.
+        tbb::enumerable_thread_specific<BFCacheManager> caches(
+            [&bfmgr]() { return bfmgr.cacheManager(); });
+        tbb::enumerable_thread_specific<double> sums(0.);
+
+        tbb::task_arena arena(nThreads);
+        auto start = std::chrono::high_resolution_clock::now();
+        arena.execute([&]() {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, tracks_.size()),
+                              [&](tbb::blocked_range<size_t> const& r) {
+                                  BFCacheManager const& cm = caches.local();
+                                  double& s = sums.local();
+                                  CLHEP::Hep3Vector b;
+                                  for (size_t it = r.begin(); it != r.end(); ++it) {
+                                      for (auto const& pos : tracks_[it]) {
+                                          if (cached) {
+                                              bfmgr.getBFieldWithStatus(pos, cm, b);
+                                          } else {
+                                              bfmgr.getBFieldWithStatus(pos, b);
+                                          }
+                                          s += b.x() + b.y() + b.z();
+                                      }
+                                  }
+                              });
+        });
+        auto end = std::chrono::high_resolution_clock::now();
+
+        // The order in which the partial sums are combined depends on the scheduling,
+        // so expect round off differences in the last digits of the checksum.
+        sum = sums.combine([](double a, double b) { return a + b; });
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    void BFieldThroughput::beginRun(const art::Run& run) {
+        GeomHandle<BFieldManager> bfmgr;
+        bfmgr->mapIndex().print(std::cout);
+
+        makeTracks();
+        const double nQueries = double(nTracks_) * pointsPerTrack_;
+
+        std::cout << "BFieldThroughput: " << nTracks_ << " tracks x " << pointsPerTrack_
+                  << " points, best of " << nRepeat_ << " repetitions" << std::endl;
+        std::printf("%-10s %8s %14s %10s %20s\n", "mode", "threads", "queries/s", "speedup",
+                    "checksum");
+
+        for (bool cached : {true, false}) {
+            double reference(0.);
+            for (unsigned nt : nThreads_) {
+                double best(0.);
+                double sum(0.);
+                for (unsigned irep = 0; irep != nRepeat_; ++irep) {
+                    double t = run(*bfmgr, nt, cached, sum);
+                    if (irep == 0 || t < best) {
+                        best = t;
+                    }
+                }
+                const double rate = best > 0. ? nQueries / best : 0.;
+                if (reference == 0.) {
+                    reference = rate;
+                }
+                std::printf("%-10s %8u %14.4g %10.2f %20.10g\n", cached ? "cached" : "uncached",
+                            nt, rate, reference > 0. ? rate / reference : 0., sum);
+            }
+        }
+    }
+
+}  // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::BFieldThroughput);
@@ -0,0 +1,59 @@
+#ifndef CrvGumbelFitter_h
+#define CrvGumbelFitter_h
+
+//Least-squares fit of one or two Gumbel functions
+//  f(t) = sum_k A_k*exp(-(t-mu_k)/beta_k-exp(-(t-mu_k)/beta_k)),  parameters A_k, mu_k, beta_k
+//directly to the ADC samples of a CRV waveform, without TGraph/TF1 and the ROOT fitter.
+//The model, parameter limits and fit range are set like for the TF1s of MakeCrvRecoPulses.
+//
+//The starting values of a Gumbel function whose starting time is at a local maximum of the waveform
+//are estimated from a parabola through the logarithms of the three largest samples
+//(the peak of ln(f) is at mu with ln(A)-1 and the curvature -1/beta^2).
+//They are followed by a fixed maximum number of damped Gauss-Newton iterations with analytic derivatives.
+
+#include <vector>
+
+namespace mu2eCrv
+{
+
+class CrvGumbelFitter
+{
+  public:
+  static const int maxGumbels=2;
+
+  explicit CrvGumbelFitter(int nGumbels, int maxIterations=15);
+
+  void   SetParameter(int i, double value)               {_par[i]=value;}
+  void   SetParLimits(int i, double lower, double upper) {_lower[i]=lower; _upper[i]=upper;}
+  void   SetRange(double xmin, double xmax)              {_xmin=xmin; _xmax=xmax;}
+
+  //fits the samples with times (startTDC+bin)*digitizationPeriod inside the range
+  void   Fit(const std::vector<unsigned int> &waveform, unsigned int startTDC, float digitizationPeriod, float pedestal);
+
+  double Parameter(int i) const    {return _par[i];}
+  double Eval(double t) const;
+  int    GetNumberFitPoints() const {return _t.size();}
+  //sum of (y-f)^2/f over the fit range, as MakeCrvRecoPulses::Chi2
+  double Chi2() const              {return _chi2;}
+  //fit didn't converge, or a parameter is within 1% of its limits (same criterion as for the ROOT fit)
+  bool   FailedFit(int paramStart, int paramEnd) const;
+
+  private:
+  CrvGumbelFitter();
+  double SumOfSquares(const double *par) const;
+  void   EstimateParameters(int k);
+
+  int    _nGumbels, _nPar;
+  int    _maxIterations;
+  double _par[3*maxGumbels];
+  double _lower[3*maxGumbels], _upper[3*maxGumbels];
+  double _xmin, _xmax;
+  bool   _valid;
+  double _chi2;
+
+  std::vector<double> _t, _y;  //samples inside the fit range
+};
+
+}
+
+#endif
@@ -87,6 +87,21 @@ struct LookupBin
   void Read(std::ifstream &lookupfile, const unsigned int &i);
 };
 
+//the LookupBins of one table stored in contiguous arrays.
+//the arrays are part of the flat lookup table image, which is either
+//built from a lookup table file or memory-mapped from a flat lookup table file.
+struct LookupBinTable
+{
+  unsigned int         nBins;
+  const float         *arrivalProbability;
+  const unsigned int  *probabilityScaleTimeDelays;
+  const unsigned int  *probabilityScaleFiberEmissions;
+  const unsigned int  *timeDelaysOffset;       //nBins+1 entries: the time delays of bin i are
+  const unsigned int  *fiberEmissionsOffset;   //timeDelays[timeDelaysOffset[i]...timeDelaysOffset[i+1]-1]
+  const unsigned char *timeDelays;
+  const unsigned char *fiberEmissions;
+};
+
 
 
 class MakeCrvPhotons
@@ -94,13 +109,20 @@ class MakeCrvPhotons
   public:
 
     MakeCrvPhotons(CLHEP::RandFlat &randFlat, CLHEP::RandGaussQ &randGaussQ, CLHEP::RandPoissonQ &randPoissonQ) : 
+                                                      _mappedImage(NULL), _mappedSize(0),
                                                       _randFlat(randFlat), _randGaussQ(randGaussQ), _randPoissonQ(randPoissonQ) {}
 
     ~MakeCrvPhotons();
+    MakeCrvPhotons(const MakeCrvPhotons &) = delete;
+    MakeCrvPhotons &operator=(const MakeCrvPhotons &) = delete;
 
     const std::string         &GetFileName() const {return _fileName;}
 
+    //reads a lookup table file, or maps a flat lookup table file (which is recognized by its first bytes)
+    //so that all processes on a node share one copy of the table
     void                      LoadLookupTable(const std::string &filename);
+    void                      WriteFlatLookupTable(const std::string &filename) const;
+    bool                      IsMapped() const {return _mappedImage!=NULL;}
     void                      MakePhotons(const CLHEP::Hep3Vector &stepStart,   //they need to be points
                                       const CLHEP::Hep3Vector &stepEnd,         //local to the CRV bar
                                       double timeStart, double timeEnd,
@@ -123,7 +145,16 @@ class MakeCrvPhotons
     LookupConstants           _LC;
     LookupCerenkov            _LCerenkov;
     LookupBinDefinitions      _LBD;
-    std::vector<LookupBin>    _bins[3];   //scintillation in scintillator (0), Cerenkov in scintillator (1), Cerenkov in fiber (2)
+    LookupBinTable            _tables[3];   //scintillation in scintillator (0), Cerenkov in scintillator (1), Cerenkov in fiber (2)
+
+    std::vector<char>         _image;       //flat lookup table image, if it was built from a lookup table file
+    void                     *_mappedImage; //flat lookup table image, if it was mapped from a flat lookup table file
+    size_t                    _mappedSize;
+    const char               *ImageData() const {return _mappedImage!=NULL ? static_cast<const char*>(_mappedImage) : _image.data();}
+    size_t                    ImageSize() const {return _mappedImage!=NULL ? _mappedSize : _image.size();}
+    void                      ReadLookupTable(const std::string &filename);
+    void                      MapFlatLookupTable(const std::string &filename);
+    void                      ReadImage();
 
     CLHEP::RandFlat           &_randFlat;
     CLHEP::RandGaussQ         &_randGaussQ;
@@ -131,8 +162,8 @@ class MakeCrvPhotons
 
     bool   IsInsideScintillator(const CLHEP::Hep3Vector &p);
     bool   IsInsideFiber(const CLHEP::Hep3Vector &p, const CLHEP::Hep3Vector &dir, double &r, double &phi);
-    double GetRandomTime(const LookupBin *theBin);
-    int    GetRandomFiberEmissions(const LookupBin *theBin);
+    double GetRandomTime(const LookupBinTable &table, unsigned int bin);
+    int    GetRandomFiberEmissions(const LookupBinTable &table, unsigned int bin);
     double GetAverageNumberOfCerenkovPhotons(double beta, double charge, std::map<double,double> &photons);
     int    GetNumberOfPhotonsFromAverage(double average, int nSteps);
 
@@ -1,6 +1,8 @@
 #ifndef MakeCrvRecoPulses_h
 #define MakeCrvRecoPulses_h
 
+#include "CRVResponse/inc/CrvGumbelFitter.hh"
+
 #include <vector>
 #include <TF1.h>
 #include <TGraph.h>
@@ -13,7 +15,8 @@ class MakeCrvRecoPulses
   public:
   MakeCrvRecoPulses(float minADCdifference, float defaultBeta, float minBeta, float maxBeta,
                     float maxTimeDifference, float minPulseHeightRatio, float maxPulseHeightRatio,
-                    float LEtimeFactor, bool allowDoubleGumbel, float doubleGumbelThreshold);
+                    float LEtimeFactor, bool allowDoubleGumbel, float doubleGumbelThreshold,
+                    bool fastGumbelFit=false);
   void         SetWaveform(const std::vector<unsigned int> &waveform, unsigned int startTDC, 
                            float digitizationPeriod, float pedestal, float calibrationFactor, 
                            float calibrationFactorPulseHeight);
@@ -29,15 +32,22 @@ class MakeCrvRecoPulses
 
   private:
   MakeCrvRecoPulses();
-  void FillGraphAndFindPeaks(const std::vector<unsigned int> &waveform, unsigned int startTDC,
-                             float digitizationPeriod, float pedestal,
-                             TGraph &g, std::vector<std::pair<size_t,size_t> > &peaks);
+  void FindPeaks(const std::vector<unsigned int> &waveform, float pedestal,
+                 std::vector<std::pair<size_t,size_t> > &peaks);
+  void FillGraph(const std::vector<unsigned int> &waveform, unsigned int startTDC,
+                 float digitizationPeriod, float pedestal, TGraph &g);
+  //Fitter is either the ROOT fit of _f1/_f2 or the CrvGumbelFitters _g1/_g2
+  template<class Fitter>
+  void FitPeaks(Fitter &f1, Fitter &f2, const std::vector<unsigned int> &waveform,
+                unsigned int startTDC, float digitizationPeriod, float pedestal,
+                float calibrationFactor, float calibrationFactorPulseHeight,
+                const std::vector<std::pair<size_t,size_t> > &peaks);
   void RangeFinderNarrow(const std::vector<unsigned int> &waveform, const size_t peakStart, const size_t peakEnd, size_t &start, size_t &end);
   void RangeFinder(const std::vector<unsigned int> &waveform, const size_t peakStart, const size_t peakEnd, size_t &start, size_t &end);
-  bool FailedFit(TFitResultPtr fr, int paramStart, int paramEnd);
-  double Chi2(TF1 &f, const TGraph &g);
 
   TF1    _f1, _f2;
+  CrvGumbelFitter _g1, _g2;
+  bool   _fastGumbelFit;
   float  _minADCdifference;
   float  _defaultBeta;
   float  _minBeta, _maxBeta;
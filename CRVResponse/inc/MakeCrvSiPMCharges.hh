@@ -98,11 +98,50 @@ namespace mu2eCrv
     TFile *_photonMapFile;
     TH2F  *_photonMap;
 
+    //batched simulation: the photon map is sampled with an alias table,
+    //the pixels are flat arrays indexed by x*_nPixelsY+y (O(1) lookups of inactive pixels and discharge times),
+    //and the random numbers are drawn in blocks
+    struct BatchedCharge
+    {
+      double _time;
+      long   _order;        //charges with equal times are processed in the same order as in _scheduledCharges
+      int    _pixel;
+      size_t _photonIndex;
+      bool   _darkNoise;
+      bool operator>(const BatchedCharge &r) const {return _time>r._time || (_time==r._time && _order>r._order);}
+    };
+
+    bool                      _batched;
+    std::vector<double>       _aliasProbability;     //alias table of the photon map bins
+    std::vector<unsigned int> _aliasIndex;
+    std::vector<double>       _aliasBinLowX, _aliasBinWidthX, _aliasBinLowY, _aliasBinWidthY;
+    bool                      _photonMapFitsPixels;
+    std::vector<char>         _inactivePixelMap;
+    std::vector<double>       _pixelDischargeTimes;  //NAN for fully charged pixels
+    std::vector<int>          _dischargedPixels;     //pixels which need to be recharged for the next SiPM
+    std::vector<BatchedCharge> _chargeQueue;         //min-heap
+    long                      _chargeOrder;
+    std::vector<double>       _uniforms;             //block of uniforms, the first _nUniforms are drawn
+    size_t                    _nextUniform, _nUniforms;
+    size_t                    _uniformBlockSize;     //size of the next block
+    double                    _trapType0ProductionProb, _trapType1ProductionProb;
+    double                    _crossTalkProductionProbSinglePixel;
+
+    void   BuildAliasTable();
+    double NextUniform();
+    int    FindFiberPhotonsPixelBatched();
+    void   ScheduleChargeBatched(int pixel, double time, size_t photonIndex, bool darkNoise, bool crossTalk);
+    double GenerateAvalancheBatched(int pixel, double time, size_t photonIndex, bool darkNoise);
+    void   SimulateBatched(const std::vector<std::pair<double,size_t> > &photons,
+                           std::vector<SiPMresponse> &SiPMresponseVector, double startTime, double endTime);
+
     public:
 
     MakeCrvSiPMCharges(CLHEP::RandFlat &randFlat, CLHEP::RandPoissonQ &randPoissonQ, const std::string &photonMapFileName);
     ~MakeCrvSiPMCharges() {_photonMapFile->Close();}
 
+    void SetBatchedSimulation(bool batched) {_batched=batched;}
+
     void SetSiPMConstants(int nPixelsX, int nPixelsY, double overvoltage, double timeConstant, 
                           double capacitance, ProbabilitiesStruct probabilities,
                           const std::vector<std::pair<int,int> > &inactivePixels);
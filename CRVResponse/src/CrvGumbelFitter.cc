@@ -0,0 +1,230 @@
+#include "CRVResponse/inc/CrvGumbelFitter.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+  const int maxPar=3*mu2eCrv::CrvGumbelFitter::maxGumbels;
+
+  //in place Cholesky decomposition of the symmetric n x n matrix a (lower triangle)
+  bool Cholesky(double *a, int n)
+  {
+    for(int j=0; j<n; ++j)
+    {
+      double d=a[j*n+j];
+      for(int k=0; k<j; ++k) d-=a[j*n+k]*a[j*n+k];
+      if(!(d>0)) return false;
+      d=sqrt(d);
+      a[j*n+j]=d;
+      for(int i=j+1; i<n; ++i)
+      {
+        double s=a[i*n+j];
+        for(int k=0; k<j; ++k) s-=a[i*n+k]*a[j*n+k];
+        a[i*n+j]=s/d;
+      }
+    }
+    return true;
+  }
+
+  //solves L*L^T*x=b
+  void CholeskySolve(const double *l, int n, const double *b, double *x)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      double s=b[i];
+      for(int k=0; k<i; ++k) s-=l[i*n+k]*x[k];
+      x[i]=s/l[i*n+i];
+    }
+    for(int i=n-1; i>=0; --i)
+    {
+      double s=x[i];
+      for(int k=i+1; k<n; ++k) s-=l[k*n+i]*x[k];
+      x[i]=s/l[i*n+i];
+    }
+  }
+}
+
+namespace mu2eCrv
+{
+
+CrvGumbelFitter::CrvGumbelFitter(int nGumbels, int maxIterations) : _nGumbels(nGumbels), _nPar(3*nGumbels), _maxIterations(maxIterations),
+                                                                     _xmin(0), _xmax(0), _valid(false), _chi2(0)
+{
+  if(nGumbels<1 || nGumbels>maxGumbels) throw std::logic_error("CrvGumbelFitter: one or two Gumbel functions can be fitted.");
+  std::fill(_par,_par+maxPar,0);
+  std::fill(_lower,_lower+maxPar,0);
+  std::fill(_upper,_upper+maxPar,0);
+}
+
+double CrvGumbelFitter::Eval(double t) const
+{
+  double f=0;
+  for(int k=0; k<_nGumbels; ++k)
+  {
+    const double *p=_par+3*k;
+    double z=(t-p[1])/p[2];
+    f+=p[0]*exp(-z-exp(-z));
+  }
+  return f;
+}
+
+double CrvGumbelFitter::SumOfSquares(const double *par) const
+{
+  double s=0;
+  for(size_t i=0; i<_t.size(); ++i)
+  {
+    double f=0;
+    for(int k=0; k<_nGumbels; ++k)
+    {
+      const double *p=par+3*k;
+      double z=(_t[i]-p[1])/p[2];
+      f+=p[0]*exp(-z-exp(-z));
+    }
+    s+=(_y[i]-f)*(_y[i]-f);
+  }
+  return s;
+}
+
+void CrvGumbelFitter::EstimateParameters(int k)
+{
+  //sample closest to the starting time
+  double *p=_par+3*k;
+  size_t n=_t.size();
+  if(n<3) return;
+  size_t j=std::lower_bound(_t.begin(),_t.end(),p[1])-_t.begin();
+  if(j==n || (j>0 && p[1]-_t[j-1]<_t[j]-p[1])) --j;
+  if(j==0 || j==n-1) return;
+  if(_y[j]<_y[j-1] || _y[j]<_y[j+1] || _y[j-1]<=0 || _y[j+1]<=0) return;  //not at a local maximum
+
+  //parabola l(t)=l1+b*(t-t1)+c*(t-t1)^2 through the logarithms of the three samples
+  double h=_t[j+1]-_t[j];
+  double l0=log(_y[j-1]), l1=log(_y[j]), l2=log(_y[j+1]);
+  double b=(l2-l0)/(2.0*h);
+  double c=(l0-2.0*l1+l2)/(2.0*h*h);
+  if(!(c<0)) return;
+  double dt=-b/(2.0*c);
+  if(fabs(dt)>h) return;
+  p[0]=exp(l1-b*b/(4.0*c)+1.0);
+  p[1]=_t[j]+dt;
+  p[2]=1.0/sqrt(-2.0*c);
+}
+
+void CrvGumbelFitter::Fit(const std::vector<unsigned int> &waveform, unsigned int startTDC, float digitizationPeriod, float pedestal)
+{
+  _t.clear();
+  _y.clear();
+  for(size_t bin=0; bin<waveform.size(); ++bin)
+  {
+    double t=(startTDC+bin)*digitizationPeriod;   //same times as the points of the TGraph
+    if(t<_xmin || t>_xmax) continue;
+    _t.push_back(t);
+    _y.push_back(waveform[bin]-pedestal);
+  }
+
+  for(int k=0; k<_nGumbels; ++k) EstimateParameters(k);
+  for(int i=0; i<_nPar; ++i)
+  {
+    if(_lower[i]<_upper[i]) _par[i]=std::min(std::max(_par[i],_lower[i]),_upper[i]);
+  }
+
+  double alpha[maxPar*maxPar], beta[maxPar], work[maxPar*maxPar], delta[maxPar], trial[maxPar];
+  double grad[maxPar];
+  double s=SumOfSquares(_par);
+  double lambda=1e-3;
+  bool   positiveDefinite=false;
+  for(int iteration=0; iteration<_maxIterations; ++iteration)
+  {
+    //J^T*J and J^T*r with the analytic derivatives of the Gumbel functions
+    std::fill(alpha,alpha+_nPar*_nPar,0);
+    std::fill(beta,beta+_nPar,0);
+    for(size_t i=0; i<_t.size(); ++i)
+    {
+      double f=0;
+      for(int k=0; k<_nGumbels; ++k)
+      {
+        const double *p=_par+3*k;
+        double z=(_t[i]-p[1])/p[2];
+        double e=exp(-z);
+        double g=exp(-z-e);
+        double d=p[0]*g*(1.0-e)/p[2];
+        f+=p[0]*g;
+        grad[3*k]=g;
+        grad[3*k+1]=d;
+        grad[3*k+2]=d*z;
+      }
+      double r=_y[i]-f;
+      for(int a=0; a<_nPar; ++a)
+      {
+        beta[a]+=grad[a]*r;
+        for(int b=0; b<=a; ++b) alpha[a*_nPar+b]+=grad[a]*grad[b];
+      }
+    }
+    for(int a=0; a<_nPar; ++a)
+    {
+      for(int b=0; b<a; ++b) alpha[b*_nPar+a]=alpha[a*_nPar+b];
+    }
+
+    std::copy(alpha,alpha+_nPar*_nPar,work);
+    positiveDefinite=Cholesky(work,_nPar);
+    if(!positiveDefinite) break;
+
+    //damped step, the damping is increased until the sum of squares decreases
+    bool accepted=false;
+    while(!accepted && lambda<1e10)
+    {
+      std::copy(alpha,alpha+_nPar*_nPar,work);
+      for(int a=0; a<_nPar; ++a) work[a*_nPar+a]*=1.0+lambda;
+      if(!Cholesky(work,_nPar)) {lambda*=10; continue;}
+      CholeskySolve(work,_nPar,beta,delta);
+      for(int a=0; a<_nPar; ++a)
+      {
+        trial[a]=_par[a]+delta[a];
+        if(_lower[a]<_upper[a]) trial[a]=std::min(std::max(trial[a],_lower[a]),_upper[a]);
+      }
+      double sTrial=SumOfSquares(trial);
+      if(sTrial<=s)
+      {
+        accepted=true;
+        lambda=std::max(0.1*lambda,1e-10);
+        std::copy(trial,trial+_nPar,_par);
+        bool converged=(s-sTrial<=1e-9*s);
+        s=sTrial;
+        if(converged) iteration=_maxIterations;
+      }
+      else lambda*=10;
+    }
+    if(!accepted) break;
+  }
+
+  _valid=positiveDefinite && (int)_t.size()>=_nPar;
+  for(int i=0; i<_nPar; ++i) if(!std::isfinite(_par[i])) _valid=false;
+
+  //same chi2 as MakeCrvRecoPulses::Chi2
+  float chi2=0;
+  for(size_t i=0; i<_t.size(); ++i)
+  {
+    float fy=Eval(_t[i]);
+    chi2+=(_y[i]-fy)*(_y[i]-fy)/fy;
+  }
+  _chi2=chi2;
+}
+
+bool CrvGumbelFitter::FailedFit(int paramStart, int paramEnd) const
+{
+  if(!_valid) return true;
+
+  const double tolerance=0.01;
+  for(int i=paramStart; i<=paramEnd; ++i)
+  {
+    double v=_par[i];
+    double lower=_lower[i], upper=_upper[i];
+    if(!(lower<upper)) continue;
+    if((v-lower)/(upper-lower)<tolerance) return true;
+    if((upper-v)/(upper-lower)<tolerance) return true;
+  }
+  return false;
+}
+
+}
@@ -17,7 +17,7 @@
 #include "MCDataProducts/inc/CrvStep.hh"
 #include "MCDataProducts/inc/CrvPhotons.hh"
 #include "MCDataProducts/inc/ProtonBunchTimeMC.hh"
-#include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
+#include "Mu2eUtilities/inc/SimParticleTimeTable.hh"
 #include "SeedService/inc/SeedService.hh"
 
 #include "ProditionsService/inc/ProditionsHandle.hh"
@@ -127,7 +127,8 @@ namespace mu2e
     art::InputTag _protonBunchTimeMCTag;
     double      _microBunchPeriod;
 
-    SimParticleTimeOffset _timeOffsets;
+    std::vector<art::InputTag> _timeOffsetInputs;
+    SimParticleTimeTable _timeOffsets;
 
     CLHEP::HepRandomEngine& _engine;
     CLHEP::RandFlat       _randFlat;
@@ -154,7 +155,7 @@ namespace mu2e
     _crvStepMargin(conf().crvStepMargin()),
     _eventWindowMarkerTag(conf().eventWindowMarkerTag()),
     _protonBunchTimeMCTag(conf().protonBunchTimeMCTag()),
-    _timeOffsets(conf().timeOffsets()),
+    _timeOffsetInputs(conf().timeOffsets()),
     _engine{createEngine(art::ServiceHandle<SeedService>()->getSeed())},
     _randFlat(_engine),
     _randGaussQ(_engine),
@@ -224,7 +225,7 @@ namespace mu2e
 
   void CrvPhotonGenerator::produce(art::Event& event)
   {
-    _timeOffsets.updateMap(event);
+    _timeOffsets.fill(event,_timeOffsetInputs);
 
     _scintillationYieldsAdjusted.clear();
 
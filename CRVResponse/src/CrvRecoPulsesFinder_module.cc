@@ -60,6 +60,7 @@ namespace mu2e
       fhicl::Atom<bool> allowDoubleGumbel{Name("allowDoubleGumbel"), Comment("tries fitting with two Gumbel functions")};
       fhicl::Atom<float> doubleGumbelThreshold{Name("doubleGumbelThreshold"), Comment("Chi2/#ADCsamples (based on single Gumbel fit) at which a fit with two Gumbel functions should be attempted")};
       fhicl::Atom<float> minPEs{Name("minPEs"), Comment("minimum number of PEs")}; //0
+      fhicl::Atom<bool> fastGumbelFit{Name("fastGumbelFit"), Comment("fit the pulses with the analytic Gumbel fitter instead of the ROOT fitter"), false};
       fhicl::Atom<art::InputTag> protonBunchTimeTag{ Name("protonBunchTimeTag"), Comment("ProtonBunchTime producer"),"EWMProducer" };
     };
 
@@ -100,7 +101,8 @@ namespace mu2e
                                                                                                     conf().maxPulseHeightRatio(),
                                                                                                     conf().LEtimeFactor(),
                                                                                                     conf().allowDoubleGumbel(),
-                                                                                                    conf().doubleGumbelThreshold()));
+                                                                                                    conf().doubleGumbelThreshold(),
+                                                                                                    conf().fastGumbelFit()));
   }
 
   void CrvRecoPulsesFinder::beginJob()
@@ -0,0 +1,206 @@
+//
+// A module to validate the analytic Gumbel fitter of the CRV reco pulses against the ROOT fit.
+// Every waveform is reconstructed with both fitters. For the waveforms with the same number of pulses,
+// the module compares the pulse heights, pulse times and the integrals (PEs) of the pulses with valid fits,
+// and at the end of the job it prints these differences, the fraction of failed fits of each fitter
+// and the number of waveforms per second of both fitters.
+//
+
+#include "CRVResponse/inc/MakeCrvRecoPulses.hh"
+
+#include "ConditionsService/inc/CrvParams.hh"
+#include "ConditionsService/inc/ConditionsHandle.hh"
+#include "RecoDataProducts/inc/CrvDigiCollection.hh"
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "art/Framework/Principal/Run.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace mu2e
+{
+  class CrvRecoPulsesFitCompare : public art::EDAnalyzer
+  {
+    public:
+    struct Config
+    {
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+      fhicl::Atom<std::string> crvDigiModuleLabel{Name("crvDigiModuleLabel"), Comment("module label for CrvDigis")};
+      fhicl::Atom<float> minADCdifference{Name("minADCdifference"), Comment("minimum ADC difference above pedestal to be considered for reconstruction")};
+      fhicl::Atom<float> defaultBeta{Name("defaultBeta"), Comment("initialization value for fit and default value for invalid fits")};
+      fhicl::Atom<float> minBeta{Name("minBeta"), Comment("smallest accepted beta for valid fit [ns]")};
+      fhicl::Atom<float> maxBeta{Name("maxBeta"), Comment("largest accepted beta for valid fit [ns]")};
+      fhicl::Atom<float> maxTimeDifference{Name("maxTimeDifference"), Comment("largest accepted difference between time of largest ADC value and fitted peak [ns]")};
+      fhicl::Atom<float> minPulseHeightRatio{Name("minPulseHeightRatio"), Comment("smallest accepted ratio between largest ADC value and fitted peak")};
+      fhicl::Atom<float> maxPulseHeightRatio{Name("maxPulseHeightRatio"), Comment("largest accepted ratio between largest ADC value and fitted peak")};
+      fhicl::Atom<float> LEtimeFactor{Name("LEtimeFactor"), Comment("time of leading edge is peakTime-LEtimeFactor*beta")};
+      fhicl::Atom<bool> allowDoubleGumbel{Name("allowDoubleGumbel"), Comment("tries fitting with two Gumbel functions")};
+      fhicl::Atom<float> doubleGumbelThreshold{Name("doubleGumbelThreshold"), Comment("Chi2/#ADCsamples (based on single Gumbel fit) at which a fit with two Gumbel functions should be attempted")};
+      //parameters of CrvRecoPulsesFinder, which are not used here
+      fhicl::Atom<float> minPEs{Name("minPEs"), Comment("ignored, all pulses are compared"), 0};
+      fhicl::Atom<art::InputTag> protonBunchTimeTag{ Name("protonBunchTimeTag"), Comment("ignored"),"EWMProducer" };
+      fhicl::Atom<bool> fastGumbelFit{Name("fastGumbelFit"), Comment("ignored, both fitters are used"), false};
+    };
+
+    typedef art::EDAnalyzer::Table<Config> Parameters;
+
+    explicit CrvRecoPulsesFitCompare(const Parameters& config);
+    void analyze(const art::Event& e);
+    void beginRun(const art::Run &run);
+    void endJob();
+
+    private:
+    struct Difference
+    {
+      size_t n=0;
+      double sum=0, sum2=0, max=0;
+      void Add(double d) {++n; sum+=d; sum2+=d*d; max=std::max(max,std::fabs(d));}
+      void Print(const char *name) const
+      {
+        double mean=n>0?sum/n:0;
+        double rms=n>0?std::sqrt(std::max(sum2/n-mean*mean,0.0)):0;
+        std::printf("[CrvRecoPulsesFitCompare] %-36s mean %10.4g  rms %10.4g  max %10.4g\n",name,mean,rms,max);
+      }
+    };
+
+    std::unique_ptr<mu2eCrv::MakeCrvRecoPulses> _rootFit, _fastFit;
+
+    std::string _crvDigiModuleLabel;
+    float       _digitizationPeriod;
+    float       _pedestal;
+    float       _calibrationFactor;
+    float       _calibrationFactorPulseHeight;
+
+    size_t      _nWaveforms, _nSamePulses, _nPulses, _nSameFailedFits;
+    size_t      _nPulsesRoot, _nPulsesFast, _nFailedRoot, _nFailedFast;
+    double      _timeRoot, _timeFast;
+    Difference  _pulseHeight, _pulseTime, _PEs, _beta;
+  };
+
+  CrvRecoPulsesFitCompare::CrvRecoPulsesFitCompare(const Parameters& conf) :
+    art::EDAnalyzer(conf),
+    _crvDigiModuleLabel(conf().crvDigiModuleLabel()),
+    _nWaveforms(0), _nSamePulses(0), _nPulses(0), _nSameFailedFits(0),
+    _nPulsesRoot(0), _nPulsesFast(0), _nFailedRoot(0), _nFailedFast(0),
+    _timeRoot(0), _timeFast(0)
+  {
+    for(bool fastGumbelFit : {false, true})
+    {
+      (fastGumbelFit?_fastFit:_rootFit).reset(new mu2eCrv::MakeCrvRecoPulses(conf().minADCdifference(),
+                                                                             conf().defaultBeta(),
+                                                                             conf().minBeta(),
+                                                                             conf().maxBeta(),
+                                                                             conf().maxTimeDifference(),
+                                                                             conf().minPulseHeightRatio(),
+                                                                             conf().maxPulseHeightRatio(),
+                                                                             conf().LEtimeFactor(),
+                                                                             conf().allowDoubleGumbel(),
+                                                                             conf().doubleGumbelThreshold(),
+                                                                             fastGumbelFit));
+    }
+  }
+
+  void CrvRecoPulsesFitCompare::beginRun(const art::Run &run)
+  {
+    mu2e::ConditionsHandle<mu2e::CrvParams> crvPar("ignored");
+    _digitizationPeriod = crvPar->digitizationPeriod;
+    _pedestal           = crvPar->pedestal;
+    _calibrationFactor  = crvPar->calibrationFactor;
+    _calibrationFactorPulseHeight  = crvPar->calibrationFactorPulseHeight;
+  }
+
+  void CrvRecoPulsesFitCompare::analyze(const art::Event& event)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    art::Handle<CrvDigiCollection> crvDigiCollection;
+    event.getByLabel(_crvDigiModuleLabel,"",crvDigiCollection);
+
+    //same waveforms as in CrvRecoPulsesFinder
+    size_t waveformIndex = 0;
+    while(waveformIndex<crvDigiCollection->size())
+    {
+      const CrvDigi &digi = crvDigiCollection->at(waveformIndex);
+      const CRSScintillatorBarIndex &barIndex = digi.GetScintillatorBarIndex();
+      int SiPM = digi.GetSiPMNumber();
+      unsigned int startTDC = digi.GetStartTDC();
+      std::vector<unsigned int> ADCs;
+      for(size_t i=0; i<CrvDigi::NSamples; ++i) ADCs.push_back(digi.GetADCs()[i]);
+
+      while(++waveformIndex<crvDigiCollection->size())
+      {
+        const CrvDigi &nextDigi = crvDigiCollection->at(waveformIndex);
+        if(barIndex!=nextDigi.GetScintillatorBarIndex()) break;
+        if(SiPM!=nextDigi.GetSiPMNumber()) break;
+        if(startTDC+ADCs.size()!=nextDigi.GetStartTDC()) break;
+        for(size_t i=0; i<CrvDigi::NSamples; ++i) ADCs.push_back(nextDigi.GetADCs()[i]);
+      }
+
+      Clock::time_point t0=Clock::now();
+      _rootFit->SetWaveform(ADCs, startTDC, _digitizationPeriod, _pedestal, _calibrationFactor, _calibrationFactorPulseHeight);
+      Clock::time_point t1=Clock::now();
+      _fastFit->SetWaveform(ADCs, startTDC, _digitizationPeriod, _pedestal, _calibrationFactor, _calibrationFactorPulseHeight);
+      Clock::time_point t2=Clock::now();
+      _timeRoot+=std::chrono::duration<double>(t1-t0).count();
+      _timeFast+=std::chrono::duration<double>(t2-t1).count();
+      ++_nWaveforms;
+
+      //failed fits of all pulses, also in the waveforms where the fitters find different pulses
+      const std::vector<bool> &failedFitsRoot=_rootFit->GetFailedFits();
+      const std::vector<bool> &failedFitsFast=_fastFit->GetFailedFits();
+      _nPulsesRoot+=failedFitsRoot.size();
+      _nPulsesFast+=failedFitsFast.size();
+      _nFailedRoot+=std::count(failedFitsRoot.begin(),failedFitsRoot.end(),true);
+      _nFailedFast+=std::count(failedFitsFast.begin(),failedFitsFast.end(),true);
+
+      size_t n=_rootFit->GetPEs().size();
+      if(n!=_fastFit->GetPEs().size()) continue;
+      ++_nSamePulses;
+
+      for(size_t j=0; j<n; ++j)
+      {
+        ++_nPulses;
+        bool failedRoot=_rootFit->GetFailedFits().at(j);
+        bool failedFast=_fastFit->GetFailedFits().at(j);
+        if(failedRoot==failedFast) ++_nSameFailedFits;
+        if(failedRoot || failedFast) continue;
+
+        float heightRoot=_rootFit->GetPulseHeights().at(j);
+        float PEsRoot=_rootFit->GetPEs().at(j);
+        _pulseHeight.Add(heightRoot>0?(_fastFit->GetPulseHeights().at(j)-heightRoot)/heightRoot:0);
+        _pulseTime.Add(_fastFit->GetPulseTimes().at(j)-_rootFit->GetPulseTimes().at(j));
+        _PEs.Add(PEsRoot>0?(_fastFit->GetPEs().at(j)-PEsRoot)/PEsRoot:0);
+        _beta.Add(_fastFit->GetPulseBetas().at(j)-_rootFit->GetPulseBetas().at(j));
+      }
+    }
+  }
+
+  void CrvRecoPulsesFitCompare::endJob()
+  {
+    std::printf("[CrvRecoPulsesFitCompare] %zu waveforms, waveforms per second: ROOT fit %.4g, Gumbel fitter %.4g\n",
+                _nWaveforms, _timeRoot>0?_nWaveforms/_timeRoot:0., _timeFast>0?_nWaveforms/_timeFast:0.);
+    std::printf("[CrvRecoPulsesFitCompare] same number of pulses in %zu waveforms, %zu pulses, same fit status for %zu pulses\n",
+                _nSamePulses, _nPulses, _nSameFailedFits);
+    std::printf("[CrvRecoPulsesFitCompare] failed fits: ROOT fit %zu of %zu pulses (%.3g%%), Gumbel fitter %zu of %zu pulses (%.3g%%)\n",
+                _nFailedRoot, _nPulsesRoot, _nPulsesRoot>0?100.0*_nFailedRoot/_nPulsesRoot:0.,
+                _nFailedFast, _nPulsesFast, _nPulsesFast>0?100.0*_nFailedFast/_nPulsesFast:0.);
+    _pulseHeight.Print("pulse height (Gumbel-ROOT)/ROOT");
+    _pulseTime.Print("pulse time Gumbel-ROOT [ns]");
+    _PEs.Print("PEs (integral) (Gumbel-ROOT)/ROOT");
+    _beta.Print("beta Gumbel-ROOT [ns]");
+  }
+
+} // end namespace mu2e
+
+using mu2e::CrvRecoPulsesFitCompare;
+DEFINE_ART_MODULE(CrvRecoPulsesFitCompare)
@@ -102,6 +102,7 @@ namespace mu2e
 
     std::string fullPhotonMapFileName(_resolveFullPath(_photonMapFileName));
     _makeCrvSiPMCharges = boost::shared_ptr<mu2eCrv::MakeCrvSiPMCharges>(new mu2eCrv::MakeCrvSiPMCharges(_randFlat, _randPoissonQ, fullPhotonMapFileName));
+    _makeCrvSiPMCharges->SetBatchedSimulation(pset.get<bool>("batchedSimulation",false));  //alias table photon map, flat pixel arrays, block random numbers
   }
 
   void CrvSiPMChargeGenerator::beginRun(art::Run &run)
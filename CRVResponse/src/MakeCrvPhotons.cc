@@ -1,10 +1,49 @@
 #include "CRVResponse/inc/MakeCrvPhotons.hh"
 
 #include <sstream>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "CLHEP/Units/GlobalSystemOfUnits.h"
 #include "CLHEP/Vector/TwoVector.h"
 
+namespace
+{
+  //flat lookup table image: the magic word and the size of the image, followed by the constants,
+  //the Cerenkov maps, the bin definitions and the three LookupBinTables, each array preceded by
+  //its length (if it is not known from a previous entry) and padded to 8 bytes.
+  //like the lookup table files, the flat files use the byte order of the machine that wrote them.
+  const char flatMagic[8]={'C','R','V','L','U','T','F','1'};
+
+  template<typename T> void Append(std::vector<char> &image, const T *data, size_t n)
+  {
+    const char *c=reinterpret_cast<const char*>(data);
+    image.insert(image.end(),c,c+sizeof(T)*n);
+    image.resize((image.size()+7)/8*8,0);
+  }
+  void AppendCount(std::vector<char> &image, uint64_t n) {Append(image,&n,1);}
+
+  struct ImageReader
+  {
+    const char *data;
+    size_t      size, pos;
+    template<typename T> const T *Get(size_t n)
+    {
+      size_t length=(sizeof(T)*n+7)/8*8;
+      if(pos+length>size) throw std::logic_error("Corrupt flat lookup table.");
+      const T *p=reinterpret_cast<const T*>(data+pos);
+      pos+=length;
+      return p;
+    }
+    uint64_t Count() {return *Get<uint64_t>(1);}
+  };
+}
+
 namespace mu2eCrv
 {
 void LookupConstants::Write(const std::string &filename)
@@ -118,12 +157,20 @@ unsigned int LookupBinDefinitions::getNFiberCerenkovBins()
 
 unsigned int LookupBinDefinitions::findBin(const std::vector<double> &v, const double &x, bool &notFound)
 {
-  for(size_t i=1; i<v.size(); i++)
+  //the bin edges are in increasing order. a branchless binary search finds the first edge v[i]>=x (i>=1).
+  //x is in bin i-1, if v[i-1]<=x, which is the first bin with v[i-1]<=x && v[i]>=x.
+  if(v.size()<2) {notFound=true; return(-1);}
+  const double *base=v.data()+1;
+  size_t n=v.size()-1;
+  while(n>1)
   {
-    if(v[i-1]<=x && v[i]>=x) return(i-1);
+    size_t half=n/2;
+    base=(base[half]<x)?base+half:base;
+    n-=half;
   }
-  notFound=true;
-  return(-1);
+  size_t i=(base-v.data())+(*base<x);
+  if(i==v.size() || !(v[i-1]<=x)) {notFound=true; return(-1);}
+  return(i-1);
 }
 int LookupBinDefinitions::findScintillatorScintillationBin(double x, double y, double z)
 {
@@ -254,34 +301,156 @@ void MakeCrvPhotons::LoadLookupTable(const std::string &filename)
   _fileName = filename;
   std::ifstream lookupfile(filename,std::ios::binary);
   if(!lookupfile.good()) throw std::logic_error("Could not open lookup table file "+filename);
+  char magic[sizeof(flatMagic)]={};
+  lookupfile.read(magic,sizeof(magic));
+  lookupfile.close();
 
-  _LC.Read(lookupfile);
-  if(_LC.version1!=6) throw std::logic_error("This version of Offline expects a lookup table version 6.x.");
-  if(_LC.reflector!=0 && _LC.reflector!=1) throw std::logic_error("Lookup tables can have either no reflector, or a reflector on the +z side.");
+  if(_mappedImage!=NULL) munmap(_mappedImage,_mappedSize);
+  _mappedImage=NULL;
+  _mappedSize=0;
+  _image.clear();
 
-  _LCerenkov.Read(lookupfile);
-  _LBD.Read(lookupfile);
+  std::cout<<"Reading CRV lookup tables "<<filename<<" ... "<<std::flush;
+  if(memcmp(magic,flatMagic,sizeof(flatMagic))==0) MapFlatLookupTable(filename);
+  else ReadLookupTable(filename);
+  ReadImage();
+  std::cout<<"Done."<<std::endl;
+}
 
-  unsigned int nScintillatorScintillationBins = _LBD.getNScintillatorScintillationBins();
-  unsigned int nScintillatorCerenkovBins      = _LBD.getNScintillatorCerenkovBins();
-  unsigned int nFiberCerenkovBins             = _LBD.getNFiberCerenkovBins();
+void MakeCrvPhotons::ReadLookupTable(const std::string &filename)
+{
+  std::ifstream lookupfile(filename,std::ios::binary);
+
+  LookupConstants      LC;
+  LookupCerenkov       LCerenkov;
+  LookupBinDefinitions LBD;
+  LC.Read(lookupfile);
+  if(LC.version1!=6) throw std::logic_error("This version of Offline expects a lookup table version 6.x.");
+  LCerenkov.Read(lookupfile);
+  LBD.Read(lookupfile);
+
+  _image.clear();
+  Append(_image,flatMagic,sizeof(flatMagic));
+  AppendCount(_image,0);  //size of the image, filled at the end
+  Append(_image,&LC,1);
+  for(const std::map<double,double> *m : {&LCerenkov.photonsScintillator, &LCerenkov.photonsFiber})
+  {
+    AppendCount(_image,m->size());
+    for(std::map<double,double>::const_iterator iter=m->begin(); iter!=m->end(); iter++)
+    {
+      double entry[2]={iter->first,iter->second};
+      Append(_image,entry,2);
+    }
+  }
+  for(const std::vector<double> *v : {&LBD.xBins, &LBD.yBins, &LBD.zBins, &LBD.betaBins, &LBD.thetaBins, &LBD.phiBins, &LBD.rBins})
+  {
+    AppendCount(_image,v->size());
+    Append(_image,v->data(),v->size());
+  }
 
   //0...scintillationInScintillator, 1...cerenkovInScintillator 2...cerenkovInFiber
-  _bins[0].resize(nScintillatorScintillationBins);
-  _bins[1].resize(nScintillatorCerenkovBins);
-  _bins[2].resize(nFiberCerenkovBins);
+  unsigned int nBins[3]={LBD.getNScintillatorScintillationBins(),LBD.getNScintillatorCerenkovBins(),LBD.getNFiberCerenkovBins()};
+  for(int table=0; table<3; table++)
+  {
+    std::vector<LookupBin> bins(nBins[table]);
+    for(unsigned int i=0; i<nBins[table]; i++) bins[i].Read(lookupfile,i);
+    if(!lookupfile.good()) throw std::logic_error("Corrupt lookup table.");
+
+    std::vector<float>         arrivalProbability;
+    std::vector<unsigned int>  probabilityScaleTimeDelays, probabilityScaleFiberEmissions;
+    std::vector<unsigned int>  timeDelaysOffset(1,0), fiberEmissionsOffset(1,0);
+    std::vector<unsigned char> timeDelays, fiberEmissions;
+    for(const LookupBin &bin : bins)
+    {
+      arrivalProbability.push_back(bin.arrivalProbability);
+      probabilityScaleTimeDelays.push_back(bin.probabilityScaleTimeDelays);
+      probabilityScaleFiberEmissions.push_back(bin.probabilityScaleFiberEmissions);
+      timeDelays.insert(timeDelays.end(),bin.timeDelays.begin(),bin.timeDelays.end());
+      fiberEmissions.insert(fiberEmissions.end(),bin.fiberEmissions.begin(),bin.fiberEmissions.end());
+      timeDelaysOffset.push_back(timeDelays.size());
+      fiberEmissionsOffset.push_back(fiberEmissions.size());
+    }
+    AppendCount(_image,nBins[table]);
+    Append(_image,arrivalProbability.data(),nBins[table]);
+    Append(_image,probabilityScaleTimeDelays.data(),nBins[table]);
+    Append(_image,probabilityScaleFiberEmissions.data(),nBins[table]);
+    Append(_image,timeDelaysOffset.data(),nBins[table]+1);
+    Append(_image,fiberEmissionsOffset.data(),nBins[table]+1);
+    Append(_image,timeDelays.data(),timeDelays.size());
+    Append(_image,fiberEmissions.data(),fiberEmissions.size());
+  }
 
-  std::cout<<"Reading CRV lookup tables "<<filename<<" ... "<<std::flush;
-  for(unsigned int i=0; i<nScintillatorScintillationBins; i++) _bins[0][i].Read(lookupfile,i);
-  for(unsigned int i=0; i<nScintillatorCerenkovBins; i++)      _bins[1][i].Read(lookupfile,i);
-  for(unsigned int i=0; i<nFiberCerenkovBins; i++)             _bins[2][i].Read(lookupfile,i);
-  std::cout<<"Done."<<std::endl;
+  uint64_t size=_image.size();
+  memcpy(_image.data()+sizeof(flatMagic),&size,sizeof(size));
+}
 
-  lookupfile.close();
+void MakeCrvPhotons::MapFlatLookupTable(const std::string &filename)
+{
+  int fd=open(filename.c_str(),O_RDONLY);
+  if(fd<0) throw std::logic_error("Could not open lookup table file "+filename);
+  struct stat st;
+  if(fstat(fd,&st)!=0 || st.st_size==0) {close(fd); throw std::logic_error("Could not read lookup table file "+filename);}
+  void *image=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if(image==MAP_FAILED) throw std::logic_error("Could not map lookup table file "+filename);
+  _mappedImage=image;
+  _mappedSize=st.st_size;
+}
+
+void MakeCrvPhotons::ReadImage()
+{
+  ImageReader reader{ImageData(),ImageSize(),0};
+  reader.Get<char>(sizeof(flatMagic));
+  if(reader.Count()!=ImageSize()) throw std::logic_error("Corrupt flat lookup table.");
+
+  memcpy(&_LC,reader.Get<LookupConstants>(1),sizeof(LookupConstants));
+  if(_LC.version1!=6) throw std::logic_error("This version of Offline expects a lookup table version 6.x.");
+  if(_LC.reflector!=0 && _LC.reflector!=1) throw std::logic_error("Lookup tables can have either no reflector, or a reflector on the +z side.");
+
+  for(std::map<double,double> *m : {&_LCerenkov.photonsScintillator, &_LCerenkov.photonsFiber})
+  {
+    m->clear();
+    size_t n=reader.Count();
+    for(size_t j=0; j<n; j++)
+    {
+      const double *entry=reader.Get<double>(2);
+      (*m)[entry[0]]=entry[1];
+    }
+  }
+  for(std::vector<double> *v : {&_LBD.xBins, &_LBD.yBins, &_LBD.zBins, &_LBD.betaBins, &_LBD.thetaBins, &_LBD.phiBins, &_LBD.rBins})
+  {
+    size_t n=reader.Count();
+    const double *d=reader.Get<double>(n);
+    v->assign(d,d+n);
+  }
+
+  unsigned int nBins[3]={_LBD.getNScintillatorScintillationBins(),_LBD.getNScintillatorCerenkovBins(),_LBD.getNFiberCerenkovBins()};
+  for(int table=0; table<3; table++)
+  {
+    LookupBinTable &t=_tables[table];
+    t.nBins=reader.Count();
+    if(t.nBins!=nBins[table]) throw std::logic_error("Corrupt flat lookup table.");
+    t.arrivalProbability             = reader.Get<float>(t.nBins);
+    t.probabilityScaleTimeDelays     = reader.Get<unsigned int>(t.nBins);
+    t.probabilityScaleFiberEmissions = reader.Get<unsigned int>(t.nBins);
+    t.timeDelaysOffset               = reader.Get<unsigned int>(t.nBins+1);
+    t.fiberEmissionsOffset           = reader.Get<unsigned int>(t.nBins+1);
+    t.timeDelays                     = reader.Get<unsigned char>(t.timeDelaysOffset[t.nBins]);
+    t.fiberEmissions                 = reader.Get<unsigned char>(t.fiberEmissionsOffset[t.nBins]);
+  }
+}
+
+void MakeCrvPhotons::WriteFlatLookupTable(const std::string &filename) const
+{
+  std::ofstream flatfile(filename,std::ios::binary);
+  flatfile.write(ImageData(),ImageSize());
+  flatfile.close();
+  if(!flatfile.good()) throw std::logic_error("Could not write flat lookup table file "+filename);
 }
 
 MakeCrvPhotons::~MakeCrvPhotons()
 {
+  if(_mappedImage!=NULL) munmap(_mappedImage,_mappedSize);
 }
 
 void MakeCrvPhotons::MakePhotons(const CLHEP::Hep3Vector &stepStartTmp,   //they need to be points
@@ -359,8 +528,10 @@ static int nPCerenkov=0;
                      //0...+pi due to symmetry
       bool isInFiber = IsInsideFiber(p,distanceVector, r,phi);
 
-      const LookupBin *scintillationBin=NULL;
-      const LookupBin *cerenkovBin=NULL;
+      const LookupBinTable *scintillationTable=NULL;
+      const LookupBinTable *cerenkovTable=NULL;
+      unsigned int scintillationBin=0;
+      unsigned int cerenkovBin=0;
       int nPhotonsScintillation=0;
       int nPhotonsCerenkov=0;
       if(isInScintillator)
@@ -368,13 +539,15 @@ static int nPCerenkov=0;
         int binNumberS=_LBD.findScintillatorScintillationBin(fabs(p.x()),p.y(),p.z());  //use only positive x values due to symmetry in x
         if(binNumberS>=0)
         {
-          scintillationBin = &_bins[0][binNumberS];   //lookup table number for scintillation in scintillator is 0
+          scintillationTable = &_tables[0];   //lookup table number for scintillation in scintillator is 0
+          scintillationBin = binNumberS;
           nPhotonsScintillation = nPhotonsScintillationPerStep;
         }
         int binNumberC=_LBD.findScintillatorCerenkovBin(fabs(p.x()),p.y(),p.z(),beta);  //use only positive x values due to symmetry in x
         if(binNumberC>=0)
         {
-          cerenkovBin = &_bins[1][binNumberC];   //lookup table number for cerenkov in scintillator is 1
+          cerenkovTable = &_tables[1];   //lookup table number for cerenkov in scintillator is 1
+          cerenkovBin = binNumberC;
           nPhotonsCerenkov = nPhotonsCerenkovInScintillatorPerStep;
         }
       }
@@ -383,7 +556,8 @@ static int nPCerenkov=0;
         int binNumber=_LBD.findFiberCerenkovBin(beta,theta,phi,r,p.z());
         if(binNumber>=0)
         {
-          cerenkovBin = &_bins[2][binNumber];   //lookup table number for cerenkov in fiber is 2
+          cerenkovTable = &_tables[2];   //lookup table number for cerenkov in fiber is 2
+          cerenkovBin = binNumber;
           nPhotonsCerenkov = nPhotonsCerenkovInFiberPerStep;
         }
       }
@@ -396,23 +570,24 @@ nPCerenkov+=nPhotonsCerenkov;
       for(int i=0; i<nPhotons; i++)
       {
         //get the right bin
-        const LookupBin *theBin=cerenkovBin;
-        if(i<nPhotonsScintillation) theBin=scintillationBin;
-        if(theBin==NULL) continue;  //this can't actually happen
+        const LookupBinTable *theTable=cerenkovTable;
+        unsigned int theBin=cerenkovBin;
+        if(i<nPhotonsScintillation) {theTable=scintillationTable; theBin=scintillationBin;}
+        if(theTable==NULL) continue;  //this can't actually happen
 
         //photon arrival probability at SiPM
-        double probability = theBin->arrivalProbability;
+        double probability = theTable->arrivalProbability[theBin];
         if(_randFlat.fire()<=probability)  //a photon arrives at the SiPM --> calculate arrival time
         {
           //start time of photons
           double arrivalTime = t;
 
           //add fiber decay times depending on the number of emissions
-          int nEmissions = GetRandomFiberEmissions(theBin);
+          int nEmissions = GetRandomFiberEmissions(*theTable,theBin);
           for(int iEmission=0; iEmission<nEmissions; iEmission++) arrivalTime+=-_LC.WLSfiberDecayTime*log(_randFlat.fire());
 
           //add additional time delay due to the photons bouncing around
-          arrivalTime+=GetRandomTime(theBin);
+          arrivalTime+=GetRandomTime(*theTable,theBin);
 
           if(reflector!=-1) _arrivalTimes[SiPM].push_back(arrivalTime);
           else _arrivalTimes[SiPM+1].push_back(arrivalTime);
@@ -476,7 +651,7 @@ bool MakeCrvPhotons::IsInsideFiber(const CLHEP::Hep3Vector &p, const CLHEP::Hep3
   return true;
 }
 
-double MakeCrvPhotons::GetRandomTime(const LookupBin *theBin)
+double MakeCrvPhotons::GetRandomTime(const LookupBinTable &table, unsigned int bin)
 {
   //The lookup tables encodes probabilities as probability*mu2eCrv::LookupBin::probabilityScale(255), 
   //so that the probabilities can be stored as integers. For example, the probability of 1 is stored as 255.
@@ -484,19 +659,20 @@ double MakeCrvPhotons::GetRandomTime(const LookupBin *theBin)
   //This bin-specifc sum is the probabilityScaleTimeDelays.
 
   size_t timeDelay=0;
-  double rand=_randFlat.fire()*theBin->probabilityScaleTimeDelays;
+  double rand=_randFlat.fire()*table.probabilityScaleTimeDelays[bin];
   double sumProb=0;
-  size_t maxTimeDelay=theBin->timeDelays.size();
+  const unsigned char *timeDelays=table.timeDelays+table.timeDelaysOffset[bin];
+  size_t maxTimeDelay=table.timeDelaysOffset[bin+1]-table.timeDelaysOffset[bin];
   for(timeDelay=0; timeDelay<maxTimeDelay; ++timeDelay)
   {
-    sumProb+=theBin->timeDelays[timeDelay];
+    sumProb+=timeDelays[timeDelay];
     if(rand<=sumProb) break;
   }
 
   return static_cast<double>(timeDelay);
 }
 
-int MakeCrvPhotons::GetRandomFiberEmissions(const LookupBin *theBin)
+int MakeCrvPhotons::GetRandomFiberEmissions(const LookupBinTable &table, unsigned int bin)
 {
   //The lookup tables encodes probabilities as probability*mu2eCrv::LookupBin::probabilityScale(255), 
   //so that the probabilities can be stored as integers. For example, the probability of 1 is stored as 255.
@@ -504,12 +680,13 @@ int MakeCrvPhotons::GetRandomFiberEmissions(const LookupBin *theBin)
   //This bin-specifc sum is the probabilityScaleFiberEmissions.
 
   size_t emissions=0;
-  double rand=_randFlat.fire()*theBin->probabilityScaleFiberEmissions;
+  double rand=_randFlat.fire()*table.probabilityScaleFiberEmissions[bin];
   double sumProb=0;
-  size_t maxEmissions=theBin->fiberEmissions.size();
+  const unsigned char *fiberEmissions=table.fiberEmissions+table.fiberEmissionsOffset[bin];
+  size_t maxEmissions=table.fiberEmissionsOffset[bin+1]-table.fiberEmissionsOffset[bin];
   for(emissions=0; emissions<maxEmissions; ++emissions)
   {
-    sumProb+=theBin->fiberEmissions[emissions];
+    sumProb+=fiberEmissions[emissions];
     if(rand<=sumProb) break;
   }
 
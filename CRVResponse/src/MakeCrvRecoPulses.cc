@@ -17,6 +17,59 @@ namespace
     double y2=par[3]*(TMath::Exp(-(x-par[4])/par[5]-TMath::Exp(-(x-par[4])/par[5])));
     return y1+y2;
   }
+
+  //ROOT fit of a TF1 to the graph of the waveform with the interface of mu2eCrv::CrvGumbelFitter
+  class RootGumbelFit
+  {
+    public:
+    RootGumbelFit(TF1 &f, TGraph &g) : _f(f), _g(g) {}
+    void   SetParameter(int i, double value)               {_f.SetParameter(i,value);}
+    void   SetParLimits(int i, double lower, double upper) {_f.SetParLimits(i,lower,upper);}
+    void   SetRange(double xmin, double xmax)              {_f.SetRange(xmin,xmax);}
+    void   Fit(const std::vector<unsigned int> &, unsigned int, float, float) {_fr=_g.Fit(&_f,"NQSR");}
+    double Parameter(int i) const                          {return _fr->Parameter(i);}
+    int    GetNumberFitPoints() const                      {return _f.GetNumberFitPoints();}
+    double Chi2() const;
+    bool   FailedFit(int paramStart, int paramEnd) const;
+
+    private:
+    TF1           &_f;
+    TGraph        &_g;
+    TFitResultPtr  _fr;
+  };
+
+  bool RootGumbelFit::FailedFit(int paramStart, int paramEnd) const
+  {
+    if(_fr!=0) return true;
+    if(!_fr->IsValid()) return true;
+
+    const double tolerance=0.01; //TODO: Need a user variable. Perhaps the limit condition can be extracted from the minimizer
+    for(int i=paramStart; i<=paramEnd; ++i)
+    {
+      double v=_fr->Parameter(i);
+      double lower, upper;
+      _fr->ParameterBounds(i,lower,upper);
+      if((v-lower)/(upper-lower)<tolerance) return true;
+      if((upper-v)/(upper-lower)<tolerance) return true;
+    }
+    return false;
+  }
+
+  double RootGumbelFit::Chi2() const
+  {
+    float chi2=0;
+    double xmin,xmax;
+    _f.GetRange(xmin,xmax);
+    for(int i=0; i<_g.GetN(); ++i)
+    {
+      double x,y;
+      _g.GetPoint(i,x,y);
+      if(x<xmin || x>xmax) continue;
+      float fy=_f.Eval(x);
+      chi2+=(y-fy)*(y-fy)/fy;
+    }
+    return chi2;
+  }
 }
 
 namespace mu2eCrv
@@ -24,8 +77,10 @@ namespace mu2eCrv
 
 MakeCrvRecoPulses::MakeCrvRecoPulses(float minADCdifference, float defaultBeta, float minBeta, float maxBeta,
                                      float maxTimeDifference, float minPulseHeightRatio, float maxPulseHeightRatio,
-                                     float LEtimeFactor, bool allowDoubleGumbel, float doubleGumbelThreshold) :
+                                     float LEtimeFactor, bool allowDoubleGumbel, float doubleGumbelThreshold,
+                                     bool fastGumbelFit) :
                                      _f1("peakfitter",Gumbel,0,0,3), _f2("peakfitter",Gumbel2,0,0,6),
+                                     _g1(1), _g2(2), _fastGumbelFit(fastGumbelFit),
                                      _minADCdifference(minADCdifference), 
                                      _defaultBeta(defaultBeta), _minBeta(minBeta), _maxBeta(maxBeta), 
                                      _maxTimeDifference(maxTimeDifference),
@@ -35,17 +90,21 @@ MakeCrvRecoPulses::MakeCrvRecoPulses(float minADCdifference, float defaultBeta,
                                      _allowDoubleGumbel(allowDoubleGumbel), _doubleGumbelThreshold(doubleGumbelThreshold)
 {}
 
-void MakeCrvRecoPulses::FillGraphAndFindPeaks(const std::vector<unsigned int> &waveform, unsigned int startTDC,
-                                              float digitizationPeriod, float pedestal,
-                                              TGraph &g, std::vector<std::pair<size_t,size_t> > &peaks)
+void MakeCrvRecoPulses::FillGraph(const std::vector<unsigned int> &waveform, unsigned int startTDC,
+                                  float digitizationPeriod, float pedestal, TGraph &g)
+{
+  size_t nBins = waveform.size();
+  for(size_t bin=0; bin<nBins; ++bin) g.SetPoint(bin,(startTDC+bin)*digitizationPeriod,waveform[bin]-pedestal);
+}
+
+void MakeCrvRecoPulses::FindPeaks(const std::vector<unsigned int> &waveform, float pedestal,
+                                  std::vector<std::pair<size_t,size_t> > &peaks)
 {
   size_t nBins = waveform.size();
   size_t peakStartBin=0;
   size_t peakEndBin=0;
   for(size_t bin=0; bin<nBins; ++bin) 
   {
-    g.SetPoint(bin,(startTDC+bin)*digitizationPeriod,waveform[bin]-pedestal);
-
     if(bin<2 || bin>=nBins-2) continue; //don't search for peaks here
     if(waveform[bin-1]<waveform[bin]) //rising edge
     {
@@ -88,39 +147,6 @@ void MakeCrvRecoPulses::RangeFinder(const std::vector<unsigned int> &waveform, c
   }
 }
 
-bool MakeCrvRecoPulses::FailedFit(TFitResultPtr fr, int paramStart, int paramEnd)
-{
-  if(fr!=0) return true;
-  if(!fr->IsValid()) return true;
-
-  const double tolerance=0.01; //TODO: Need a user variable. Perhaps the limit condition can be extracted from the minimizer
-  for(int i=paramStart; i<=paramEnd; ++i)
-  {
-    double v=fr->Parameter(i);
-    double lower, upper;
-    fr->ParameterBounds(i,lower,upper);
-    if((v-lower)/(upper-lower)<tolerance) return true;
-    if((upper-v)/(upper-lower)<tolerance) return true;
-  }
-  return false;
-}
-
-double MakeCrvRecoPulses::Chi2(TF1 &f, const TGraph &g)
-{
-  float chi2=0;
-  double xmin,xmax;
-  f.GetRange(xmin,xmax);
-  for(int i=0; i<g.GetN(); ++i)
-  {
-    double x,y;
-    g.GetPoint(i,x,y);
-    if(x<xmin || x>xmax) continue;
-    float fy=f.Eval(x);
-    chi2+=(y-fy)*(y-fy)/fy;
-  }
-  return chi2;
-}
-
 void MakeCrvRecoPulses::NoFitOption(const std::vector<unsigned int> &waveform, float pedestal, 
                                     size_t peakStart, float &sum, size_t &pulseStart, size_t &pulseEnd)
 {
@@ -164,12 +190,29 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
   _pulseStart.clear();
   _pulseEnd.clear();
 
-  //fill graph and find peaks
+  //find peaks
   std::vector<std::pair<size_t,size_t> > peaks;
-  size_t nBins = waveform.size();
-  TGraph g(nBins);
-  FillGraphAndFindPeaks(waveform, startTDC, digitizationPeriod, pedestal, g, peaks);
+  FindPeaks(waveform, pedestal, peaks);
 
+  if(_fastGumbelFit)
+  {
+    FitPeaks(_g1, _g2, waveform, startTDC, digitizationPeriod, pedestal, calibrationFactor, calibrationFactorPulseHeight, peaks);
+  }
+  else
+  {
+    TGraph g(waveform.size());
+    FillGraph(waveform, startTDC, digitizationPeriod, pedestal, g);
+    RootGumbelFit f1(_f1,g), f2(_f2,g);
+    FitPeaks(f1, f2, waveform, startTDC, digitizationPeriod, pedestal, calibrationFactor, calibrationFactorPulseHeight, peaks);
+  }
+}
+
+template<class Fitter>
+void MakeCrvRecoPulses::FitPeaks(Fitter &f1, Fitter &f2, const std::vector<unsigned int> &waveform,
+                                 unsigned int startTDC, float digitizationPeriod, float pedestal,
+                                 float calibrationFactor, float calibrationFactorPulseHeight,
+                                 const std::vector<std::pair<size_t,size_t> > &peaks)
+{
   //loop through all peaks
   for(size_t ipeak=0; ipeak<peaks.size(); ++ipeak)
   {
@@ -191,22 +234,22 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     double fitStartTime, fitEndTime;
 
     //first try simple fit (=one Gumbel function)
-    _f1.SetParameter(0, (waveform[peakStartBin]-pedestal)*TMath::E());
-    _f1.SetParameter(1, peakTime);
-    _f1.SetParameter(2, _defaultBeta);
-    _f1.SetParLimits(0,(waveform[peakStartBin]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
-    _f1.SetParLimits(1,peakStartTime-_maxTimeDifference,peakEndTime+_maxTimeDifference);
-    _f1.SetParLimits(2, _minBeta, _maxBeta);
+    f1.SetParameter(0, (waveform[peakStartBin]-pedestal)*TMath::E());
+    f1.SetParameter(1, peakTime);
+    f1.SetParameter(2, _defaultBeta);
+    f1.SetParLimits(0,(waveform[peakStartBin]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
+    f1.SetParLimits(1,peakStartTime-_maxTimeDifference,peakEndTime+_maxTimeDifference);
+    f1.SetParLimits(2, _minBeta, _maxBeta);
 
     RangeFinderNarrow(waveform, peakStartBin, peakEndBin, fitStartBin, fitEndBin);
     fitStartTime=(startTDC+fitStartBin)*digitizationPeriod;
     fitEndTime=(startTDC+fitEndBin)*digitizationPeriod;
-    _f1.SetRange(fitStartTime,fitEndTime);
+    f1.SetRange(fitStartTime,fitEndTime);
 
     //do the fit
-    TFitResultPtr fr = g.Fit(&_f1,"NQSR");
-//    float  pulseFitChi2 = _f1.GetChisquare()/_f1.GetNumberFitPoints();
-    float  pulseFitChi2 = Chi2(_f1,g)/_f1.GetNumberFitPoints();
+    f1.Fit(waveform, startTDC, digitizationPeriod, pedestal);
+    Fitter *fr = &f1;
+    float  pulseFitChi2 = f1.Chi2()/f1.GetNumberFitPoints();
     double fitParam0 = fr->Parameter(0);
     double fitParam1 = fr->Parameter(1);
     double fitParam2 = fr->Parameter(2);
@@ -214,7 +257,7 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     double fitParam4 = 0;
     double fitParam5 = 0;
 
-    if((pulseFitChi2>_doubleGumbelThreshold || FailedFit(fr,0,2)) && _allowDoubleGumbel)
+    if((pulseFitChi2>_doubleGumbelThreshold || fr->FailedFit(0,2)) && _allowDoubleGumbel)
     {
       //try fit with two pulses (=two Gumbel function) (more time consuming)
       simpleFit=false;
@@ -223,26 +266,26 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
         if(peaks[ipeak+1].first-peaks[ipeak].first<7) fittingNpeaks=2;  //two peaks close together
       }
 
-      _f2.SetParameter(0, (waveform[peakStartBin]-pedestal)*TMath::E());
-      _f2.SetParameter(1, peakTime);
-      _f2.SetParameter(2, _defaultBeta);
-      _f2.SetParameter(5, _defaultBeta);
-      _f2.SetParLimits(0,(waveform[peakStartBin]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
-      _f2.SetParLimits(1,peakStartTime-_maxTimeDifference,peakEndTime+_maxTimeDifference);
-      _f2.SetParLimits(2, _minBeta, _maxBeta);
-      _f2.SetParLimits(5, _minBeta, _maxBeta);
+      f2.SetParameter(0, (waveform[peakStartBin]-pedestal)*TMath::E());
+      f2.SetParameter(1, peakTime);
+      f2.SetParameter(2, _defaultBeta);
+      f2.SetParameter(5, _defaultBeta);
+      f2.SetParLimits(0,(waveform[peakStartBin]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
+      f2.SetParLimits(1,peakStartTime-_maxTimeDifference,peakEndTime+_maxTimeDifference);
+      f2.SetParLimits(2, _minBeta, _maxBeta);
+      f2.SetParLimits(5, _minBeta, _maxBeta);
       if(fittingNpeaks==1)  //potentially merged double peaks or hidden second peak (most likely due to a reflected pulse)
       {
-        _f2.SetParameter(3, 0.1*(waveform[peakStartBin]-pedestal)*TMath::E());
-        _f2.SetParameter(4, peakTime+3*digitizationPeriod);  //TODO
-        _f2.SetParLimits(3,0,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
-        _f2.SetParLimits(4,peakEndTime+digitizationPeriod,peakEndTime+8*digitizationPeriod); //TODO
+        f2.SetParameter(3, 0.1*(waveform[peakStartBin]-pedestal)*TMath::E());
+        f2.SetParameter(4, peakTime+3*digitizationPeriod);  //TODO
+        f2.SetParLimits(3,0,(waveform[peakStartBin]-pedestal)*TMath::E()*_maxPulseHeightRatio);
+        f2.SetParLimits(4,peakEndTime+digitizationPeriod,peakEndTime+8*digitizationPeriod); //TODO
 
         size_t fitStartBin, fitEndBin;
         RangeFinder(waveform, peakStartBin, peakEndBin, fitStartBin, fitEndBin);
         double fitStartTime=(startTDC+fitStartBin)*digitizationPeriod;
         double fitEndTime=(startTDC+fitEndBin)*digitizationPeriod;
-        _f2.SetRange(fitStartTime,fitEndTime);
+        f2.SetRange(fitStartTime,fitEndTime);
       }
       else //separated double peaks (most likely due to a reflected pulse)
       {
@@ -252,25 +295,25 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
         peakEndTime2=(startTDC+peakEndBin2)*digitizationPeriod;
         peakTime2=0.5*(peakStartTime2+peakEndTime2);
 
-        _f2.SetParameter(3, (waveform[peakStartBin2]-pedestal)*TMath::E());
-        _f2.SetParameter(4, peakTime2);
-        _f2.SetParLimits(3,(waveform[peakStartBin2]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin2]-pedestal)*TMath::E()*_maxPulseHeightRatio);
-        _f2.SetParLimits(4,peakStartTime2-_maxTimeDifference,peakEndTime2+_maxTimeDifference);
+        f2.SetParameter(3, (waveform[peakStartBin2]-pedestal)*TMath::E());
+        f2.SetParameter(4, peakTime2);
+        f2.SetParLimits(3,(waveform[peakStartBin2]-pedestal)*TMath::E()*_minPulseHeightRatio,(waveform[peakStartBin2]-pedestal)*TMath::E()*_maxPulseHeightRatio);
+        f2.SetParLimits(4,peakStartTime2-_maxTimeDifference,peakEndTime2+_maxTimeDifference);
 
         size_t fitStartBin, fitEndBin;
         RangeFinder(waveform, peakStartBin, peakEndBin, fitStartBin, fitEndBin);
         double fitStartTime=(startTDC+fitStartBin)*digitizationPeriod;
         RangeFinder(waveform, peakStartBin2, peakEndBin2, fitStartBin, fitEndBin);
         double fitEndTime=(startTDC+fitEndBin)*digitizationPeriod;
-        _f2.SetRange(fitStartTime,fitEndTime);
+        f2.SetRange(fitStartTime,fitEndTime);
 
         ++ipeak;  //this loop already looked at the next peaks, so we need to skip it in the next loop
       }
 
       //do the fit
-      fr = g.Fit(&_f2,"NQSR");
-//      pulseFitChi2 = _f2.GetChisquare()/_f2.GetNumberFitPoints();
-      pulseFitChi2 = Chi2(_f2,g)/_f2.GetNumberFitPoints();
+      f2.Fit(waveform, startTDC, digitizationPeriod, pedestal);
+      fr = &f2;
+      pulseFitChi2 = f2.Chi2()/f2.GetNumberFitPoints();
       fitParam0 = fr->Parameter(0);
       fitParam1 = fr->Parameter(1);
       fitParam2 = fr->Parameter(2);
@@ -285,7 +328,7 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     float  pulseHeight  = fitParam0/TMath::E();
     float  pulseBeta    = fitParam2;
     double LEtime       = 0;
-    bool   failedFit    = FailedFit(fr,0,2);
+    bool   failedFit    = fr->FailedFit(0,2);
 
     if(failedFit)
     {
@@ -329,7 +372,7 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     float  pulseHeight_2  = fitParam3/TMath::E();
     float  pulseBeta_2    = fitParam5;
     double LEtime_2       = pulseTime_2-_LEtimeFactor*pulseBeta_2;  //50% pulse height is reached at -0.985*beta before the peak
-    bool   failedFit_2    = FailedFit(fr,3,5);
+    bool   failedFit_2    = fr->FailedFit(3,5);
     float  PEsPulseHeight_2 = pulseHeight_2 / calibrationFactorPulseHeight;
 
     if(fittingNpeaks==1)
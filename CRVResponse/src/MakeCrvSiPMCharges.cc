@@ -8,6 +8,8 @@ Based on Paul Rubinov's C# code
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <functional>
+#include <numeric>
 
 //photon map gets created from the CRVPhoton.root file, which can be generated with the standalone program (in WLSSteppingAction)
 //in ROOT: CRVPhotons->Draw("x/0.05+20:(fabs(y)-13)/0.05+20>>photonMap(40,0,40,40,0,40)","","COLZ")
@@ -15,6 +17,13 @@ Based on Paul Rubinov's C# code
 //to get standalone version: compile with
 //g++ MakeCrvSiPMCharges.cc -std=c++11 -I../../ -I$CLHEP_INCLUDE_DIR -L$CLHEP_LIB_DIR -lCLHEP -DSiPMChargesStandalone `root-config --cflags --glibs`
 
+namespace
+{
+  const size_t nUniformsPerBlock=256;    //largest block of uniforms
+  const size_t nUniformsFirstBlock=8;    //smallest first block of a SiPM
+  const size_t nUniformsPerPhoton=8;     //pixel (4) and typical avalanche draws of a photon
+}
+
 namespace mu2eCrv
 {
 
@@ -137,6 +146,28 @@ void MakeCrvSiPMCharges::SetSiPMConstants(int nPixelsX, int nPixelsY, double ove
   _inactivePixels = inactivePixels;
 
   _avalancheProbFullyChargedPixel = GetAvalancheProbability(overvoltage);
+
+  //constants of the batched simulation (see GenerateAvalanche)
+  _trapType0ProductionProb = _probabilities._trapType0Prob/_avalancheProbFullyChargedPixel;
+  _trapType1ProductionProb = _probabilities._trapType1Prob/_avalancheProbFullyChargedPixel;
+  _crossTalkProductionProbSinglePixel = (1.0-pow(1.0-_probabilities._crossTalkProb,1.0/4.0))/_avalancheProbFullyChargedPixel;
+
+  _inactivePixelMap.assign(_nPixelsX*_nPixelsY,0);
+  for(size_t i=0; i<_inactivePixels.size(); i++)
+  {
+    int x=_inactivePixels[i].first;
+    int y=_inactivePixels[i].second;
+    if(x>=0 && x<_nPixelsX && y>=0 && y<_nPixelsY) _inactivePixelMap[x*_nPixelsY+y]=1;
+  }
+  _pixelDischargeTimes.assign(_nPixelsX*_nPixelsY,NAN);
+  _dischargedPixels.clear();
+
+  _photonMapFitsPixels=true;
+  for(size_t i=0; i<_aliasProbability.size(); i++)
+  {
+    if(_aliasBinLowX[i]<0 || _aliasBinLowX[i]+_aliasBinWidthX[i]>_nPixelsX) _photonMapFitsPixels=false;
+    if(_aliasBinLowY[i]<0 || _aliasBinLowY[i]+_aliasBinWidthY[i]>_nPixelsY) _photonMapFitsPixels=false;
+  }
 }
 
 void MakeCrvSiPMCharges::FillQueue(const std::vector<std::pair<double,size_t> > &photons, double startTime, double endTime)
@@ -171,6 +202,12 @@ void MakeCrvSiPMCharges::FillQueue(const std::vector<std::pair<double,size_t> >
 void MakeCrvSiPMCharges::Simulate(const std::vector<std::pair<double,size_t> > &photons,   //pair of photon time and index in the original photon vector
                                    std::vector<SiPMresponse> &SiPMresponseVector, double startTime, double endTime)
 {
+  if(_batched)
+  {
+    SimulateBatched(photons, SiPMresponseVector, startTime, endTime);
+    return;
+  }
+
   _pixels.clear();
   _scheduledCharges.clear();
   FillQueue(photons, startTime, endTime);
@@ -203,13 +240,179 @@ void MakeCrvSiPMCharges::Simulate(const std::vector<std::pair<double,size_t> > &
   } //while(1)
 }
 
+void MakeCrvSiPMCharges::BuildAliasTable()
+{
+  //Vose's alias method for the non-empty bins of the photon map
+  std::vector<double> weights;
+  for(int ix=1; ix<=_photonMap->GetNbinsX(); ix++)
+  {
+    for(int iy=1; iy<=_photonMap->GetNbinsY(); iy++)
+    {
+      double weight=_photonMap->GetBinContent(ix,iy);
+      if(!(weight>0)) continue;
+      weights.push_back(weight);
+      _aliasBinLowX.push_back(_photonMap->GetXaxis()->GetBinLowEdge(ix));
+      _aliasBinWidthX.push_back(_photonMap->GetXaxis()->GetBinWidth(ix));
+      _aliasBinLowY.push_back(_photonMap->GetYaxis()->GetBinLowEdge(iy));
+      _aliasBinWidthY.push_back(_photonMap->GetYaxis()->GetBinWidth(iy));
+    }
+  }
+  size_t n=weights.size();
+  if(n==0) throw std::logic_error("Photon map is empty.");
+  double sum=std::accumulate(weights.begin(),weights.end(),0.0);
+
+  _aliasProbability.assign(n,1.0);
+  _aliasIndex.resize(n);
+  std::iota(_aliasIndex.begin(),_aliasIndex.end(),0);
+  std::vector<size_t> small, large;
+  for(size_t i=0; i<n; i++)
+  {
+    weights[i]*=n/sum;
+    if(weights[i]<1.0) small.push_back(i);
+    else large.push_back(i);
+  }
+  while(!small.empty() && !large.empty())
+  {
+    size_t s=small.back();
+    size_t l=large.back();
+    small.pop_back();
+    _aliasProbability[s]=weights[s];
+    _aliasIndex[s]=l;
+    weights[l]-=1.0-weights[s];
+    if(weights[l]<1.0)
+    {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+}
+
+double MakeCrvSiPMCharges::NextUniform()
+{
+  //the blocks double in size, up to nUniformsPerBlock, so a SiPM wastes at most about half of what it draws
+  if(_nextUniform==_nUniforms)
+  {
+    _nUniforms=_uniformBlockSize;
+    _randFlat.fireArray(_nUniforms,_uniforms.data());
+    _nextUniform=0;
+    _uniformBlockSize=std::min(2*_uniformBlockSize,_uniforms.size());
+  }
+  return _uniforms[_nextUniform++];
+}
+
+int MakeCrvSiPMCharges::FindFiberPhotonsPixelBatched()
+{
+  //same distribution as TH2::GetRandom2: a bin according to its content, and a uniform position inside the bin
+  size_t n=_aliasProbability.size();
+  size_t bin=std::min(static_cast<size_t>(NextUniform()*n),n-1);
+  if(NextUniform()>=_aliasProbability[bin]) bin=_aliasIndex[bin];
+  int x=static_cast<int>(_aliasBinLowX[bin]+_aliasBinWidthX[bin]*NextUniform());
+  int y=static_cast<int>(_aliasBinLowY[bin]+_aliasBinWidthY[bin]*NextUniform());
+  return x*_nPixelsY+y;
+}
+
+void MakeCrvSiPMCharges::ScheduleChargeBatched(int pixel, double time, size_t photonIndex, bool darkNoise, bool crossTalk)
+{
+  //cross talk charges get inserted at the beginning of _scheduledCharges,
+  //i.e. before all other charges with the same time, and in reverse order
+  ++_chargeOrder;
+  _chargeQueue.push_back(BatchedCharge{time, crossTalk?-_chargeOrder:_chargeOrder, pixel, photonIndex, darkNoise});
+  std::push_heap(_chargeQueue.begin(),_chargeQueue.end(),std::greater<BatchedCharge>());
+}
+
+double MakeCrvSiPMCharges::GenerateAvalancheBatched(int pixel, double time, size_t photonIndex, bool darkNoise)
+{
+  //same as GenerateAvalanche
+  double dischargeTime = _pixelDischargeTimes[pixel];
+  double v = std::isnan(dischargeTime) ? _overvoltage : _overvoltage * (1.0-exp(-(time-dischargeTime)/_timeConstant));
+
+  if(NextUniform() >= GetAvalancheProbability(v)) return 0;  //no avalanche means no output charge
+
+  //after pulses
+  if(NextUniform() < _trapType0ProductionProb)
+  {
+    double traptime = -_probabilities._trapType0Lifetime * log10(NextUniform());
+    ScheduleChargeBatched(pixel, time + traptime, photonIndex, darkNoise, false);
+  }
+  if(NextUniform() < _trapType1ProductionProb)
+  {
+    double traptime = -_probabilities._trapType1Lifetime * log10(NextUniform());
+    ScheduleChargeBatched(pixel, time + traptime, photonIndex, darkNoise, false);
+  }
+
+  //cross talk in the 4 neighboring pixels
+  int x = pixel/_nPixelsY;
+  int y = pixel%_nPixelsY;
+  if(x>0            && NextUniform() < _crossTalkProductionProbSinglePixel) ScheduleChargeBatched(pixel-_nPixelsY, time, photonIndex, darkNoise, true);
+  if(x+1<_nPixelsX  && NextUniform() < _crossTalkProductionProbSinglePixel) ScheduleChargeBatched(pixel+_nPixelsY, time, photonIndex, darkNoise, true);
+  if(y>0            && NextUniform() < _crossTalkProductionProbSinglePixel) ScheduleChargeBatched(pixel-1, time, photonIndex, darkNoise, true);
+  if(y+1<_nPixelsY  && NextUniform() < _crossTalkProductionProbSinglePixel) ScheduleChargeBatched(pixel+1, time, photonIndex, darkNoise, true);
+
+  if(std::isnan(dischargeTime)) _dischargedPixels.push_back(pixel);
+  _pixelDischargeTimes[pixel] = time;
+
+  return _capacitance*v;
+}
+
+void MakeCrvSiPMCharges::SimulateBatched(const std::vector<std::pair<double,size_t> > &photons,
+                                         std::vector<SiPMresponse> &SiPMresponseVector, double startTime, double endTime)
+{
+  if(!_photonMapFitsPixels) throw std::logic_error("The photon map doesn't fit into the pixels of the SiPM.");
+
+  for(size_t i=0; i<_dischargedPixels.size(); i++) _pixelDischargeTimes[_dischargedPixels[i]]=NAN;
+  _dischargedPixels.clear();
+  _chargeQueue.clear();
+  _chargeOrder=0;
+  //don't carry random numbers drawn for the previous SiPM into this one,
+  //and start with a block sized for the photons of this SiPM
+  _nextUniform=_nUniforms=0;
+  _uniformBlockSize=std::min(std::max(nUniformsFirstBlock,nUniformsPerPhoton*photons.size()),_uniforms.size());
+
+  //schedule charges caused by the CRV counter photons
+  for(size_t i=0; i<photons.size(); i++)
+  {
+    ScheduleChargeBatched(FindFiberPhotonsPixelBatched(), photons[i].first, photons[i].second, false, false);
+  }
+
+  //schedule random thermal charges (see FillQueue)
+  double timeWindow = endTime-startTime;
+  double thermalProductionRate = _probabilities._thermalRate/_avalancheProbFullyChargedPixel;
+  int numberThermalCharges = _randPoissonQ.fire(thermalProductionRate * timeWindow);
+  for(int i=0; i<numberThermalCharges; i++)
+  {
+    int x = static_cast<int>(_nPixelsX*NextUniform());
+    int y = static_cast<int>(_nPixelsY*NextUniform());
+    double time = startTime + timeWindow * NextUniform();
+    ScheduleChargeBatched(x*_nPixelsY+y, time, 0, true, false);
+  }
+
+  while(!_chargeQueue.empty())
+  {
+    std::pop_heap(_chargeQueue.begin(),_chargeQueue.end(),std::greater<BatchedCharge>());
+    BatchedCharge charge = _chargeQueue.back();
+    _chargeQueue.pop_back();
+
+    if(_inactivePixelMap[charge._pixel]) continue;
+    if(charge._time>endTime) continue; //this is relevant for afterpulses
+
+    double outputCharge = GenerateAvalancheBatched(charge._pixel, charge._time, charge._photonIndex, charge._darkNoise);
+    double outputChargeInPEs = (outputCharge/_capacitance)/_overvoltage;
+
+    if(outputCharge>0) SiPMresponseVector.emplace_back(charge._time, outputCharge, outputChargeInPEs, charge._photonIndex, charge._darkNoise);
+  }
+}
+
 MakeCrvSiPMCharges::MakeCrvSiPMCharges(CLHEP::RandFlat &randFlat, CLHEP::RandPoissonQ &randPoissonQ, const std::string &photonMapFileName) :
-                                       _randFlat(randFlat), _randPoissonQ(randPoissonQ), _avalancheProbFullyChargedPixel(0) 
+                                       _randFlat(randFlat), _randPoissonQ(randPoissonQ), _avalancheProbFullyChargedPixel(0),
+                                       _batched(false), _photonMapFitsPixels(false), _chargeOrder(0),
+                                       _uniforms(nUniformsPerBlock), _nextUniform(0), _nUniforms(0),
+                                       _uniformBlockSize(nUniformsFirstBlock)
 {
   _photonMapFile = new TFile(photonMapFileName.c_str());
   if(_photonMapFile==NULL) throw std::logic_error("Could not open photon map file.");
   _photonMap = (TH2F*)_photonMapFile->FindObjectAny("photonMap");
   if(_photonMap==NULL) throw std::logic_error("Could not find photon map.");
+  BuildAliasTable();
 }
 
 }
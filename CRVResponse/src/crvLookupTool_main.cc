@@ -0,0 +1,200 @@
+//
+// Conversion and benchmark of the CRV photon lookup tables.
+//
+//   crvLookupTool convert TABLE FLATTABLE
+//     writes the flat lookup table, which MakeCrvPhotons maps instead of reading it
+//   crvLookupTool bench TABLE FLATTABLE [NSTEPS]
+//     times the loading of both tables, the bin search (linear scan vs. binary search),
+//     and the photon generation for NSTEPS random steps (default 100000) with both tables,
+//     and checks that both tables produce the same photons
+//
+
+#include "CRVResponse/inc/MakeCrvPhotons.hh"
+
+#include "CLHEP/Random/MixMaxRng.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  double seconds(Clock::time_point t0, Clock::time_point t1)
+  {
+    return std::chrono::duration<double>(t1-t0).count();
+  }
+
+  //the bin search before the binary search was introduced
+  unsigned int findBinLinear(const std::vector<double> &v, const double &x, bool &notFound)
+  {
+    for(size_t i=1; i<v.size(); i++)
+    {
+      if(v[i-1]<=x && v[i]>=x) return(i-1);
+    }
+    notFound=true;
+    return(-1);
+  }
+
+  //photon maker with its own random engine
+  struct PhotonMaker
+  {
+    CLHEP::MixMaxRng    engine;
+    CLHEP::RandFlat     randFlat;
+    CLHEP::RandGaussQ   randGaussQ;
+    CLHEP::RandPoissonQ randPoissonQ;
+    mu2eCrv::MakeCrvPhotons maker;
+    PhotonMaker(long seed) : engine(seed), randFlat(engine), randGaussQ(engine), randPoissonQ(engine),
+                             maker(randFlat, randGaussQ, randPoissonQ) {}
+  };
+
+  struct Step
+  {
+    CLHEP::Hep3Vector start, end;
+    double t1, t2, beta, energy, length;
+  };
+
+  void usage()
+  {
+    std::cout<<"usage: crvLookupTool convert TABLE FLATTABLE"<<std::endl;
+    std::cout<<"       crvLookupTool bench TABLE FLATTABLE [NSTEPS]"<<std::endl;
+  }
+
+  int convert(const std::string &table, const std::string &flatTable)
+  {
+    PhotonMaker p(0);
+    p.maker.LoadLookupTable(table);
+    p.maker.WriteFlatLookupTable(flatTable);
+    std::cout<<"Wrote flat lookup table "<<flatTable<<std::endl;
+    return 0;
+  }
+
+  int bench(const std::string &table, const std::string &flatTable, int nSteps)
+  {
+    //loading
+    const long seed=12345;
+    std::unique_ptr<PhotonMaker> pRead(new PhotonMaker(seed));
+    std::unique_ptr<PhotonMaker> pMapped(new PhotonMaker(seed));
+    Clock::time_point t0=Clock::now();
+    pRead->maker.LoadLookupTable(table);
+    Clock::time_point t1=Clock::now();
+    pMapped->maker.LoadLookupTable(flatTable);
+    Clock::time_point t2=Clock::now();
+    if(!pMapped->maker.IsMapped()) {std::cout<<flatTable<<" is not a flat lookup table"<<std::endl; return 1;}
+    std::printf("[crvLookupTool] load time (s): lookup table %.3f, flat lookup table %.3f\n",seconds(t0,t1),seconds(t1,t2));
+
+    //bin search
+    std::ifstream lookupfile(table,std::ios::binary);
+    mu2eCrv::LookupConstants      LC;
+    mu2eCrv::LookupCerenkov       LCerenkov;
+    mu2eCrv::LookupBinDefinitions LBD;
+    LC.Read(lookupfile);
+    LCerenkov.Read(lookupfile);
+    LBD.Read(lookupfile);
+    lookupfile.close();
+
+    CLHEP::MixMaxRng engine(seed);
+    CLHEP::RandFlat  randFlat(engine);
+    size_t nSearches=0, nMismatches=0;
+    double tLinear=0, tBinary=0;
+    for(const std::vector<double> *v : {&LBD.xBins, &LBD.yBins, &LBD.zBins, &LBD.betaBins, &LBD.thetaBins, &LBD.phiBins, &LBD.rBins})
+    {
+      if(v->size()<2) continue;
+      //include points outside of the bins
+      double margin=0.05*(v->back()-v->front());
+      std::vector<double> x(nSteps);
+      for(double &xi : x) xi=randFlat.fire(v->front()-margin,v->back()+margin);
+      std::vector<unsigned int> bLinear(nSteps), bBinary(nSteps);
+      std::vector<char> nfLinear(nSteps,0), nfBinary(nSteps,0);
+      Clock::time_point s0=Clock::now();
+      for(int i=0; i<nSteps; i++) {bool nf=false; bLinear[i]=findBinLinear(*v,x[i],nf); nfLinear[i]=nf;}
+      Clock::time_point s1=Clock::now();
+      for(int i=0; i<nSteps; i++) {bool nf=false; bBinary[i]=LBD.findBin(*v,x[i],nf); nfBinary[i]=nf;}
+      Clock::time_point s2=Clock::now();
+      tLinear+=seconds(s0,s1);
+      tBinary+=seconds(s1,s2);
+      nSearches+=nSteps;
+      for(int i=0; i<nSteps; i++)
+      {
+        if(nfLinear[i]!=nfBinary[i] || (!nfLinear[i] && bLinear[i]!=bBinary[i])) nMismatches++;
+      }
+    }
+    std::printf("[crvLookupTool] bin searches per second: linear scan %.3g, binary search %.3g, mismatches %zu of %zu\n",
+                tLinear>0?nSearches/tLinear:0., tBinary>0?nSearches/tBinary:0., nMismatches, nSearches);
+
+    //photon generation: random steps in the scintillator of muons with beta=1
+    int reflector=(LC.reflector==0?0:1);
+    std::vector<Step> steps(nSteps);
+    for(Step &step : steps)
+    {
+      step.start.set(randFlat.fire(-LC.halfThickness,LC.halfThickness),
+                     randFlat.fire(-LC.halfWidth,LC.halfWidth),
+                     randFlat.fire(-LC.halfLength,LC.halfLength));
+      CLHEP::Hep3Vector dir(randFlat.fire(-1,1),randFlat.fire(-1,1),randFlat.fire(-1,1));
+      if(dir.mag()==0) dir.set(1,0,0);
+      step.end=step.start+dir.unit()*randFlat.fire(0.5,5.0);   //mm
+      step.t1=randFlat.fire(0,1000);                            //ns
+      step.t2=step.t1+0.01;
+      step.beta=1.0;
+      step.length=(step.end-step.start).mag();
+      step.energy=0.2*step.length;                              //MeV
+    }
+
+    double tPhotons[2]={0,0};
+    size_t nPhotons[2]={0,0};
+    size_t nPhotonMismatches=0;
+    std::vector<double> times[4];
+    for(int i=0; i<nSteps; i++)
+    {
+      const Step &step=steps[i];
+      for(int iMaker=0; iMaker<2; iMaker++)
+      {
+        mu2eCrv::MakeCrvPhotons &maker=(iMaker==0?pRead->maker:pMapped->maker);
+        Clock::time_point p0=Clock::now();
+        maker.MakePhotons(step.start, step.end, step.t1, step.t2, step.beta, 1.0, step.energy, step.length, reflector);
+        Clock::time_point p1=Clock::now();
+        tPhotons[iMaker]+=seconds(p0,p1);
+        for(int SiPM=0; SiPM<4; SiPM++)
+        {
+          nPhotons[iMaker]+=maker.GetNumberOfPhotons(SiPM);
+          if(iMaker==0) times[SiPM]=maker.GetArrivalTimes(SiPM);
+          else if(times[SiPM]!=maker.GetArrivalTimes(SiPM)) nPhotonMismatches++;
+        }
+      }
+    }
+    for(int iMaker=0; iMaker<2; iMaker++)
+    {
+      std::printf("[crvLookupTool] %s: %d steps, steps per second %.3g, photons per second %.3g\n",
+                  iMaker==0?"lookup table     ":"flat lookup table", nSteps,
+                  tPhotons[iMaker]>0?nSteps/tPhotons[iMaker]:0., tPhotons[iMaker]>0?nPhotons[iMaker]/tPhotons[iMaker]:0.);
+    }
+    std::printf("[crvLookupTool] SiPMs with different photons %zu\n",nPhotonMismatches);
+
+    return (nMismatches==0 && nPhotonMismatches==0)?0:1;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if(argc<2) {usage(); return 1;}
+  std::string command=argv[1];
+  try
+  {
+    if(command=="convert" && argc==4) return convert(argv[2],argv[3]);
+    if(command=="bench" && (argc==4 || argc==5)) return bench(argv[2],argv[3],argc==5?atoi(argv[4]):100000);
+  }
+  catch(std::exception &e)
+  {
+    std::cout<<"crvLookupTool: "<<e.what()<<std::endl;
+    return 1;
+  }
+  usage();
+  return 1;
+}
@@ -0,0 +1,189 @@
+//
+// Statistical comparison of the standard and the batched SiPM simulation of MakeCrvSiPMCharges.
+//
+//   crvSiPMChargesTest PHOTONMAP [NTRIALS]
+//
+// Both simulations (with independent random engines) simulate NTRIALS SiPMs (default 20000)
+// for a few scenarios with the SiPM constants of CRVResponse/fcl/prolog_v09.fcl.
+// For the number of charges, the number of dark noise charges and the total charge (in PEs) per SiPM,
+// the means are compared (z-score) and the distributions of the total charge are compared with a KS test.
+// Both simulations are timed.
+// The exit code is 1, if any |z|>5 or any KS statistic is above its critical value at 0.1% significance.
+//
+
+#include "CRVResponse/inc/MakeCrvSiPMCharges.hh"
+
+#include "CLHEP/Random/MixMaxRng.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  //SiPM simulation with its own random engine
+  struct SiPMSimulation
+  {
+    CLHEP::MixMaxRng    engine;
+    CLHEP::RandFlat     randFlat;
+    CLHEP::RandPoissonQ randPoissonQ;
+    mu2eCrv::MakeCrvSiPMCharges sim;
+    SiPMSimulation(long seed, const std::string &photonMap, bool batched) : engine(seed), randFlat(engine), randPoissonQ(engine),
+                                                                             sim(randFlat, randPoissonQ, photonMap)
+    {
+      mu2eCrv::MakeCrvSiPMCharges::ProbabilitiesStruct probabilities;
+      probabilities._avalancheProbParam1 = 0.607;
+      probabilities._avalancheProbParam2 = 2.7;
+      probabilities._trapType0Prob = 0.14;     //the trap probabilities are 0 in prolog_v09.fcl,
+      probabilities._trapType1Prob = 0.06;     //but the afterpulses are tested here, too
+      probabilities._trapType0Lifetime = 5.0;
+      probabilities._trapType1Lifetime = 50.0;
+      probabilities._thermalRate = 3.0e-4;
+      probabilities._crossTalkProb = 0.05;
+      std::vector<std::pair<int,int> > inactivePixels;
+      for(int x=18; x<=21; x++) for(int y=18; y<=21; y++) inactivePixels.emplace_back(x,y);
+      sim.SetSiPMConstants(40, 40, 3.0, 13.3, 8.84e-14, probabilities, inactivePixels);
+      sim.SetBatchedSimulation(batched);
+    }
+  };
+
+  struct Scenario
+  {
+    const char *name;
+    int         nPhotons;
+    double      photonTime, photonTimeSpread;
+  };
+
+  struct Sample
+  {
+    std::vector<double> nCharges, nDarkNoise, PEs;
+    double time=0;
+  };
+
+  double mean(const std::vector<double> &v)
+  {
+    double s=0;
+    for(double x : v) s+=x;
+    return v.empty()?0:s/v.size();
+  }
+
+  double variance(const std::vector<double> &v)
+  {
+    double m=mean(v), s=0;
+    for(double x : v) s+=(x-m)*(x-m);
+    return v.size()<2?0:s/(v.size()-1);
+  }
+
+  double zScore(const std::vector<double> &a, const std::vector<double> &b)
+  {
+    double sigma=sqrt(variance(a)/a.size()+variance(b)/b.size());
+    double d=mean(a)-mean(b);
+    return sigma>0?d/sigma:(d==0?0:INFINITY);
+  }
+
+  //two-sample Kolmogorov-Smirnov statistic
+  double ksStatistic(std::vector<double> a, std::vector<double> b)
+  {
+    std::sort(a.begin(),a.end());
+    std::sort(b.begin(),b.end());
+    size_t i=0, j=0;
+    double d=0;
+    while(i<a.size() && j<b.size())
+    {
+      double x=std::min(a[i],b[j]);
+      while(i<a.size() && a[i]==x) i++;
+      while(j<b.size() && b[j]==x) j++;
+      d=std::max(d,fabs(double(i)/a.size()-double(j)/b.size()));
+    }
+    return d;
+  }
+
+  Sample simulate(mu2eCrv::MakeCrvSiPMCharges &sim, CLHEP::RandFlat &randFlat, const Scenario &scenario, int nTrials)
+  {
+    const double startTime=400.0, endTime=1750.0;
+    Sample sample;
+    std::vector<std::pair<double,size_t> > photons;
+    std::vector<mu2eCrv::SiPMresponse> responses;
+    for(int trial=0; trial<nTrials; trial++)
+    {
+      photons.clear();
+      for(int i=0; i<scenario.nPhotons; i++) photons.emplace_back(scenario.photonTime+scenario.photonTimeSpread*randFlat.fire(),i);
+      std::sort(photons.begin(),photons.end());
+      responses.clear();
+      Clock::time_point t0=Clock::now();
+      sim.Simulate(photons, responses, startTime, endTime);
+      Clock::time_point t1=Clock::now();
+      sample.time+=std::chrono::duration<double>(t1-t0).count();
+
+      double nDarkNoise=0, PEs=0;
+      for(const mu2eCrv::SiPMresponse &r : responses)
+      {
+        if(r._darkNoise) nDarkNoise++;
+        PEs+=r._chargeInPEs;
+      }
+      sample.nCharges.push_back(responses.size());
+      sample.nDarkNoise.push_back(nDarkNoise);
+      sample.PEs.push_back(PEs);
+    }
+    return sample;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if(argc!=2 && argc!=3)
+  {
+    std::cout<<"usage: crvSiPMChargesTest PHOTONMAP [NTRIALS]"<<std::endl;
+    return 1;
+  }
+  std::string photonMap=argv[1];
+  int nTrials=(argc==3?atoi(argv[2]):20000);
+
+  const Scenario scenarios[]={{"dark noise only",      0,  500.0,  0.0},
+                              {"10 photons",          10,  500.0, 10.0},
+                              {"200 photons",        200,  500.0, 10.0},
+                              {"2000 photons (saturation)", 2000, 500.0, 30.0}};
+
+  bool passed=true;
+  try
+  {
+    SiPMSimulation standard(1234, photonMap, false);
+    SiPMSimulation batched(5678, photonMap, true);
+    for(const Scenario &scenario : scenarios)
+    {
+      Sample s=simulate(standard.sim, standard.randFlat, scenario, nTrials);
+      Sample b=simulate(batched.sim, batched.randFlat, scenario, nTrials);
+
+      double zCharges=zScore(s.nCharges,b.nCharges);
+      double zDarkNoise=zScore(s.nDarkNoise,b.nDarkNoise);
+      double zPEs=zScore(s.PEs,b.PEs);
+      double ks=ksStatistic(s.PEs,b.PEs);
+      double ksCritical=1.95*sqrt(2.0/nTrials);
+      bool ok=fabs(zCharges)<5 && fabs(zDarkNoise)<5 && fabs(zPEs)<5 && ks<ksCritical;
+      passed=passed && ok;
+
+      std::printf("[crvSiPMChargesTest] %s: %s\n", scenario.name, ok?"ok":"FAILED");
+      std::printf("  charges per SiPM    standard %9.4f  batched %9.4f  z %6.2f\n", mean(s.nCharges), mean(b.nCharges), zCharges);
+      std::printf("  dark noise per SiPM standard %9.4f  batched %9.4f  z %6.2f\n", mean(s.nDarkNoise), mean(b.nDarkNoise), zDarkNoise);
+      std::printf("  PEs per SiPM        standard %9.4f  batched %9.4f  z %6.2f  KS %.4f (critical %.4f)\n",
+                  mean(s.PEs), mean(b.PEs), zPEs, ks, ksCritical);
+      std::printf("  SiPMs per second    standard %9.4g  batched %9.4g\n",
+                  s.time>0?nTrials/s.time:0., b.time>0?nTrials/b.time:0.);
+    }
+  }
+  catch(std::exception &e)
+  {
+    std::cout<<"crvSiPMChargesTest: "<<e.what()<<std::endl;
+    return 1;
+  }
+
+  return passed?0:1;
+}
@@ -123,10 +123,9 @@ namespace mu2e {
               int visitId = crystalToVisit.front();
               isVisited[visitId]=true;
 
-              std::vector<int>  neighborsId = cal.crystal(visitId).neighbors();
-              if (extendSearch_) std::copy(cal.nextNeighbors(visitId).begin(), cal.nextNeighbors(visitId).end(), std::back_inserter(neighborsId));
-
-              for (const auto& iId : neighborsId)
+              // first ring, then second ring if requested, read in place from the calorimeter tables
+              for (int ring=0; ring < (extendSearch_ ? 2 : 1); ++ring)
+              for (int iId : (ring==0) ? cal.lookup().neighbors(visitId) : cal.lookup().nextNeighbors(visitId))
               {
                   if (isVisited[iId]) continue;
                   isVisited[iId] = true;
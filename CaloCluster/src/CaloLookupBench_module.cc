@@ -0,0 +1,301 @@
+//
+// Validate the precomputed calorimeter tables (CaloLookup) against the Disk / CaloGeomUtil computations
+// they replace, and time both:
+//   - crystalIdxFromPosition and nearestIdxFromPosition at random points around each disk, a fraction of
+//     them on the boundaries of the lookup grid
+//   - the neighbor and next neighbor lists, the crystal positions in the disk front face frame and the
+//     front face to tracker transformation
+//   - a flood fill clustering from each hit crystal of random occupancy patterns, copying the neighbor
+//     lists as the clustering did before, and reading them from the tables
+// Any difference throws. Everything is done in beginRun.
+//
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "fhiclcpp/types/Atom.h"
+#include "cetlib_except/exception.h"
+
+#include "CalorimeterGeom/inc/Calorimeter.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <vector>
+
+
+namespace mu2e {
+
+  class CaloLookupBench : public art::EDAnalyzer
+  {
+     public:
+        struct Config
+        {
+            using Name    = fhicl::Name;
+            using Comment = fhicl::Comment;
+            fhicl::Atom<unsigned>  nPoints        { Name("nPoints"),        Comment("Number of random points per disk"), 100000 };
+            fhicl::Atom<double>    boundaryFrac   { Name("boundaryFrac"),   Comment("Fraction of the points on the grid cell boundaries"), 0.1 };
+            fhicl::Atom<unsigned>  nPatterns      { Name("nPatterns"),      Comment("Number of random occupancy patterns for the clustering"), 1000 };
+            fhicl::Atom<double>    occupancy      { Name("occupancy"),      Comment("Fraction of crystals with a hit in each pattern"), 0.05 };
+            fhicl::Atom<bool>      extendSearch   { Name("extendSearch"),   Comment("Visit the next neighbors in the clustering"), true };
+            fhicl::Atom<unsigned>  seed           { Name("seed"),           Comment("Random seed"), 2468 };
+        };
+
+        explicit CaloLookupBench(const art::EDAnalyzer::Table<Config>& config) :
+          EDAnalyzer{config},
+          nPoints_      (config().nPoints()),
+          boundaryFrac_ (config().boundaryFrac()),
+          nPatterns_    (config().nPatterns()),
+          occupancy_    (config().occupancy()),
+          extendSearch_ (config().extendSearch()),
+          seed_         (config().seed())
+        {}
+
+        void beginRun(const art::Run& run) override;
+        void analyze(const art::Event&) override {};
+
+
+     private:
+        using Clock = std::chrono::high_resolution_clock;
+
+        unsigned  nPoints_;
+        double    boundaryFrac_;
+        unsigned  nPatterns_;
+        double    occupancy_;
+        bool      extendSearch_;
+        unsigned  seed_;
+
+        int  refCrystalIdx(const Calorimeter& cal, const CLHEP::Hep3Vector& pos) const;
+        int  refNearestIdx(const Calorimeter& cal, const CLHEP::Hep3Vector& pos) const;
+        void validatePositions(const Calorimeter& cal, std::mt19937_64& engine) const;
+        void validateTables(const Calorimeter& cal) const;
+        void benchClustering(const Calorimeter& cal, std::mt19937_64& engine) const;
+  };
+
+
+  //----------------------------------------------------------------------------------------------------------
+  // The computations of DiskCalorimeter before the tables
+  int CaloLookupBench::refCrystalIdx(const Calorimeter& cal, const CLHEP::Hep3Vector& pos) const
+  {
+      for (unsigned idisk=0;idisk<cal.nDisk();++idisk)
+      {
+          if (!cal.geomUtil().isInsideSection(idisk,pos)) continue;
+          CLHEP::Hep3Vector posInSection = cal.geomUtil().mu2eToDisk(idisk,pos);
+          return cal.disk(idisk).crystalOffset() + cal.disk(idisk).idxFromPosition(posInSection.x(),posInSection.y());
+      }
+      return -1;
+  }
+
+  int CaloLookupBench::refNearestIdx(const Calorimeter& cal, const CLHEP::Hep3Vector& pos) const
+  {
+      CLHEP::Hep3Vector posInSection = cal.geomUtil().mu2eToDisk(0,pos);
+
+      unsigned closest(0);
+      for (unsigned idisk=1;idisk<cal.nDisk();++idisk)
+         if (std::abs(cal.disk(idisk).geomInfo().origin().z()-pos.z()) < std::abs(cal.disk(closest).geomInfo().origin().z()-pos.z())) closest = idisk;
+
+      std::vector<int> cand = cal.disk(0).nearestIdxFromPosition(posInSection.x(),posInSection.y());
+      auto deltaPerp = [&](int ic) {return sqrt((cal.crystal(ic).position()-pos).perp2());};
+      auto best = std::min_element(cand.begin(),cand.end(),[&](int ic1, int ic2) {return deltaPerp(ic1) < deltaPerp(ic2);});
+
+      return *best + cal.disk(closest).crystalOffset();
+  }
+
+
+  //----------------------------------------------------------------------------------------------------------
+  void CaloLookupBench::validatePositions(const Calorimeter& cal, std::mt19937_64& engine) const
+  {
+      const CaloLookup& lookup = cal.lookup();
+      const double zLength     = cal.geomUtil().crystalZLength();
+      std::uniform_real_distribution<double> flat(0.,1.);
+
+      for (unsigned idisk=0;idisk<cal.nDisk();++idisk)
+      {
+          const Disk& disk   = cal.disk(idisk);
+          const double cell  = disk.nominalCellSize();
+          const double range = disk.outerRadius()+cell;
+
+          // points in the front face frame of the disk, from just before the front face to just after the back
+          std::vector<CLHEP::Hep3Vector> points;
+          points.reserve(nPoints_);
+          for (unsigned i=0;i<nPoints_;++i)
+          {
+              double x = range*(2.0*flat(engine)-1.0);
+              double y = range*(2.0*flat(engine)-1.0);
+              double z = zLength*(1.2*flat(engine)-0.1);
+              if (flat(engine) < boundaryFrac_) {x = 0.5*cell*std::round(2.0*x/cell); y = 0.5*cell*std::round(2.0*y/cell);}
+              points.push_back(cal.geomUtil().diskFFToMu2e(idisk,CLHEP::Hep3Vector(x,y,z)));
+          }
+
+          std::vector<int> idxRef(points.size()), idxNew(points.size()), nearRef(points.size()), nearNew(points.size());
+          auto t0 = Clock::now();
+          for (size_t i=0;i<points.size();++i) idxRef[i] = refCrystalIdx(cal,points[i]);
+          auto t1 = Clock::now();
+          for (size_t i=0;i<points.size();++i) idxNew[i] = lookup.crystalIdxFromPosition(points[i]);
+          auto t2 = Clock::now();
+          for (size_t i=0;i<points.size();++i) nearRef[i] = refNearestIdx(cal,points[i]);
+          auto t3 = Clock::now();
+          for (size_t i=0;i<points.size();++i) nearNew[i] = lookup.nearestIdxFromPosition(points[i]);
+          auto t4 = Clock::now();
+
+          unsigned nInside(0), nDiffIdx(0), nDiffNear(0);
+          for (size_t i=0;i<points.size();++i)
+          {
+              if (idxRef[i]  > -1)        ++nInside;
+              if (idxRef[i]  != idxNew[i])  ++nDiffIdx;
+              if (nearRef[i] != nearNew[i]) ++nDiffNear;
+          }
+
+          const double np = points.size();
+          std::printf("CaloLookupBench disk %u: %zu points, %u inside a crystal\n", idisk, points.size(), nInside);
+          std::printf("  crystalIdxFromPosition  %8u differences  %9.1f ns/pt reference  %9.1f ns/pt lookup\n", nDiffIdx,
+                      1e9*std::chrono::duration<double>(t1-t0).count()/np, 1e9*std::chrono::duration<double>(t2-t1).count()/np);
+          std::printf("  nearestIdxFromPosition  %8u differences  %9.1f ns/pt reference  %9.1f ns/pt lookup\n", nDiffNear,
+                      1e9*std::chrono::duration<double>(t3-t2).count()/np, 1e9*std::chrono::duration<double>(t4-t3).count()/np);
+
+          if (nDiffIdx > 0 || nDiffNear > 0)
+             throw cet::exception("CaloLookupBench") << " disk " << idisk << ": " << nDiffIdx << " crystalIdxFromPosition and "
+                                                     << nDiffNear << " nearestIdxFromPosition differences\n";
+      }
+  }
+
+
+  //----------------------------------------------------------------------------------------------------------
+  void CaloLookupBench::validateTables(const Calorimeter& cal) const
+  {
+      const CaloLookup& lookup = cal.lookup();
+
+      unsigned nDiffNeighbors(0), nDiffPosition(0), nDiffTracker(0);
+      for (int ic=0;ic<cal.nCrystal();++ic)
+      {
+          for (bool raw : {false,true})
+          {
+              auto n1 = lookup.neighbors(ic,raw);
+              auto n2 = lookup.nextNeighbors(ic,raw);
+              if (!std::equal(n1.begin(),n1.end(),cal.neighbors(ic,raw).begin(),cal.neighbors(ic,raw).end()))         ++nDiffNeighbors;
+              if (!std::equal(n2.begin(),n2.end(),cal.nextNeighbors(ic,raw).begin(),cal.nextNeighbors(ic,raw).end())) ++nDiffNeighbors;
+          }
+
+          const Crystal& crystal = cal.crystal(ic);
+          CLHEP::Hep3Vector posFF = cal.geomUtil().mu2eToDiskFF(crystal.diskID(),crystal.position());
+          if (lookup.crystalPosFF(ic) != posFF) ++nDiffPosition;
+
+          CLHEP::Hep3Vector posTracker = cal.geomUtil().mu2eToTracker(cal.geomUtil().diskFFToMu2e(crystal.diskID(),posFF));
+          if (lookup.diskFFToTracker(crystal.diskID(),posFF) != posTracker) ++nDiffTracker;
+      }
+
+      for (unsigned idisk=0;idisk<cal.nDisk();++idisk)
+         if (lookup.frontFaceInTracker(idisk) != cal.geomUtil().mu2eToTracker(cal.disk(idisk).geomInfo().frontFaceCenter())) ++nDiffTracker;
+
+      std::printf("CaloLookupBench tables: %d crystals, %u neighbor list differences, %u position differences, %u transformation differences\n",
+                  cal.nCrystal(), nDiffNeighbors, nDiffPosition, nDiffTracker);
+
+      if (nDiffNeighbors > 0 || nDiffPosition > 0 || nDiffTracker > 0)
+         throw cet::exception("CaloLookupBench") << " " << nDiffNeighbors << " neighbor list, " << nDiffPosition << " position and "
+                                                 << nDiffTracker << " transformation differences\n";
+  }
+
+
+  //----------------------------------------------------------------------------------------------------------
+  // Flood fill from each hit crystal through the hit crystals, as the clustering does
+  void CaloLookupBench::benchClustering(const Calorimeter& cal, std::mt19937_64& engine) const
+  {
+      const CaloLookup& lookup = cal.lookup();
+      std::uniform_real_distribution<double> flat(0.,1.);
+
+      std::vector<std::vector<char>> patterns(nPatterns_, std::vector<char>(cal.nCrystal()));
+      for (auto& pattern : patterns)
+         for (auto& hit : pattern) hit = flat(engine) < occupancy_;
+
+      std::vector<char> isVisited(cal.nCrystal());
+      std::queue<int>   crystalToVisit;
+      size_t nSeeds(0), nVisitCopy(0), nVisitTable(0);
+
+      auto t0 = Clock::now();
+      for (const auto& pattern : patterns)
+      {
+          for (int seed=0;seed<cal.nCrystal();++seed)
+          {
+              if (!pattern[seed]) continue;
+              ++nSeeds;
+              std::fill(isVisited.begin(),isVisited.end(),0);
+              crystalToVisit.push(seed);
+              while (!crystalToVisit.empty())
+              {
+                  int visitId = crystalToVisit.front();
+                  isVisited[visitId] = 1;
+
+                  std::vector<int> neighborsId = cal.crystal(visitId).neighbors();
+                  if (extendSearch_) neighborsId.insert(neighborsId.end(), cal.nextNeighbors(visitId).begin(), cal.nextNeighbors(visitId).end());
+                  for (int iId : neighborsId)
+                  {
+                      if (isVisited[iId]) continue;
+                      isVisited[iId] = 1;
+                      ++nVisitCopy;
+                      if (pattern[iId]) crystalToVisit.push(iId);
+                  }
+                  crystalToVisit.pop();
+              }
+          }
+      }
+      auto t1 = Clock::now();
+      for (const auto& pattern : patterns)
+      {
+          for (int seed=0;seed<cal.nCrystal();++seed)
+          {
+              if (!pattern[seed]) continue;
+              std::fill(isVisited.begin(),isVisited.end(),0);
+              crystalToVisit.push(seed);
+              while (!crystalToVisit.empty())
+              {
+                  int visitId = crystalToVisit.front();
+                  isVisited[visitId] = 1;
+
+                  for (int ring=0; ring < (extendSearch_ ? 2 : 1); ++ring)
+                  for (int iId : (ring==0) ? lookup.neighbors(visitId) : lookup.nextNeighbors(visitId))
+                  {
+                      if (isVisited[iId]) continue;
+                      isVisited[iId] = 1;
+                      ++nVisitTable;
+                      if (pattern[iId]) crystalToVisit.push(iId);
+                  }
+                  crystalToVisit.pop();
+              }
+          }
+      }
+      auto t2 = Clock::now();
+
+      const double dtCopy  = std::chrono::duration<double>(t1-t0).count();
+      const double dtTable = std::chrono::duration<double>(t2-t1).count();
+      std::printf("CaloLookupBench clustering: %u patterns, occupancy %g, %zu seeds, visits %zu / %zu\n",
+                  nPatterns_, occupancy_, nSeeds, nVisitCopy, nVisitTable);
+      std::printf("  neighbor copies  %9.1f ns/visit  %9.3g clusters/s\n", 1e9*dtCopy/std::max<size_t>(nVisitCopy,1), nSeeds/dtCopy);
+      std::printf("  neighbor tables  %9.1f ns/visit  %9.3g clusters/s\n", 1e9*dtTable/std::max<size_t>(nVisitTable,1), nSeeds/dtTable);
+
+      if (nVisitCopy != nVisitTable)
+         throw cet::exception("CaloLookupBench") << " clustering visits differ: " << nVisitCopy << " with copies, "
+                                                 << nVisitTable << " with tables\n";
+  }
+
+
+  //----------------------------------------------------------------------------------------------------------
+  void CaloLookupBench::beginRun(const art::Run&)
+  {
+      const Calorimeter& cal = *(GeomHandle<Calorimeter>());
+      std::mt19937_64 engine(seed_);
+
+      validateTables(cal);
+      validatePositions(cal,engine);
+      benchClustering(cal,engine);
+  }
+
+}
+
+DEFINE_ART_MODULE(mu2e::CaloLookupBench);
@@ -32,10 +32,9 @@ namespace mu2e {
 		 int visitId         = crystalToVisit_.front();
 		 isVisited_[visitId] = true;
 
-		 std::vector<int>  neighborsId = cal_->crystal(visitId).neighbors();
-                 if (addSecondRing_) neighborsId.insert(neighborsId.end(), cal_->nextNeighbors(visitId).begin(), cal_->nextNeighbors(visitId).end());
-		 
-                 for (auto& iId : neighborsId)
+		 // first ring, then second ring if requested, read in place from the calorimeter tables
+                 for (int ring=0; ring < (addSecondRing_ ? 2 : 1); ++ring)
+		 for (int iId : (ring==0) ? cal_->lookup().neighbors(visitId) : cal_->lookup().nextNeighbors(visitId))
 		 {               
 		     if (isVisited_[iId]) continue;
 		     isVisited_[iId] = true;
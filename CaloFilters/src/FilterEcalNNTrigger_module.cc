@@ -85,7 +85,10 @@ namespace mu2e {
        const Calorimeter& cal = *(GeomHandle<Calorimeter>());
        const CaloClusterCollection& caloClusters(*caloClustersHandle);
  
-       bool select(false);
+       // collect the variables of all candidate clusters and score them in one call
+       constexpr size_t nvars(8);
+       std::vector<size_t> candidates;
+       std::vector<float>  mvavars;
        for (auto clusterIt=caloClusters.begin(); clusterIt != caloClusters.end();++clusterIt)
        {
           if (clusterIt->energyDep() < minEtoTest_) continue;
@@ -101,22 +104,27 @@ namespace mu2e {
               if (std::find(nneighborsId.begin(), nneighborsId.end(), hit->crystalID()) != nneighborsId.end()) {e25 += hit->energyDep();}
           }
 
-          std::vector<float> mvavars(8,0.0);
-          mvavars[0] = clusterIt->energyDep();
-          mvavars[1] = clusterIt->cog3Vector().perp();
-          mvavars[2] = clusterIt->size(); 
-          mvavars[3] = hits[0]->energyDep();
-          mvavars[4] = (hits.size()>1) ?  hits[0]->energyDep() + hits[1]->energyDep() : hits[0]->energyDep();
-          mvavars[5] = e9;
-          mvavars[6] = e25;
-          mvavars[7] = clusterIt->diskID();
-          
-          float mvaout = caloBkgMVA_.evalMVA(mvavars);
-          if (mvaout < minMVAScore_) continue;
+          candidates.push_back(std::distance(caloClusters.begin(),clusterIt));
+          mvavars.push_back(clusterIt->energyDep());
+          mvavars.push_back(clusterIt->cog3Vector().perp());
+          mvavars.push_back(clusterIt->size()); 
+          mvavars.push_back(hits[0]->energyDep());
+          mvavars.push_back((hits.size()>1) ?  hits[0]->energyDep() + hits[1]->energyDep() : hits[0]->energyDep());
+          mvavars.push_back(e9);
+          mvavars.push_back(e25);
+          mvavars.push_back(clusterIt->diskID());
+       }
+
+       std::vector<float> mvaout;
+       caloBkgMVA_.evalMVA(mvavars,nvars,mvaout);
+
+       bool select(false);
+       for (size_t ic=0; ic < candidates.size(); ++ic)
+       {
+          if (mvaout[ic] < minMVAScore_) continue;
 
           select = true;
-          size_t index = std::distance(caloClusters.begin(),clusterIt);
-          trigInfo._caloClusters.push_back(art::Ptr<CaloCluster>(caloClustersHandle,index));
+          trigInfo._caloClusters.push_back(art::Ptr<CaloCluster>(caloClustersHandle,candidates[ic]));
      }
      
      return select;
@@ -48,7 +48,7 @@ namespace mu2e {
 
         void                         addFullNoise(std::vector<double>& wfVector, bool doAR);
         void                         addSampleNoise(std::vector<double>& wfVector, unsigned istart, unsigned ilength);
-        void                         addSaltAndPepper(std::vector<double>& wfVector);
+        unsigned                     addSaltAndPepper(std::vector<double>& wfVector);
         void                         plotNoise(std::string name);
 
         const std::vector<double>&   noise()    const {return waveform_;}
@@ -0,0 +1,110 @@
+//
+// Compare the distributions of two CaloDigi collections, e.g. made from individual and binned PE times.
+// For each collection the module fills histograms of the number of digis per event, the digi start time,
+// the peak ADC value and the sum of the waveform, and at the end of the job prints their means and the
+// Kolmogorov-Smirnov probability that the two samples come from the same distribution.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art_root_io/TFileService.h"
+#include "art_root_io/TFileDirectory.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include "RecoDataProducts/inc/CaloDigi.hh"
+
+#include "TH1.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <numeric>
+#include <string>
+
+
+namespace mu2e {
+
+  class CaloDigiCompare : public art::EDAnalyzer
+  {
+     public:
+         struct Config
+         {
+             using Name    = fhicl::Name;
+             using Comment = fhicl::Comment;
+             fhicl::Atom<art::InputTag> caloDigiCollection1 { Name("caloDigiCollection1"), Comment("Reference CaloDigi collection") };
+             fhicl::Atom<art::InputTag> caloDigiCollection2 { Name("caloDigiCollection2"), Comment("CaloDigi collection to compare") };
+         };
+
+         explicit CaloDigiCompare(const art::EDAnalyzer::Table<Config>& config) :
+            EDAnalyzer{config},
+            caloDigi1Token_{consumes<CaloDigiCollection>(config().caloDigiCollection1())},
+            caloDigi2Token_{consumes<CaloDigiCollection>(config().caloDigiCollection2())}
+         {}
+
+         void beginJob() override;
+         void analyze(const art::Event& event) override;
+         void endJob() override;
+
+     private:
+         enum {hNDigi, hT0, hPeak, hSum, nHist};
+         void fill(const CaloDigiCollection& digis, std::array<TH1F*,nHist>& hist);
+
+         const art::ProductToken<CaloDigiCollection> caloDigi1Token_;
+         const art::ProductToken<CaloDigiCollection> caloDigi2Token_;
+         std::array<TH1F*,nHist>                     hist1_;
+         std::array<TH1F*,nHist>                     hist2_;
+  };
+
+
+  //-----------------------------------------------------------------------------
+  void CaloDigiCompare::beginJob()
+  {
+      art::ServiceHandle<art::TFileService> tfs;
+      for (int i : {1,2})
+      {
+          auto& hist = (i==1) ? hist1_ : hist2_;
+          std::string s = std::to_string(i);
+          hist[hNDigi] = tfs->make<TH1F>(("hNDigi"+s).c_str(), "Number of digis per event", 200,  0, 2000);
+          hist[hT0]    = tfs->make<TH1F>(("hT0"+s).c_str(),    "Digi t0 (ns)",              170,  0, 1700);
+          hist[hPeak]  = tfs->make<TH1F>(("hPeak"+s).c_str(),  "Digi peak ADC",             205,  0, 4100);
+          hist[hSum]   = tfs->make<TH1F>(("hSum"+s).c_str(),   "Digi waveform sum (ADC)",   200,  0, 40000);
+      }
+  }
+
+  //-----------------------------------------------------------------------------
+  void CaloDigiCompare::analyze(const art::Event& event)
+  {
+      fill(*event.getValidHandle(caloDigi1Token_), hist1_);
+      fill(*event.getValidHandle(caloDigi2Token_), hist2_);
+  }
+
+  //-----------------------------------------------------------------------------
+  void CaloDigiCompare::fill(const CaloDigiCollection& digis, std::array<TH1F*,nHist>& hist)
+  {
+      hist[hNDigi]->Fill(digis.size());
+      for (const auto& digi : digis)
+      {
+          const auto& wf = digi.waveform();
+          if (wf.empty()) continue;
+          hist[hT0]->Fill(digi.t0());
+          hist[hPeak]->Fill(*std::max_element(wf.begin(),wf.end()));
+          hist[hSum]->Fill(std::accumulate(wf.begin(),wf.end(),0));
+      }
+  }
+
+  //-----------------------------------------------------------------------------
+  void CaloDigiCompare::endJob()
+  {
+      std::printf("[CaloDigiCompare] %-28s %12s %12s %10s\n", "quantity", "mean 1", "mean 2", "KS prob");
+      for (int i=0;i<nHist;++i)
+      {
+          double prob = (hist1_[i]->GetEntries() > 0 && hist2_[i]->GetEntries() > 0) ? hist1_[i]->KolmogorovTest(hist2_[i]) : -1;
+          std::printf("[CaloDigiCompare] %-28s %12.4g %12.4g %10.3g\n", hist1_[i]->GetTitle(),
+                      hist1_[i]->GetMean(), hist2_[i]->GetMean(), prob);
+      }
+  }
+
+}
+
+DEFINE_ART_MODULE(mu2e::CaloDigiCompare);
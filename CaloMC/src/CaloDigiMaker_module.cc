@@ -2,6 +2,7 @@
 // Simulate the readout waveform for each sensors from CaloShowerROs.
 // Individual photo-electrons are generated for each readout, including photo-statistic fluctuations
 // Simulate digitization procedure and produce CaloDigis. 
+// CaloShowerROs with binned PE times add one pulse per time bin, scaled by the number of PEs in the bin.
 //
 //
 #include "art/Framework/Core/EDProducer.h"
@@ -37,6 +38,7 @@
 #include "TStyle.h"
 #include "TGraph.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -82,7 +84,12 @@ namespace mu2e {
             addNoise_          (config().addNoise()),
             generateSpotNoise_ (config().generateSpotNoise()),
             noiseGenerator_    (config().noise_gen_conf(), engine_, 0),
-            diagLevel_         (config().diagLevel())
+            minPeakADC_        (config().minPeakADC()),
+            diagLevel_         (config().diagLevel()),
+            roStart_           (),
+            roIndex_           (),
+            waveform_          (),
+            wfADC_             ()
          {
              produces<CaloDigiCollection>();
          }
@@ -92,7 +99,9 @@ namespace mu2e {
 
     private:       
        void makeDigitization  (const CaloShowerROCollection&, CaloDigiCollection&);
+       void sortROHits        (unsigned nWaveforms, const CaloShowerROCollection&);
        void fillROHits        (unsigned iRO, std::vector<double>& waveform, const CaloShowerROCollection&, const ConditionsHandle<CalorimeterCalibrations>&);
+       void addPulse          (std::vector<double>& waveform, float time, double scaleFactor);
        void generateNoise     (std::vector<double>& waveform, unsigned iRO, const ConditionsHandle<CalorimeterCalibrations>&);
        void buildOutputDigi   (unsigned iRO, std::vector<double>& waveform, int pedestal, CaloDigiCollection&);
        void diag0             (unsigned, const std::vector<int>&);
@@ -114,7 +123,12 @@ namespace mu2e {
        bool                    generateSpotNoise_;
        CaloNoiseSimGenerator   noiseGenerator_;
        const Calorimeter*      calorimeter_;
+       int                     minPeakADC_;
        int                     diagLevel_;
+       std::vector<unsigned>   roStart_;   // CaloShowerROs of readout i are roIndex_[roStart_[i]] ... roIndex_[roStart_[i+1]-1]
+       std::vector<unsigned>   roIndex_;
+       std::vector<double>     waveform_;  // waveform buffers reused for all readouts
+       std::vector<int>        wfADC_;
   };
 
 
@@ -164,41 +178,93 @@ namespace mu2e {
       unsigned nWaveforms   = calorimeter_->nCrystal()*calorimeter_->caloInfo().getInt("nSiPMPerCrystal");
       unsigned waveformSize = static_cast<unsigned>( (mbtime_ - blindTime_ + endTimeBuffer_) / digiSampling_ ); 
 
+      sortROHits(nWaveforms, CaloShowerROs);
+      waveform_.resize(waveformSize);
+
       for (unsigned iRO=0;iRO<nWaveforms;++iRO)
       {
-          std::vector<double> waveform(waveformSize,0.0);
-          fillROHits(iRO, waveform, CaloShowerROs, calorimeterCalibrations);
-          if (addNoise_ &&  generateSpotNoise_) generateNoise(waveform, iRO, calorimeterCalibrations);
-          if (addNoise_ && !generateSpotNoise_) noiseGenerator_.addFullNoise(waveform, false);
-          buildOutputDigi(iRO, waveform, noiseGenerator_.pedestal(), caloDigiColl);
+          // Readouts without deposits: an empty waveform produces no digi, and with spot noise generateNoise 
+          // would find no signal and only add salt and pepper noise. The random numbers are drawn in the 
+          // same order as for the full treatment.
+          const bool noDeposit = roStart_[iRO] == roStart_[iRO+1] && minPeakADC_ > 0;
+          if (noDeposit && !addNoise_) continue;
+
+          std::fill(waveform_.begin(),waveform_.end(),0.0);
+          if (noDeposit && generateSpotNoise_ && calorimeterCalibrations->MeV2ADC(iRO) > 0)
+          {
+              if (noiseGenerator_.addSaltAndPepper(waveform_) > 0) 
+                 buildOutputDigi(iRO, waveform_, noiseGenerator_.pedestal(), caloDigiColl);
+              continue;
+          }
+
+          fillROHits(iRO, waveform_, CaloShowerROs, calorimeterCalibrations);
+          if (addNoise_ &&  generateSpotNoise_) generateNoise(waveform_, iRO, calorimeterCalibrations);
+          if (addNoise_ && !generateSpotNoise_) noiseGenerator_.addFullNoise(waveform_, false);
+          buildOutputDigi(iRO, waveform_, noiseGenerator_.pedestal(), caloDigiColl);
+      }
+  }
+
+
+  // Counting sort of the CaloShowerROs by SiPM ID, keeping the order of the collection for each SiPM
+  //--------------------------------------------------------------------------
+  void CaloDigiMaker::sortROHits(unsigned nWaveforms, const CaloShowerROCollection& CaloShowerROs)
+  {
+      // SiPM IDs beyond the number of readouts are not digitized
+      roStart_.assign(nWaveforms+1,0);
+      for (const auto& CaloShowerRO : CaloShowerROs)
+      {
+          if (unsigned(CaloShowerRO.SiPMID()) < nWaveforms) ++roStart_[CaloShowerRO.SiPMID()+1];
+      }
+      std::partial_sum(roStart_.begin(),roStart_.end(),roStart_.begin());
+
+      roIndex_.resize(roStart_.back());
+      std::vector<unsigned> next(roStart_.begin(),roStart_.end()-1);
+      for (unsigned i=0;i<CaloShowerROs.size();++i) 
+      {
+          unsigned SiPMID = CaloShowerROs[i].SiPMID();
+          if (SiPMID < nWaveforms) roIndex_[next[SiPMID]++] = i;
       }
   }
 
 
-  // Note: Loop could be optimized if all CaloShowerRO are ordered by SiPM ID 
   //--------------------------------------------------------------------------
   void CaloDigiMaker::fillROHits(unsigned iRO, std::vector<double>& waveform, const CaloShowerROCollection& CaloShowerROs,
                                  const ConditionsHandle<CalorimeterCalibrations>& calorimeterCalibrations)
   {
+      if (roStart_[iRO] == roStart_[iRO+1]) return;
+
       double scaleFactor = calorimeterCalibrations->MeV2ADC(iRO)/calorimeterCalibrations->peMeV(iRO);
 
-      for (const auto& CaloShowerRO : CaloShowerROs)
+      for (unsigned i=roStart_[iRO]; i<roStart_[iRO+1]; ++i)
       {
-          unsigned SiPMID = CaloShowerRO.SiPMID();
-          if (SiPMID != iRO) continue;
-          for (const float PEtime : CaloShowerRO.PETime())
-          {        
-              float       time           = PEtime - blindTime_;         
-              unsigned    startSample    = std::max(0u,unsigned(time/digiSampling_));
-              const auto& pulse          = pulseShape_.digitizedPulse(time);
-              unsigned    stopSample     = std::min(startSample+pulse.size(), waveform.size());
-              
-              for (size_t timeSample = startSample; timeSample < stopSample; ++timeSample) 
-                 waveform.at(timeSample) += pulse.at(timeSample - startSample)*scaleFactor;              
+          const auto& CaloShowerRO = CaloShowerROs[roIndex_[i]];
+          if (CaloShowerRO.isBinned())
+          {
+              const auto& PECounts = CaloShowerRO.PECounts();
+              for (unsigned ibin=0; ibin<PECounts.size(); ++ibin)
+              {
+                  if (PECounts[ibin]==0) continue;
+                  float time = std::max(CaloShowerRO.PEBinTime(ibin) - float(blindTime_), 0.0f);
+                  addPulse(waveform, time, PECounts[ibin]*scaleFactor);
+              }
+              continue;
           }
+          
+          for (const float PEtime : CaloShowerRO.PETime()) addPulse(waveform, PEtime - blindTime_, scaleFactor);
       }
   }
 
+  //--------------------------------------------------------------------------
+  void CaloDigiMaker::addPulse(std::vector<double>& waveform, float time, double scaleFactor)
+  {
+      unsigned    startSample    = std::max(0u,unsigned(time/digiSampling_));
+      const auto& pulse          = pulseShape_.digitizedPulse(time);
+      unsigned    stopSample     = std::min(startSample+pulse.size(), waveform.size());
+      
+      for (size_t timeSample = startSample; timeSample < stopSample; ++timeSample) 
+         waveform[timeSample] += pulse[timeSample - startSample]*scaleFactor;              
+  }
+
 
   //----------------------------------------------------------------------------------------------------------
   void CaloDigiMaker::generateNoise(std::vector<double>& waveform, unsigned iRO, 
@@ -251,12 +317,12 @@ namespace mu2e {
   void CaloDigiMaker::buildOutputDigi(unsigned iRO, std::vector<double>& waveform, int pedestal, CaloDigiCollection& caloDigiColl)
   {
        // round the waveform into non-null integers and apply maxADC cut
-       std::vector<int> wf;
-       wf.reserve(waveform.size());
-       for (const auto& val : waveform)
+       std::vector<int>& wf = wfADC_;
+       wf.resize(waveform.size());
+       for (size_t i=0;i<waveform.size();++i)
        { 
-          if (val < pedestal) wf.emplace_back(0);
-          else                wf.emplace_back(std::min(maxADCCounts_, int(val - pedestal)) );
+          const double val = waveform[i];
+          wf[i] = (val < pedestal) ? 0 : std::min(maxADCCounts_, int(val - pedestal));
        }
        if (diagLevel_ > 2) diag0(iRO, wf);
 
@@ -169,10 +169,12 @@ namespace mu2e {
 
 
    //------------------------------------------------------------------------------------------------------------------
-   void CaloNoiseSimGenerator::addSaltAndPepper(std::vector<double>& wfVector) 
+   // returns the number of noise fragments added to the waveform
+   unsigned CaloNoiseSimGenerator::addSaltAndPepper(std::vector<double>& wfVector) 
    {      
-       double muNoise = waveform_.size()*digiNoiseProb_;
-       int    nNoise  = randPoisson_(muNoise);
+       double   muNoise = waveform_.size()*digiNoiseProb_;
+       int      nNoise  = randPoisson_(muNoise);
+       unsigned nAdded(0);
        for (int in=0;in<nNoise;++in)
        {
            unsigned idigi = unsigned(randFlat_.fire(0.,digiNoise_.size()));
@@ -184,7 +186,9 @@ namespace mu2e {
            {
                 if (wfVector[istart+i] < minPeakADC_) wfVector[istart+i] += digi[i];
            }   
+           ++nAdded;
        }
+       return nAdded;
    }
 
 
@@ -1,7 +1,8 @@
 //
 // Transform the energy deposited in the scintillator into photo-electrons (PE) seen by the photosensor. 
 // Includes corrections from Birks law, longitudinal response uniformity and photo-statistcs fluctuations.
-// The PE are generated individually and corrected for transit time.
+// The PE are generated individually and corrected for transit time. They are stored individually, or if 
+// PEBinWidth > 0 as the number of PEs in time bins of that width (see CaloShowerRO).
 //
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
@@ -22,10 +23,12 @@
 #include "MCDataProducts/inc/CaloShowerRO.hh"
 #include "MCDataProducts/inc/CaloShowerSim.hh"
 #include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
+#include "Mu2eUtilities/inc/SimParticleTimeTable.hh"
 #include "SeedService/inc/SeedService.hh"
 #include "CLHEP/Random/RandPoissonQ.h"
 #include "CLHEP/Random/RandFlat.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <cmath>
@@ -93,23 +96,25 @@ namespace mu2e {
              fhicl::Atom<bool>               BirksCorrection          { Name("BirksCorrection"),          Comment("Include Birks corrections") };
              fhicl::Atom<bool>               PEStatCorrection         { Name("PEStatCorrection"),         Comment("Include PE Poisson fluctuations") };
              fhicl::Atom<bool>               addTravelTime            { Name("addTravelTime"),            Comment("Include light propagation time") };
+             fhicl::Atom<float>              PEBinWidth               { Name("PEBinWidth"),               Comment("Width of the PE time bins (ns), 0 to store individual PE times"),0 };
              fhicl::Atom<int>                diagLevel                { Name("diagLevel"),                Comment("Diag Level"),0 };
          };
 
          explicit CaloShowerROMaker(const art::EDProducer::Table<Config>& config) :
             EDProducer{config},
-            toff_             (config().timeOffsets()),
+            toffInputs_       (config().timeOffsets().inputs()),
             blindTime_        (config().blindTime()),
             LRUCorrection_    (config().LRUCorrection()),
             BirksCorrection_  (config().BirksCorrection()),
             PEStatCorrection_ (config().PEStatCorrection()),
             addTravelTime_    (config().addTravelTime()),
+            PEBinWidth_       (config().PEBinWidth()),
             diagLevel_        (config().diagLevel()),
             engine_           (createEngine(art::ServiceHandle<SeedService>()->getSeed())),
             randPoisson_      (engine_),
             photonProp_       (engine_)
          {
-             // the following consumes statements are necessary because SimParticleTimeOffset::updateMap calls getValidHandle.
+             // the following consumes statements are necessary because SimParticleTimeTable::fill calls getValidHandle.
              for (auto const& tag : config().caloShowerStepCollection()) crystalShowerTokens_.push_back(consumes<CaloShowerStepCollection>(tag));
              for (auto const& tag : config().timeOffsets().inputs()) consumes<SimParticleTimeMap>(tag);
              produces<CaloShowerROCollection>();
@@ -128,15 +133,18 @@ namespace mu2e {
          float LRUCorrection     (int, float, float, const ConditionsHandle<CalorimeterCalibrations>&);
          float PECorrection      (int, float, float);
          void  dumpCaloShowerSim (const CaloShowerSimCollection& caloShowerSims);
+         void  binPETimes        (const std::vector<float>& PETime, int& firstBin, std::vector<unsigned>& counts) const;
 
          std::vector<art::ProductToken<CaloShowerStepCollection>> crystalShowerTokens_;
-         SimParticleTimeOffset   toff_;
+         std::vector<art::InputTag> toffInputs_;
+         SimParticleTimeTable    toff_;
          float                   blindTime_;
          float                   mbtime_;
          bool                    LRUCorrection_;
          bool                    BirksCorrection_;
          bool                    PEStatCorrection_;
          bool                    addTravelTime_;
+         float                   PEBinWidth_;
          int                     diagLevel_;
          CLHEP::HepRandomEngine& engine_;
          CLHEP::RandPoissonQ     randPoisson_;
@@ -177,7 +185,7 @@ namespace mu2e {
       //update condition cache
       ConditionsHandle<AcceleratorParams> accPar("ignored");
       mbtime_ = accPar->deBuncherPeriod;
-      toff_.updateMap(event);
+      toff_.fill(event, toffInputs_);
 
       // Containers to hold the output hits.
       auto CaloShowerROs  = std::make_unique<CaloShowerROCollection>();
@@ -256,7 +264,14 @@ namespace mu2e {
                   {
                       for (auto& time : PETime) time += photonProp_.propTimeSimu(2.0*cryhalflength-posZ);
                   }    
-                  CaloShowerROs.push_back(CaloShowerRO(SiPMID,stepPtr,PETime));                  
+                  if (PEBinWidth_ > 0)
+                  {
+                      int firstBin(0);
+                      std::vector<unsigned> PECounts;
+                      binPETimes(PETime, firstBin, PECounts);
+                      CaloShowerROs.push_back(CaloShowerRO(SiPMID,stepPtr,PEBinWidth_,firstBin,PECounts,NPE));
+                  }
+                  else CaloShowerROs.push_back(CaloShowerRO(SiPMID,stepPtr,PETime));                  
                                     
                   if (diagLevel_ > 2) std::cout<<"[CaloShowerROMaker::generatePE] SiPMID:"<<SiPMID<<"  energy / NPE = "<<edep_corr<<"  /  "<<NPE<<std::endl;
                   if (diagLevel_ > 2) {std::cout<<"Time hit "<<std::endl; for (auto time : PETime) std::cout<<time<<" "; std::cout<<std::endl;}
@@ -345,6 +360,17 @@ namespace mu2e {
       return edep;
   }
 
+  //-------------------------------------------------------------------------------------------------------------------------------------------------------
+  void CaloShowerROMaker::binPETimes(const std::vector<float>& PETime, int& firstBin, std::vector<unsigned>& counts) const
+  {
+      auto bin = [this](float time) {return int(std::floor(time/PEBinWidth_));};
+      
+      const auto minmax = std::minmax_element(PETime.begin(),PETime.end());
+      firstBin = bin(*minmax.first);
+      counts.assign(bin(*minmax.second)-firstBin+1,0);
+      for (auto time : PETime) ++counts[bin(time)-firstBin];
+  }
+
   //-------------------------------------------------------------------------------------------------------------------------------------------------------
   void CaloShowerROMaker::dumpCaloShowerSim(const CaloShowerSimCollection& caloShowerSims)
   {
@@ -0,0 +1,52 @@
+#ifndef CaloTemplateLMFitter_HH
+#define CaloTemplateLMFitter_HH
+
+// Levenberg-Marquardt fit of the waveform template, an alternative to the Minuit fit of CaloTemplateWFUtil.
+//
+// The model and the figure of merit are the same as in the Minuit fit: a constant background par[0] plus
+// a sum of pulses par[i]*pulse(x-par[i+1]), and F = sum (y-f)^2/par[0]. The residuals r = (y-f)/sqrt(par[0])
+// are differentiated analytically, using the slope of the cached pulse shape, so each iteration costs
+// one pass over the waveform. All work buffers are on the stack and the fitter holds no state besides
+// its configuration, so one instance can be used concurrently.
+//
+// Parameters are bounded to [0,1e6] as in the Minuit fit; a parameter can also be fixed. The parameter
+// errors are taken from the inverse of J^T J, which is the Minuit error matrix for this figure of merit.
+//
+// The status follows the Minuit convention used by the callers: 3 for a converged fit with an accurate
+// error matrix, 1 if the fit did not converge or the error matrix is approximate, 0 if no fit was done.
+
+#include "Mu2eUtilities/inc/CaloPulseShape.hh"
+
+
+namespace mu2e {
+
+  class CaloTemplateLMFitter {
+
+     public:
+        static constexpr unsigned maxPar = 49;
+
+        CaloTemplateLMFitter(const CaloPulseShape& pulse, unsigned nParBkg, unsigned nParFcn);
+
+        // Fit the points [i0,i1) with npar parameters, par is updated in place. fixed may be null.
+        int    fit        (const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar,
+                           double* par, double* err, const bool* fixed, double& fmin) const;
+
+        double fcn        (const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar, const double* par) const;
+
+        void   setMaxIter (unsigned val) {maxIter_ = val;}
+        void   setEdmTol  (double val)   {edmTol_  = val;}
+
+
+     private:
+        double accumulate (const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar, const double* par,
+                           const unsigned* idx, unsigned nfree, double* alpha, double* beta) const;
+
+        const CaloPulseShape& pulse_;
+        unsigned              nParBkg_;
+        unsigned              nParFcn_;
+        unsigned              maxIter_;
+        double                edmTol_;
+  };
+
+}
+#endif
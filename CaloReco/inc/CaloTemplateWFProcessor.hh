@@ -7,6 +7,8 @@
 // For a single peak, the amplitude can be found analytically for a given start time, and a 
 // quasi-Netwon method can be used to fit the waveform. 
 // If there are more than one peak, we use a generic gradient descent method, namely minuit.
+// Alternatively, fitEngine : "LevenbergMarquardt" selects a Levenberg-Marquardt fit with analytic 
+// derivatives of the pulse template (see CaloTemplateLMFitter), which is faster and reentrant.
 //
 // There is an additional option to refit the leding edge of the first peak to improve 
 // timing accuracy
@@ -20,6 +22,7 @@
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/Sequence.h"
 #include "TH2.h"
+#include <string>
 #include <vector>
 
 
@@ -43,6 +46,7 @@ namespace mu2e {
             fhicl::Atom<double>   digiSampling      { Name("digiSampling"),     Comment("Digitization time sampling") }; 
             fhicl::Atom<int>      fitPrintLevel     { Name("fitPrintLevel"),    Comment("minuit fit print level") };
             fhicl::Atom<int>      fitStrategy       { Name("fitStrategy"),      Comment("Minuit fit strategy") };
+            fhicl::Atom<std::string> fitEngine      { Name("fitEngine"),        Comment("Fit engine: Minuit or LevenbergMarquardt"), "Minuit" };
             fhicl::Atom<int>      diagLevel         { Name("diagLevel"),        Comment("Diagnosis level") };
         };
 
@@ -11,6 +11,8 @@ namespace mu2e {
   class CaloTemplateWFUtil  {
      
      public:     
+        enum FitEngine {Minuit, LevenbergMarquardt};
+        
         CaloTemplateWFUtil(double minPeakAmplitude, double digiSampling, double minDTPeaks, int printLevel=-1);
         
         void                        initialize    (); 
@@ -29,6 +31,7 @@ namespace mu2e {
         void                        plotFit       (const std::string& pname) const;
  
         void                        setStrategy   (int val) {fitStrategy_ = val;}
+        void                        setFitEngine  (FitEngine val) {fitEngine_ = val;}
         void                        setPrintLevel (int val) {printLevel_  = val;}
         void                        setFitStartegy(int val) {fitStrategy_ = val;}
         void                        setDiagLevel  (int val) {diagLevel_   = val;}
@@ -45,11 +48,13 @@ namespace mu2e {
 
 
      private:              
-        bool                selectComponent(const std::vector<double>& tempPar, const std::vector<double>& tempErr, unsigned ip);       
+        bool                selectComponent(const double* tempPar, const double* tempErr, unsigned ip);       
+        void                fitLM          ();
 
         CaloPulseShape      pulseCache_;
         double              minPeakAmplitude_;
         double              minDTPeaks_;
+        FitEngine           fitEngine_;
         int                 fitStrategy_;
         int                 diagLevel_;
         int                 printLevel_;
@@ -60,6 +65,10 @@ namespace mu2e {
         unsigned            nParBkg_;
         double              chi2_;
         unsigned            status_;
+        std::vector<double> xvec_;
+        std::vector<double> yvec_;
+        unsigned            x0_;
+        unsigned            x1_;
   };
   
 }
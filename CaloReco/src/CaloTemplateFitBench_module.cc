@@ -0,0 +1,146 @@
+//
+// Compare the Minuit and Levenberg-Marquardt engines of the template fit on the same CaloDigis.
+//
+// Each waveform is processed by two CaloTemplateWFProcessors, configured by MinuitProcessor and
+// LMProcessor. At the end of the job the module prints the number of fits per second of each engine,
+// the fraction of waveforms for which both find the same number of peaks, and for those the mean,
+// rms and largest differences of the peak amplitudes (relative) and times (ns).
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Table.h"
+
+#include "RecoDataProducts/inc/CaloDigi.hh"
+#include "CaloReco/inc/CaloTemplateWFProcessor.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+
+namespace mu2e {
+
+  class CaloTemplateFitBench : public art::EDAnalyzer
+  {
+     public:
+        struct Config
+        {
+           using Name    = fhicl::Name;
+           using Comment = fhicl::Comment;
+           fhicl::Table<mu2e::CaloTemplateWFProcessor::Config> minuitConf          { Name("MinuitProcessor"),     Comment("Template processor with the Minuit fit") };
+           fhicl::Table<mu2e::CaloTemplateWFProcessor::Config> lmConf              { Name("LMProcessor"),         Comment("Template processor with the Levenberg-Marquardt fit") };
+           fhicl::Atom<art::InputTag>                          caloDigiCollection  { Name("caloDigiCollection"),  Comment("Calo Digi module label") };
+           fhicl::Atom<double>                                 digiSampling        { Name("digiSampling"),        Comment("Calo ADC sampling time (ns)") };
+           fhicl::Atom<int>                                    diagLevel           { Name("diagLevel"),           Comment("Diagnosis level"), 0 };
+        };
+
+        explicit CaloTemplateFitBench(const art::EDAnalyzer::Table<Config>& config) :
+           EDAnalyzer{config},
+           caloDigisToken_ {consumes<CaloDigiCollection>(config().caloDigiCollection())},
+           digiSampling_   (config().digiSampling()),
+           diagLevel_      (config().diagLevel()),
+           minuitProc_     (config().minuitConf()),
+           lmProc_         (config().lmConf()),
+           nFits_(0), nSamePeaks_(0), nPeaks_(0),
+           timeMinuit_(0), timeLM_(0),
+           sumdA_(0), sumdA2_(0), maxdA_(0),
+           sumdT_(0), sumdT2_(0), maxdT_(0)
+        {}
+
+        void beginRun(const art::Run& aRun) override;
+        void analyze (const art::Event& event) override;
+        void endJob  () override;
+
+     private:
+        const art::ProductToken<CaloDigiCollection> caloDigisToken_;
+        double                                      digiSampling_;
+        int                                         diagLevel_;
+        CaloTemplateWFProcessor                     minuitProc_;
+        CaloTemplateWFProcessor                     lmProc_;
+
+        unsigned nFits_, nSamePeaks_, nPeaks_;
+        double   timeMinuit_, timeLM_;
+        double   sumdA_, sumdA2_, maxdA_;
+        double   sumdT_, sumdT2_, maxdT_;
+  };
+
+
+  //--------------------------------------------------
+  void CaloTemplateFitBench::beginRun(const art::Run&)
+  {
+      minuitProc_.initialize();
+      lmProc_.initialize();
+  }
+
+  //--------------------------------------------------
+  void CaloTemplateFitBench::analyze(const art::Event& event)
+  {
+      typedef std::chrono::steady_clock Clock;
+      const auto& caloDigis = *event.getValidHandle(caloDigisToken_);
+
+      std::vector<double> x{},y{};
+      for (const auto& caloDigi : caloDigis)
+      {
+          const std::vector<int>& waveform = caloDigi.waveform();
+          x.clear();y.clear();
+          for (unsigned int i=0;i<waveform.size();++i)
+          {
+              x.push_back(caloDigi.t0() + (i+0.5)*digiSampling_);
+              y.push_back(waveform[i]);
+          }
+
+          auto t0 = Clock::now();
+          minuitProc_.reset();
+          minuitProc_.extract(x,y);
+          auto t1 = Clock::now();
+          lmProc_.reset();
+          lmProc_.extract(x,y);
+          auto t2 = Clock::now();
+
+          timeMinuit_ += std::chrono::duration<double>(t1-t0).count();
+          timeLM_     += std::chrono::duration<double>(t2-t1).count();
+          ++nFits_;
+
+          if (minuitProc_.nPeaks() != lmProc_.nPeaks())
+          {
+              if (diagLevel_ > 0) std::printf("[CaloTemplateFitBench] SiPM %d: %d peaks with Minuit, %d with LM\n",
+                                              caloDigi.SiPMID(), minuitProc_.nPeaks(), lmProc_.nPeaks());
+              continue;
+          }
+          ++nSamePeaks_;
+
+          for (int i=0;i<minuitProc_.nPeaks();++i)
+          {
+              double dA = minuitProc_.amplitude(i) > 0 ? (lmProc_.amplitude(i)-minuitProc_.amplitude(i))/minuitProc_.amplitude(i) : 0;
+              double dT = lmProc_.time(i)-minuitProc_.time(i);
+              sumdA_ += dA; sumdA2_ += dA*dA; maxdA_ = std::max(maxdA_,std::abs(dA));
+              sumdT_ += dT; sumdT2_ += dT*dT; maxdT_ = std::max(maxdT_,std::abs(dT));
+              ++nPeaks_;
+          }
+      }
+  }
+
+  //--------------------------------------------------
+  void CaloTemplateFitBench::endJob()
+  {
+      if (nFits_ == 0) return;
+      double n = std::max(nPeaks_,1u);
+      std::printf("[CaloTemplateFitBench] %u waveforms, fits per second: Minuit %.0f, LM %.0f\n", nFits_,
+                  timeMinuit_ > 0 ? nFits_/timeMinuit_ : 0.0, timeLM_ > 0 ? nFits_/timeLM_ : 0.0);
+      std::printf("[CaloTemplateFitBench] same number of peaks in %.4f of the waveforms, %u peaks compared\n",
+                  nSamePeaks_/double(nFits_), nPeaks_);
+      std::printf("[CaloTemplateFitBench] amplitude (LM-Minuit)/Minuit: mean %.3g rms %.3g max %.3g\n",
+                  sumdA_/n, std::sqrt(sumdA2_/n), maxdA_);
+      std::printf("[CaloTemplateFitBench] time LM-Minuit (ns):          mean %.3g rms %.3g max %.3g\n",
+                  sumdT_/n, std::sqrt(sumdT2_/n), maxdT_);
+  }
+
+}
+
+DEFINE_ART_MODULE(mu2e::CaloTemplateFitBench);
@@ -0,0 +1,243 @@
+#include "CaloReco/inc/CaloTemplateLMFitter.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+
+namespace
+{
+    // same bounds as the Minuit fit, the background is kept away from 0 where the figure of merit is undefined
+    constexpr double parMin_(0.0), parMax_(1e6), bkgMin_(1e-5);
+    constexpr double lambdaStart_(1e-3), lambdaMin_(1e-10), lambdaMax_(1e10);
+
+    // In place Cholesky decomposition of the symmetric n x n matrix a, lower triangle
+    bool cholesky(double* a, unsigned n)
+    {
+        for (unsigned j=0;j<n;++j)
+        {
+            double d = a[j*n+j];
+            for (unsigned k=0;k<j;++k) d -= a[j*n+k]*a[j*n+k];
+            if (!(d > 0)) return false;
+            d = std::sqrt(d);
+            a[j*n+j] = d;
+            for (unsigned i=j+1;i<n;++i)
+            {
+                double s = a[i*n+j];
+                for (unsigned k=0;k<j;++k) s -= a[i*n+k]*a[j*n+k];
+                a[i*n+j] = s/d;
+            }
+        }
+        return true;
+    }
+
+    // Solve L L^T x = b
+    void cholSolve(const double* l, unsigned n, const double* b, double* x)
+    {
+        for (unsigned i=0;i<n;++i)
+        {
+            double s = b[i];
+            for (unsigned k=0;k<i;++k) s -= l[i*n+k]*x[k];
+            x[i] = s/l[i*n+i];
+        }
+        for (unsigned i=n;i-- >0;)
+        {
+            double s = x[i];
+            for (unsigned k=i+1;k<n;++k) s -= l[k*n+i]*x[k];
+            x[i] = s/l[i*n+i];
+        }
+    }
+}
+
+
+
+namespace mu2e {
+
+   CaloTemplateLMFitter::CaloTemplateLMFitter(const CaloPulseShape& pulse, unsigned nParBkg, unsigned nParFcn) :
+      pulse_(pulse),
+      nParBkg_(nParBkg),
+      nParFcn_(nParFcn),
+      maxIter_(200),
+      edmTol_(1e-4)
+   {}
+
+
+   //-----------------------------------------------------------------------------------------------------
+   // Figure of merit, and if alpha is not null J^T J and J^T r restricted to the parameters listed in idx
+   double CaloTemplateLMFitter::accumulate(const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar, const double* par,
+                                           const unsigned* idx, unsigned nfree, double* alpha, double* beta) const
+   {
+       const double p0 = par[0];
+       const double sp = std::sqrt(p0);
+
+       if (alpha != nullptr)
+       {
+           std::fill(alpha, alpha+nfree*nfree, 0.0);
+           std::fill(beta,  beta+nfree, 0.0);
+       }
+
+       std::array<double,maxPar> grad{};
+       double f(0);
+       for (unsigned i=i0;i<i1;++i)
+       {
+           double val(par[0]);
+           for (unsigned ip=nParBkg_; ip+1<npar; ip+=nParFcn_)
+           {
+               double slope(0);
+               double shape = pulse_.evaluate(x[i]-par[ip+1],slope);
+               val         += par[ip]*shape;
+               grad[ip]     = -shape/sp;
+               grad[ip+1]   = par[ip]*slope/sp;
+           }
+           f += (y[i]-val)*(y[i]-val)/p0;
+
+           if (alpha == nullptr) continue;
+           double r = (y[i]-val)/sp;
+           grad[0]  = -1.0/sp - 0.5*r/p0;
+
+           for (unsigned a=0;a<nfree;++a)
+           {
+               double ga = grad[idx[a]];
+               if (ga == 0.0) continue;
+               beta[a] += ga*r;
+               for (unsigned b=0;b<=a;++b) alpha[a*nfree+b] += ga*grad[idx[b]];
+           }
+       }
+
+       if (alpha != nullptr)
+       {
+           for (unsigned a=0;a<nfree;++a)
+              for (unsigned b=0;b<a;++b) alpha[b*nfree+a] = alpha[a*nfree+b];
+       }
+       return f;
+   }
+
+   //-----------------------------------------------------------------------------------------------------
+   double CaloTemplateLMFitter::fcn(const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar, const double* par) const
+   {
+       if (std::abs(par[0]) <= bkgMin_) return 0.0;
+       return accumulate(x, y, i0, i1, npar, par, nullptr, 0, nullptr, nullptr);
+   }
+
+   //-----------------------------------------------------------------------------------------------------
+   int CaloTemplateLMFitter::fit(const double* x, const double* y, unsigned i0, unsigned i1, unsigned npar,
+                                 double* par, double* err, const bool* fixed, double& fmin) const
+   {
+       fmin = 0;
+       if (npar == 0 || npar > maxPar || i1 <= i0) return 0;
+
+       auto lower = [](unsigned ip) {return ip==0 ? bkgMin_ : parMin_;};
+
+       std::array<unsigned,maxPar> idx;
+       unsigned nfree(0);
+       for (unsigned ip=0;ip<npar;++ip)
+       {
+           err[ip] = 0;
+           if (fixed != nullptr && fixed[ip]) continue;
+           par[ip] = std::min(std::max(par[ip],lower(ip)),parMax_);
+           idx[nfree++] = ip;
+       }
+       if (nfree == 0 || par[0] <= bkgMin_) {fmin = fcn(x, y, i0, i1, npar, par); return 0;}
+
+       std::array<double,maxPar*maxPar> alphaBuf1, alphaBuf2, work;
+       std::array<double,maxPar>        betaBuf1, betaBuf2, rhs, delta, trial;
+       std::array<unsigned,maxPar>      act;
+       double* alpha  = alphaBuf1.data();
+       double* beta   = betaBuf1.data();
+       double* alphaT = alphaBuf2.data();
+       double* betaT  = betaBuf2.data();
+
+       double f = accumulate(x, y, i0, i1, npar, par, idx.data(), nfree, alpha, beta);
+       double lambda(lambdaStart_);
+       bool   converged(false);
+
+       for (unsigned iter=0; iter<maxIter_; ++iter)
+       {
+           // parameters pushed against a bound or without influence on the fit do not move in this iteration
+           unsigned nact(0);
+           for (unsigned a=0;a<nfree;++a)
+           {
+               unsigned ip = idx[a];
+               if (alpha[a*nfree+a] <= 0.0)                    continue;
+               if (par[ip] <= lower(ip) && beta[a] > 0)        continue;
+               if (par[ip] >= parMax_   && beta[a] < 0)        continue;
+               act[nact++] = a;
+           }
+           if (nact == 0) {converged = true; break;}
+
+           for (unsigned a=0;a<nact;++a) rhs[a] = -beta[act[a]];
+
+           // estimated distance to minimum from the undamped step, as in Minuit
+           for (unsigned a=0;a<nact;++a)
+              for (unsigned b=0;b<nact;++b) work[a*nact+b] = alpha[act[a]*nfree+act[b]];
+           if (cholesky(work.data(), nact))
+           {
+               cholSolve(work.data(), nact, rhs.data(), delta.data());
+               double edm(0);
+               for (unsigned a=0;a<nact;++a) edm += rhs[a]*delta[a];
+               if (edm < edmTol_) {converged = true; break;}
+           }
+
+           bool accepted(false);
+           while (!accepted && lambda < lambdaMax_)
+           {
+               for (unsigned a=0;a<nact;++a)
+               {
+                  for (unsigned b=0;b<nact;++b) work[a*nact+b] = alpha[act[a]*nfree+act[b]];
+                  work[a*nact+a] *= 1.0+lambda;
+               }
+               if (!cholesky(work.data(), nact)) {lambda *= 10; continue;}
+               cholSolve(work.data(), nact, rhs.data(), delta.data());
+
+               std::copy(par, par+npar, trial.begin());
+               for (unsigned a=0;a<nact;++a)
+               {
+                   unsigned ip = idx[act[a]];
+                   trial[ip] = std::min(std::max(trial[ip]+delta[a],lower(ip)),parMax_);
+               }
+
+               double fT = accumulate(x, y, i0, i1, npar, trial.data(), idx.data(), nfree, alphaT, betaT);
+               if (fT <= f)
+               {
+                   std::copy(trial.begin(), trial.begin()+npar, par);
+                   std::swap(alpha, alphaT);
+                   std::swap(beta, betaT);
+                   f        = fT;
+                   lambda   = std::max(0.1*lambda, lambdaMin_);
+                   accepted = true;
+               }
+               else lambda *= 10;
+           }
+           if (!accepted) break;
+       }
+
+       // errors from the inverse of J^T J over all free parameters
+       std::copy(alpha, alpha+nfree*nfree, work.begin());
+       bool accurate = cholesky(work.data(), nfree);
+       if (accurate)
+       {
+           for (unsigned j=0;j<nfree;++j)
+           {
+               // column j of L^-1, the diagonal of (L L^T)^-1 is the sum of its squares
+               double s2(0);
+               for (unsigned i=j;i<nfree;++i)
+               {
+                   double s = (i==j) ? 1.0 : 0.0;
+                   for (unsigned k=j;k<i;++k) s -= work[i*nfree+k]*rhs[k];
+                   rhs[i] = s/work[i*nfree+i];
+                   s2 += rhs[i]*rhs[i];
+               }
+               err[idx[j]] = std::sqrt(s2);
+           }
+       }
+       else
+       {
+           for (unsigned a=0;a<nfree;++a)
+              err[idx[a]] = alpha[a*nfree+a] > 0 ? 1.0/std::sqrt(alpha[a*nfree+a]) : 0.0;
+       }
+
+       fmin = f;
+       return (converged && accurate) ? 3 : 1;
+   }
+
+}
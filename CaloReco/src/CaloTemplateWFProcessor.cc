@@ -3,6 +3,7 @@
 #include "ConditionsService/inc/ConditionsHandle.hh"
 #include "art_root_io/TFileService.h"
 #include "art_root_io/TFileDirectory.h"
+#include "cetlib_except/exception.h"
 
 #include "TFile.h"
 #include "TH2.h"
@@ -35,6 +36,10 @@ namespace mu2e {
    {	                 
        if (diagLevel_ > 1) initHistos();
        if (windowPeak_ < 1) windowPeak_=1;
+       
+       if      (config.fitEngine() == "Minuit")             fmutil_.setFitEngine(CaloTemplateWFUtil::Minuit);
+       else if (config.fitEngine() == "LevenbergMarquardt") fmutil_.setFitEngine(CaloTemplateWFUtil::LevenbergMarquardt);
+       else throw cet::exception("CATEGORY")<< "Unrecognized fitEngine "<<config.fitEngine()<<" in CaloTemplateWFProcessor";
    }       
 
    
@@ -1,4 +1,5 @@
 #include "CaloReco/inc/CaloTemplateWFUtil.hh"
+#include "CaloReco/inc/CaloTemplateLMFitter.hh"
 #include "Mu2eUtilities/inc/CaloPulseShape.hh"
 
 #include "TMinuit.h"
@@ -7,6 +8,7 @@
 #include "TCanvas.h"
 
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <sstream>
 
@@ -17,35 +19,50 @@
 // the signal (see doc-db 36707 for a full explanation)
 
 
-//An anonymous namespace to use Minuit
+//An anonymous namespace to use Minuit. The Minuit fit reads the waveform and the model through these globals,
+//they are set before each Minuit fit and plot. The Levenberg-Marquardt fit does not use them.
 namespace 
 {
-    unsigned              npTot_(0),npFcn_(0),npBkg_(0),x0_(0),x1_(0);
-    std::vector<double>   xvec_{},yvec_{};
-    mu2e::CaloPulseShape* pulseCachePtr_=(nullptr);
+    unsigned                    npTot_(0),npFcn_(0),npBkg_(0),i0Fit_(0),i1Fit_(0);
+    const double*               xFit_(nullptr);
+    const double*               yFit_(nullptr);
+    const mu2e::CaloPulseShape* pulseCachePtr_(nullptr);
       
-    double logn(double x, double *par) {return par[0]*pulseCachePtr_->evaluate(x-par[1]); }
+    double logn(double x, const double *par, const mu2e::CaloPulseShape& pulse) {return par[0]*pulse.evaluate(x-par[1]); }
 
-    double fitfunction(double x, double *par)
+    double fitfunction(double x, const double *par, const mu2e::CaloPulseShape& pulse, unsigned nBkg, unsigned nFcn, unsigned nTot)
     {   
 	double result(par[0]);
-	for (unsigned i=npBkg_; i<npTot_; i+=npFcn_) result += logn(x,&par[i]);
+	for (unsigned i=nBkg; i<nTot; i+=nFcn) result += logn(x,&par[i],pulse);
 	return result;
     }      
-    double fitfunctionPlot(double* x, double *par) {return fitfunction(x[0],par);}
+    double fitfunctionPlot(double* x, double *par) {return fitfunction(x[0],par,*pulseCachePtr_,npBkg_,npFcn_,npTot_);}
 
     void myfcn(int& npar, double* , double &f, double *par, int)
     {   
 	f=0;       
-	for (unsigned i=x0_;i<x1_;++i)
+	for (unsigned i=i0Fit_;i<i1Fit_;++i)
 	{    
-            double x = xvec_[i];
-            double y = yvec_[i];
-            double val = fitfunction(x, par);
+            double x = xFit_[i];
+            double y = yFit_[i];
+            double val = fitfunction(x, par, *pulseCachePtr_, npBkg_, npFcn_, npTot_);
             // modified fit function
             if (fabs(par[0]) > 1e-5) f += (y-val)*(y-val)/par[0];
 	}
     }      
+    
+    void setFitState(const mu2e::CaloPulseShape& pulse, const std::vector<double>& xvec, const std::vector<double>& yvec, 
+                     unsigned x0, unsigned x1, unsigned nBkg, unsigned nFcn, unsigned nTot)
+    {
+        pulseCachePtr_ = &pulse;
+        xFit_  = xvec.data();
+        yFit_  = yvec.data();
+        i0Fit_ = x0;
+        i1Fit_ = x1;
+        npBkg_ = nBkg;
+        npFcn_ = nFcn;
+        npTot_ = nTot;
+    }
 }
 
 
@@ -61,6 +78,7 @@ namespace mu2e {
       pulseCache_(CaloPulseShape(digiSampling)),
       minPeakAmplitude_(minPeakAmplitude),
       minDTPeaks_(minDTPeaks),
+      fitEngine_(Minuit),
       fitStrategy_(1),
       diagLevel_(0),
       printLevel_(printLevel),
@@ -69,20 +87,20 @@ namespace mu2e {
       nParTot_(3),
       nParFcn_(2),
       nParBkg_(1),
-      chi2_(999.0)
-   {
-      pulseCachePtr_ = &pulseCache_;
-      npTot_ = nParTot_;
-      npFcn_ = nParFcn_;
-      npBkg_ = nParBkg_;
-   }       
+      chi2_(999.0),
+      status_(0),
+      xvec_(),
+      yvec_(),
+      x0_(0),
+      x1_(0)
+   {}       
    
 
    //-----------------------------------------------------------------------------------------------------
    void   CaloTemplateWFUtil::initialize ()                                                                 {pulseCache_.buildShapes();}
-   void   CaloTemplateWFUtil::reset      ()                                                                 {param_.clear(); paramErr_.clear(); nParTot_=0; npTot_ = 0;}
+   void   CaloTemplateWFUtil::reset      ()                                                                 {param_.clear(); paramErr_.clear(); nParTot_=0;}
    void   CaloTemplateWFUtil::setXYVector(const std::vector<double>& xvec, const std::vector<double>& yvec) {xvec_ = xvec; yvec_ = yvec; x0_=0; x1_ = xvec_.size();}
-   void   CaloTemplateWFUtil::setPar     (const std::vector<double>& par)                                   {param_ = par; nParTot_ = npTot_ = par.size();}
+   void   CaloTemplateWFUtil::setPar     (const std::vector<double>& par)                                   {param_ = par; nParTot_ = par.size();}
   
    //-----------------------------------------------------------------------------------------------------
    void CaloTemplateWFUtil::fit() 
@@ -90,6 +108,9 @@ namespace mu2e {
        status_ = 0;
        if (param_.empty() || param_.size()>49 || xvec_.empty()) return;       
        if (nParTot_ < nParBkg_  || (nParTot_-nParBkg_)%nParFcn_ !=0) return;
+       if (fitEngine_ == LevenbergMarquardt) {fitLM(); return;}
+
+       setFitState(pulseCache_, xvec_, yvec_, x0_, x1_, nParBkg_, nParFcn_, nParTot_);
 
        int ierr(0),nvpar(999), nparx(999), istat(999);
        double arglist[2]={0,0}, edm(999), errdef(999);
@@ -129,7 +150,7 @@ namespace mu2e {
 
            for (unsigned ip=nParBkg_; ip<nParTot_; ip += nParFcn_)
            {    
-	       if (selectComponent(tempPar,tempErr,ip)) continue;           
+	       if (selectComponent(tempPar.data(),tempErr.data(),ip)) continue;           
 	       minuit.mnparm(ip,   "fixed par", 0, 0.01, -1e6, 1e6, ierr);
 	       minuit.mnparm(ip+1, "fixed par", 0, 0.01, -1e6, 1e6, ierr);
                minuit.FixParameter(ip);
@@ -164,14 +185,56 @@ namespace mu2e {
        
        //recalculate the chi2 removing the baseline to better reject the noise ?      
        //chi2_=0;
-       //for (unsigned i=x0_;i<x1_;++i)
+       //for (unsigned i=i0Fit_;i<i1Fit_;++i)
        //{    
        //    double val = fitfunction(xvec_[i], &param_[0]);
        //    if (yvec_[i]>1e-5) chi2_ += (yvec_[i]-val)*(yvec_[i]-val)/(yvec_[i]-param_[0]);
        //}
           
        nParTot_ = param_.size();
-       npTot_   = nParTot_;
+       status_  = istat;
+   }
+   
+   //-----------------------------------------------------------------------------------------------------
+   void CaloTemplateWFUtil::fitLM() 
+   {
+       CaloTemplateLMFitter fitter(pulseCache_, nParBkg_, nParFcn_);
+       
+       std::array<double,CaloTemplateLMFitter::maxPar> par{},err{};
+       std::array<bool,CaloTemplateLMFitter::maxPar>   fixed{};
+       std::copy(param_.begin(), param_.end(), par.begin());
+       
+       double fmin(0);
+       int istat = fitter.fit(xvec_.data(), yvec_.data(), x0_, x1_, nParTot_, par.data(), err.data(), fixed.data(), fmin);
+
+       // Remove small or "duplicate" components and redo the fit, same selection as the Minuit fit 
+       if (nParTot_ > nParFcn_+nParBkg_)
+       {        
+           bool refit(false);
+           std::array<double,CaloTemplateLMFitter::maxPar> tempPar(par),tempErr(err);
+           for (unsigned ip=nParBkg_; ip<nParTot_; ip += nParFcn_)
+           {    
+	       if (selectComponent(tempPar.data(),tempErr.data(),ip)) continue;           
+               par[ip]   = par[ip+1]   = 0;
+               fixed[ip] = fixed[ip+1] = true;
+               refit = true;
+           }
+           if (refit) istat = fitter.fit(xvec_.data(), yvec_.data(), x0_, x1_, nParTot_, par.data(), err.data(), fixed.data(), fmin);
+       }
+
+       param_.clear();
+       paramErr_.clear();
+       unsigned i(0);
+       while (i<nParTot_)
+       {
+	   if (par[i]<1 && i >=nParBkg_ && (i-nParBkg_)%nParFcn_==0) {i+=nParFcn_;continue;}
+	   param_.push_back(par[i]);
+           paramErr_.push_back(err[i]);
+	   ++i;
+       }
+
+       chi2_    = fmin;
+       nParTot_ = param_.size();
        status_  = istat;
    }
    
@@ -190,6 +253,24 @@ namespace mu2e {
        x0_ = 0; 
        //x0_ = ilow; 
        x1_ = imax;
+       
+       if (fitEngine_ == LevenbergMarquardt)
+       {
+           // fit the first peak only, keep the time 
+           CaloTemplateLMFitter fitter(pulseCache_, nParBkg_, nParFcn_);
+           std::array<double,CaloTemplateLMFitter::maxPar> par{},err{};
+           std::copy(param_.begin(), param_.begin()+nParBkg_+nParFcn_, par.begin());
+           double fmin(0);
+           status_ = fitter.fit(xvec_.data(), yvec_.data(), x0_, x1_, nParBkg_+nParFcn_, par.data(), err.data(), nullptr, fmin);
+           
+           param_[nParBkg_+1]    = par[nParBkg_+1];
+           paramErr_[nParBkg_+1] = err[nParBkg_+1];
+           x0_ = 0; 
+           x1_ = xvec_.size();
+           return;
+       }
+        
+       setFitState(pulseCache_, xvec_, yvec_, x0_, x1_, nParBkg_, nParFcn_, nParTot_);
         
        int ierr(0),nvpar(999), nparx(999), istat(999);
        double arglist[2]={0,0}, edm(999), errdef(999),chi(9999),val(0),err(0);
@@ -222,7 +303,7 @@ namespace mu2e {
    }
    
    //----------------------------------------------------------------------------------
-   bool CaloTemplateWFUtil::selectComponent(const std::vector<double>& tempPar, const std::vector<double>& tempErr, unsigned ip)
+   bool CaloTemplateWFUtil::selectComponent(const double* tempPar, const double* tempErr, unsigned ip)
    {
        // first check if component is too small, error too large or out of time
        if (tempPar[ip] < minPeakAmplitude_)                               return false;
@@ -230,7 +311,7 @@ namespace mu2e {
        if (tempErr[ip] >1e3)                                              return false;
 
        //remove peaks close in time with smaller amplitude
-       for (unsigned ip2=nParBkg_; ip2<npTot_; ip2 += nParFcn_)
+       for (unsigned ip2=nParBkg_; ip2<nParTot_; ip2 += nParFcn_)
        {
            if (ip==ip2) continue;
            double dt = std::abs(tempPar[ip2+1]-tempPar[ip+1]);          	  
@@ -247,13 +328,13 @@ namespace mu2e {
    double CaloTemplateWFUtil::eval_fcn(double x)
    {       
        if (param_.size()<nParFcn_) return 0.0;
-       return fitfunction(x,&param_[0]);       
+       return fitfunction(x,&param_[0],pulseCache_,nParBkg_,nParFcn_,nParTot_);       
    }
    //------------------------------------------------------------
    double CaloTemplateWFUtil::eval_logn(double x, int ioffset)
    {
        if (param_.size() < ioffset+nParFcn_) return 0.0;
-       return logn(x,&param_[ioffset]);       
+       return logn(x,&param_[ioffset],pulseCache_);       
    }
    //------------------------------------------------------------
    double CaloTemplateWFUtil::maxAmplitude()
@@ -269,7 +350,7 @@ namespace mu2e {
       double s1(0),s2(0);
       for (unsigned i=i0;i<=i1;++i)
       {
-	 double ff = pulseCachePtr_->evaluate(xvalues[i]-x0);
+	 double ff = pulseCache_.evaluate(xvalues[i]-x0);
 
 	 s1 += ff*ff;
 	 s2 += yvalues[i]*ff;
@@ -285,7 +366,7 @@ namespace mu2e {
       double chi2(0);
       for (unsigned i=i0;i<=i1;++i)
       {
-	 double cc = A*pulseCachePtr_->evaluate(xvalues[i]-x0)-yvalues[i];      
+	 double cc = A*pulseCache_.evaluate(xvalues[i]-x0)-yvalues[i];      
 	 chi2 += cc*cc;
       }
       return chi2; 
@@ -303,6 +384,7 @@ namespace mu2e {
    void CaloTemplateWFUtil::plotFit(const std::string& pname) const
    {
        if (xvec_.empty()) return;
+       setFitState(pulseCache_, xvec_, yvec_, x0_, x1_, nParBkg_, nParFcn_, nParTot_);
        double dx = xvec_[1]-xvec_[0];
 
        TH1F h("test","Amplitude vs time",x1_-x0_,xvec_[x0_]-0.5*dx,xvec_[x1_-1]+0.5*dx);
@@ -0,0 +1,126 @@
+//
+// Precomputed tables for the frequent geometry queries of the reconstruction:
+//   - a 2D grid per disk giving the crystal at each position. The grid cells are half a crystal wide,
+//     so each cell lies inside a single cell of the crystal map, and the grid gives the same crystal as
+//     Disk::idxFromPosition. Each cell also holds the candidates of Disk::nearestIdxFromPosition.
+//     Positions outside the grid, or exactly on a cell boundary, are passed to the Disk
+//   - the neighbors and next neighbors of all crystals in contiguous (CSR) arrays: the neighbors of
+//     crystal i are ids[offsets[i]] ... ids[offsets[i+1]-1]
+//   - the disk transformations, crystal positions in the disk front face frame, and the disk front faces
+//     in the tracker frame
+//
+// The tables are filled by DiskCalorimeterMaker once the crystals are placed.
+//
+
+#ifndef CalorimeterGeom_CaloLookup_hh
+#define CalorimeterGeom_CaloLookup_hh
+
+#include "CalorimeterGeom/inc/Disk.hh"
+#include "CalorimeterGeom/inc/Crystal.hh"
+
+#include "CLHEP/Vector/Rotation.h"
+#include "CLHEP/Vector/ThreeVector.h"
+#include <vector>
+#include <memory>
+
+
+namespace mu2e {
+
+    class CaloGeomUtil;
+
+    class CaloLookup {
+
+       public:
+
+          // crystal ids, in place in the tables
+          class IdRange {
+             public:
+                IdRange(const int* first, const int* last) : first_(first), last_(last) {}
+                const int* begin()                const {return first_;}
+                const int* end()                  const {return last_;}
+                size_t     size()                 const {return last_-first_;}
+                bool       empty()                const {return first_==last_;}
+                int        operator[](size_t i)   const {return first_[i];}
+             private:
+                const int* first_;
+                const int* last_;
+          };
+
+          CaloLookup();
+
+          void build(const std::vector<std::shared_ptr<Disk>>& disks, const std::vector<const Crystal*>& fullCrystalList,
+                     const CaloGeomUtil& geomUtil);
+
+          // same as Calorimeter::neighbors / nextNeighbors, without the copy
+          IdRange neighbors(int crystalId, bool rawMap=false)     const {return (rawMap ? neighborsRaw_ : neighbors_).range(crystalId);}
+          IdRange nextNeighbors(int crystalId, bool rawMap=false) const {return (rawMap ? nextNeighborsRaw_ : nextNeighbors_).range(crystalId);}
+
+          // same results as DiskCalorimeter::crystalIdxFromPosition / nearestIdxFromPosition had before the tables
+          int crystalIdxFromPosition(const CLHEP::Hep3Vector& pos) const;
+          int nearestIdxFromPosition(const CLHEP::Hep3Vector& pos) const;
+
+          // crystal position in the front face frame of its disk
+          const CLHEP::Hep3Vector& crystalPosFF(int crystalId)     const {return crystalPosFF_[crystalId];}
+
+          // coordinates transformations, as in CaloGeomUtil
+          CLHEP::Hep3Vector mu2eToDiskFF(int diskId, const CLHEP::Hep3Vector& pos)    const;
+          CLHEP::Hep3Vector diskFFToTracker(int diskId, const CLHEP::Hep3Vector& pos) const;
+
+          // disk front face center in the tracker frame, and crystal axis from the front face to the back
+          const CLHEP::Hep3Vector& frontFaceInTracker(int diskId)  const {return disks_[diskId].frontFaceInTracker;}
+          const CLHEP::Hep3Vector& frontToBack(int diskId)         const {return disks_[diskId].frontToBack;}
+          double                   crystalZLength()                const {return crystalZLength_;}
+
+
+       private:
+
+          struct Table {
+             IdRange range(int i) const {return IdRange(ids.data()+offsets[i], ids.data()+offsets[i+1]);}
+             void    clear() {offsets.assign(1,0); ids.clear();}
+             void    append(const std::vector<int>& list) {ids.insert(ids.end(), list.begin(), list.end()); offsets.push_back(ids.size());}
+
+             std::vector<unsigned> offsets;
+             std::vector<int>      ids;
+          };
+
+          // the grid covers [-nHalf,nHalf) half cells along x and y in the disk frame, in the units of the crystal map
+          struct Grid {
+             int cell(double x, double y) const;
+
+             double           cellSize;
+             int              nHalf;
+             std::vector<int> crystal;   // local crystal id in each cell, -1 if none
+             Table            nearest;   // local crystal ids of the candidates of nearestIdxFromPosition in each cell
+          };
+
+          struct DiskInfo {
+             const Disk*        disk;
+             bool               rotated;
+             CLHEP::HepRotation rotation;
+             CLHEP::HepRotation inverseRotation;
+             CLHEP::Hep3Vector  origin;
+             CLHEP::Hep3Vector  originToCrystalOrigin;
+             CLHEP::Hep3Vector  frontFaceInTracker;
+             CLHEP::Hep3Vector  frontToBack;
+             int                crystalOffset;
+             Grid               grid;
+          };
+
+          int               idxFromPosition(const DiskInfo& info, double x, double y) const;
+          CLHEP::Hep3Vector mu2eToDisk(const DiskInfo& info, const CLHEP::Hep3Vector& pos) const;
+
+          std::vector<DiskInfo>           disks_;
+          std::vector<double>             crystalX_;
+          std::vector<double>             crystalY_;
+          std::vector<CLHEP::Hep3Vector>  crystalPosFF_;
+          Table                           neighbors_;
+          Table                           nextNeighbors_;
+          Table                           neighborsRaw_;
+          Table                           nextNeighborsRaw_;
+          CLHEP::Hep3Vector               trackerCenter_;
+          double                          crystalZLength_;
+    };
+
+}
+
+#endif
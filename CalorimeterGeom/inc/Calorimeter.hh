@@ -11,6 +11,7 @@
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
 #include "CalorimeterGeom/inc/CaloInfo.hh"
 #include "CalorimeterGeom/inc/CaloIDMapper.hh"
+#include "CalorimeterGeom/inc/CaloLookup.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
 
@@ -42,6 +43,7 @@ namespace mu2e {
 	   virtual const CaloInfo&               caloInfo()     const = 0;
 	   virtual const CaloIDMapper&           caloIDMapper() const = 0;
 	   virtual const CaloGeomUtil&           geomUtil()     const = 0; 
+	   virtual const CaloLookup&             lookup()       const = 0; 
 
 
   	   // neighbors, indexing 
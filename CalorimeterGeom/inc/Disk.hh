@@ -41,6 +41,7 @@ namespace mu2e {
 	   
            double                          innerRadius()            const {return radiusIn_;}
            double                          outerRadius()            const {return radiusOut_;}
+           double                          nominalCellSize()        const {return nominalCellSize_;}
  	   
 	   int                             idxFromPosition(double x, double y) const;           
 	   std::vector<int>                findLocalNeighbors(int crystalId, int level, bool raw=false) const;            
@@ -12,6 +12,7 @@
 #include "CalorimeterGeom/inc/CaloInfo.hh"
 #include "CalorimeterGeom/inc/CaloIDMapper.hh"
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
+#include "CalorimeterGeom/inc/CaloLookup.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
 
@@ -49,6 +50,7 @@ namespace mu2e {
 	    virtual const CaloInfo&           caloInfo()     const  {return caloInfo_;} 
 	    virtual const CaloIDMapper&       caloIDMapper() const  {return caloIDMapper_;} 
 	    virtual const CaloGeomUtil&       geomUtil()     const  {return geomUtil_;} 
+	    virtual const CaloLookup&         lookup()       const  {return lookup_;} 
 	                  CaloInfo&           caloInfo()            {return caloInfo_;} 
 	                  CaloIDMapper&       caloIDMapper()        {return caloIDMapper_;} 
 	                  CaloGeomUtil&       geomUtil()            {return geomUtil_;} 
@@ -70,9 +72,6 @@ namespace mu2e {
 	private:            
 	    using  DiskPtr = std::shared_ptr<Disk>;
 
-            double deltaZ(const CLHEP::Hep3Vector& p1, const CLHEP::Hep3Vector& p2) const;
-            double deltaPerp(int ic, const CLHEP::Hep3Vector& pos) const;
-            
 	    int                           nDisks_;
             int                           nCrates_;
             int                           nBoards_;
@@ -82,6 +81,7 @@ namespace mu2e {
             CaloInfo                      caloInfo_;
             CaloIDMapper                  caloIDMapper_;
 	    CaloGeomUtil                  geomUtil_;
+	    CaloLookup                    lookup_;          //precomputed tables, filled by DiskCalorimeterMaker
      };
 
 }    
@@ -0,0 +1,195 @@
+//
+// Precomputed calorimeter geometry tables, see CaloLookup.hh
+//
+
+#include "CalorimeterGeom/inc/CaloLookup.hh"
+#include "CalorimeterGeom/inc/CaloGeomUtil.hh"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace mu2e {
+
+
+    CaloLookup::CaloLookup() :
+      disks_(),
+      crystalX_(),
+      crystalY_(),
+      crystalPosFF_(),
+      neighbors_(),
+      nextNeighbors_(),
+      neighborsRaw_(),
+      nextNeighborsRaw_(),
+      trackerCenter_(),
+      crystalZLength_(0.0)
+    {
+       neighbors_.clear();
+       nextNeighbors_.clear();
+       neighborsRaw_.clear();
+       nextNeighborsRaw_.clear();
+    }
+
+
+    //-----------------------------------------------------------------------------
+    void CaloLookup::build(const std::vector<std::shared_ptr<Disk>>& disks, const std::vector<const Crystal*>& fullCrystalList,
+                           const CaloGeomUtil& geomUtil)
+    {
+        trackerCenter_  = geomUtil.trackerCenter();
+        crystalZLength_ = geomUtil.crystalZLength();
+
+        disks_.clear();
+        for (const auto& disk : disks)
+        {
+            DiskInfo info;
+            info.disk                  = disk.get();
+            info.rotated               = !disk->geomInfo().rotation().isIdentity();
+            info.rotation              = disk->geomInfo().rotation();
+            info.inverseRotation       = disk->geomInfo().inverseRotation();
+            info.origin                = disk->geomInfo().origin();
+            info.originToCrystalOrigin = disk->geomInfo().originToCrystalOrigin();
+            info.frontFaceInTracker    = geomUtil.mu2eToTracker(disk->geomInfo().frontFaceCenter());
+            info.frontToBack           = disk->geomInfo().crystalDirection()*crystalZLength_;
+            info.crystalOffset         = disk->crystalOffset();
+
+            // the crystals fill half a cell on each side of their center, leave one more cell of margin
+            Grid& grid    = info.grid;
+            grid.cellSize = disk->nominalCellSize();
+            double extent(0);
+            for (size_t icry=0;icry<disk->nCrystals();++icry)
+            {
+                const CLHEP::Hep3Vector& pos = disk->crystal(icry).localPosition();
+                extent = std::max(extent, std::max(std::abs(pos.x()),std::abs(pos.y())));
+            }
+            grid.nHalf = int(2.0*extent/grid.cellSize) + 4;
+
+            // each cell is inside a single cell of the crystal map, so its center gives the answer for the whole cell
+            int nCells = 2*grid.nHalf;
+            grid.crystal.assign(nCells*nCells,-1);
+            grid.nearest.clear();
+            for (int iy=0;iy<nCells;++iy)
+            {
+                double y = 0.5*(iy-grid.nHalf+0.5)*grid.cellSize;
+                for (int ix=0;ix<nCells;++ix)
+                {
+                    double x = 0.5*(ix-grid.nHalf+0.5)*grid.cellSize;
+                    grid.crystal[iy*nCells+ix] = disk->idxFromPosition(x,y);
+                    grid.nearest.append(disk->nearestIdxFromPosition(x,y));
+                }
+            }
+
+            disks_.push_back(std::move(info));
+        }
+
+        crystalX_.clear();
+        crystalY_.clear();
+        crystalPosFF_.clear();
+        neighbors_.clear();
+        nextNeighbors_.clear();
+        neighborsRaw_.clear();
+        nextNeighborsRaw_.clear();
+        for (const Crystal* crystal : fullCrystalList)
+        {
+            crystalX_.push_back(crystal->position().x());
+            crystalY_.push_back(crystal->position().y());
+            crystalPosFF_.push_back(geomUtil.mu2eToDiskFF(crystal->diskID(),crystal->position()));
+            neighbors_.append(crystal->neighbors(false));
+            nextNeighbors_.append(crystal->nextNeighbors(false));
+            neighborsRaw_.append(crystal->neighbors(true));
+            nextNeighborsRaw_.append(crystal->nextNeighbors(true));
+        }
+    }
+
+
+    //-----------------------------------------------------------------------------
+    // Cell containing (x,y), or -1 outside the grid or on a cell boundary, where the crystal map decides the side.
+    // The coordinates are scaled as in Disk::idxFromPosition, doubling them is exact
+    int CaloLookup::Grid::cell(double x, double y) const
+    {
+        double u  = 2.0*(x/cellSize);
+        double v  = 2.0*(y/cellSize);
+        double fu = std::floor(u);
+        double fv = std::floor(v);
+
+        if (!(fu >= -nHalf && fu < nHalf && fv >= -nHalf && fv < nHalf)) return -1;
+        if (fu == u || fv == v) return -1;
+
+        return (int(fv)+nHalf)*2*nHalf + int(fu)+nHalf;
+    }
+
+    int CaloLookup::idxFromPosition(const DiskInfo& info, double x, double y) const
+    {
+        int icell = info.grid.cell(x,y);
+        if (icell < 0) return info.disk->idxFromPosition(x,y);
+        return info.grid.crystal[icell];
+    }
+
+    CLHEP::Hep3Vector CaloLookup::mu2eToDisk(const DiskInfo& info, const CLHEP::Hep3Vector& pos) const
+    {
+        if (info.rotated) return info.rotation*(pos-info.origin);
+        return pos-info.origin;
+    }
+
+
+    //-----------------------------------------------------------------------------
+    int CaloLookup::crystalIdxFromPosition(const CLHEP::Hep3Vector& pos) const
+    {
+        for (const auto& info : disks_)
+        {
+            CLHEP::Hep3Vector posInSection = mu2eToDisk(info,pos);
+            CLHEP::Hep3Vector posInFF      = posInSection - info.originToCrystalOrigin;
+
+            if (posInFF.z() < -1e-6 || posInFF.z() > crystalZLength_+1e-6) continue;
+            if (idxFromPosition(info,posInFF.x(),posInFF.y()) < 0)           continue;
+
+            return info.crystalOffset + idxFromPosition(info,posInSection.x(),posInSection.y());
+        }
+        return -1;
+    }
+
+
+    //-----------------------------------------------------------------------------
+    // The candidates are searched in the first disk, and the offset taken from the closest disk in z
+    int CaloLookup::nearestIdxFromPosition(const CLHEP::Hep3Vector& pos) const
+    {
+        const DiskInfo& first = disks_[0];
+        CLHEP::Hep3Vector posInSection = mu2eToDisk(first,pos);
+
+        std::vector<int> list;
+        int icell = first.grid.cell(posInSection.x(),posInSection.y());
+        if (icell < 0) list = first.disk->nearestIdxFromPosition(posInSection.x(),posInSection.y());
+        IdRange cand = (icell < 0) ? IdRange(list.data(),list.data()+list.size()) : first.grid.nearest.range(icell);
+
+        int bestCand(cand[0]);
+        double bestDist(1e30);
+        for (int ic : cand)
+        {
+            double dx   = crystalX_[ic]-pos.x();
+            double dy   = crystalY_[ic]-pos.y();
+            double dist = sqrt(dx*dx+dy*dy);
+            if (dist < bestDist) {bestDist = dist; bestCand = ic;}
+        }
+
+        const DiskInfo* closest = &first;
+        for (const auto& info : disks_)
+           if (std::abs(info.origin.z()-pos.z()) < std::abs(closest->origin.z()-pos.z())) closest = &info;
+
+        return bestCand + closest->crystalOffset;
+    }
+
+
+    //-----------------------------------------------------------------------------
+    CLHEP::Hep3Vector CaloLookup::mu2eToDiskFF(int diskId, const CLHEP::Hep3Vector& pos) const
+    {
+        const DiskInfo& info = disks_[diskId];
+        return mu2eToDisk(info,pos) - info.originToCrystalOrigin;
+    }
+
+    CLHEP::Hep3Vector CaloLookup::diskFFToTracker(int diskId, const CLHEP::Hep3Vector& pos) const
+    {
+        const DiskInfo& info = disks_[diskId];
+        if (info.rotated) return info.inverseRotation*(pos + info.originToCrystalOrigin) + info.origin - trackerCenter_;
+        return pos + info.originToCrystalOrigin + info.origin - trackerCenter_;
+    }
+
+}
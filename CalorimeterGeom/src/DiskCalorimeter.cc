@@ -15,7 +15,8 @@ namespace mu2e {
       disks_(),
       fullCrystalList_(),  
       caloInfo_(),
-      geomUtil_(disks_, fullCrystalList_)
+      geomUtil_(disks_, fullCrystalList_),
+      lookup_()
     {}
 
 
@@ -34,39 +35,13 @@ namespace mu2e {
     
     int DiskCalorimeter::crystalIdxFromPosition(const CLHEP::Hep3Vector& pos) const 
     {   
-	for (size_t idisk=0;idisk<disks_.size();++idisk)
-	{
- 	   if ( geomUtil_.isInsideSection(idisk,pos) )
-	   {
-		 CLHEP::Hep3Vector posInSection = geomUtil_.mu2eToDisk(idisk, pos);
-		 return disk(idisk).crystalOffset() + disk(idisk).idxFromPosition(posInSection.x(),posInSection.y());
-	   } 
-	}       	  
-	return -1;
+        return lookup_.crystalIdxFromPosition(pos);
     }
     
 
     int DiskCalorimeter::nearestIdxFromPosition(const CLHEP::Hep3Vector& pos) const 
     {                   
-        CLHEP::Hep3Vector posInSection = geomUtil_.mu2eToDisk(0,pos);
-                
-        auto minDistIter = std::min_element(disks_.begin(),disks_.end(), [&](const auto& disk1, const auto& disk2)
-                           {return this->deltaZ(disk1->geomInfo().origin(),pos) < this->deltaZ(disk2->geomInfo().origin(),pos); });
-                
-        std::vector<int> cand = disks_[0]->nearestIdxFromPosition(posInSection.x(),posInSection.y());
-        auto bestCandIter = std::min_element(cand.begin(),cand.end(),[&](int ic1, int ic2) {return this->deltaPerp(ic1,pos) < this->deltaPerp(ic2,pos);});
-
-	return *bestCandIter+(*minDistIter)->crystalOffset();
-    }
- 
-    double DiskCalorimeter::deltaZ(const CLHEP::Hep3Vector& p1, const CLHEP::Hep3Vector& p2) const
-    {
-        return std::abs(p1.z()-p2.z());
-    }
-    
-    double DiskCalorimeter::deltaPerp(int ic, const CLHEP::Hep3Vector& pos) const
-    {
-        return sqrt((fullCrystalList_.at(ic)->position()-pos).perp2());
+        return lookup_.nearestIdxFromPosition(pos);
     }
  
  
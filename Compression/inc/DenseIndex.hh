@@ -0,0 +1,60 @@
+#ifndef Compression_DenseIndex_hh
+#define Compression_DenseIndex_hh
+//
+// Dense indices 0,1,2,... for objects of several collections, each
+// object identified by the ProductID of its collection and its key.
+// The indices are given in the order the objects are inserted, so the
+// information about the objects can be kept in flat vectors indexed
+// by them.  The lookup is an open addressing hash table with linear
+// probing; clear() keeps the memory, so an instance which is reused
+// from event to event does not allocate once it has grown.
+//
+// Keys of map_vectors are not contiguous (in mixed events the keys of
+// each frame are offset by a large number), so they are hashed rather
+// than used to index an array.
+//
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "canvas/Persistency/Provenance/ProductID.h"
+
+namespace mu2e {
+
+  class DenseIndex {
+  public:
+
+    static constexpr unsigned npos = std::numeric_limits<unsigned>::max();
+
+    // The index of the object, and true if it was not there before.
+    std::pair<unsigned,bool> insert(const art::ProductID& id, std::size_t key);
+
+    // The index of the object, or npos if it has not been inserted.
+    unsigned find(const art::ProductID& id, std::size_t key) const;
+
+    std::size_t size() const { return _entries.size(); }
+    bool empty() const { return _entries.empty(); }
+    const art::ProductID& productID(unsigned i) const { return _entries[i].id; }
+    std::size_t key(unsigned i) const { return _entries[i].key; }
+
+    void reserve(std::size_t n);
+    void clear();
+
+  private:
+
+    struct Entry {
+      art::ProductID id;
+      std::size_t key;
+    };
+
+    void rehash(std::size_t nslots);
+
+    std::vector<Entry> _entries;
+    std::vector<unsigned> _slots; // index into _entries or npos; the size is a power of 2
+  };
+
+}
+
+#endif /* Compression_DenseIndex_hh */
@@ -0,0 +1,175 @@
+#ifndef Compression_PtrRemap_hh
+#define Compression_PtrRemap_hh
+//
+// The bookkeeping of the compression modules: the set of objects which
+// are kept, and the new Ptr of each of them once it has been copied to
+// the output.  It replaces the std::set and std::map<art::Ptr<T>, art::Ptr<T>>
+// which were used before: every kept object gets a dense index (see
+// DenseIndex.hh), and the old and new Ptrs are held in flat vectors.
+//
+// The objects are held in the order they were first inserted.
+//
+// FlatKeyRemap is the key remapping of compressSimParticleCollection
+// (when the SimParticles get new keys) built on the same index.
+//
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+#include "cetlib/map_vector.h"
+#include "cetlib_except/exception.h"
+
+#include "Compression/inc/DenseIndex.hh"
+
+namespace mu2e {
+
+  template<class T>
+  class PtrRemap {
+  public:
+
+    // The selector for compressSimParticleCollection: is the object
+    // with this key in collection id kept?
+    class Selector {
+    public:
+      Selector(const PtrRemap& remap, const art::ProductID& id) : _remap(remap), _id(id) {}
+      bool operator[](cet::map_vector_key key) const {
+        return _remap.contains(_id, key.asUint());
+      }
+    private:
+      const PtrRemap& _remap;
+      art::ProductID _id;
+    };
+
+    // Record an object as kept.  Returns true if it was not kept before.
+    bool insert(const art::Ptr<T>& oldPtr) {
+      if (_index.insert(oldPtr.id(), oldPtr.key()).second) {
+        _old.push_back(oldPtr);
+        _new.emplace_back();
+        _mapped.push_back(false);
+        return true;
+      }
+      return false;
+    }
+
+    // Set the new Ptr of the i-th kept object, or of an object (which is kept if it was not).
+    void set(std::size_t i, const art::Ptr<T>& newPtr) {
+      _new[i] = newPtr;
+      _mapped[i] = true;
+    }
+    void set(const art::Ptr<T>& oldPtr, const art::Ptr<T>& newPtr) {
+      insert(oldPtr);
+      set(_index.find(oldPtr.id(), oldPtr.key()), newPtr);
+    }
+
+    bool contains(const art::Ptr<T>& oldPtr) const {
+      return contains(oldPtr.id(), oldPtr.key());
+    }
+    bool contains(const art::ProductID& id, std::size_t key) const {
+      return _index.find(id, key) != DenseIndex::npos;
+    }
+
+    // The new Ptr, or nullptr if none has been set
+    const art::Ptr<T>* find(const art::Ptr<T>& oldPtr) const {
+      unsigned i = _index.find(oldPtr.id(), oldPtr.key());
+      return (i != DenseIndex::npos && _mapped[i]) ? &_new[i] : nullptr;
+    }
+
+    // The new Ptr; throws if none has been set
+    const art::Ptr<T>& at(const art::Ptr<T>& oldPtr) const {
+      const art::Ptr<T>* newPtr = find(oldPtr);
+      if (newPtr == nullptr) {
+        throw cet::exception("COMPRESSION")
+          << "PtrRemap: there is no new Ptr for " << oldPtr << "\n";
+      }
+      return *newPtr;
+    }
+
+    // The kept objects, in the order they were inserted
+    std::size_t size() const { return _old.size(); }
+    bool empty() const { return _old.empty(); }
+    const art::Ptr<T>& oldPtr(std::size_t i) const { return _old[i]; }
+    const art::Ptr<T>& newPtr(std::size_t i) const { return _new[i]; }
+
+    // The number of kept objects of collection id
+    std::size_t count(const art::ProductID& id) const {
+      std::size_t n = 0;
+      for (const auto& p : _old) {
+        if (p.id() == id) {
+          ++n;
+        }
+      }
+      return n;
+    }
+
+    Selector selector(const art::ProductID& id) const { return Selector(*this, id); }
+
+    void reserve(std::size_t n) {
+      _index.reserve(n);
+      _old.reserve(n);
+      _new.reserve(n);
+      _mapped.reserve(n);
+    }
+
+    void clear() {
+      _index.clear();
+      _old.clear();
+      _new.clear();
+      _mapped.clear();
+    }
+
+  private:
+
+    DenseIndex _index;
+    std::vector<art::Ptr<T> > _old;
+    std::vector<art::Ptr<T> > _new;
+    std::vector<char> _mapped;
+  };
+
+
+  class FlatKeyRemap {
+  public:
+
+    typedef std::pair<cet::map_vector_key, cet::map_vector_key> value_type;
+
+    // As std::map::try_emplace: add oldKey -> newKey unless oldKey is already there
+    std::pair<const value_type*, bool> try_emplace(const cet::map_vector_key& oldKey, const cet::map_vector_key& newKey) {
+      auto result = _index.insert(art::ProductID(), oldKey.asUint());
+      if (result.second) {
+        _keys.emplace_back(oldKey, newKey);
+      }
+      return std::make_pair(&_keys[result.first], result.second);
+    }
+
+    const cet::map_vector_key& at(const cet::map_vector_key& oldKey) const {
+      unsigned i = _index.find(art::ProductID(), oldKey.asUint());
+      if (i == DenseIndex::npos) {
+        throw cet::exception("COMPRESSION")
+          << "FlatKeyRemap: there is no new key for " << oldKey.asUint() << "\n";
+      }
+      return _keys[i].second;
+    }
+
+    std::size_t size() const { return _keys.size(); }
+
+    void reserve(std::size_t n) {
+      _index.reserve(n);
+      _keys.reserve(n);
+    }
+
+    void clear() {
+      _index.clear();
+      _keys.clear();
+    }
+
+  private:
+
+    DenseIndex _index;
+    std::vector<value_type> _keys;
+  };
+
+}
+
+#endif /* Compression_PtrRemap_hh */
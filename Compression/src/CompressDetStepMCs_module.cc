@@ -43,39 +43,13 @@
 #include "Compression/inc/CompressionLevel.hh"
 #include "MCDataProducts/inc/MCTrajectoryCollection.hh"
 #include "MCDataProducts/inc/MCRelationship.hh"
+#include "Compression/inc/PtrRemap.hh"
 
 namespace mu2e {
   class CompressDetStepMCs;
 
-  typedef std::set<art::Ptr<SimParticle> > SimParticleSet;
-
-  class SimParticleSelector {
-  public:
-    SimParticleSelector(const SimParticleSet& simPartSet) {
-      for (const auto& i_simPart : simPartSet) {
-        cet::map_vector_key key = cet::map_vector_key(i_simPart.key());
-        m_keys.insert(key);
-      }
-    }
-
-    bool operator[]( cet::map_vector_key key ) const {
-      return m_keys.find(key) != m_keys.end();
-    }
-
-    const std::set<cet::map_vector_key>& keys() const {
-      return m_keys;
-    }
-
-    void clear() {
-      m_keys.clear();
-    }
-
-  private:
-    std::set<cet::map_vector_key> m_keys;
-
-  };
-
   typedef std::string InstanceLabel;
+  typedef PtrRemap<mu2e::SimParticle> SimParticleRemap;
 }
 
 
@@ -169,9 +143,9 @@ private:
   art::ProductID _newGenParticlesPID;
   const art::EDProductGetter* _newGenParticleGetter;
 
-  // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us
-  std::map<art::ProductID, mu2e::SimParticleSet> _simParticlesToKeep;
-  SimParticleRemapping _simPtrRemap;
+  // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us,
+  // and then their Ptrs in the new collection
+  SimParticleRemap _simParticleRemap;
 };
 
 
@@ -230,8 +204,7 @@ void mu2e::CompressDetStepMCs::produce(art::Event & event)
 
   _newMCTrajectories = std::unique_ptr<MCTrajectoryCollection>(new MCTrajectoryCollection);
 
-  _simParticlesToKeep.clear();
-  _simPtrRemap.clear();
+  _simParticleRemap.clear();
 
   // Compress detector steps and record which SimParticles we want to keep
   if (_conf.strawGasStepTag() != "") { compressStrawGasSteps(event); }
@@ -291,6 +264,7 @@ void mu2e::CompressDetStepMCs::produce(art::Event & event)
 void mu2e::CompressDetStepMCs::compressStrawGasSteps(const art::Event& event) {
   const auto& strawGasStepsHandle = event.getValidHandle(_strawGasStepToken);
   const auto& strawGasSteps = *strawGasStepsHandle;
+  _newStrawGasSteps->reserve(strawGasSteps.size());
   if(_debugLevel>0 && strawGasSteps.size()>0) {
     std::cout << "Compressing StrawGasSteps from " << _conf.strawGasStepTag() << std::endl;
   }
@@ -311,6 +285,7 @@ void mu2e::CompressDetStepMCs::compressStrawGasSteps(const art::Event& event) {
 void mu2e::CompressDetStepMCs::compressCaloShowerSteps(const art::Event& event) {
   const auto& caloShowerStepsHandle = event.getValidHandle(_caloShowerStepToken);
   const auto& caloShowerSteps = *caloShowerStepsHandle;
+  _newCaloShowerSteps->reserve(caloShowerSteps.size());
   if(_debugLevel>0 && caloShowerSteps.size()>0) {
     std::cout << "Compressing CaloShowerSteps from " << _conf.caloShowerStepTag() << std::endl;
   }
@@ -331,6 +306,7 @@ void mu2e::CompressDetStepMCs::compressCaloShowerSteps(const art::Event& event)
 void mu2e::CompressDetStepMCs::compressCrvSteps(const art::Event& event) {
   const auto& crvStepsHandle = event.getValidHandle(_crvStepToken);
   const auto& crvSteps = *crvStepsHandle;
+  _newCrvSteps->reserve(crvSteps.size());
   if(_debugLevel>0 && crvSteps.size()>0) {
     std::cout << "Compressing CrvSteps from " << _conf.crvStepTag() << std::endl;
   }
@@ -351,7 +327,7 @@ void mu2e::CompressDetStepMCs::compressCrvSteps(const art::Event& event) {
 void mu2e::CompressDetStepMCs::updateStrawGasSteps() {
   for (auto& i_strawGasStep : *_newStrawGasSteps) {
     const auto& oldSimPtr = i_strawGasStep.simParticle();
-    art::Ptr<mu2e::SimParticle> newSimPtr = _simPtrRemap.at(oldSimPtr);
+    art::Ptr<mu2e::SimParticle> newSimPtr = _simParticleRemap.at(oldSimPtr);
     if(_debugLevel>0) {
       std::cout << "Updating SimParticlePtr in StrawGasStep from " << oldSimPtr << " to " << newSimPtr << std::endl;
     }
@@ -363,7 +339,7 @@ void mu2e::CompressDetStepMCs::updateStrawGasSteps() {
 void mu2e::CompressDetStepMCs::updateCaloShowerSteps() {
   for (auto& i_caloShowerStep : *_newCaloShowerSteps) {
     const auto& oldSimPtr = i_caloShowerStep.simParticle();
-    art::Ptr<mu2e::SimParticle> newSimPtr = _simPtrRemap.at(oldSimPtr);
+    art::Ptr<mu2e::SimParticle> newSimPtr = _simParticleRemap.at(oldSimPtr);
     if(_debugLevel>0) {
       std::cout << "Updating SimParticlePtr in CaloShowerStep from " << oldSimPtr << " to " << newSimPtr << std::endl;
     }
@@ -375,7 +351,7 @@ void mu2e::CompressDetStepMCs::updateCaloShowerSteps() {
 void mu2e::CompressDetStepMCs::updateCrvSteps() {
   for (auto& i_crvStep : *_newCrvSteps) {
     const auto& oldSimPtr = i_crvStep.simParticle();
-    art::Ptr<mu2e::SimParticle> newSimPtr = _simPtrRemap.at(oldSimPtr);
+    art::Ptr<mu2e::SimParticle> newSimPtr = _simParticleRemap.at(oldSimPtr);
     if(_debugLevel>0) {
       std::cout << "Updating SimParticlePtr in CrvStep from " << oldSimPtr << " to " << newSimPtr << std::endl;
     }
@@ -392,22 +368,28 @@ void mu2e::CompressDetStepMCs::compressSimParticles(const art::Event& event) {
   const art::EDProductGetter* i_prod_getter = event.productGetter(i_product_id);
   if (_simParticleCompressionLevel == CompressionLevel::kNoCompression) {
     // add all the SimParticles
+    _simParticleRemap.reserve(_simParticleRemap.size() + oldSimParticles->size());
     for (const auto& i_simParticle : *oldSimParticles) {
       art::Ptr<SimParticle> oldSimPtr(i_product_id, i_simParticle.first.asUint(), i_prod_getter);
       recordSimParticle(oldSimPtr);
     }
   }
 
-  SimParticleSelector simPartSelector(_simParticlesToKeep[i_product_id]);
-  keep_size += _simParticlesToKeep[i_product_id].size();
+  _newSimParticles->reserve(_simParticleRemap.size());
+  SimParticleRemap::Selector simPartSelector = _simParticleRemap.selector(i_product_id);
+  keep_size += _simParticleRemap.count(i_product_id);
   compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles, simPartSelector, *_newSimParticles);
 
-  // Fill out the SimParticleRemapping
-  for (const auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
-    cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.key());
-    _simPtrRemap[i_keptSimPart] = art::Ptr<mu2e::SimParticle>(_newSimParticlesPID, oldKey.asUint(), _newSimParticleGetter);
+  // Fill out the new Ptrs of the kept SimParticles
+  for (size_t i_keptSimPart = 0; i_keptSimPart < _simParticleRemap.size(); ++i_keptSimPart) {
+    const art::Ptr<mu2e::SimParticle>& oldSimPtr = _simParticleRemap.oldPtr(i_keptSimPart);
+    if (oldSimPtr.id() != i_product_id) {
+      continue;
+    }
+    cet::map_vector_key oldKey = cet::map_vector_key(oldSimPtr.key());
+    _simParticleRemap.set(i_keptSimPart, art::Ptr<mu2e::SimParticle>(_newSimParticlesPID, oldKey.asUint(), _newSimParticleGetter));
     if (_debugLevel>0) {
-      std::cout << "Compressing SimParticle " << i_keptSimPart << " --> " << _simPtrRemap.at(i_keptSimPart) << std::endl;
+      std::cout << "Compressing SimParticle " << oldSimPtr << " --> " << _simParticleRemap.newPtr(i_keptSimPart) << std::endl;
     }
   }
   if (keep_size != _newSimParticles->size()) {
@@ -423,13 +405,16 @@ void mu2e::CompressDetStepMCs::compressSimParticles(const art::Event& event) {
   // add them back as truncated SimParticles
   if (_keepNGenerations >= 0) {
     // Go through the particles we are keeping and see if any parents are not there
-    for (auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
+    for (size_t i_keptSimPart = 0; i_keptSimPart < _simParticleRemap.size(); ++i_keptSimPart) {
+      if (_simParticleRemap.oldPtr(i_keptSimPart).id() != i_product_id) {
+        continue;
+      }
 
-      art::Ptr<mu2e::SimParticle> i_childPtr = i_keptSimPart;
+      art::Ptr<mu2e::SimParticle> i_childPtr = _simParticleRemap.oldPtr(i_keptSimPart);
       art::Ptr<mu2e::SimParticle> i_parentPtr = i_childPtr->parent();
       while (i_parentPtr) {
         // if the parent will not be in the output collection
-        if (_simPtrRemap.find(i_parentPtr) == _simPtrRemap.end()) {
+        if (!_simParticleRemap.find(i_parentPtr)) {
           if (_debugLevel>0) {
             std::cout << "SimParticle " << i_parentPtr << " will not be in output collection because it has been compressed away by genealogy compression" << std::endl;
           }
@@ -440,7 +425,7 @@ void mu2e::CompressDetStepMCs::compressSimParticles(const art::Event& event) {
         else {
           // this parent is in the output collection so
           if (_debugLevel>0) {
-            std::cout << "SimParticle " << i_parentPtr << " is in the output collection as " << _simPtrRemap.at(i_parentPtr) << std::endl;
+            std::cout << "SimParticle " << i_parentPtr << " is in the output collection as " << _simParticleRemap.at(i_parentPtr) << std::endl;
           }
         }
         i_childPtr = i_parentPtr;
@@ -458,13 +443,13 @@ void mu2e::CompressDetStepMCs::compressSimParticles(const art::Event& event) {
           std::cout << "Look for a new parent for particle id " << newsim.id() << " (current parent = " << i_ancestorPtr << ")" << std::endl;
         }
         while (i_ancestorPtr) {
-          const auto& findIter = _simPtrRemap.find(i_ancestorPtr);
-          if (findIter != _simPtrRemap.end()) {
-            newsim.parent() = findIter->second;
+          const art::Ptr<mu2e::SimParticle>* newAncestorPtr = _simParticleRemap.find(i_ancestorPtr);
+          if (newAncestorPtr) {
+            newsim.parent() = *newAncestorPtr;
             art::Ptr<mu2e::SimParticle> newChildPtr = art::Ptr<mu2e::SimParticle>(_newSimParticlesPID, newsim.id().asUint(), _newSimParticleGetter);
             (*_newSimParticles)[i_ancestorPtr->id()].addDaughter(newChildPtr);
             if (_debugLevel > 0) {
-              std::cout << "Because of truncation setting SimParticle (" << newsim.id() << ")'s parent to " << findIter->second << " and adding daughter " << newChildPtr << std::endl;
+              std::cout << "Because of truncation setting SimParticle (" << newsim.id() << ")'s parent to " << *newAncestorPtr << " and adding daughter " << newChildPtr << std::endl;
             }
             break; // don't need to go any further
           }
@@ -508,20 +493,12 @@ void mu2e::CompressDetStepMCs::compressStepPointMCs(const art::Event& event) {
     if(_debugLevel>0 && stepPointMCs->size()>0) {
       std::cout << "Compressing StepPointMCs from " << i_tag << std::endl;
     }
+    _newStepPointMCs.at(i_tag.instance())->reserve(stepPointMCs->size());
     for (const auto& stepPointMC : *stepPointMCs) {
       if (_stepPointMCCompressionLevel == mu2e::CompressionLevel::kSimParticleCompression) {
-        for (const auto& simPartsToKeep : _simParticlesToKeep) {
-          const art::ProductID& oldProdID = simPartsToKeep.first;
-          if (stepPointMC.simParticle().id() != oldProdID) {
-            continue;
-          }
-          const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-          for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-            if (stepPointMC.simParticle() == alreadyKeptSimPart) {
-              StepPointMC newStepPointMC(stepPointMC);
-              _newStepPointMCs.at(i_tag.instance())->push_back(newStepPointMC);
-            }
-          }
+        if (_simParticleRemap.contains(stepPointMC.simParticle())) {
+          StepPointMC newStepPointMC(stepPointMC);
+          _newStepPointMCs.at(i_tag.instance())->push_back(newStepPointMC);
         }
       }
       else if (_stepPointMCCompressionLevel == mu2e::CompressionLevel::kNoCompression) {
@@ -543,18 +520,9 @@ void mu2e::CompressDetStepMCs::compressMCTrajectories(const art::Event& event) {
   }
   for (const auto& mcTrajectory : *mcTrajectories) {
     if (_mcTrajectoryCompressionLevel == mu2e::CompressionLevel::kSimParticleCompression) {
-      for (const auto& simPartsToKeep : _simParticlesToKeep) {
-        const art::ProductID& oldProdID = simPartsToKeep.first;
-        if (mcTrajectory.second.sim().id() != oldProdID) {
-          continue;
-        }
-        const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-        for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-          if (mcTrajectory.second.sim() == alreadyKeptSimPart) {
-            MCTrajectory newMCTrajectory(mcTrajectory.second);
-            _newMCTrajectories->insert(std::make_pair(mcTrajectory.second.sim(), newMCTrajectory));
-          }
-        }
+      if (_simParticleRemap.contains(mcTrajectory.second.sim())) {
+        MCTrajectory newMCTrajectory(mcTrajectory.second);
+        _newMCTrajectories->insert(std::make_pair(mcTrajectory.second.sim(), newMCTrajectory));
       }
     }
     else if (_mcTrajectoryCompressionLevel == mu2e::CompressionLevel::kNoCompression) {
@@ -572,7 +540,7 @@ void mu2e::CompressDetStepMCs::updateStepPointMCs() {
   for (const auto& i_tag : _conf.stepPointMCTags()) {
     for (auto& i_stepPointMC : *(_newStepPointMCs.at(i_tag.instance()))) {
       const auto& oldSimPtr = i_stepPointMC.simParticle();
-      art::Ptr<mu2e::SimParticle> newSimPtr = _simPtrRemap.at(oldSimPtr);
+      art::Ptr<mu2e::SimParticle> newSimPtr = _simParticleRemap.at(oldSimPtr);
       if(_debugLevel>0) {
         std::cout << "Updating SimParticlePtr in StepPointMC from " << oldSimPtr << " to " << newSimPtr << std::endl;
       }
@@ -584,7 +552,7 @@ void mu2e::CompressDetStepMCs::updateStepPointMCs() {
 void mu2e::CompressDetStepMCs::updateMCTrajectories() {
   for (auto& i_mcTrajectory : *_newMCTrajectories) {
     const auto& oldSimPtr = i_mcTrajectory.second.sim();
-    art::Ptr<mu2e::SimParticle> newSimPtr = _simPtrRemap.at(oldSimPtr);
+    art::Ptr<mu2e::SimParticle> newSimPtr = _simParticleRemap.at(oldSimPtr);
     if(_debugLevel>0) {
       std::cout << "Updating SimParticlePtr in MCTrajectory from " << oldSimPtr << " to " << newSimPtr << std::endl;
     }
@@ -598,7 +566,7 @@ void mu2e::CompressDetStepMCs::updateMCTrajectories() {
 
 void mu2e::CompressDetStepMCs::recordSimParticle(const art::Ptr<mu2e::SimParticle>& sim_ptr) {
   // Also need to add all the parents too
-  _simParticlesToKeep[sim_ptr.id()].insert(sim_ptr);
+  _simParticleRemap.insert(sim_ptr);
   art::Ptr<mu2e::SimParticle> childPtr = sim_ptr;
   art::Ptr<mu2e::SimParticle> parentPtr = childPtr->parent();
 
@@ -608,13 +576,13 @@ void mu2e::CompressDetStepMCs::recordSimParticle(const art::Ptr<mu2e::SimParticl
   while (parentPtr) {
     MCRelationship mcr(sim_ptr, parentPtr);
     if (_keepNGenerations == -1 || ( (mcr.removal() <= _keepNGenerations) && mcr.removal()>=0) ) {
-      _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
+      _simParticleRemap.insert(parentPtr);
       if(_debugLevel>0) {
         std::cout << "and recording its ancestor " << parentPtr << " (NGen = " << (int)mcr.removal() << ")" << std::endl;
       }
     }
     else if (parentPtr->isPrimary()) { // always keep the very first SimParticle
-      _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
+      _simParticleRemap.insert(parentPtr);
       if(_debugLevel>0) {
         std::cout << "and recording the very first SimParticle " << parentPtr << std::endl;
       }
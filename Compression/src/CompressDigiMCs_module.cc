@@ -25,6 +25,7 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 #include "art_root_io/TFileService.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "MCDataProducts/inc/StrawDigiMCCollection.hh"
@@ -41,49 +42,19 @@
 #include "Mu2eUtilities/inc/compressSimParticleCollection.hh"
 #include "MCDataProducts/inc/GenParticleCollection.hh"
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
-#include "MCDataProducts/inc/SimParticleRemapping.hh"
 #include "DataProducts/inc/IndexMap.hh"
 #include "MCDataProducts/inc/CrvCoincidenceClusterMCCollection.hh"
 #include "MCDataProducts/inc/PrimaryParticle.hh"
 #include "MCDataProducts/inc/MCTrajectoryCollection.hh"
+#include "Compression/inc/PtrRemap.hh"
 
 namespace mu2e {
   class CompressDigiMCs;
 
-  typedef std::set<art::Ptr<SimParticle> > SimParticleSet;
-
-  class SimParticleSelector {
-  public:
-    SimParticleSelector(const SimParticleSet& simPartSet) {
-      for (const auto& i_simPart : simPartSet) {
-        cet::map_vector_key key = cet::map_vector_key(i_simPart.key());
-        m_keys.insert(key);
-      }
-    }
-
-    bool operator[]( cet::map_vector_key key ) const {
-      return m_keys.find(key) != m_keys.end();
-    }
-
-    const std::set<cet::map_vector_key>& keys() const {
-      return m_keys;
-    }
-
-    void clear() {
-      m_keys.clear();
-    }
-
-  private:
-    std::set<cet::map_vector_key> m_keys;
-
-  };
-
   typedef std::string InstanceLabel;
-  typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
-  typedef std::map<art::Ptr<mu2e::StepPointMC>, art::Ptr<mu2e::StepPointMC> > StepPointMCRemap;
-  typedef std::map<art::Ptr<mu2e::StrawGasStep>, art::Ptr<mu2e::StrawGasStep> > StrawGasStepRemap;
-  typedef std::map<art::Ptr<mu2e::CaloShowerStep>, art::Ptr<mu2e::CaloShowerStep> > CaloShowerStepRemap;
-  typedef std::map<art::Ptr<mu2e::CrvStep>, art::Ptr<mu2e::CrvStep> > CrvStepRemap;
+  typedef PtrRemap<mu2e::SimParticle> SimParticleRemap;
+  typedef PtrRemap<mu2e::CaloShowerStep> CaloShowerStepRemap;
+  typedef PtrRemap<mu2e::CrvStep> CrvStepRemap;
 }
 
 
@@ -201,8 +172,11 @@ private:
   art::ProductID _newCaloHitMCsPID;
   const art::EDProductGetter* _newCaloHitMCGetter;
 
-  // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us
-  std::map<art::ProductID, SimParticleSet> _simParticlesToKeep;
+  // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us,
+  // and then their Ptrs in the new collection
+  SimParticleRemap _simParticleRemap;
+  std::vector<art::ProductID> _simParticleIDs;
+  FlatKeyRemap _keyRemap;
 
   std::vector<InstanceLabel> _newStepPointMCInstances;
 
@@ -223,9 +197,9 @@ private:
 
   // For CrvDigiMCs, there's a chance that the same StepPointMC will go into multiple CrvDigiMCs
   // This module didn't take this into account initially and so the same StepPointMC was being written out multiple times
-  // This std::set is used to make sure that this doesn't happen
-  std::set<art::Ptr<CrvStep> > _crvStepsSeen;
-  std::map<art::Ptr<CrvStep>, art::Ptr<CrvStep> > _crvStepsMap;
+  // This remap is used to make sure that this doesn't happen
+  CrvStepRemap _crvStepRemap;
+  CaloShowerStepRemap _caloShowerStepRemap;
 
   bool _noCompression;
 };
@@ -328,12 +302,17 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Create all the new collections, ProductIDs and product getters for the SimParticles and GenParticles
   // There is one for each background frame plus one for the primary event
   unsigned int n_gen_particles_to_keep = 0;
+  _simParticleRemap.clear();
+  _simParticleIDs.clear();
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
     const art::EDProductGetter* i_product_getter = event.productGetter(i_product_id);
 
-    _simParticlesToKeep[i_product_id].clear();
+    _simParticleIDs.push_back(i_product_id);
+    if (_noCompression) {
+      _simParticleRemap.reserve(_simParticleRemap.size() + oldSimParticles->size());
+    }
 
     if (_keepAllGenParticles || _noCompression) {
       // Add all the SimParticles that are also GenParticles
@@ -406,6 +385,8 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Now start to compress
   event.getByLabel(_strawDigiMCTag, _strawDigiMCsHandle);
   const auto& strawDigiMCs = *_strawDigiMCsHandle;
+  _newStrawDigiMCs->reserve(strawDigiMCs.size());
+  _newStrawGasSteps->reserve(strawDigiMCs.size());
   for (size_t i = 0; i < strawDigiMCs.size(); ++i) {
     const auto& i_strawDigiMC = strawDigiMCs.at(i);
     mu2e::FullIndex full_i = i;
@@ -426,11 +407,11 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 
   if (_crvDigiMCTag != "") {
-    _crvStepsSeen.clear();
-    _crvStepsMap.clear();
+    _crvStepRemap.clear();
 
     event.getByLabel(_crvDigiMCTag, _crvDigiMCsHandle);
     const auto& crvDigiMCs = *_crvDigiMCsHandle;
+    _newCrvDigiMCs->reserve(crvDigiMCs.size());
     for (size_t i = 0; i < crvDigiMCs.size(); ++i) {
       const auto& i_crvDigiMC = crvDigiMCs.at(i);
       mu2e::FullIndex full_i = i;
@@ -452,7 +433,7 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Two possible compressions for calorimeter
   // The first just takes the CaloShowerSteps, CaloShowerSims and CaloShowerROs and reassigns Ptrs (i.e. no actual compression....)
   if (_caloShowerStepTags.size() != 0) {
-    CaloShowerStepRemap caloShowerStepRemap;
+    _caloShowerStepRemap.clear();
     _newCaloShowerSteps = std::unique_ptr<CaloShowerStepCollection>(new CaloShowerStepCollection);
     _newCaloShowerStepsPID = event.getProductID<CaloShowerStepCollection>();
     _newCaloShowerStepGetter = event.productGetter(_newCaloShowerStepsPID);
@@ -460,26 +441,30 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
       const auto& oldCaloShowerSteps = event.getValidHandle<CaloShowerStepCollection>(*i_tag);
       art::ProductID i_product_id = oldCaloShowerSteps.id();
       _oldCaloShowerStepGetter[i_product_id] = event.productGetter(i_product_id);
+      _newCaloShowerSteps->reserve(_newCaloShowerSteps->size() + oldCaloShowerSteps->size());
+      _caloShowerStepRemap.reserve(_caloShowerStepRemap.size() + oldCaloShowerSteps->size());
 
       for (CaloShowerStepCollection::const_iterator i_caloShowerStep = oldCaloShowerSteps->begin(); i_caloShowerStep != oldCaloShowerSteps->end(); ++i_caloShowerStep) {
         art::Ptr<mu2e::CaloShowerStep> oldShowerStepPtr(i_product_id,  i_caloShowerStep - oldCaloShowerSteps->begin(), _oldCaloShowerStepGetter[i_product_id]);
         art::Ptr<mu2e::CaloShowerStep> newShowerStepPtr = copyCaloShowerStep(*i_caloShowerStep);
-        caloShowerStepRemap[oldShowerStepPtr] = newShowerStepPtr;
+        _caloShowerStepRemap.set(oldShowerStepPtr, newShowerStepPtr);
       }
     }
 
     _newCaloShowerSims = std::unique_ptr<CaloShowerSimCollection>(new CaloShowerSimCollection);
     event.getByLabel(_caloShowerSimTag, _caloShowerSimsHandle);
     const auto& caloShowerSims = *_caloShowerSimsHandle;
+    _newCaloShowerSims->reserve(caloShowerSims.size());
     for (const auto& i_caloShowerSim : caloShowerSims) {
-      copyCaloShowerSim(i_caloShowerSim, caloShowerStepRemap);
+      copyCaloShowerSim(i_caloShowerSim, _caloShowerStepRemap);
     }
 
     _newCaloShowerROs = std::unique_ptr<CaloShowerROCollection>(new CaloShowerROCollection);
     event.getByLabel(_caloShowerROTag, _CaloShowerROsHandle);
     const auto& CaloShowerROs = *_CaloShowerROsHandle;
+    _newCaloShowerROs->reserve(CaloShowerROs.size());
     for (const auto& i_CaloShowerRO : CaloShowerROs) {
-      copyCaloShowerRO(i_CaloShowerRO, caloShowerStepRemap);
+      copyCaloShowerRO(i_CaloShowerRO, _caloShowerStepRemap);
     }
   }
 
@@ -509,20 +494,14 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   for (std::vector<art::InputTag>::const_iterator i_tag = _extraStepPointMCTags.begin(); i_tag != _extraStepPointMCTags.end(); ++i_tag) {
     const auto& stepPointMCs = event.getValidHandle<StepPointMCCollection>(*i_tag);
     for (const auto& stepPointMC : *stepPointMCs) {
-      for (const auto& simPartsToKeep : _simParticlesToKeep) {
-        const art::ProductID& oldProdID = simPartsToKeep.first;
-        if (stepPointMC.simParticle().id() != oldProdID) {
-          continue;
-        }
-        if (!_noCompression) { // if we want to compress
-          const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-          for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-            if (stepPointMC.simParticle() == alreadyKeptSimPart) {
-              copyStepPointMC(stepPointMC, (*i_tag).instance() );
-            }
-          }
+      if (!_noCompression) { // if we want to compress
+        if (_simParticleRemap.contains(stepPointMC.simParticle())) {
+          copyStepPointMC(stepPointMC, (*i_tag).instance() );
         }
-        else { // if we don't want to compress
+      }
+      else { // if we don't want to compress
+        const art::ProductID& oldProdID = stepPointMC.simParticle().id();
+        if (std::find(_simParticleIDs.begin(), _simParticleIDs.end(), oldProdID) != _simParticleIDs.end()) {
           copyStepPointMC(stepPointMC, (*i_tag).instance() );
         }
       }
@@ -530,32 +509,36 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   }
 
   // Now compress the SimParticleCollections into their new collections
-  KeyRemap* keyRemap = new KeyRemap;
-  SimParticleRemapping remap;
+  SimParticleRemap& remap = _simParticleRemap;
   unsigned int keep_size = 0;
+  _newSimParticles->reserve(remap.size());
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
-    keyRemap->clear();
+    _keyRemap.clear();
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
-    SimParticleSelector simPartSelector(_simParticlesToKeep[i_product_id]);
-    keep_size += _simParticlesToKeep[i_product_id].size();
+    SimParticleRemap::Selector simPartSelector = remap.selector(i_product_id);
+    keep_size += remap.count(i_product_id);
     if (_rekeySimParticleCollection) {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
-                                    simPartSelector, *_newSimParticles, keyRemap);
+                                    simPartSelector, *_newSimParticles, &_keyRemap);
     }
     else {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
                                     simPartSelector, *_newSimParticles);
     }
 
-    // Fill out the SimParticleRemapping
-    for (const auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
-      cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.key());
+    // Fill out the new Ptrs of the kept SimParticles
+    for (size_t i_keptSimPart = 0; i_keptSimPart < remap.size(); ++i_keptSimPart) {
+      const art::Ptr<SimParticle>& oldSimPtr = remap.oldPtr(i_keptSimPart);
+      if (oldSimPtr.id() != i_product_id) {
+        continue;
+      }
+      cet::map_vector_key oldKey = cet::map_vector_key(oldSimPtr.key());
       cet::map_vector_key newKey = oldKey;
       if (_rekeySimParticleCollection) {
-        newKey = keyRemap->at(oldKey);
+        newKey = _keyRemap.at(oldKey);
       }
-      remap[i_keptSimPart] = art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter);
+      remap.set(i_keptSimPart, art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter));
     }
   }
   if (keep_size != _newSimParticles->size()) {
@@ -589,10 +572,9 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     SimParticleTimeMap& i_newTimeMap = *_newSimParticleTimeMaps.at(i_element);
     for (const auto& timeMapPair : i_oldTimeMap) {
       art::Ptr<SimParticle> oldSimPtr = timeMapPair.first;
-      const auto& newSimPtrIter = remap.find(oldSimPtr);
-      if (newSimPtrIter != remap.end()) {
-        art::Ptr<SimParticle> newSimPtr = newSimPtrIter->second;
-        i_newTimeMap[newSimPtr] = timeMapPair.second;
+      const art::Ptr<SimParticle>* newSimPtr = remap.find(oldSimPtr);
+      if (newSimPtr) {
+        i_newTimeMap[*newSimPtr] = timeMapPair.second;
       }
     }
   }
@@ -673,8 +655,9 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   if (_mcTrajectoryTag != "") {
     for (const auto& i_mcTrajectory : *_mcTrajectoriesHandle) {
       art::Ptr<SimParticle> oldSimPtr = i_mcTrajectory.first;
-      if (remap.find(oldSimPtr) != remap.end()) {
-        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(remap.at(oldSimPtr), i_mcTrajectory.second));
+      const art::Ptr<SimParticle>* newSimPtr = remap.find(oldSimPtr);
+      if (newSimPtr) {
+        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(*newSimPtr, i_mcTrajectory.second));
       }
     }
   }
@@ -725,25 +708,29 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 void mu2e::CompressDigiMCs::copyStrawDigiMC(const mu2e::StrawDigiMC& old_straw_digi_mc) {
 
-  StrawGasStepRemap step_remap;
-
   // Need to update the Ptrs for the StepPointMCs
+  // Both ends usually have the same step, which is copied once
   StrawDigiMC::SGSPA newTriggerStepPtr;
   for(int i_end=0;i_end<StrawEnd::nends;++i_end){
     StrawEnd::End end = static_cast<StrawEnd::End>(i_end);
 
     const auto& old_step_point = old_straw_digi_mc.strawGasStep(end);
-    const auto& newStepPtrIter = step_remap.find(old_step_point);
-    if (newStepPtrIter == step_remap.end()) {
-      if (old_step_point.isAvailable()) {
-	step_remap[old_step_point] = copyStrawGasStep( *old_step_point);
-      }
-      else { // this is a null Ptr but it should be added anyway to keep consistency (not expected for StrawDigis)
-	step_remap[old_step_point] = old_step_point;
+    int i_same = -1;
+    for (int j_end = 0; j_end < i_end; ++j_end) {
+      if (old_straw_digi_mc.strawGasStep(static_cast<StrawEnd::End>(j_end)) == old_step_point) {
+        i_same = j_end;
+        break;
       }
     }
-    art::Ptr<StrawGasStep> new_step_point = step_remap.at(old_step_point);
-    newTriggerStepPtr[i_end] = new_step_point;
+    if (i_same >= 0) {
+      newTriggerStepPtr[i_end] = newTriggerStepPtr[i_same];
+    }
+    else if (old_step_point.isAvailable()) {
+      newTriggerStepPtr[i_end] = copyStrawGasStep( *old_step_point);
+    }
+    else { // this is a null Ptr but it should be added anyway to keep consistency (not expected for StrawDigis)
+      newTriggerStepPtr[i_end] = old_step_point;
+    }
   }
   StrawDigiMC new_straw_digi_mc(old_straw_digi_mc, newTriggerStepPtr); // copy everything except the Ptrs from the old StrawDigiMC
   _newStrawDigiMCs->push_back(new_straw_digi_mc);
@@ -753,15 +740,16 @@ void mu2e::CompressDigiMCs::copyCrvDigiMC(const mu2e::CrvDigiMC& old_crv_digi_mc
 
   // Need to update the Ptrs for the StepPointMCs
   std::vector<art::Ptr<CrvStep> > newStepPtrs;
+  newStepPtrs.reserve(old_crv_digi_mc.GetCrvSteps().size());
   for (const auto& i_step_mc : old_crv_digi_mc.GetCrvSteps()) {
     if (i_step_mc.isAvailable()) {
-      if (_crvStepsSeen.insert(i_step_mc).second == true) { // if we have inserted this CrvStepPtrs (i.e. it hasn't already been seen)
+      if (_crvStepRemap.insert(i_step_mc)) { // if we have inserted this CrvStepPtrs (i.e. it hasn't already been seen)
         art::Ptr<CrvStep> newStepPtr = copyCrvStep(*i_step_mc);
         newStepPtrs.push_back(newStepPtr);
-        _crvStepsMap[i_step_mc] = newStepPtr;
+        _crvStepRemap.set(_crvStepRemap.size()-1, newStepPtr);
       }
       else {
-        newStepPtrs.push_back(_crvStepsMap.at(i_step_mc));
+        newStepPtrs.push_back(_crvStepRemap.at(i_step_mc));
       }
     }
     else { // this is a null Ptr but it should be added anyway to keep consistency (expected for CrvDigis)
@@ -804,6 +792,7 @@ void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_cal
 
   const auto& caloShowerStepPtrs = old_calo_shower_sim.caloShowerSteps();
   std::vector<art::Ptr<CaloShowerStep> > newCaloShowerStepPtrs;
+  newCaloShowerStepPtrs.reserve(caloShowerStepPtrs.size());
   for (const auto& i_caloShowerStepPtr : caloShowerStepPtrs) {
     newCaloShowerStepPtrs.push_back(remap.at(i_caloShowerStepPtr));
   }
@@ -895,13 +884,17 @@ art::Ptr<mu2e::CrvStep> mu2e::CompressDigiMCs::copyCrvStep(const mu2e::CrvStep&
 
 void mu2e::CompressDigiMCs::keepSimParticle(const art::Ptr<SimParticle>& sim_ptr) {
 
-  // Also need to add all the parents too
-  _simParticlesToKeep[sim_ptr.id()].insert(sim_ptr);
+  // Also need to add all the parents too, unless this one is already kept (and so its parents too)
+  if (!_simParticleRemap.insert(sim_ptr)) {
+    return;
+  }
   art::Ptr<SimParticle> childPtr = sim_ptr;
   art::Ptr<SimParticle> parentPtr = childPtr->parent();
 
   while (parentPtr.isNonnull()) {
-    _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
+    if (!_simParticleRemap.insert(parentPtr)) {
+      break;
+    }
     childPtr = parentPtr;
     parentPtr = parentPtr->parent();
   }
@@ -0,0 +1,85 @@
+//
+// Dense indices for (ProductID, key) pairs, see the header.
+//
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Compression/inc/DenseIndex.hh"
+
+namespace {
+
+  // the table is at most half full
+  const std::size_t minSlots = 64;
+
+  inline std::size_t hashOf(const art::ProductID& id, std::size_t key) {
+    uint64_t h = (uint64_t(id.value()) << 40) ^ uint64_t(key);
+    h *= 0x9E3779B97F4A7C15ull;
+    return std::size_t(h ^ (h >> 29));
+  }
+
+}
+
+namespace mu2e {
+
+  std::pair<unsigned,bool> DenseIndex::insert(const art::ProductID& id, std::size_t key) {
+    if (2*(_entries.size()+1) > _slots.size()) {
+      rehash(std::max(minSlots, 2*_slots.size()));
+    }
+    const std::size_t mask = _slots.size()-1;
+    for (std::size_t s = hashOf(id, key) & mask; ; s = (s+1) & mask) {
+      unsigned i = _slots[s];
+      if (i == npos) {
+        i = _entries.size();
+        _slots[s] = i;
+        _entries.push_back(Entry{id, key});
+        return std::make_pair(i, true);
+      }
+      if (_entries[i].key == key && _entries[i].id == id) {
+        return std::make_pair(i, false);
+      }
+    }
+  }
+
+  unsigned DenseIndex::find(const art::ProductID& id, std::size_t key) const {
+    if (_slots.empty()) {
+      return npos;
+    }
+    const std::size_t mask = _slots.size()-1;
+    for (std::size_t s = hashOf(id, key) & mask; ; s = (s+1) & mask) {
+      unsigned i = _slots[s];
+      if (i == npos || (_entries[i].key == key && _entries[i].id == id)) {
+        return i;
+      }
+    }
+  }
+
+  void DenseIndex::reserve(std::size_t n) {
+    _entries.reserve(n);
+    std::size_t nslots = minSlots;
+    while (nslots < 2*n) {
+      nslots *= 2;
+    }
+    if (nslots > _slots.size()) {
+      rehash(nslots);
+    }
+  }
+
+  void DenseIndex::clear() {
+    _entries.clear();
+    std::fill(_slots.begin(), _slots.end(), npos);
+  }
+
+  void DenseIndex::rehash(std::size_t nslots) {
+    _slots.assign(nslots, npos);
+    const std::size_t mask = nslots-1;
+    for (unsigned i = 0; i < _entries.size(); ++i) {
+      std::size_t s = hashOf(_entries[i].id, _entries[i].key) & mask;
+      while (_slots[s] != npos) {
+        s = (s+1) & mask;
+      }
+      _slots[s] = i;
+    }
+  }
+
+}
@@ -0,0 +1,330 @@
+//
+// Benchmark of the Ptr bookkeeping of the compression modules
+// (CompressDigiMCs, CompressDetStepMCs) on a synthetic mixed digi sample.
+//
+//   compressionBench [NEVENTS] [NFRAMES] [NPARTICLES]
+//
+// Each event has a primary SimParticleCollection and four mixed
+// collections, as made by the mixing of the background streams: each
+// has NFRAMES frames (default 20) of NPARTICLES particles (default 400),
+// with the keys of each frame offset by 100000.  The particles form
+// chains of up to 6 generations.  Straw digis refer to the steps of a
+// quarter of the particles, crv digis share crv steps, and virtual
+// detector steps refer to random particles.  For NEVENTS events
+// (default 10) the bookkeeping of CompressDigiMCs (keep the particles
+// and their parents, copy the shared crv steps once, keep the virtual
+// detector steps of kept particles, compress and rekey the
+// SimParticles, remap every Ptr) is done
+//   - with the previous containers: std::set and std::map keyed on art::Ptr
+//   - with PtrRemap and FlatKeyRemap
+// and both must give the same SimParticles and Ptrs.  The exit code is
+// 1 if anything differs.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "MCDataProducts/inc/SimParticleCollection.hh"
+#include "Mu2eUtilities/inc/compressSimParticleCollection.hh"
+#include "Compression/inc/PtrRemap.hh"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+  typedef art::Ptr<mu2e::SimParticle> SimPtr;
+
+  const unsigned frameOffset = 100000;
+  const unsigned nCollections = 5;
+
+  struct Event {
+    std::vector<art::ProductID> ids;
+    std::vector<mu2e::SimParticleCollection> sims;
+    std::vector<SimPtr> strawSteps;                     // two per digi
+    std::vector<std::vector<unsigned> > crvDigis;       // indices of crv steps
+    std::vector<SimPtr> crvSteps;
+    std::vector<SimPtr> vdSteps;
+  };
+
+  // what the module writes, to compare the two schemes
+  struct Output {
+    mu2e::SimParticleCollection sims;
+    std::vector<SimPtr> remapped;
+    std::vector<unsigned> crvCopies;                    // the crv steps copied
+    std::vector<unsigned> crvRefs;                      // the copies the crv digis refer to
+    size_t nVdSteps = 0;
+  };
+
+  const art::ProductID newID(100);
+
+  Event makeEvent(std::mt19937& gen, unsigned nFrames, unsigned nParticles) {
+    Event ev;
+    std::uniform_real_distribution<double> flat(0.,1.);
+    std::vector<SimPtr> all;
+    for (unsigned i_coll = 0; i_coll < nCollections; ++i_coll) {
+      art::ProductID id(i_coll+1);
+      ev.ids.push_back(id);
+      ev.sims.emplace_back();
+      mu2e::SimParticleCollection& coll = ev.sims.back();
+      unsigned frames = (i_coll == 0 ? 1 : nFrames);
+      for (unsigned i_frame = 0; i_frame < frames; ++i_frame) {
+        unsigned first = 1 + i_frame*frameOffset;
+        for (unsigned i = 0; i < nParticles; ++i) {
+          cet::map_vector_key key(first+i);
+          mu2e::SimParticle& sim = coll[key];
+          sim.id() = key;
+          // a new chain every few particles, otherwise the daughter of one of the last few
+          if (i%6 != 0) {
+            unsigned parent = first + i - 1 - unsigned(flat(gen)*std::min(i%6, 3u));
+            sim.parent() = SimPtr(id, parent, nullptr);
+            coll[cet::map_vector_key(parent)].addDaughter(SimPtr(id, key.asUint(), nullptr));
+          }
+          all.push_back(SimPtr(id, key.asUint(), nullptr));
+        }
+      }
+    }
+    for (const auto& p : all) {
+      double r = flat(gen);
+      if (r < 0.25) {
+        ev.strawSteps.push_back(p);
+        ev.strawSteps.push_back(p);
+      }
+      else if (r < 0.30) {
+        ev.crvSteps.push_back(p);
+      }
+      if (flat(gen) < 0.05) {
+        ev.vdSteps.push_back(all[size_t(flat(gen)*all.size())]);
+      }
+    }
+    for (unsigned i = 0; !ev.crvSteps.empty() && i < ev.crvSteps.size()/2; ++i) {
+      std::vector<unsigned> digi;
+      for (unsigned j = 0; j < 4; ++j) {
+        digi.push_back(unsigned(flat(gen)*ev.crvSteps.size()));
+      }
+      ev.crvDigis.push_back(digi);
+    }
+    return ev;
+  }
+
+  const mu2e::SimParticle& particle(const Event& ev, const SimPtr& p) {
+    return *ev.sims.at(p.id().value()-1).getOrNull(cet::map_vector_key(p.key()));
+  }
+
+  // The previous scheme
+  class SimParticleSelector {
+  public:
+    SimParticleSelector(const std::set<SimPtr>& simPartSet) {
+      for (const auto& i_simPart : simPartSet) {
+        m_keys.insert(cet::map_vector_key(i_simPart.key()));
+      }
+    }
+    bool operator[](cet::map_vector_key key) const {
+      return m_keys.find(key) != m_keys.end();
+    }
+  private:
+    std::set<cet::map_vector_key> m_keys;
+  };
+
+  void compressOld(const Event& ev, Output& out) {
+    std::map<art::ProductID, std::set<SimPtr> > toKeep;
+    auto keep = [&](const SimPtr& sim_ptr) {
+      toKeep[sim_ptr.id()].insert(sim_ptr);
+      SimPtr parentPtr = particle(ev, sim_ptr).parent();
+      while (parentPtr.isNonnull()) {
+        toKeep[sim_ptr.id()].insert(parentPtr);
+        parentPtr = particle(ev, parentPtr).parent();
+      }
+    };
+    for (const auto& id : ev.ids) {
+      toKeep[id].clear();
+    }
+    for (const auto& p : ev.strawSteps) {
+      keep(p);
+    }
+
+    std::set<unsigned> crvSeen;
+    std::map<unsigned, unsigned> crvMap;
+    for (const auto& digi : ev.crvDigis) {
+      for (auto i_step : digi) {
+        if (crvSeen.insert(i_step).second) {
+          keep(ev.crvSteps[i_step]);
+          crvMap[i_step] = out.crvCopies.size();
+          out.crvRefs.push_back(out.crvCopies.size());
+          out.crvCopies.push_back(i_step);
+        }
+        else {
+          out.crvRefs.push_back(crvMap.at(i_step));
+        }
+      }
+    }
+
+    std::vector<SimPtr> vdKept;
+    for (const auto& p : ev.vdSteps) {
+      for (const auto& simPartsToKeep : toKeep) {
+        if (p.id() != simPartsToKeep.first) {
+          continue;
+        }
+        for (const auto& alreadyKept : simPartsToKeep.second) {
+          if (p == alreadyKept) {
+            vdKept.push_back(p);
+            keep(p);
+          }
+        }
+      }
+    }
+    out.nVdSteps = vdKept.size();
+
+    mu2e::KeyRemap keyRemap;
+    std::map<SimPtr, SimPtr> remap;
+    for (unsigned i_coll = 0; i_coll < ev.ids.size(); ++i_coll) {
+      keyRemap.clear();
+      const auto& kept = toKeep[ev.ids[i_coll]];
+      SimParticleSelector selector(kept);
+      mu2e::compressSimParticleCollection(newID, nullptr, ev.sims[i_coll], selector, out.sims, &keyRemap);
+      for (const auto& p : kept) {
+        remap[p] = SimPtr(newID, keyRemap.at(cet::map_vector_key(p.key())).asUint(), nullptr);
+      }
+    }
+
+    for (const auto& p : ev.strawSteps) out.remapped.push_back(remap.at(p));
+    for (const auto& p : ev.crvSteps) {
+      auto it = remap.find(p);
+      if (it != remap.end()) out.remapped.push_back(it->second);
+    }
+    for (const auto& p : vdKept) out.remapped.push_back(remap.at(p));
+  }
+
+  // PtrRemap and FlatKeyRemap; they are kept from event to event as in the modules
+  mu2e::PtrRemap<mu2e::SimParticle> simRemap;
+  mu2e::PtrRemap<mu2e::SimParticle> crvRemap; // stands for PtrRemap<CrvStep>
+  mu2e::FlatKeyRemap flatKeyRemap;
+
+  void compressNew(const Event& ev, Output& out) {
+    simRemap.clear();
+    auto keep = [&](const SimPtr& sim_ptr) {
+      if (!simRemap.insert(sim_ptr)) {
+        return;
+      }
+      SimPtr parentPtr = particle(ev, sim_ptr).parent();
+      while (parentPtr.isNonnull()) {
+        if (!simRemap.insert(parentPtr)) {
+          break;
+        }
+        parentPtr = particle(ev, parentPtr).parent();
+      }
+    };
+    for (const auto& p : ev.strawSteps) {
+      keep(p);
+    }
+
+    crvRemap.clear();
+    for (const auto& digi : ev.crvDigis) {
+      for (auto i_step : digi) {
+        SimPtr stepPtr(art::ProductID(50), i_step, nullptr);
+        if (crvRemap.insert(stepPtr)) {
+          keep(ev.crvSteps[i_step]);
+          crvRemap.set(crvRemap.size()-1, SimPtr(newID, out.crvCopies.size(), nullptr));
+          out.crvRefs.push_back(out.crvCopies.size());
+          out.crvCopies.push_back(i_step);
+        }
+        else {
+          out.crvRefs.push_back(crvRemap.at(stepPtr).key());
+        }
+      }
+    }
+
+    std::vector<SimPtr> vdKept;
+    for (const auto& p : ev.vdSteps) {
+      if (simRemap.contains(p)) {
+        vdKept.push_back(p);
+        keep(p);
+      }
+    }
+    out.nVdSteps = vdKept.size();
+
+    out.sims.reserve(simRemap.size());
+    for (unsigned i_coll = 0; i_coll < ev.ids.size(); ++i_coll) {
+      flatKeyRemap.clear();
+      const art::ProductID& id = ev.ids[i_coll];
+      mu2e::compressSimParticleCollection(newID, nullptr, ev.sims[i_coll], simRemap.selector(id), out.sims, &flatKeyRemap);
+      for (size_t i = 0; i < simRemap.size(); ++i) {
+        if (simRemap.oldPtr(i).id() == id) {
+          simRemap.set(i, SimPtr(newID, flatKeyRemap.at(cet::map_vector_key(simRemap.oldPtr(i).key())).asUint(), nullptr));
+        }
+      }
+    }
+
+    for (const auto& p : ev.strawSteps) out.remapped.push_back(simRemap.at(p));
+    for (const auto& p : ev.crvSteps) {
+      const SimPtr* newPtr = simRemap.find(p);
+      if (newPtr) out.remapped.push_back(*newPtr);
+    }
+    for (const auto& p : vdKept) out.remapped.push_back(simRemap.at(p));
+  }
+
+  bool same(const Output& a, const Output& b) {
+    if (a.remapped != b.remapped || a.crvCopies != b.crvCopies || a.crvRefs != b.crvRefs || a.nVdSteps != b.nVdSteps
+        || a.sims.size() != b.sims.size()) {
+      return false;
+    }
+    auto ib = b.sims.begin();
+    for (const auto& i_a : a.sims) {
+      const auto& i_b = *ib;
+      ++ib;
+      if (i_a.first != i_b.first || i_a.second.id() != i_b.second.id()
+          || i_a.second.parent() != i_b.second.parent()
+          || i_a.second.daughters() != i_b.second.daughters()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  int nEvents = (argc>1 ? atoi(argv[1]) : 10);
+  int nFrames = (argc>2 ? atoi(argv[2]) : 20);
+  int nParticles = (argc>3 ? atoi(argv[3]) : 400);
+  if (nFrames < 1) nFrames = 1;
+
+  bool passed = true;
+  try {
+    std::mt19937 gen(4321);
+    double tOld = 0, tNew = 0;
+    size_t nKept = 0, nInput = 0;
+    for (int i_event = 0; i_event < nEvents; ++i_event) {
+      Event ev = makeEvent(gen, nFrames, nParticles);
+      for (const auto& coll : ev.sims) nInput += coll.size();
+
+      Output outOld, outNew;
+      Clock::time_point t0 = Clock::now();
+      compressOld(ev, outOld);
+      Clock::time_point t1 = Clock::now();
+      compressNew(ev, outNew);
+      Clock::time_point t2 = Clock::now();
+      tOld += std::chrono::duration<double>(t1-t0).count();
+      tNew += std::chrono::duration<double>(t2-t1).count();
+
+      nKept += outNew.sims.size();
+      passed = passed && same(outOld, outNew);
+    }
+
+    std::printf("[compressionBench] %d events, %zu SimParticles per event, %zu kept\n",
+                nEvents, nInput/std::max(nEvents,1), nKept/std::max(nEvents,1));
+    std::printf("[compressionBench] std::set/std::map      : %9.3f ms/event\n", 1e3*tOld/std::max(nEvents,1));
+    std::printf("[compressionBench] PtrRemap/FlatKeyRemap  : %9.3f ms/event\n", 1e3*tNew/std::max(nEvents,1));
+    std::printf("[compressionBench] same output: %s\n", passed ? "ok" : "FAILED");
+  } catch (std::exception const& e) {
+    std::cout << "compressionBench: " << e.what() << std::endl;
+    passed = false;
+  }
+
+  return passed ? 0 : 1;
+}
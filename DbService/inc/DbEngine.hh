@@ -1,7 +1,8 @@
 #ifndef DbService_DbEngine_hh
 #define DbService_DbEngine_hh
 
-#include <shared_mutex>
+#include <mutex>
+#include <atomic>
 #include <chrono>
 
 #include "DbService/inc/DbReader.hh"
@@ -12,13 +13,14 @@
 #include "DbTables/inc/DbCache.hh"
 #include "DbTables/inc/DbValCache.hh"
 #include "DbTables/inc/DbLiveTable.hh"
+#include "DbTables/inc/DbIoVIndex.hh"
 
 
 namespace mu2e {
   class DbEngine {
   public:
 
-    DbEngine():_verbose(0),_saveCsv(true),_initialized(false),
+    DbEngine():_verbose(0),_saveCsv(true),_initialized(false),_ready(false),
 	       _lockWaitTime(0),_lockTime(0) {}
     // the big read of the IOV structure is done in beginJob
     int beginJob();
@@ -30,6 +32,9 @@ namespace mu2e {
     void setCache(std::shared_ptr<DbValCache> vcache) { _vcache = vcache; }
     // add tables directly - optionally set before beginJob
     void addOverride(DbTableCollection const& coll);
+    // read the db content from a snapshot file written by 
+    // dbTool write-snapshot - optionally set before beginJob
+    void setSnapshot(std::string const& fileName) { _snapshotFile = fileName; }
     void setVerbose(int verbose = 0) { _verbose = verbose; }
     // whether to save the csv text content when loading a table
     void setSaveCsv(bool saveCsv) { _saveCsv = saveCsv; }
@@ -37,11 +42,18 @@ namespace mu2e {
     std::shared_ptr<DbValCache>& valCache() {return _vcache;}
     std::vector<int> gids() { return _gids; }
     DbReader& reader() { return _reader; }
+    // all cids in the IoV structure of this version, after beginJob
+    std::vector<int> cids() const;
     // these are the only methods that can be called from threads, 
-    // such as DbHandle, after the single-threaded configuration
+    // such as DbHandle, after the single-threaded configuration.
+    // The lookup structures do not change after beginJob, so these
+    // only take a lock to read a table which is not yet in the cache
     DbLiveTable update(int tid, uint32_t run, uint32_t subrun);
     int tidByName(std::string const& name);
     std::string nameByTid(int tid);
+    // time spent waiting for and holding the lock, in s
+    double lockWaitTime() const { return _lockWaitTime.count()*1.0e-6; }
+    double lockTime() const { return _lockTime.count()*1.0e-6; }
 
   private:
 
@@ -56,10 +68,34 @@ namespace mu2e {
       int _cid;
     };
 
+    // the IOVs of one table type, in the order they are searched,
+    // with their index, and for each Row, its slot in _slots
+    struct TidLookup {
+      std::vector<Row> rows;
+      DbIoVIndex index;
+      std::vector<std::size_t> slots;
+    };
+
+    // the override tables of one table type, positions in _override
+    struct OverrideLookup {
+      std::vector<std::size_t> overrides;
+      DbIoVIndex index;
+    };
+
+    // a table in the cache, for each cid in the lookup.  The table is
+    // written once, under the lock, and then published by filled
+    struct Slot {
+      std::atomic<bool> filled{false};
+      DbTable::cptr_t ptr;
+    };
+
     // call beginRun on first use, if needed
     void lazyBeginJob();
-    // find a table cid in the fast lookup structure
-    Row findTable(int tid, uint32_t run, uint32_t subrun);
+    // build the lookup structures after _lookup rows and _override tids are set
+    void buildIndex();
+    // find a table cid in the fast lookup structure, -1 if not found
+    int findTable(int tid, uint32_t run, uint32_t subrun, 
+		  Row& row, Slot*& slot);
 
 
     DbId _id;
@@ -71,14 +107,19 @@ namespace mu2e {
     DbCache _cache;
     std::shared_ptr<DbValCache> _vcache;
     bool _initialized;
-    // a join of relevant tables, int is tid, Row is above
-    std::map<int,std::vector<Row>> _lookup;
+    // set when beginJob is done, after which the lookup is not changed
+    std::atomic<bool> _ready;
+    // a join of relevant tables, int is tid
+    std::map<int,TidLookup> _lookup;
+    std::map<int,OverrideLookup> _overrideLookup;
+    std::vector<Slot> _slots;
     DbTableCollection _last;
     std::vector<int> _gids;
     std::map<std::string,int> _overrideTids;
+    std::string _snapshotFile;
 
-    // lock for threaded access
-    mutable std::shared_mutex _mutex;
+    // lock for reading tables and for the lazy beginJob
+    std::mutex _mutex;
     // count the time locked
     std::chrono::microseconds _lockWaitTime;
     std::chrono::microseconds _lockTime;
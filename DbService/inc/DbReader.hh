@@ -11,11 +11,17 @@
 // this code will retry up to the timeout, then abort
 // if you want to handle the failure, set setAbortOnFail(false)
 //
+// If a snapshot is set, queries are answered from the snapshot
+// where possible.  If the url of the DbId starts with "file:", the
+// queries are answered from csv files in that directory, see queryFile.
+//
 #include <string>
 #include <chrono>
+#include <memory>
 #include <curl/curl.h>
 #include "DbTables/inc/DbId.hh"
 #include "DbTables/inc/DbValCache.hh"
+#include "DbService/inc/DbSnapshot.hh"
 
 
 namespace mu2e {
@@ -46,6 +52,8 @@ namespace mu2e {
     int multiQuery(std::vector<QueryForm>& qfv);
 
     int fillTableByCid(DbTable::ptr_t ptr, int cid);
+    // the where clause of fillTableByCid
+    static std::string whereCid(int cid) { return "cid:eq:"+std::to_string(cid); }
     int fillValTables(DbValCache& vcache);
 
     std::string& lastError() { return _lastError; }
@@ -65,6 +73,9 @@ namespace mu2e {
     void setVerbose(int verbose) { _verbose = verbose; }
     void setTimeVerbose(int timeVerbose) { _timeVerbose = timeVerbose; }
     void setSaveCsv(bool saveCsv) { _saveCsv = saveCsv; }
+    // answer queries from this snapshot where possible
+    void setSnapshot(std::shared_ptr<const DbSnapshot> snapshot) {
+      _snapshot = snapshot; }
 
   private:
 
@@ -79,6 +90,14 @@ namespace mu2e {
     int queryCore(std::string& csv, const std::string& select, 
 	      const std::string& table, const std::string& where="",
 	      const std::string& order="");
+    // the stand-in server for url's of the form file:DIR/
+    bool isFileUrl() const { return _id.url().compare(0,5,"file:")==0; }
+    int queryFile(std::string& csv, const std::string& select, 
+	      const std::string& table, const std::string& where="",
+	      const std::string& order="");
+    bool querySnapshot(std::string& csv, const std::string& select, 
+	      const std::string& table, const std::string& where="",
+	      const std::string& order="");
 
     DbId _id;
     CURL *_curl_handle;
@@ -95,6 +114,7 @@ namespace mu2e {
     int _verbose;
     int _timeVerbose;
     bool _saveCsv;
+    std::shared_ptr<const DbSnapshot> _snapshot;
   };
 }
 #endif
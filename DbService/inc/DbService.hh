@@ -39,6 +39,8 @@ namespace mu2e {
 	  Comment("read the DB immedatiately, not on first use")};
       fhicl::OptionalAtom<int> cacheLifetime{Name("cacheLifetime"), 
 	  Comment("if >0, read IoV from cache, but renew each lifetime s")};
+      fhicl::OptionalAtom<std::string> snapshot{Name("snapshot"), 
+	  Comment("file from dbTool write-snapshot, read instead of the DB")};
     };
 
     // this line is required by art to allow the command line help print
@@ -0,0 +1,96 @@
+#ifndef DbService_DbSnapshot_hh
+#define DbService_DbSnapshot_hh
+
+//
+// A binary snapshot of the answers of the conditions database to the
+// queries of a job: the val tables and the calibration tables of one
+// purpose/version.  It is written once by "dbTool write-snapshot" and
+// memory-mapped by DbEngine::beginJob, so that all jobs on a node share
+// the pages and none of them contacts the database at startup.
+//
+// The file is content-addressed: each distinct answer is stored once,
+// under the hash of its content, and the queries point to these answers.
+// The hash of the whole content identifies the snapshot.  An answer is
+// csv text or, for calibration tables, the columnar binary form of the
+// table (see DbColumns), aligned so it can be used in place.
+// The file is written to a temporary name and renamed, so a job never
+// maps a partially written snapshot.
+//
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace mu2e {
+
+  class DbSnapshot {
+  public:
+
+    DbSnapshot():_data(nullptr),_size(0),_nEntries(0),_contentHash(0) {}
+    ~DbSnapshot();
+    DbSnapshot(DbSnapshot const&) = delete;
+    DbSnapshot& operator=(DbSnapshot const&) = delete;
+
+    // the query text which identifies an answer
+    static std::string key(std::string const& table,
+			   std::string const& select,
+			   std::string const& where="",
+			   std::string const& order="");
+    // 64-bit FNV-1a hash
+    static uint64_t hash(const char* data, size_t size,
+			 uint64_t h=14695981039346656037ULL);
+
+    // for writing: the database and purpose/version the snapshot was made for
+    void setSource(std::string const& dbName, std::string const& version) {
+      _dbName = dbName; _version = version; }
+    void add(std::string const& key, std::string const& csv);
+    // returns the content hash
+    uint64_t write(std::string const& filename);
+
+    // for reading: map a snapshot file, throws if it is not valid.
+    // verify recomputes the content hash, which reads the whole file
+    void map(std::string const& filename, bool verify=true);
+    bool isMapped() const { return _data!=nullptr; }
+    // find the answer for a query key, returns false if it is not in the snapshot
+    bool find(std::string const& key, std::string& csv) const;
+    // the same, pointing into the mapped file instead of copying
+    bool find(std::string const& key, const char*& data, size_t& size) const;
+
+    std::string const& dbName() const { return _dbName; }
+    std::string const& version() const { return _version; }
+    std::string const& fileName() const { return _fileName; }
+    uint64_t contentHash() const { return _contentHash; }
+    size_t nEntries() const { return isMapped() ? _nEntries : _added.size(); }
+    size_t size() const { return _size; }
+
+  private:
+
+    // layout of the index in the file
+    struct Entry {
+      uint64_t keyHash;
+      uint64_t keyOffset;
+      uint64_t keyLength;
+      uint64_t csvOffset;
+      uint64_t csvLength;
+    };
+
+    // the mapped file
+    const char* _data;
+    size_t _size;
+    uint64_t _nEntries;
+    const Entry* _entries;
+    const char* _strings;
+    uint64_t _stringsSize;
+
+    // entries added for writing
+    std::map<std::string,std::string> _added;
+
+    std::string _fileName;
+    std::string _dbName;
+    std::string _version;
+    uint64_t _contentHash;
+  };
+
+}
+#endif
@@ -12,6 +12,9 @@
 //   tool.init();
 //   tool.commitCalibrationSql(coll);
 //
+// "dbTool write-snapshot" writes the DbSnapshot file, which 
+// DbService can read instead of the database (see DbSnapshot.hh)
+//
 
 #include <map>
 #include "DbService/inc/DbReader.hh"
@@ -68,6 +71,8 @@ namespace mu2e {
     int commitPurpose();
     int commitVersion();
 
+    int writeSnapshot();
+
     int findPidVid(std::string purpose, std::string version, int& pid, int& vid);
     int testUrl();
 
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <chrono>
+#include <algorithm>
 #include "cetlib_except/exception.h"
 #include "DbService/inc/DbEngine.hh"
 #include "DbTables/inc/DbTableFactory.hh"
@@ -52,12 +53,35 @@ int mu2e::DbEngine::beginJob() {
       lt.setCid(fakeCid); // assign fake cid to label this data
       fakeCid++;
     }
+    _lookup.clear();
+    buildIndex();
+    _ready.store(true,std::memory_order_release);
     
     if(_verbose>1) cout << "DbEngine::beginJob exit early, purpose=EMPTY" 
 			<< endl;
     return 0;
   }
 
+  // the val tables and the calibration tables are read from the 
+  // snapshot, if it was provided, instead of from the database
+  if(!_snapshotFile.empty()) {
+    auto snapshot = std::make_shared<DbSnapshot>();
+    snapshot->map(_snapshotFile);
+    if(snapshot->dbName()!=_id.name() || 
+       snapshot->version()!=_version.to_string()) {
+      throw cet::exception("DBENGINE_BAD_SNAPSHOT") 
+	<< " DbEngine::beginJob snapshot " << _snapshotFile 
+	<< " was made for " << snapshot->dbName() << " " << snapshot->version()
+	<< ", not for " << _id.name() << " " << _version.to_string() << "\n";
+    }
+    if(_verbose>0) {
+      std::cout << "DbEngine mapped snapshot " << _snapshotFile 
+		<< " with " << snapshot->nEntries() << " queries, hash "
+		<< std::hex << snapshot->contentHash() << std::dec << std::endl;
+    }
+    _reader.setSnapshot(snapshot);
+  }
+
   if(!_vcache) { // if not already provided, create and fil it
     _vcache = std::make_shared<DbValCache>();
     _reader.fillValTables(*_vcache);
@@ -188,7 +212,7 @@ int mu2e::DbEngine::beginJob() {
   auto const& tls = vcache.valTableLists();
   for(auto const& r : tls.rows()) {
     if(r.lid()==lid) {
-      _lookup[r.tid()] = std::vector<Row>();
+      _lookup[r.tid()] = TidLookup();
     }
   }
 
@@ -207,7 +231,7 @@ int mu2e::DbEngine::beginJob() {
       if(r.gid()==g) {
 	auto const& irow = iids.row(r.iid());
 	auto const& crow = cids.row(irow.cid());
-	_lookup[crow.tid()].emplace_back(irow.iov(),irow.cid());
+	_lookup[crow.tid()].rows.emplace_back(irow.iov(),irow.cid());
 	niov++;
       }
     }
@@ -243,12 +267,15 @@ int mu2e::DbEngine::beginJob() {
     fakeCid++;
   }
 
+  // the interval indexes and the cache slots
+  buildIndex();
+
   if( _verbose>9 ) {
     std::cout << "DbEngine::beginRun results of lookup" << std::endl;
     std::cout << "  tid       valid range        cid" << std::endl;
     for(auto const& p : _lookup) {
       int tid = p.first;
-      for(auto r : p.second) {
+      for(auto r : p.second.rows) {
 	std::cout << std::setw(5) << tid
 		  << std::setw(20) << r.iov()
 		  << std::setw(6)  << std::right << r.cid() << std::endl;
@@ -280,6 +307,9 @@ int mu2e::DbEngine::beginJob() {
 	     << beginJobTime.count()*1.0e-6<<" s" << std::endl;
   }
 
+  // from here on, the lookup structures are only read
+  _ready.store(true,std::memory_order_release);
+
   if(_verbose>5) cout << "DbEngine::beginJob end" << endl;
 
   return 0;
@@ -296,33 +326,26 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
 
   // first look for table in override table list
   // this data never changes, so no need to lock
-
-  // loop over override tables
-  for(size_t iover=0; iover<_override.size(); iover++) {
-    auto& oltab = _override[iover];
-    if(oltab.tid()==tid) { // if override table is the right type
-      if(oltab.iov().inInterval(run,subrun)) { // and in valid interval
-	auto dblt = oltab;
-	if(_verbose>9) cout << "DbEngine::update table found " 
-			    << dblt.table().name() << " in overrides " << endl;
-	return dblt;
-      }
+  auto oiter = _overrideLookup.find(tid);
+  if(oiter!=_overrideLookup.end()) {
+    int io = oiter->second.index.find(run,subrun);
+    if(io>=0) { // an override of the right type, in valid interval
+      auto dblt = _override[oiter->second.overrides[io]];
+      if(_verbose>9) cout << "DbEngine::update table found " 
+			  << dblt.table().name() << " in overrides " << endl;
+      return dblt;
     }
   }
 
   // this will hold the table in the end
   DbTable::cptr_t ptr;
-  int cid = -1;
-  DbIoV iov;
-
-  // try to read the table
-  {
-    std::shared_lock lock(_mutex); // shared read lock
-    auto row = findTable(tid, run, subrun);
-    cid = row.cid();
-    iov = row.iov();
-    if(_cache.hasTable(row.cid())) ptr = _cache.get(row.cid());
-  } // read lock goes out of scope
+  Row row(DbIoV(),-1);
+  Slot* slot = nullptr;
+
+  // try to find the table, no lock is needed
+  int cid = findTable(tid, run, subrun, row, slot);
+  DbIoV iov = row.iov();
+  if(cid>=0 && slot->filled.load(std::memory_order_acquire)) ptr = slot->ptr;
 
   // if no cid now, then table can't be found - have to stop
   if(cid<0) {
@@ -342,7 +365,9 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
     
     // have to check if some other thread loaded it 
     // since the above read attempt
-    if(_cache.hasTable(cid)) {
+    if(slot->filled.load(std::memory_order_acquire)) {
+      ptr = slot->ptr;
+    } else if(_cache.hasTable(cid)) {
       ptr = _cache.get(cid);
     } else {
       auto const& tabledef = _vcache->valTables().row(tid);
@@ -366,6 +391,11 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
       // push to cache
       _cache.add(cid,ptr);
     }
+    // publish to the readers
+    if(!slot->filled.load(std::memory_order_relaxed)) {
+      slot->ptr = ptr;
+      slot->filled.store(true,std::memory_order_release);
+    }
 
     auto etime = std::chrono::high_resolution_clock::now();
     dt = std::chrono::duration_cast<std::chrono::microseconds>
@@ -378,9 +408,9 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
   // this code handles the case where an override takes effect
   // in the middle of a database IOV - remove the override
   // table interval from the database table's interval
-  for(auto& oltab : _override) { // loop over override tables
-    if(oltab.tid()==tid) { // if override is the right type
-      iov.subtract(oltab.iov());
+  if(oiter!=_overrideLookup.end()) {
+    for(auto iover : oiter->second.overrides) {
+      iov.subtract(_override[iover].iov());
     }
   }
   
@@ -390,29 +420,63 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
 
 }
 
+std::vector<int> mu2e::DbEngine::cids() const {
+  std::vector<int> cids;
+  for(auto const& p : _lookup) {
+    for(auto const& r : p.second.rows) cids.push_back(r.cid());
+  }
+  std::sort(cids.begin(),cids.end());
+  cids.erase(std::unique(cids.begin(),cids.end()),cids.end());
+  return cids;
+}
+
 // find a table by cid in the fast lookup structure
-// can only be called inside a read lock
-mu2e::DbEngine::Row mu2e::DbEngine::findTable(
-			    int tid, uint32_t run, uint32_t subrun) {
+// only called after beginJob, when the structure does not change
+int mu2e::DbEngine::findTable(int tid, uint32_t run, uint32_t subrun,
+			      Row& row, Slot*& slot) {
   auto iter = _lookup.find(tid);
-  if(iter!=_lookup.end()) { // if the IOV structure includes this tid
-    for(auto const& r : iter->second) { // find which iov is appropriate
-      if(r.iov().inInterval(run,subrun)) {
-	return r; // return iov and cid in a Row
-      }
-    } // loop over Rows for table type
-  }  
-  return DbEngine::Row(DbIoV(),-1); // not found
+  if(iter==_lookup.end()) return -1; // the IOV structure lacks this tid
+  int irow = iter->second.index.find(run,subrun);
+  if(irow<0) return -1; // not found
+  row = iter->second.rows[irow];
+  slot = &_slots[iter->second.slots[irow]];
+  return row.cid();
 }
 
+// index the IOVs of each tid and of the override tables,
+// and make one cache slot for each cid
+void mu2e::DbEngine::buildIndex() {
+  std::map<int,std::size_t> cidSlots;
+  std::vector<DbIoV> iovs;
+  for(auto& p : _lookup) {
+    iovs.clear();
+    p.second.slots.clear();
+    for(auto const& r : p.second.rows) {
+      iovs.push_back(r.iov());
+      auto iter = cidSlots.emplace(r.cid(),cidSlots.size()).first;
+      p.second.slots.push_back(iter->second);
+    }
+    p.second.index.build(iovs);
+  }
+  _slots = std::vector<Slot>(cidSlots.size());
+
+  // the override tables, searched in the order they were added
+  _overrideLookup.clear();
+  for(std::size_t i=0; i<_override.size(); i++) {
+    _overrideLookup[_override[i].tid()].overrides.push_back(i);
+  }
+  for(auto& p : _overrideLookup) {
+    iovs.clear();
+    for(auto i : p.second.overrides) iovs.push_back(_override[i].iov());
+    p.second.index.build(iovs);
+  }
+}
 
 
 int mu2e::DbEngine::tidByName(std::string const& name) {
 
   lazyBeginJob(); // initialize if needed
 
-  std::shared_lock lock(_mutex); // shared read lock
-
   // tables known to the db
   if(_vcache) {
     for(auto const& r: _vcache->valTables().rows()) {
@@ -430,9 +494,6 @@ std::string mu2e::DbEngine::nameByTid(int tid) {
 
   lazyBeginJob(); // initialize if needed
 
-  std::shared_lock lock(_mutex); // shared read lock
-
-
   for(auto const& r: _vcache->valTables().rows()) {
     if(r.tid()==tid) return r.name();
   }
@@ -452,11 +513,8 @@ void mu2e::DbEngine::addOverride(DbTableCollection const& coll) {
 
 void mu2e::DbEngine::lazyBeginJob() {
 
-  {
-    // check if initialized
-    std::shared_lock lock(_mutex); // shared read lock
-    if(_initialized) return;
-  }
+  // check if initialized
+  if(_ready.load(std::memory_order_acquire)) return;
 
   // need to call beginRun, read lock out of scope, destroyed
   auto stime = std::chrono::high_resolution_clock::now();
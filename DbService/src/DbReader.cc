@@ -1,6 +1,10 @@
 #include <unistd.h>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <boost/algorithm/string.hpp>
 #include "cetlib_except/exception.h"
 #include "DbService/inc/DbReader.hh"
 #include "DbService/inc/DbCurl.hh"
@@ -31,6 +35,9 @@ int mu2e::DbReader::query(std::string& csv,
 
   int rc;
 
+  if(querySnapshot(csv,select,table,where,order)) return 0;
+  if(isFileUrl()) return queryFile(csv,select,table,where,order);
+
   // reserve resources, alloc memory
   rc = openHandle();
   if (rc!=0) return rc;
@@ -52,13 +59,31 @@ int mu2e::DbReader::query(QueryForm& qf) {
 
 int mu2e::DbReader::multiQuery(std::vector<QueryForm>& qfv) {
 
-  int rc = openHandle();
+  // the queries which are not answered by the snapshot
+  std::vector<QueryForm*> remaining;
+  for(auto& qf : qfv) {
+    if(!querySnapshot(qf.csv,qf.select,qf.table,qf.where,qf.order)) {
+      remaining.push_back(&qf);
+    }
+  }
+  if(remaining.empty()) return 0;
+
+  int rc = 0;
+  if(isFileUrl()) {
+    for(auto qf : remaining) {
+      rc = queryFile(qf->csv,qf->select,qf->table,qf->where,qf->order);
+      if(rc!=0) return rc;
+    }
+    return 0;
+  }
+
+  rc = openHandle();
   if (rc!=0) return rc;
 
-  auto iter = qfv.begin();
-  while(rc==0 && iter!=qfv.end()) {
-    rc = queryCore(iter->csv,iter->select,iter->table,
-		   iter->where,iter->order);
+  auto iter = remaining.begin();
+  while(rc==0 && iter!=remaining.end()) {
+    rc = queryCore((*iter)->csv,(*iter)->select,(*iter)->table,
+		   (*iter)->where,(*iter)->order);
     iter++;
   }
 
@@ -72,7 +97,16 @@ int mu2e::DbReader::multiQuery(std::vector<QueryForm>& qfv) {
 
 int mu2e::DbReader::fillTableByCid(DbTable::ptr_t ptr, int cid) {
   std::string csv;
-  std::string where="cid:eq:"+std::to_string(cid);
+  std::string where=whereCid(cid);
+  // the columnar form in the snapshot is used in place, without parsing
+  const char* data;
+  size_t size;
+  if(_snapshot && 
+     _snapshot->find(DbSnapshot::key(ptr->dbname(),ptr->query(),where),data,size)
+     && DbColumns::isColumnar(data,size)) {
+    ptr->fill(DbColumns(data,size),_saveCsv);
+    return 0;
+  }
   int rc = query(csv,ptr->query(),ptr->dbname(),where);
   if(rc!=0) return rc;
   ptr->fill(csv,_saveCsv);
@@ -368,6 +402,138 @@ int mu2e::DbReader::queryCore(std::string& csv,
   return 0;
 }
 
+bool mu2e::DbReader::querySnapshot(std::string& csv, 
+				   const std::string& select, 
+				   const std::string& table, 
+				   const std::string& where,
+				   const std::string& order) {
+  if(!_snapshot) return false;
+  bool found = _snapshot->find(DbSnapshot::key(table,select,where,order),csv);
+  // a table stored in columnar form is returned as csv
+  if(found && DbColumns::isColumnar(csv)) csv = DbColumns(csv).toCsv();
+  if(_verbose>3) {
+    std::cout << "DbReader " << (found ? "found " : "did not find ")
+	      << table << " " << where << " in snapshot" << std::endl;
+  }
+  return found;
+}
+
+// this is a stand-in for the web server, so jobs and tools can be 
+// tested without the database.  The url has the form file:DIR/ 
+// and DIR contains a file TABLE.csv for each table, for example
+// val.tables.csv, with a line of column names followed by the rows.
+// The query selects the columns by name, applies a where of the
+// form COLUMN:OP:VALUE (OP is eq,ne,lt,le,gt,ge) and an order of 
+// the form COLUMN or -COLUMN, and returns the rows as csv
+int mu2e::DbReader::queryFile(std::string& csv, 
+			      const std::string& select, 
+			      const std::string& table, 
+			      const std::string& where,
+			      const std::string& order) {
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  std::string fn = _id.url().substr(5)+table+".csv";
+  std::ifstream in(fn);
+  if(!in) {
+    _lastError = "could not open "+fn;
+    if (_abortOnFail) {
+      throw cet::exception("DBREADER_FAILED_FILE") << 
+	"DbReader failed to read database " << _id.name() 
+		   << ", last error: "<<_lastError <<"\n";
+    }
+    return 1;
+  }
+
+  std::string line;
+  std::getline(in,line);
+  auto titles = DbUtil::splitCsv(line);
+  auto column = [&](std::string const& name) {
+    auto iter = std::find(titles.begin(),titles.end(),name);
+    if(iter==titles.end()) {
+      throw cet::exception("DBREADER_BAD_COLUMN") << 
+	"DbReader::queryFile no column " << name << " in " << fn << "\n";
+    }
+    return size_t(iter-titles.begin());
+  };
+
+  std::vector<size_t> selected;
+  for(auto const& name : DbUtil::splitCsv(select)) selected.push_back(column(name));
+
+  // compare as numbers if both are numbers, otherwise as text
+  auto compare = [](std::string const& a, std::string const& b) {
+    char *ea, *eb;
+    double da = strtod(a.c_str(),&ea);
+    double db = strtod(b.c_str(),&eb);
+    if(!a.empty() && !b.empty() && *ea==0 && *eb==0) {
+      return (da<db) ? -1 : (da>db ? 1 : 0);
+    }
+    return a.compare(b);
+  };
+
+  size_t wcol = 0;
+  std::string wop,wvalue;
+  if(!where.empty()) {
+    std::vector<std::string> words;
+    boost::split(words,where, boost::is_any_of(":"));
+    if(words.size()!=3) {
+      throw cet::exception("DBREADER_BAD_WHERE") << 
+	"DbReader::queryFile could not parse where " << where << "\n";
+    }
+    wcol = column(words[0]);
+    wop = words[1];
+    wvalue = words[2];
+  }
+
+  std::vector<std::vector<std::string> > rows;
+  while(std::getline(in,line)) {
+    if(line.empty()) continue;
+    auto columns = DbUtil::splitCsv(line);
+    if(columns.size()!=titles.size()) {
+      throw cet::exception("DBREADER_BAD_COLUMN_COUNT") << 
+	"DbReader::queryFile wrong number of columns in " << fn << ": " << line << "\n";
+    }
+    if(!wop.empty()) {
+      int c = compare(columns[wcol],wvalue);
+      bool pass = (wop=="eq" && c==0) || (wop=="ne" && c!=0) ||
+	(wop=="lt" && c<0) || (wop=="le" && c<=0) ||
+	(wop=="gt" && c>0) || (wop=="ge" && c>=0);
+      if(!pass) continue;
+    }
+    rows.push_back(std::move(columns));
+  }
+
+  if(!order.empty()) {
+    bool descending = order[0]=='-';
+    size_t ocol = column(descending ? order.substr(1) : order);
+    std::stable_sort(rows.begin(),rows.end(),
+		     [&](std::vector<std::string> const& a, 
+			 std::vector<std::string> const& b) {
+		       int c = compare(a[ocol],b[ocol]);
+		       return descending ? c>0 : c<0; });
+  }
+
+  // same form as the server reply, after removing the line of column titles
+  csv.clear();
+  for(auto const& r : rows) {
+    for(size_t i=0; i<selected.size(); i++) {
+      if(i>0) csv.append(",");
+      csv.append(r[selected[i]]);
+    }
+    csv.append("\n");
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  _lastTime = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+  _totalTime += _lastTime;
+
+  if(_verbose>3) {
+    std::cout << "DbReader read " << rows.size() << " rows from " << fn << std::endl;
+  }
+
+  return 0;
+}
+
 int mu2e::DbReader::closeHandle() {
 
   // close the socket and release other dynamic resources
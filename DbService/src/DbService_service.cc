@@ -67,6 +67,14 @@ namespace mu2e {
       _engine.addOverride(coll);
     } // end loop over files
 
+    // the snapshot is mapped by the engine in beginJob
+    std::string snapshot;
+    if(_config.snapshot(snapshot)) {
+      if(_verbose>1) std::cout << "DbService using snapshot "<<
+		       snapshot <<std::endl;
+      _engine.setSnapshot( configFile(snapshot) );
+    }
+
     int cacheLifetime = 0;
     _config.cacheLifetime(cacheLifetime);
     _engine.reader().setCacheLifetime(cacheLifetime);
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cetlib_except/exception.h"
+#include "DbService/inc/DbSnapshot.hh"
+
+namespace {
+
+  const char magic[8] = {'M','U','2','E','D','B','S','1'};
+
+  // the file starts with this header, followed by the index
+  // (entries sorted by key hash) and the string area with
+  // the database name, the version, the keys and the answers
+  struct Header {
+    char magic[8];
+    uint64_t contentHash; // of everything after the header
+    uint64_t nEntries;
+    uint64_t stringsSize;
+    uint64_t dbNameLength;
+    uint64_t versionLength;
+  };
+
+}
+
+mu2e::DbSnapshot::~DbSnapshot() {
+  if(_data) munmap(const_cast<char*>(_data),_size);
+}
+
+// ****************************************************************
+
+std::string mu2e::DbSnapshot::key(std::string const& table,
+				  std::string const& select,
+				  std::string const& where,
+				  std::string const& order) {
+  // same fields as the url of the query
+  return "t="+table+"&c="+select+"&w="+where+"&o="+order;
+}
+
+uint64_t mu2e::DbSnapshot::hash(const char* data, size_t size, uint64_t h) {
+  for(size_t i=0; i<size; i++) {
+    h ^= (unsigned char)data[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// ****************************************************************
+
+void mu2e::DbSnapshot::add(std::string const& key, std::string const& csv) {
+  if(isMapped()) {
+    throw cet::exception("DBSNAPSHOT_MAPPED")
+      << "DbSnapshot::add can't add to a mapped snapshot " << _fileName << "\n";
+  }
+  _added[key] = csv;
+}
+
+uint64_t mu2e::DbSnapshot::write(std::string const& filename) {
+
+  std::string strings = _dbName + _version;
+
+  // store each distinct answer once, addressed by its hash
+  std::map<std::pair<uint64_t,std::string>,uint64_t> csvOffsets;
+  std::vector<Entry> entries;
+  for(auto const& a : _added) {
+    Entry e;
+    e.keyHash = hash(a.first.data(),a.first.size());
+    e.keyOffset = strings.size();
+    e.keyLength = a.first.size();
+    strings.append(a.first);
+    auto cKey = std::make_pair(hash(a.second.data(),a.second.size()),a.second);
+    auto iter = csvOffsets.find(cKey);
+    if(iter==csvOffsets.end()) {
+      // aligned, so columnar answers can be read in place
+      strings.resize((strings.size()+7)&~size_t(7),'\0');
+      iter = csvOffsets.emplace(cKey,strings.size()).first;
+      strings.append(a.second);
+    }
+    e.csvOffset = iter->second;
+    e.csvLength = a.second.size();
+    entries.push_back(e);
+  }
+  std::sort(entries.begin(),entries.end(),
+	    [](Entry const& a, Entry const& b) {return a.keyHash<b.keyHash;});
+
+  Header h;
+  std::copy(magic,magic+8,h.magic);
+  h.nEntries = entries.size();
+  h.stringsSize = strings.size();
+  h.dbNameLength = _dbName.size();
+  h.versionLength = _version.size();
+  const char* ep = reinterpret_cast<const char*>(entries.data());
+  size_t esize = entries.size()*sizeof(Entry);
+  h.contentHash = hash(reinterpret_cast<const char*>(&h.nEntries),
+		       sizeof(Header)-offsetof(Header,nEntries));
+  h.contentHash = hash(ep,esize,h.contentHash);
+  h.contentHash = hash(strings.data(),strings.size(),h.contentHash);
+
+  // write to a temporary file and rename, so readers never see a partial file
+  std::string tmpname = filename+".tmp"+std::to_string(getpid());
+  std::ofstream out(tmpname,std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&h),sizeof(Header));
+  out.write(ep,esize);
+  out.write(strings.data(),strings.size());
+  out.close();
+  if(!out.good() || std::rename(tmpname.c_str(),filename.c_str())!=0) {
+    std::remove(tmpname.c_str());
+    throw cet::exception("DBSNAPSHOT_WRITE_FAILED")
+      << "DbSnapshot::write could not write " << filename << "\n";
+  }
+
+  _fileName = filename;
+  _contentHash = h.contentHash;
+  _size = sizeof(Header)+esize+strings.size();
+  return _contentHash;
+}
+
+// ****************************************************************
+
+void mu2e::DbSnapshot::map(std::string const& filename, bool verify) {
+
+  int fd = open(filename.c_str(),O_RDONLY);
+  if(fd<0) {
+    throw cet::exception("DBSNAPSHOT_OPEN_FAILED")
+      << "DbSnapshot::map could not open " << filename << "\n";
+  }
+  struct stat st;
+  if(fstat(fd,&st)!=0 || size_t(st.st_size)<sizeof(Header)) {
+    close(fd);
+    throw cet::exception("DBSNAPSHOT_BAD_FILE")
+      << "DbSnapshot::map " << filename << " is not a snapshot\n";
+  }
+  void* addr = mmap(nullptr,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if(addr==MAP_FAILED) {
+    throw cet::exception("DBSNAPSHOT_MMAP_FAILED")
+      << "DbSnapshot::map could not map " << filename << "\n";
+  }
+  if(_data) munmap(const_cast<char*>(_data),_size);
+  _data = static_cast<const char*>(addr);
+  _size = st.st_size;
+  _fileName = filename;
+
+  Header h;
+  std::memcpy(&h,_data,sizeof(Header));
+  uint64_t esize = h.nEntries*sizeof(Entry);
+  bool ok = std::equal(magic,magic+8,h.magic)
+    && h.nEntries<=_size/sizeof(Entry)
+    && sizeof(Header)+esize+h.stringsSize==_size
+    && h.dbNameLength+h.versionLength<=h.stringsSize;
+  if(!ok) {
+    throw cet::exception("DBSNAPSHOT_BAD_FILE")
+      << "DbSnapshot::map " << filename << " is not a snapshot or is truncated\n";
+  }
+
+  // the content hash, computed as in write
+  if(verify) {
+    uint64_t ch = hash(reinterpret_cast<const char*>(&h.nEntries),
+		       sizeof(Header)-offsetof(Header,nEntries));
+    ch = hash(_data+sizeof(Header),esize+h.stringsSize,ch);
+    if(ch!=h.contentHash) {
+      throw cet::exception("DBSNAPSHOT_BAD_FILE")
+	<< "DbSnapshot::map " << filename << " content hash " << std::hex << ch
+	<< " does not match the header " << h.contentHash << std::dec << "\n";
+    }
+  }
+
+  _nEntries = h.nEntries;
+  _entries = reinterpret_cast<const Entry*>(_data+sizeof(Header));
+  _strings = _data+sizeof(Header)+esize;
+  _stringsSize = h.stringsSize;
+  _contentHash = h.contentHash;
+  _dbName.assign(_strings,h.dbNameLength);
+  _version.assign(_strings+h.dbNameLength,h.versionLength);
+
+  for(uint64_t i=0; i<_nEntries; i++) {
+    Entry const& e = _entries[i];
+    if(e.keyOffset+e.keyLength>_stringsSize || e.csvOffset+e.csvLength>_stringsSize) {
+      throw cet::exception("DBSNAPSHOT_BAD_FILE")
+	<< "DbSnapshot::map " << filename << " has a corrupt index\n";
+    }
+  }
+
+}
+
+bool mu2e::DbSnapshot::find(std::string const& key, std::string& csv) const {
+  const char* data;
+  size_t size;
+  if(!find(key,data,size)) return false;
+  csv.assign(data,size);
+  return true;
+}
+
+bool mu2e::DbSnapshot::find(std::string const& key, 
+			    const char*& data, size_t& size) const {
+  if(!isMapped()) return false;
+  uint64_t h = hash(key.data(),key.size());
+  const Entry* end = _entries+_nEntries;
+  const Entry* e = std::lower_bound(_entries,end,h,
+		     [](Entry const& a, uint64_t v) {return a.keyHash<v;});
+  for(; e!=end && e->keyHash==h; e++) {
+    if(key.compare(0,key.size(),_strings+e->keyOffset,e->keyLength)==0) {
+      data = _strings+e->csvOffset;
+      size = e->csvLength;
+      return true;
+    }
+  }
+  return false;
+}
@@ -34,6 +34,8 @@ int mu2e::DbTool::run() {
   if(_action=="commit-purpose") return commitPurpose();
   if(_action=="commit-version") return commitVersion();
 
+  if(_action=="write-snapshot") return writeSnapshot();
+
   if(_action=="test-url") return testUrl();
   
   std::cout << "error: could not parse action : "<< _args[0]<< std::endl;
@@ -1542,6 +1544,76 @@ int mu2e::DbTool::commitVersion() {
 }
 
 
+// ****************************************  writeSnapshot
+
+int mu2e::DbTool::writeSnapshot() {
+  int rc = 0;
+
+  map_ss args;
+  args["purpose"] = "";
+  args["version"] = "";
+  args["file"] = "";
+  args["csv"] = "";
+  if( (rc = getArgs(args)) ) return rc;
+
+  if(args["purpose"].empty() || args["file"].empty()) {
+    std::cout << "write-snapshot: --purpose and --file are required "<<std::endl;
+    return 1;
+  }
+
+  // the engine finds the calibrations of this purpose/version,
+  // exactly as it will in the jobs reading the snapshot
+  DbVersion version(args["purpose"],args["version"]);
+  DbEngine engine;
+  engine.setDbId(_id);
+  engine.setVersion(version);
+  engine.setVerbose(_verbose);
+  engine.setCache(std::make_shared<DbValCache>(_valcache));
+  engine.beginJob();
+
+  DbSnapshot snapshot;
+  snapshot.setSource(_id.name(),version.to_string());
+
+  // the val tables, with the queries of DbReader::fillValTables
+  for(auto name : {"ValTables","ValCalibrations","ValIovs","ValGroups",
+	"ValGroupLists","ValPurposes","ValLists","ValTableLists",
+	"ValVersions","ValExtensions","ValExtensionLists"}) {
+    auto const& tab = _valcache.asTable(name);
+    snapshot.add(DbSnapshot::key(tab.dbname(),tab.query()),tab.csv());
+  }
+
+  // the calibration tables, with the queries of DbReader::fillTableByCid,
+  // in columnar form if the table has a schema
+  auto cids = engine.cids();
+  size_t ncolumnar = 0;
+  for(auto cid : cids) {
+    int tid = _valcache.valCalibrations().row(cid).tid();
+    std::string name = _valcache.valTables().row(tid).name();
+    auto ptr = DbTableFactory::newTable(name);
+    rc = _reader.fillTableByCid(ptr,cid);
+    if(rc!=0) return rc;
+    auto schema = DbTableFactory::schema(name);
+    std::string answer = ptr->csv();
+    if(!schema.empty() && args["csv"].empty()) {
+      answer = DbColumns::encode(schema,answer);
+      ncolumnar++;
+    }
+    snapshot.add(DbSnapshot::key(ptr->dbname(),ptr->query(),
+				 DbReader::whereCid(cid)),answer);
+  }
+
+  uint64_t hash = snapshot.write(args["file"]);
+
+  std::cout << "write-snapshot: wrote " << snapshot.nEntries() 
+	    << " queries (" << cids.size() << " calibration tables, "
+	    << ncolumnar << " in columnar form) for "
+	    << version.to_string() << " to " << args["file"] 
+	    << ", " << snapshot.size() << " b, hash " 
+	    << std::hex << hash << std::dec << std::endl;
+
+  return 0;
+}
+
 // ****************************************  testUrl
 
 int mu2e::DbTool::testUrl() {
@@ -1676,6 +1748,8 @@ int mu2e::DbTool::help() {
       "    commit-list : declare a new list of table types for a version\n"
       "    commit-purpose : declare a new calibration set purpose\n"
       "    commit-version : declare a new version of a calibration set purpose\n"
+      "    \n"
+      "    write-snapshot : write the tables of a calibration set to a file for DbService\n"
       " \n"
       " arguments that are lists of integers may have the form:\n"
       "    int   example: --cid 234\n"
@@ -1914,6 +1988,27 @@ int mu2e::DbTool::help() {
       "  dbTool commit-version --purpose PRODUCTION --list 12 \\\n"
       "     --major 2 --minor 0 --comment \"to add alignment tables\"\n"
       << std::endl;
+  } else if(_action=="write-snapshot") {
+    std::cout << 
+      " \n"
+      " dbTool write-snapshot [OPTIONS]\n"
+      " \n"
+      " Write the val tables and all calibration tables of a calibration\n"
+      " set to a snapshot file.  DbService reads the tables from the file\n"
+      " (parameter snapshot) instead of from the database.  The calibration\n"
+      " tables are stored in a binary columnar form, which DbService uses\n"
+      " without parsing text.\n"
+      " \n"
+      " [OPTIONS]\n"
+      "    --purpose TEXT : purpose name (required)\n"
+      "    --version TEXT : the version, same as for DbService\n"
+      "    --file FILE : the snapshot file (required)\n"
+      "    --csv : store the calibration tables as csv text\n"
+      "  \n"
+      "  Example:\n"
+      "  dbTool write-snapshot --purpose PRODUCTION --version v1_1 \\\n"
+      "     --file PRODUCTION_v1_1.dbs\n"
+      << std::endl;
   } else if(_action=="commit-extension") {
     std::cout << 
       " \n"
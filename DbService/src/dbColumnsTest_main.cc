@@ -0,0 +1,155 @@
+//
+// Check and time the columnar binary form of the calibration tables (DbColumns).
+//
+//   dbColumnsTest [NREPEAT]
+//
+// For every table of DbTableFactory, csv content is generated (the fixed
+// number of rows of the table, or 2000 rows), and
+//   - the schema must have as many columns as the query of the table
+//   - encoding the csv, converting the payload back to csv and encoding
+//     again must give the same payload, also for a payload which is
+//     not aligned in memory, and a truncated payload must be rejected
+//   - the table filled from the payload must have the same rows as the
+//     table filled from the csv
+// then filling the table from csv and from the payload is timed
+// (NREPEAT times, default 20).  The exit code is 1 if any check fails.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include "DataProducts/inc/StrawId.hh"
+#include "DbTables/inc/DbTableFactory.hh"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  // csv content which each table accepts
+  std::string makeCsv(std::string const& name, mu2e::DbTable const& table,
+		      mu2e::DbColumns::Schema const& schema, size_t nrow) {
+    std::vector<std::string> names;
+    boost::split(names,table.query(),boost::is_any_of(","));
+    std::string csv;
+    char buf[64];
+    for(size_t i=0; i<nrow; i++) {
+      for(size_t j=0; j<schema.size(); j++) {
+	if(j>0) csv.push_back(',');
+	std::string cname = boost::algorithm::to_lower_copy(names.at(j));
+	if(schema[j]==mu2e::DbColumns::Int) {
+	  // the first column is an index, others are flags
+	  snprintf(buf,sizeof(buf),"%d",int(j==0 ? i : i%2));
+	} else if(schema[j]==mu2e::DbColumns::Float) {
+	  snprintf(buf,sizeof(buf),"%.4f",((i*37+j*101)%1000)*0.001-0.5);
+	} else if(cname=="strawid") {
+	  mu2e::StrawId sid(i/(mu2e::StrawId::_nstraws*mu2e::StrawId::_npanels),
+			    (i/mu2e::StrawId::_nstraws)%mu2e::StrawId::_npanels,
+			    i%mu2e::StrawId::_nstraws);
+	  snprintf(buf,sizeof(buf),"%d_%d_%d",sid.plane(),sid.panel(),sid.straw());
+	} else if(cname=="strawstatus") {
+	  snprintf(buf,sizeof(buf),"%s",name=="TrkStrawStatusShort" ? "Noise" : "Absent");
+	} else {
+	  // quoted, with a comma
+	  snprintf(buf,sizeof(buf),"\"text,%d\"",int(i));
+	}
+	csv.append(buf);
+      }
+      csv.push_back('\n');
+    }
+    return csv;
+  }
+
+  std::string rowsToCsv(mu2e::DbTable const& table) {
+    std::ostringstream ss;
+    for(size_t i=0; i<table.nrow(); i++) {
+      table.rowToCsv(ss,i);
+      ss << "\n";
+    }
+    return ss.str();
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  int nRepeat = (argc>1 ? atoi(argv[1]) : 20);
+
+  const char* names[] = {"TstCalib1","TstCalib2","TstCalib3",
+			 "TrkDelayPanel","TrkDelayRStraw","TrkPreampStraw",
+			 "TrkAlignTracker","TrkAlignPlane","TrkAlignPanel",
+			 "TrkAlignStraw","TrkPlaneStatus","TrkPanelStatus",
+			 "TrkStrawStatusLong","TrkStrawStatusShort",
+			 "AnaTrkQualDb","SimEfficiencies",
+			 "CalRoIDMapDIRACToOffline","CalRoIDMapOfflineToDIRAC"};
+
+  bool passed = true;
+  try {
+    for(auto name : names) {
+      auto table = mu2e::DbTableFactory::newTable(name);
+      auto schema = mu2e::DbTableFactory::schema(name);
+      std::vector<std::string> qnames;
+      boost::split(qnames,table->query(),boost::is_any_of(","));
+      if(schema.size()!=qnames.size()) {
+	std::printf("[dbColumnsTest] %s: FAILED, schema has %zu columns, query %zu\n",
+		    name,schema.size(),qnames.size());
+	passed = false;
+	continue;
+      }
+
+      size_t nrow = (table->nrowFix()>0 ? table->nrowFix() : 2000);
+      std::string csv = makeCsv(name,*table,schema,nrow);
+
+      // csv round trip
+      std::string payload = mu2e::DbColumns::encode(schema,csv);
+      mu2e::DbColumns columns(payload);
+      bool ok = columns.nrow()==nrow
+	&& mu2e::DbColumns::encode(schema,columns.toCsv())==payload;
+      std::string shifted = " "+payload;
+      mu2e::DbColumns unaligned(shifted.data()+1,payload.size());
+      ok = ok && unaligned.toCsv()==columns.toCsv();
+      try {
+	mu2e::DbColumns truncated(payload.data(),payload.size()-8);
+	ok = ok && nrow==0;
+      } catch (std::exception const&) {}
+
+      // same rows from both forms
+      auto fromCsv = mu2e::DbTableFactory::newTable(name);
+      fromCsv->fill(csv,false);
+      auto fromColumns = mu2e::DbTableFactory::newTable(name);
+      fromColumns->fill(columns,true);
+      ok = ok && fromColumns->nrow()==fromCsv->nrow()
+	&& rowsToCsv(*fromColumns)==rowsToCsv(*fromCsv)
+	&& fromColumns->csv()==columns.toCsv();
+
+      // timing
+      double tCsv = 0, tColumns = 0;
+      for(int i=0; i<nRepeat; i++) {
+	auto t1 = mu2e::DbTableFactory::newTable(name);
+	auto t2 = mu2e::DbTableFactory::newTable(name);
+	Clock::time_point c0 = Clock::now();
+	t1->fill(csv,false);
+	Clock::time_point c1 = Clock::now();
+	t2->fill(mu2e::DbColumns(payload),false);
+	Clock::time_point c2 = Clock::now();
+	tCsv += std::chrono::duration<double>(c1-c0).count();
+	tColumns += std::chrono::duration<double>(c2-c1).count();
+      }
+
+      passed = passed && ok;
+      std::printf("[dbColumnsTest] %-26s %s  %6zu rows  csv %8zu b  columns %8zu b"
+		  "  fill csv %9.1f us  columns %9.1f us\n",
+		  name, ok ? "ok" : "FAILED", nrow, csv.size(), payload.size(),
+		  1e6*tCsv/nRepeat, 1e6*tColumns/nRepeat);
+    }
+  } catch (std::exception const& e) {
+    std::cout << "dbColumnsTest: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+//
+// Benchmark of the table lookup of DbEngine::update with many threads.
+//
+//   dbEngineBench [NRUNS] [NTHREADS] [NLOOKUPS]
+//
+// A calibration set of one table (TstCalib1) is made in memory, with
+// IOVs for NRUNS runs (default 500): two subrun ranges per run, with
+// a gap every 7th run, and a second group of 100-run intervals which
+// overlap them.  The table contents are read from csv files in a
+// temporary directory (a file: url).  After one pass which loads all
+// the tables, NTHREADS threads (default: the number of cores) each
+// look up NLOOKUPS (default 200000) random run:subruns
+//   - with the previous scheme: a shared_mutex and a linear search of
+//     the IOVs, which also gives the expected cid
+//   - with DbEngine::update
+// The exit code is 1 if any cid differs or if the engine waited for
+// its lock during the lookups.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "DbService/inc/DbEngine.hh"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  const char* stamp = "2020-01-01 00:00:00.000000-06:00,bench";
+
+  struct Query {
+    uint32_t run;
+    uint32_t subrun;
+    int cid;
+  };
+
+  // the previous lookup of DbEngine, for reference
+  struct OldLookup {
+    std::vector<std::pair<mu2e::DbIoV,int>> rows;
+    std::map<int,int> cache;
+    mutable std::shared_mutex mutex;
+    int find(uint32_t run, uint32_t subrun) const {
+      std::shared_lock lock(mutex);
+      for(auto const& r : rows) {
+	if(r.first.inInterval(run,subrun)) {
+	  return cache.find(r.second)!=cache.end() ? r.second : -1;
+	}
+      }
+      return -1;
+    }
+  };
+
+}
+
+int main(int argc, char** argv) {
+
+  int nRuns = (argc>1 ? atoi(argv[1]) : 500);
+  int nThreads = (argc>2 ? atoi(argv[2]) : std::thread::hardware_concurrency());
+  int nLookups = (argc>3 ? atoi(argv[3]) : 200000);
+  if(nThreads<1) nThreads = 1;
+  const uint32_t run0 = 1000;
+
+  // the IOVs in the order the engine searches them: group 1, then group 2
+  std::vector<std::pair<mu2e::DbIoV,int>> rows;
+  std::vector<int> gids;
+  int cid = 0;
+  for(int i=0; i<nRuns; i++) {
+    if(i%7==3) continue;
+    uint32_t run = run0+i;
+    rows.emplace_back(mu2e::DbIoV(run,0,run,499),++cid);
+    gids.push_back(1);
+    rows.emplace_back(mu2e::DbIoV(run,500,run,999999),++cid);
+    gids.push_back(1);
+  }
+  for(int i=0; i<nRuns; i+=100) {
+    rows.emplace_back(mu2e::DbIoV(run0+i,0,run0+i+99,999999),++cid);
+    gids.push_back(2);
+  }
+
+  // the val tables
+  std::string tables = std::string("1,TstCalib1,tst.calib1,")+stamp+"\n";
+  std::string calibrations, iovs, grouplists;
+  for(size_t i=0; i<rows.size(); i++) {
+    auto const& iov = rows[i].first;
+    int c = rows[i].second;
+    calibrations += std::to_string(c)+",1,"+stamp+"\n";
+    iovs += std::to_string(c)+","+std::to_string(c)+","
+      +std::to_string(iov.startRun())+","+std::to_string(iov.startSubrun())+","
+      +std::to_string(iov.endRun())+","+std::to_string(iov.endSubrun())+","
+      +stamp+"\n";
+    grouplists += std::to_string(gids[i])+","+std::to_string(c)+"\n";
+  }
+  auto vcache = std::make_shared<mu2e::DbValCache>();
+  mu2e::ValTables vt; vt.fill(tables);
+  mu2e::ValCalibrations vc; vc.fill(calibrations);
+  mu2e::ValIovs vi; vi.fill(iovs);
+  mu2e::ValGroups vg; vg.fill(std::string("1,")+stamp+"\n2,"+stamp+"\n");
+  mu2e::ValGroupLists vgl; vgl.fill(grouplists);
+  mu2e::ValPurposes vp; vp.fill(std::string("1,BENCH,\"benchmark\",")+stamp+"\n");
+  mu2e::ValLists vl; vl.fill(std::string("1,BENCH_LIST,\"benchmark\",")+stamp+"\n");
+  mu2e::ValTableLists vtl; vtl.fill("1,1\n");
+  mu2e::ValVersions vv; vv.fill(std::string("1,1,1,1,0,\"benchmark\",")+stamp+"\n");
+  mu2e::ValExtensions ve; ve.fill(std::string("1,1,0,")+stamp+"\n");
+  mu2e::ValExtensionLists vel; vel.fill("1,1\n1,2\n");
+  vcache->setValTables(vt);
+  vcache->setValCalibrations(vc);
+  vcache->setValIovs(vi);
+  vcache->setValGroups(vg);
+  vcache->setValGroupLists(vgl);
+  vcache->setValPurposes(vp);
+  vcache->setValLists(vl);
+  vcache->setValTableLists(vtl);
+  vcache->setValVersions(vv);
+  vcache->setValExtensions(ve);
+  vcache->setValExtensionLists(vel);
+
+  // the table contents
+  char dir[] = "/tmp/dbEngineBenchXXXXXX";
+  if(!mkdtemp(dir)) {
+    std::cout << "dbEngineBench: could not make a temporary directory" << std::endl;
+    return 1;
+  }
+  std::string fn = std::string(dir)+"/tst.calib1.csv";
+  {
+    std::ofstream out(fn);
+    out << "cid,channel,flag,dtoe\n";
+    for(auto const& r : rows) {
+      for(int ch=0; ch<3; ch++) out << r.second << "," << ch << "," << r.second%100 << ",1.5\n";
+    }
+  }
+
+  bool passed = true;
+  try {
+    mu2e::DbEngine engine;
+    engine.setDbId(mu2e::DbId("bench","localhost","0",
+			      std::string("file:")+dir+"/",std::string("file:")+dir+"/"));
+    engine.setVersion(mu2e::DbVersion("BENCH","v1_0"));
+    engine.setCache(vcache);
+    engine.setSaveCsv(false);
+    engine.beginJob();
+    int tid = engine.tidByName("TstCalib1");
+
+    // load all tables which can be found
+    OldLookup old;
+    old.rows = rows;
+    Clock::time_point t0 = Clock::now();
+    for(int i=0; i<nRuns; i++) {
+      for(uint32_t subrun : {0,500}) {
+	auto lt = engine.update(tid,run0+i,subrun);
+	old.cache[lt.cid()] = lt.cid();
+      }
+    }
+    double tLoad = std::chrono::duration<double>(Clock::now()-t0).count();
+
+    // random queries inside the covered runs
+    std::vector<std::vector<Query>> queries(nThreads);
+    for(int i=0; i<nThreads; i++) {
+      std::mt19937 gen(1234+i);
+      std::uniform_int_distribution<uint32_t> runs(run0,run0+nRuns-1);
+      std::uniform_int_distribution<uint32_t> subruns(0,999);
+      for(int j=0; j<nLookups; j++) queries[i].push_back({runs(gen),subruns(gen),-1});
+    }
+
+    auto timeThreads = [&](auto work) {
+      std::vector<std::thread> threads;
+      Clock::time_point t0 = Clock::now();
+      for(int i=0; i<nThreads; i++) threads.emplace_back(work,i);
+      for(auto& t : threads) t.join();
+      return std::chrono::duration<double>(Clock::now()-t0).count();
+    };
+
+    double tOld = timeThreads([&](int i) {
+	for(auto& q : queries[i]) q.cid = old.find(q.run,q.subrun);
+      });
+
+    double lockWait0 = engine.lockWaitTime();
+    std::vector<size_t> mismatches(nThreads,0);
+    double tNew = timeThreads([&](int i) {
+	for(auto const& q : queries[i]) {
+	  auto lt = engine.update(tid,q.run,q.subrun);
+	  if(lt.cid()!=q.cid || !lt.ptr()) mismatches[i]++;
+	}
+      });
+    double lockWait = engine.lockWaitTime()-lockWait0;
+
+    size_t nMismatch = 0;
+    for(auto m : mismatches) nMismatch += m;
+    passed = nMismatch==0 && lockWait==0;
+    double n = double(nThreads)*nLookups;
+    std::printf("[dbEngineBench] %zu IOVs, %d threads, %d lookups per thread, tables loaded in %.3f s\n",
+		rows.size(),nThreads,nLookups,tLoad);
+    std::printf("[dbEngineBench] shared_mutex, linear search: %10.4g lookups/s\n",n/tOld);
+    std::printf("[dbEngineBench] DbEngine::update           : %10.4g lookups/s\n",n/tNew);
+    std::printf("[dbEngineBench] %zu different cids, lock wait during lookups %.6f s: %s\n",
+		nMismatch,lockWait,passed ? "ok" : "FAILED");
+  } catch (std::exception const& e) {
+    std::cout << "dbEngineBench: " << e.what() << std::endl;
+    passed = false;
+  }
+
+  std::remove(fn.c_str());
+  rmdir(dir);
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#ifndef DbTables_DbColumns_hh
+#define DbTables_DbColumns_hh
+
+//
+// A typed, columnar binary form of the contents of a DbTable.
+// Each column of the table has a type from the table schema
+// (see DbTableFactory::schema) and is stored as one contiguous
+// array: int32 or float values, or for text columns, an array of
+// offsets followed by the characters.  A DbColumns is a view of
+// such a payload, for example in a memory-mapped snapshot: the
+// column accessors point into the payload, nothing is copied or
+// parsed, so a table is filled with one pass over plain arrays.
+//
+// The payload is made from the csv text of a table with encode,
+// and toCsv converts it back to csv, which gives the same payload
+// when encoded again.  Text columns keep the csv text as it is,
+// including quotes.
+//
+// Payload layout, all offsets relative to the start of the payload
+// and all arrays aligned to 8 bytes:
+//   char[8] "MU2EDBC1", uint64 nrow, uint64 ncol
+//   ncol x (uint64 type, uint64 offset, uint64 length)
+//   the column arrays
+//
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace mu2e {
+
+  class DbColumns {
+  public:
+
+    enum Type : uint64_t { Int=1, Float=2, Text=3 };
+    typedef std::vector<Type> Schema;
+
+    // a view of a payload, throws if it is not a valid payload
+    DbColumns(const char* data, std::size_t size);
+    explicit DbColumns(std::string const& payload):
+      DbColumns(payload.data(),payload.size()) {}
+    DbColumns(DbColumns const&) = delete;
+    DbColumns& operator=(DbColumns const&) = delete;
+
+    // check the payload header, to tell a payload from csv text
+    static bool isColumnar(const char* data, std::size_t size);
+    static bool isColumnar(std::string const& payload) {
+      return isColumnar(payload.data(),payload.size()); }
+
+    // convert the csv text of a table to a payload
+    static std::string encode(Schema const& schema, std::string const& csv);
+    // convert back to csv
+    std::string toCsv() const;
+
+    std::size_t nrow() const { return _nrow; }
+    std::size_t ncol() const { return _ncol; }
+    Type type(std::size_t icol) const;
+
+    // the arrays of a column, throw if the column has another type
+    const int32_t* intColumn(std::size_t icol) const;
+    const float* floatColumn(std::size_t icol) const;
+    // single values
+    int32_t intAt(std::size_t icol, std::size_t irow) const {
+      return intColumn(icol)[irow]; }
+    float floatAt(std::size_t icol, std::size_t irow) const {
+      return floatColumn(icol)[irow]; }
+    std::string_view textAt(std::size_t icol, std::size_t irow) const;
+
+    // a row as strings, in the form of DbTable::addRow
+    void rowToStrings(std::size_t irow, std::vector<std::string>& columns) const;
+
+    // the payload
+    const char* data() const { return _data; }
+    std::size_t size() const { return _size; }
+
+  private:
+
+    // layout of the column descriptors
+    struct Column {
+      uint64_t type;
+      uint64_t offset;
+      uint64_t length;
+    };
+
+    const char* column(std::size_t icol, Type type) const;
+
+    const char* _data;
+    std::size_t _size;
+    std::size_t _nrow;
+    std::size_t _ncol;
+    const Column* _columns;
+    // a copy of a payload which was not aligned
+    std::vector<uint64_t> _aligned;
+  };
+
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef DbTables_DbIoVIndex_hh
+#define DbTables_DbIoVIndex_hh
+
+//
+// An index for finding which of a list of intervals of validity
+// contains a run:subrun.  The intervals are cut into sorted,
+// non-overlapping segments of run:subrun, and each segment points
+// to the first interval of the list which covers it, so a lookup 
+// is a binary search and gives the same answer as checking the 
+// intervals in the order of the list.  It is not changed after
+// build, so it can be read from many threads without locks.
+//
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "DbTables/inc/DbIoV.hh"
+
+namespace mu2e {
+
+  class DbIoVIndex {
+  public:
+
+    // the list is in priority order, where intervals overlap,
+    // the earlier one is found
+    void build(std::vector<DbIoV> const& iovs);
+
+    // the position in the list of the interval which contains 
+    // run:subrun, or -1 if there is none
+    int find(uint32_t run, uint32_t subrun) const {
+      auto iter = std::upper_bound(_starts.begin(),_starts.end(),
+				   key(run,subrun));
+      if(iter==_starts.begin()) return -1;
+      return _items[iter-_starts.begin()-1];
+    }
+
+    std::size_t nSegments() const { return _starts.size(); }
+    void clear() { _starts.clear(); _items.clear(); }
+
+  private:
+
+    // run:subrun as one number, in the order of DbIoV::inInterval
+    static uint64_t key(uint32_t run, uint32_t subrun) {
+      return (uint64_t(run)<<32) | subrun; }
+
+    // segment i starts at _starts[i] and ends before _starts[i+1],
+    // the last one is open-ended, _items[i] is -1 for gaps
+    std::vector<uint64_t> _starts;
+    std::vector<int> _items;
+  };
+
+}
+#endif
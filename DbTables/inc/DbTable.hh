@@ -6,6 +6,7 @@
 #include <memory>
 #include <sstream>
 #include <cstdint>
+#include "DbTables/inc/DbColumns.hh"
 
 namespace mu2e {
 
@@ -41,11 +42,18 @@ namespace mu2e {
 
     // take the cvs text from a query and build out the table contents
     int fill(const std::string& csv, bool saveCsv=true);
+    // build out the table contents from the columnar binary form,
+    // the csv is only made if requested
+    int fill(DbColumns const& columns, bool saveCsv=false);
     // in case table was filled with binary values, convert to csv
     int toCsv();
 
     // part of building content, convert list of strings to binary row
     virtual void addRow(const std::vector<std::string>& columns) =0;
+    // part of building content from the columnar form, convert all
+    // rows at once.  The default converts each row to strings and
+    // calls addRow, tables with many rows override it
+    virtual void addColumns(DbColumns const& columns);
     // convert a row in a binary format to a string
     virtual void rowToCsv(std::ostringstream& stream, size_t irow) const =0;
     // remove all rows
@@ -53,6 +61,9 @@ namespace mu2e {
     void baseClear() { _csv.clear(); }
 
   private:
+    // if this table has a fixed number of rows, check that
+    void checkNrow() const;
+
     std::string _name;
     std::string _dbname;
     std::string _query;
@@ -8,6 +8,9 @@ namespace mu2e  {
   class DbTableFactory {
   public:
     static mu2e::DbTable::ptr_t newTable(std::string const& name);
+    // the column types of a table, for its columnar binary form,
+    // the schema is empty for tables which are only kept as csv
+    static mu2e::DbColumns::Schema schema(std::string const& name);
   };
 
 }
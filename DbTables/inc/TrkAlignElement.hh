@@ -39,6 +39,18 @@ namespace mu2e {
 			 std::stof(columns[7]));
     }
 
+    void addColumns(DbColumns const& columns) override {
+      const int32_t* index = columns.intColumn(0);
+      const float* v[6];
+      for(std::size_t j=0; j<6; j++) v[j] = columns.floatColumn(j+2);
+      _rows.reserve(_rows.size()+columns.nrow());
+      for(std::size_t i=0; i<columns.nrow(); i++) {
+	_rows.emplace_back(index[i],
+			   StrawId(std::string(columns.textAt(1,i))),
+			   v[0][i],v[1][i],v[2][i],v[3][i],v[4][i],v[5][i]);
+      }
+    }
+
     void rowToCsv(std::ostringstream& sstream, std::size_t irow) const override {
       TrkAlignParams const& r = _rows.at(irow);
       sstream << r.index()<<",";
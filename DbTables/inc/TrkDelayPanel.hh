@@ -41,6 +41,15 @@ namespace mu2e {
 			 std::stof(columns[1]) );
     }
 
+    void addColumns(DbColumns const& columns) override {
+      const int32_t* index = columns.intColumn(0);
+      const float* delay = columns.floatColumn(1);
+      _rows.reserve(_rows.size()+columns.nrow());
+      for(std::size_t i=0; i<columns.nrow(); i++) {
+	_rows.emplace_back(index[i],delay[i]);
+      }
+    }
+
     void rowToCsv(std::ostringstream& sstream, std::size_t irow) const override {
       Row const& r = _rows.at(irow);
       sstream << r.index()<<",";
@@ -53,6 +53,22 @@ namespace mu2e {
                          std::stof(columns[2]));
     }
 
+    void addColumns(DbColumns const& columns) override {
+      const int32_t* straw = columns.intColumn(0);
+      const float* delay_hv = columns.floatColumn(1);
+      const float* delay_cal = columns.floatColumn(2);
+      _rows.reserve(_rows.size()+columns.nrow());
+      for(std::size_t i=0; i<columns.nrow(); i++) {
+	// enforce a strict sequential order
+	if(straw[i]!=int(_rows.size())) {
+	  throw cet::exception("TRKDELAYRSTRAW_BAD_INDEX") 
+	    << "TrkDelayRStraw::addColumns found straw out of order: " 
+	    <<straw[i] << " != " << _rows.size() <<"\n";
+	}
+	_rows.emplace_back(straw[i],delay_hv[i],delay_cal[i]);
+      }
+    }
+
     void rowToCsv(std::ostringstream& sstream, std::size_t irow) const override {
       Row const& r = _rows.at(irow);
       sstream << r.straw()<<",";
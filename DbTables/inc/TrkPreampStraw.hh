@@ -57,6 +57,20 @@ namespace mu2e {
 			 std::stof(columns[5]) );
     }
 
+    void addColumns(DbColumns const& columns) override {
+      const int32_t* index = columns.intColumn(0);
+      const float* delay_hv = columns.floatColumn(1);
+      const float* delay_cal = columns.floatColumn(2);
+      const float* threshold_hv = columns.floatColumn(3);
+      const float* threshold_cal = columns.floatColumn(4);
+      const float* gain = columns.floatColumn(5);
+      _rows.reserve(_rows.size()+columns.nrow());
+      for(std::size_t i=0; i<columns.nrow(); i++) {
+	_rows.emplace_back(index[i],delay_hv[i],delay_cal[i],
+			   threshold_hv[i],threshold_cal[i],gain[i]);
+      }
+    }
+
     void rowToCsv(std::ostringstream& sstream, std::size_t irow) const override {
       Row const& r = _rows.at(irow);
       sstream << r.index()<<",";
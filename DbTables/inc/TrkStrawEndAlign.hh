@@ -15,6 +15,7 @@ namespace mu2e {
 	float wire_hv_dV, float wire_hv_dW,
 	float straw_cal_dV, float straw_cal_dW,
 	float straw_hv_dV, float straw_hv_dW) :
+      _index(index), _id(id),
       _wire_cal_dV(wire_cal_dV), _wire_cal_dW(wire_cal_dW),
       _wire_hv_dV(wire_hv_dV), _wire_hv_dW(wire_hv_dW),
       _straw_cal_dV(straw_cal_dV), _straw_cal_dW(straw_cal_dW),
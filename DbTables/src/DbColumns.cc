@@ -0,0 +1,233 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "cetlib_except/exception.h"
+#include "DbTables/inc/DbColumns.hh"
+#include "DbTables/inc/DbUtil.hh"
+
+namespace {
+
+  const char magic[8] = {'M','U','2','E','D','B','C','1'};
+
+  // the fixed part of the payload
+  struct Header {
+    char magic[8];
+    uint64_t nrow;
+    uint64_t ncol;
+  };
+
+  size_t pad8(size_t n) { return (n+7)&~size_t(7); }
+
+  // the shortest text which converts back to the same float,
+  // at most 9 digits are needed
+  int formatFloat(char* buf, size_t size, float x) {
+    int n = 0;
+    for(int digits=6; digits<=9; digits++) {
+      n = snprintf(buf,size,"%.*g",digits,x);
+      if(strtof(buf,nullptr)==x) break;
+    }
+    return n;
+  }
+
+}
+
+mu2e::DbColumns::DbColumns(const char* data, std::size_t size):
+  _data(data),_size(size),_nrow(0),_ncol(0),_columns(nullptr) {
+
+  if(!isColumnar(data,size)) {
+    throw cet::exception("DBCOLUMNS_BAD_PAYLOAD")
+      << "DbColumns found a payload without the columnar header\n";
+  }
+  // the arrays are read in place, which needs the payload aligned
+  if(reinterpret_cast<uintptr_t>(data)%8 != 0) {
+    _aligned.resize(pad8(size)/8);
+    std::memcpy(_aligned.data(),data,size);
+    _data = reinterpret_cast<const char*>(_aligned.data());
+  }
+
+  Header h;
+  std::memcpy(&h,_data,sizeof(Header));
+  _nrow = h.nrow;
+  _ncol = h.ncol;
+  bool ok = _nrow <= _size && _ncol <= (_size-sizeof(Header))/sizeof(Column);
+  if(ok) _columns = reinterpret_cast<const Column*>(_data+sizeof(Header));
+  for(size_t i=0; ok && i<_ncol; i++) {
+    Column const& c = _columns[i];
+    size_t minLength = 0;
+    if(c.type==Int) {
+      minLength = _nrow*sizeof(int32_t);
+    } else if(c.type==Float) {
+      minLength = _nrow*sizeof(float);
+    } else if(c.type==Text) {
+      minLength = (_nrow+1)*sizeof(uint64_t);
+    } else {
+      ok = false;
+    }
+    ok = ok && c.offset%8==0 && c.offset<=_size
+      && c.length<=_size-c.offset && c.length>=minLength;
+    if(ok && c.type==Text) {
+      const uint64_t* offsets = reinterpret_cast<const uint64_t*>(_data+c.offset);
+      ok = offsets[0]==(_nrow+1)*sizeof(uint64_t) && offsets[_nrow]<=c.length;
+      for(size_t j=0; ok && j<_nrow; j++) ok = offsets[j]<=offsets[j+1];
+    }
+  }
+  if(!ok) {
+    throw cet::exception("DBCOLUMNS_BAD_PAYLOAD")
+      << "DbColumns found a truncated or corrupt payload\n";
+  }
+}
+
+// ****************************************************************
+
+bool mu2e::DbColumns::isColumnar(const char* data, std::size_t size) {
+  return size>=sizeof(Header) && std::equal(magic,magic+8,data);
+}
+
+// ****************************************************************
+
+std::string mu2e::DbColumns::encode(Schema const& schema, std::string const& csv) {
+
+  std::vector<std::vector<std::string> > rows;
+  for(auto const& line: DbUtil::splitCsvLines(csv)) {
+    rows.emplace_back(DbUtil::splitCsv(line));
+    if(rows.back().size()!=schema.size()) {
+      throw cet::exception("DBCOLUMNS_BAD_COLUMN_COUNT")
+	<< "DbColumns::encode found " << rows.back().size()
+	<< " columns when the schema has " << schema.size()
+	<< ". Text:" << line << "\n";
+    }
+  }
+  size_t nrow = rows.size();
+  size_t ncol = schema.size();
+
+  std::vector<Column> columns(ncol);
+  std::string body;
+  size_t offset = pad8(sizeof(Header)+ncol*sizeof(Column));
+  for(size_t i=0; i<ncol; i++) {
+    std::string array;
+    if(schema[i]==Int || schema[i]==Float) {
+      array.resize(nrow*4);
+      for(size_t j=0; j<nrow; j++) {
+	std::string const& text = rows[j][i];
+	try {
+	  if(schema[i]==Int) {
+	    int32_t x = std::stoi(text);
+	    std::memcpy(&array[j*4],&x,4);
+	  } else {
+	    float x = std::stof(text);
+	    std::memcpy(&array[j*4],&x,4);
+	  }
+	} catch (std::exception const&) {
+	  throw cet::exception("DBCOLUMNS_BAD_VALUE")
+	    << "DbColumns::encode could not convert \"" << text
+	    << "\" in column " << i << " of row " << j << "\n";
+	}
+      }
+    } else if(schema[i]==Text) {
+      std::vector<uint64_t> offsets(nrow+1);
+      std::string chars;
+      for(size_t j=0; j<nrow; j++) {
+	offsets[j] = offsets.size()*sizeof(uint64_t)+chars.size();
+	chars.append(rows[j][i]);
+      }
+      offsets[nrow] = offsets.size()*sizeof(uint64_t)+chars.size();
+      array.assign(reinterpret_cast<const char*>(offsets.data()),
+		   offsets.size()*sizeof(uint64_t));
+      array.append(chars);
+    } else {
+      throw cet::exception("DBCOLUMNS_BAD_SCHEMA")
+	<< "DbColumns::encode found unknown type " << schema[i]
+	<< " for column " << i << "\n";
+    }
+    columns[i].type = schema[i];
+    columns[i].offset = offset+body.size();
+    columns[i].length = array.size();
+    body.append(array);
+    body.resize(pad8(body.size()),'\0');
+  }
+
+  Header h;
+  std::copy(magic,magic+8,h.magic);
+  h.nrow = nrow;
+  h.ncol = ncol;
+  std::string payload(reinterpret_cast<const char*>(&h),sizeof(Header));
+  payload.append(reinterpret_cast<const char*>(columns.data()),
+		 ncol*sizeof(Column));
+  payload.resize(offset,'\0');
+  payload.append(body);
+  return payload;
+}
+
+// ****************************************************************
+
+std::string mu2e::DbColumns::toCsv() const {
+  std::string csv;
+  char buf[32];
+  for(size_t j=0; j<_nrow; j++) {
+    for(size_t i=0; i<_ncol; i++) {
+      if(i>0) csv.push_back(',');
+      Type t = type(i);
+      if(t==Int) {
+	csv.append(buf,snprintf(buf,sizeof(buf),"%d",intAt(i,j)));
+      } else if(t==Float) {
+	csv.append(buf,formatFloat(buf,sizeof(buf),floatAt(i,j)));
+      } else {
+	csv.append(textAt(i,j));
+      }
+    }
+    csv.push_back('\n');
+  }
+  return csv;
+}
+
+// ****************************************************************
+
+mu2e::DbColumns::Type mu2e::DbColumns::type(std::size_t icol) const {
+  if(icol>=_ncol) {
+    throw cet::exception("DBCOLUMNS_BAD_COLUMN")
+      << "DbColumns::type column " << icol << " of " << _ncol << "\n";
+  }
+  return Type(_columns[icol].type);
+}
+
+const char* mu2e::DbColumns::column(std::size_t icol, Type t) const {
+  if(type(icol)!=t) {
+    throw cet::exception("DBCOLUMNS_BAD_TYPE")
+      << "DbColumns column " << icol << " has type " << type(icol)
+      << ", not " << t << "\n";
+  }
+  return _data+_columns[icol].offset;
+}
+
+const int32_t* mu2e::DbColumns::intColumn(std::size_t icol) const {
+  return reinterpret_cast<const int32_t*>(column(icol,Int));
+}
+
+const float* mu2e::DbColumns::floatColumn(std::size_t icol) const {
+  return reinterpret_cast<const float*>(column(icol,Float));
+}
+
+std::string_view mu2e::DbColumns::textAt(std::size_t icol, std::size_t irow) const {
+  const char* c = column(icol,Text);
+  const uint64_t* offsets = reinterpret_cast<const uint64_t*>(c);
+  return std::string_view(c+offsets[irow],offsets[irow+1]-offsets[irow]);
+}
+
+// ****************************************************************
+
+void mu2e::DbColumns::rowToStrings(std::size_t irow,
+				   std::vector<std::string>& columns) const {
+  columns.resize(_ncol);
+  char buf[32];
+  for(size_t i=0; i<_ncol; i++) {
+    Type t = type(i);
+    if(t==Int) {
+      columns[i].assign(buf,snprintf(buf,sizeof(buf),"%d",intAt(i,irow)));
+    } else if(t==Float) {
+      columns[i].assign(buf,formatFloat(buf,sizeof(buf),floatAt(i,irow)));
+    } else {
+      columns[i].assign(textAt(i,irow));
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#include <numeric>
+#include "DbTables/inc/DbIoVIndex.hh"
+
+void mu2e::DbIoVIndex::build(std::vector<DbIoV> const& iovs) {
+
+  // the segments begin at the start and after the end of each interval
+  _starts.clear();
+  for(auto const& iov : iovs) {
+    uint64_t s = key(iov.startRun(),iov.startSubrun());
+    uint64_t e = key(iov.endRun(),iov.endSubrun());
+    if(s>e) continue; // an empty interval
+    _starts.push_back(s);
+    _starts.push_back(e+1);
+  }
+  std::sort(_starts.begin(),_starts.end());
+  _starts.erase(std::unique(_starts.begin(),_starts.end()),_starts.end());
+  _items.assign(_starts.size(),-1);
+
+  // give each segment to the first interval which covers it.  
+  // next[i] skips ahead to the first segment at or after i which is 
+  // not yet taken, so each segment is only visited once
+  std::vector<std::size_t> next(_starts.size()+1);
+  std::iota(next.begin(),next.end(),0);
+  auto nextFree = [&next](std::size_t i) {
+    while(next[i]!=i) {
+      next[i] = next[next[i]];
+      i = next[i];
+    }
+    return i;
+  };
+
+  for(std::size_t i=0; i<iovs.size(); i++) {
+    uint64_t s = key(iovs[i].startRun(),iovs[i].startSubrun());
+    uint64_t e = key(iovs[i].endRun(),iovs[i].endSubrun());
+    if(s>e) continue;
+    std::size_t lo = std::lower_bound(_starts.begin(),_starts.end(),s)
+      - _starts.begin();
+    std::size_t hi = std::lower_bound(_starts.begin(),_starts.end(),e+1)
+      - _starts.begin();
+    for(std::size_t j=nextFree(lo); j<hi; j=nextFree(j)) {
+      _items[j] = int(i);
+      next[j] = j+1;
+    }
+  }
+}
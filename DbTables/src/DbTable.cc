@@ -20,14 +20,7 @@ int mu2e::DbTable::fill(const std::string& csv, bool saveCsv) {
     addRow(columns);
   }
 
-  // if this table has a fixed number of rows, check that
-  if(nrowFix()>0 && nrow()!=nrowFix()) {
-    throw cet::exception("DBTABLE_BAD_ROW_COUNT") 
-      << "DbTable::fill csv line counts is "
-      << std::to_string(nrow()) << " but "
-      << std::to_string(nrowFix()) << " is required while filling "
-      << name();
-  }
+  checkNrow();
 
   // save the plain text
   if(saveCsv) {
@@ -39,6 +32,25 @@ int mu2e::DbTable::fill(const std::string& csv, bool saveCsv) {
   return 0;
 }
 
+int mu2e::DbTable::fill(DbColumns const& columns, bool saveCsv) {
+  _csv.clear();
+  addColumns(columns);
+  checkNrow();
+  // the csv of the columns keeps the values exactly, unlike rowToCsv
+  if(saveCsv) _csv = columns.toCsv();
+  return 0;
+}
+
+void mu2e::DbTable::checkNrow() const {
+  if(nrowFix()>0 && nrow()!=nrowFix()) {
+    throw cet::exception("DBTABLE_BAD_ROW_COUNT") 
+      << "DbTable::fill csv line counts is "
+      << std::to_string(nrow()) << " but "
+      << std::to_string(nrowFix()) << " is required while filling "
+      << name();
+  }
+}
+
 int mu2e::DbTable::toCsv() {
   if(!_csv.empty()) return 0;
   std::ostringstream ss;
@@ -52,6 +64,14 @@ void mu2e::DbTable::addRow(const std::vector<std::string>& columns) {
     << "DbTable::addRow must be overridden ";
 }
 
+void mu2e::DbTable::addColumns(DbColumns const& columns) {
+  std::vector<std::string> row;
+  for(std::size_t i=0; i<columns.nrow(); i++) {
+    columns.rowToStrings(i,row);
+    addRow(row);
+  }
+}
+
 void mu2e::DbTable::rowToCsv(std::ostringstream& stream, size_t irow) const {
   throw cet::exception("DBTABLE_FUNCTION_NOT_IMPLEMENTED") 
     << "DbTable::rowToCsv must be overridden ";
@@ -1,3 +1,4 @@
+#include <map>
 #include "cetlib_except/exception.h"
 
 #include "DbTables/inc/DbTableFactory.hh"
@@ -59,3 +60,33 @@ mu2e::DbTable::ptr_t mu2e::DbTableFactory::newTable(std::string const& name) {
 
   }
 }
+
+mu2e::DbColumns::Schema mu2e::DbTableFactory::schema(std::string const& name) {
+  // one entry for each column in the query of the table
+  const DbColumns::Type I = DbColumns::Int;
+  const DbColumns::Type F = DbColumns::Float;
+  const DbColumns::Type T = DbColumns::Text;
+  static const std::map<std::string,DbColumns::Schema> schemas = {
+    {"TstCalib1",                {I,I,F}},
+    {"TstCalib2",                {I,T}},
+    {"TstCalib3",                {I,F,F,F,F,F,F,F,F,F,F}},
+    {"TrkDelayPanel",            {I,F}},
+    {"TrkDelayRStraw",           {I,F,F}},
+    {"TrkPreampStraw",           {I,F,F,F,F,F}},
+    {"TrkAlignTracker",          {I,T,F,F,F,F,F,F}},
+    {"TrkAlignPlane",            {I,T,F,F,F,F,F,F}},
+    {"TrkAlignPanel",            {I,T,F,F,F,F,F,F}},
+    {"TrkAlignStraw",            {I,T,F,F,F,F,F,F,F,F}},
+    {"TrkPlaneStatus",           {T,T}},
+    {"TrkPanelStatus",           {T,T}},
+    {"TrkStrawStatusLong",       {T,T}},
+    {"TrkStrawStatusShort",      {T,T}},
+    {"AnaTrkQualDb",             {I,T,T,I}},
+    {"SimEfficiencies",          {T,I,I,F}},
+    {"CalRoIDMapDIRACToOffline", {I,I}},
+    {"CalRoIDMapOfflineToDIRAC", {I,I}}
+  };
+  auto iter = schemas.find(name);
+  if(iter==schemas.end()) return DbColumns::Schema();
+  return iter->second;
+}
@@ -9,6 +9,16 @@
 //    art/Persistency/Common/CollectionUtilities.h
 //
 //
+// With framePoolSize set, the secondary events are read only once:
+// the first event asks the MixHelper for framePoolSize secondaries,
+// whose products are kept in memory, one collection per secondary
+// event (a "frame"), with their Ptrs already remapped to the output
+// products.  That event and all the following ones then mix frames
+// drawn at random from this pool; the number of frames per event is
+// still decided by the detail class (Poisson, PBI, ...).  Mixing then
+// costs copying the frames instead of reading them from ROOT files.
+// The pool is not changed after it is filled.
+//
 // Andrei Gaponenko, 2018
 
 #ifndef EventMixing_inc_Mu2eProductMixing_hh
@@ -17,6 +27,8 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <random>
+#include <tuple>
 
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/OptionalAtom.h"
@@ -97,6 +109,10 @@ namespace mu2e {
       fhicl::Table<CollectionMixerConfig> eventIDMixer { fhicl::Name("eventIDMixer") };
       fhicl::OptionalTable<VolumeInfoMixerConfig> volumeInfoMixer { fhicl::Name("volumeInfoMixer") };
       fhicl::Atom<art::InputTag> simTimeOffset { fhicl::Name("simTimeOffset"), fhicl::Comment("Simulation time offset to apply (optional)"), art::InputTag() };
+      fhicl::Atom<unsigned> framePoolSize { fhicl::Name("framePoolSize"),
+          fhicl::Comment("If not 0, read this many secondary events once, at the first event, keep them\n"
+                         "in memory, and mix frames drawn at random from them in every event."),
+          0u };
     };
 
     Mu2eProductMixer(const Config& conf, art::MixHelper& helper);
@@ -105,47 +121,68 @@ namespace mu2e {
     void beginSubRun(const art::SubRun& sr);
     void endSubRun(art::SubRun& sr);
 
+    // The number of secondary events the MixHelper should read for
+    // nMix frames to be mixed in this event.  With a frame pool, the
+    // frames are drawn here, and only the first event reads events.
+    template<class URBG> std::size_t nSecondaries(std::size_t nMix, URBG& urbg);
+
+    // The IDs of the secondary events mixed in this event, from the
+    // IDs of the events read.
+    art::EventIDSequence mixedEventIDs(art::EventIDSequence const& seq);
+
+    bool usesFramePool() const { return poolSize_ > 0; }
+
   private:
 
+    template<class REMAP>
     bool mixGenParticles(std::vector<GenParticleCollection const*> const& in,
                          GenParticleCollection& out,
-                         art::PtrRemapper const& remap);
+                         REMAP const& remap);
 
+    template<class REMAP>
     bool mixSimParticles(std::vector<SimParticleCollection const*> const& in,
                          SimParticleCollection& out,
-                         art::PtrRemapper const& remap);
+                         REMAP const& remap);
 
+    template<class REMAP>
     bool mixStepPointMCs(std::vector<StepPointMCCollection const*> const& in,
                          StepPointMCCollection& out,
-                         art::PtrRemapper const& remap);
+                         REMAP const& remap);
 
+    template<class REMAP>
     bool mixMCTrajectories(std::vector<MCTrajectoryCollection const*> const& in,
                            MCTrajectoryCollection& out,
-                           art::PtrRemapper const& remap);
+                           REMAP const& remap);
 
+    template<class REMAP>
     bool mixCaloShowerSteps(std::vector<CaloShowerStepCollection const*> const& in,
                             CaloShowerStepCollection& out,
-                            art::PtrRemapper const& remap);
+                            REMAP const& remap);
 
+    template<class REMAP>
     bool mixStrawGasSteps(std::vector<StrawGasStepCollection const*> const& in,
                             StrawGasStepCollection& out,
-                            art::PtrRemapper const& remap);
+                            REMAP const& remap);
 
+    template<class REMAP>
     bool mixCrvSteps(std::vector<CrvStepCollection const*> const& in,
                             CrvStepCollection& out,
-                            art::PtrRemapper const& remap);
+                            REMAP const& remap);
 
+    template<class REMAP>
     bool mixExtMonSimHits(std::vector<ExtMonFNALSimHitCollection const*> const& in,
                           ExtMonFNALSimHitCollection& out,
-                          art::PtrRemapper const& remap);
+                          REMAP const& remap);
 
+    template<class REMAP>
     bool mixCosmicLivetime(std::vector<mu2e::CosmicLivetime const*> const &in,
                                  mu2e::CosmicLivetime& out,
-                                 art::PtrRemapper const& remap);
+                                 REMAP const& remap);
 
+    template<class REMAP>
     bool mixEventIDs(std::vector<art::EventIDSequence const*> const &in,
                      art::EventIDSequence& out,
-                     art::PtrRemapper const& remap);
+                     REMAP const& remap);
 
 
     //----------------
@@ -165,7 +202,8 @@ namespace mu2e {
     typedef GenParticleCollection::size_type GenOffset;
     std::vector<GenOffset> genOffsets_;
 
-    void updateSimParticle(SimParticle& particle, SPOffset offset, art::PtrRemapper const& remap);
+    template<class REMAP>
+    void updateSimParticle(SimParticle& particle, SPOffset offset, REMAP const& remap);
 
     typedef std::map<cet::map_vector_key,PhysicalVolumeInfo> VolumeMap;
     typedef std::vector<VolumeMap> MultiStageMap;
@@ -180,8 +218,49 @@ namespace mu2e {
 
     void addInfo(VolumeMap* map, const PhysicalVolumeInfoSingleStage::value_type& entry);
 
+    //----------------
+    // The frame pool: for each entry of each mixingMap, one collection
+    // per frame, indexed by the order of declaration of the entries
+    template<class T> using PoolSlots = std::vector<std::vector<T> >;
+    typedef std::tuple<PoolSlots<GenParticleCollection>,
+                       PoolSlots<SimParticleCollection>,
+                       PoolSlots<StepPointMCCollection>,
+                       PoolSlots<MCTrajectoryCollection>,
+                       PoolSlots<CaloShowerStepCollection>,
+                       PoolSlots<StrawGasStepCollection>,
+                       PoolSlots<CrvStepCollection>,
+                       PoolSlots<ExtMonFNALSimHitCollection>,
+                       PoolSlots<CosmicLivetime>,
+                       PoolSlots<art::EventIDSequence> > FramePool;
+    FramePool pool_;
+    std::size_t poolSize_;
+    bool poolFilled_;
+    art::EventIDSequence poolEventIDs_;
+    PhysicalVolumeInfoMultiCollection poolVolumes_;
+    // the frames mixed in this event
+    std::vector<std::size_t> sampled_;
+    art::Event const* event_;
+
+    // declare the mixing of one entry of a mixingMap, through the pool if it is used
+    template<class T, class MIX>
+    void declareMixOp(art::MixHelper& helper, CollectionMixerConfig::Entry const& e, MIX mix);
+
   };
 
+  //----------------------------------------------------------------
+  template<class URBG>
+  std::size_t Mu2eProductMixer::nSecondaries(std::size_t nMix, URBG& urbg) {
+    if(poolSize_ == 0) {
+      return nMix;
+    }
+    sampled_.clear();
+    std::uniform_int_distribution<std::size_t> frame(0, poolSize_-1);
+    for(std::size_t i=0; i<nMix; ++i) {
+      sampled_.push_back(frame(urbg));
+    }
+    return poolFilled_ ? 0 : poolSize_;
+  }
+
 }
 
 #endif/*EventMixing_inc_Mu2eProductMixing_hh*/
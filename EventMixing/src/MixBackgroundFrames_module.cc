@@ -213,7 +213,7 @@ namespace mu2e {
     std::poisson_distribution<size_t> poisson(mean);
     auto res = poisson(urbg_);
     if(debugLevel_ > 0)std::cout << " Mixing " << res  << " Secondaries " << std::endl;
-    return res;
+    return spm_.nSecondaries(res, urbg_);
   }
 
   //================================================================
@@ -235,7 +235,9 @@ namespace mu2e {
   }
 
   //================================================================
-  void MixBackgroundFramesDetail::processEventIDs(art::EventIDSequence const& seq) {
+  void MixBackgroundFramesDetail::processEventIDs(art::EventIDSequence const& readSeq) {
+    // with a frame pool, the events mixed are not the events read
+    const art::EventIDSequence seq = spm_.mixedEventIDs(readSeq);
     if(writeEventIDs_) {
       idseq_ = seq;
     }
@@ -38,6 +38,34 @@ namespace mu2e {
       }
       return std::distance(offsets.begin(), --ub);
     }
+
+    // Ptrs of the pooled frames were remapped to the output products
+    // when the pool was filled; for each event they only need the key
+    // offset and the product getter of the event.
+    class PoolRemapper {
+    public:
+      explicit PoolRemapper(art::Event const& e): event_(e) {}
+      template<typename T, typename OFFSET>
+      art::Ptr<T> operator()(art::Ptr<T> const& p, OFFSET offset) const {
+        if(p.isNull()) return p;
+        return art::Ptr<T>(p.id(), p.key()+offset, event_.productGetter(p.id()));
+      }
+    private:
+      art::Event const& event_;
+    };
+
+    // Filling the pool, each frame on its own: the Ptrs are remapped
+    // to the output products with their keys in the frame
+    class FrameRemapper {
+    public:
+      explicit FrameRemapper(art::PtrRemapper const& remap): remap_(remap) {}
+      template<typename T, typename OFFSET>
+      art::Ptr<T> operator()(art::Ptr<T> const& p, OFFSET) const {
+        return remap_(p, 0);
+      }
+    private:
+      art::PtrRemapper const& remap_;
+    };
   }
 
   //----------------------------------------------------------------
@@ -46,56 +74,59 @@ namespace mu2e {
       , applyTimeOffset_{! conf.simTimeOffset().empty() }
       , timeOffsetTag_{ conf.simTimeOffset() }
       , stoff_(0.0)
+      , poolSize_{ conf.framePoolSize() }
+      , poolFilled_(false)
+      , event_(nullptr)
   {
 
     for(const auto& e: conf.genParticleMixer().mixingMap()) {
-      helper.declareMixOp
-	(e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixGenParticles, *this);
+      declareMixOp<GenParticleCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixGenParticles(in, out, remap); });
     }
 
     for(const auto& e: conf.simParticleMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixSimParticles, *this);
+      declareMixOp<SimParticleCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixSimParticles(in, out, remap); });
     }
 
     for(const auto& e: conf.stepPointMCMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixStepPointMCs, *this);
+      declareMixOp<StepPointMCCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixStepPointMCs(in, out, remap); });
     }
 
     for(const auto& e: conf.mcTrajectoryMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixMCTrajectories, *this);
+      declareMixOp<MCTrajectoryCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixMCTrajectories(in, out, remap); });
     }
 
     for(const auto& e: conf.caloShowerStepMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCaloShowerSteps, *this);
+      declareMixOp<CaloShowerStepCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixCaloShowerSteps(in, out, remap); });
     }
 
     for(const auto& e: conf.strawGasStepMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixStrawGasSteps, *this);
+      declareMixOp<StrawGasStepCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixStrawGasSteps(in, out, remap); });
     }
 
     for(const auto& e: conf.crvStepMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCrvSteps, *this);
+      declareMixOp<CrvStepCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixCrvSteps(in, out, remap); });
     }
 
     for(const auto& e: conf.extMonSimHitMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixExtMonSimHits, *this);
+      declareMixOp<ExtMonFNALSimHitCollection>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixExtMonSimHits(in, out, remap); });
     }
 
     for(const auto& e: conf.cosmicLivetimeMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCosmicLivetime, *this);
+      declareMixOp<CosmicLivetime>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixCosmicLivetime(in, out, remap); });
     }
 
     for(const auto& e: conf.eventIDMixer().mixingMap()) {
-      helper.declareMixOp
-        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixEventIDs, *this);
+      declareMixOp<art::EventIDSequence>(helper, e, [this](auto const& in, auto& out, auto const& remap) {
+          return mixEventIDs(in, out, remap); });
     }
 
     //----------------------------------------------------------------
@@ -118,13 +149,100 @@ namespace mu2e {
 
       const bool putVolsIntoEvent{evtVolInstanceName_};
       std::string evtOutInstance = putVolsIntoEvent ? *evtVolInstanceName_ : "unused";
-      helper.declareMixOp<art::InSubRun>
-        (volumesInput_, evtOutInstance, &Mu2eProductMixer::mixVolumeInfos, *this, putVolsIntoEvent);
+      if(poolSize_ == 0) {
+        helper.declareMixOp<art::InSubRun>
+          (volumesInput_, evtOutInstance, &Mu2eProductMixer::mixVolumeInfos, *this, putVolsIntoEvent);
+      }
+      else {
+        // all the volumes of the pool go into each event and subrun
+        helper.declareMixOp<art::InSubRun>
+          (volumesInput_, evtOutInstance,
+           art::MixFunc<PhysicalVolumeInfoMultiCollection>
+           ([this](std::vector<PhysicalVolumeInfoMultiCollection const*> const& in,
+                   PhysicalVolumeInfoMultiCollection& out,
+                   art::PtrRemapper const& remap) {
+             if(!in.empty()) {
+               mixVolumeInfos(in, poolVolumes_, remap);
+             }
+             std::vector<PhysicalVolumeInfoMultiCollection const*> pooled;
+             if(!poolVolumes_.empty()) {
+               pooled.push_back(&poolVolumes_);
+             }
+             return mixVolumeInfos(pooled, out, remap);
+           }),
+           putVolsIntoEvent);
+      }
     }
     //----------------------------------------------------------------
   }
 
+  //----------------------------------------------------------------
+  template<class T, class MIX>
+  void Mu2eProductMixer::declareMixOp(art::MixHelper& helper,
+                                      CollectionMixerConfig::Entry const& e,
+                                      MIX mix)
+  {
+    if(poolSize_ == 0) {
+      helper.declareMixOp
+        (e.inTag, e.resolvedInstanceName(),
+         art::MixFunc<T>([mix](std::vector<T const*> const& in, T& out, art::PtrRemapper const& remap) {
+             return mix(in, out, remap);
+           }));
+      return;
+    }
+
+    auto& slots = std::get<PoolSlots<T> >(pool_);
+    const auto slot = slots.size();
+    slots.emplace_back();
+    helper.declareMixOp
+      (e.inTag, e.resolvedInstanceName(),
+       art::MixFunc<T>([this, slot, mix](std::vector<T const*> const& in, T& out, art::PtrRemapper const& remap) {
+           auto& frames = std::get<PoolSlots<T> >(pool_)[slot];
+           if(!in.empty()) {
+             // the event which fills the pool: the time offset is
+             // applied when the frames are mixed, not here
+             const SimTimeOffset stoff = stoff_;
+             stoff_ = SimTimeOffset(0.0);
+             frames.resize(in.size());
+             for(std::size_t i=0; i<in.size(); ++i) {
+               mix(std::vector<T const*>{in[i]}, frames[i], FrameRemapper(remap));
+             }
+             stoff_ = stoff;
+           }
+           if(sampled_.empty()) {
+             return true;
+           }
+           std::vector<T const*> sampled;
+           sampled.reserve(sampled_.size());
+           for(auto i: sampled_) {
+             sampled.push_back(&frames.at(i));
+           }
+           return mix(sampled, out, PoolRemapper(*event_));
+         }));
+  }
+
+  //----------------------------------------------------------------
+  art::EventIDSequence Mu2eProductMixer::mixedEventIDs(art::EventIDSequence const& seq) {
+    if(poolSize_ == 0) {
+      return seq;
+    }
+    if(!seq.empty()) {
+      poolEventIDs_ = seq;
+    }
+    art::EventIDSequence ids;
+    ids.reserve(sampled_.size());
+    for(auto i: sampled_) {
+      ids.push_back(poolEventIDs_.at(i));
+    }
+    return ids;
+  }
+
   void Mu2eProductMixer::startEvent(art::Event const& e) {
+    // the pool was filled by the previous event
+    if(poolSize_ > 0 && event_ != nullptr) {
+      poolFilled_ = true;
+    }
+    event_ = &e;
     if(applyTimeOffset_){
     // find the time offset in the event, and copy it locally
       const auto& stoH = e.getValidHandle<SimTimeOffset>(timeOffsetTag_);
@@ -153,9 +271,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixGenParticles(std::vector<GenParticleCollection const*> const& in,
                                          GenParticleCollection& out,
-                                         art::PtrRemapper const& remap)
+                                         REMAP const& remap)
   {
     art::flattenCollections(in, out, genOffsets_);
     if(applyTimeOffset_){
@@ -170,9 +289,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixSimParticles(std::vector<SimParticleCollection const*> const& in,
                                          SimParticleCollection& out,
-                                         art::PtrRemapper const& remap)
+                                         REMAP const& remap)
   {
     art::flattenCollections(in, out, simOffsets_ );
 
@@ -188,9 +308,10 @@ namespace mu2e {
 
   //----------------
   // Update one SimParticle to deal with the flattening of the SimParticleCollections.
+  template<class REMAP>
   void Mu2eProductMixer::updateSimParticle(mu2e::SimParticle& sim,
                                            SPOffsets::size_type inputEventIndex,
-                                           art::PtrRemapper const& remap
+                                           REMAP const& remap
                                            )
   {
     auto simOffset = simOffsets_[inputEventIndex];
@@ -222,9 +343,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixStepPointMCs(std::vector<StepPointMCCollection const*> const& in,
                                          StepPointMCCollection& out,
-                                         art::PtrRemapper const& remap)
+                                         REMAP const& remap)
   {
     std::vector<StepPointMCCollection::size_type> stepOffsets;
     art::flattenCollections(in, out, stepOffsets);
@@ -241,9 +363,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixMCTrajectories(std::vector<MCTrajectoryCollection const*> const& in,
                                            MCTrajectoryCollection& out,
-                                           art::PtrRemapper const& remap)
+                                           REMAP const& remap)
   {
     // flattenCollections() does not seem to preserve enough info to remap ptrs in the output map.
     // Follow the pattern, including the nullptr checks, but add custom remapping code
@@ -276,9 +399,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixCaloShowerSteps(std::vector<CaloShowerStepCollection const*> const& in,
                                             CaloShowerStepCollection& out,
-                                            art::PtrRemapper const& remap)
+                                            REMAP const& remap)
   {
     std::vector<CaloShowerStepCollection::size_type> stepOffsets;
     art::flattenCollections(in, out, stepOffsets);
@@ -293,9 +417,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixStrawGasSteps(std::vector<StrawGasStepCollection const*> const& in,
                                           StrawGasStepCollection& out,
-                                          art::PtrRemapper const& remap)
+                                          REMAP const& remap)
   {
     std::vector<StrawGasStepCollection::size_type> stepOffsets;
     art::flattenCollections(in, out, stepOffsets);
@@ -309,9 +434,10 @@ namespace mu2e {
     return true;
   }
 
+  template<class REMAP>
   bool Mu2eProductMixer::mixCrvSteps(std::vector<CrvStepCollection const*> const& in,
                                           CrvStepCollection& out,
-                                          art::PtrRemapper const& remap)
+                                          REMAP const& remap)
   {
     std::vector<CrvStepCollection::size_type> stepOffsets;
     art::flattenCollections(in, out, stepOffsets);
@@ -326,9 +452,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixExtMonSimHits(std::vector<ExtMonFNALSimHitCollection const*> const& in,
                                           ExtMonFNALSimHitCollection& out,
-                                          art::PtrRemapper const& remap)
+                                          REMAP const& remap)
   {
     std::vector<ExtMonFNALSimHitCollection::size_type> stepOffsets;
     art::flattenCollections(in, out, stepOffsets);
@@ -343,9 +470,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixCosmicLivetime(std::vector<CosmicLivetime const*> const& in,
                                                  CosmicLivetime& out,
-                                                 art::PtrRemapper const& remap)
+                                                 REMAP const& remap)
   {
     if(in.size() > 1)
       throw cet::exception("BADINPUT")<<"Mu2eProductMixer/evt: can't mix CosmicLiveTime" << std::endl; 
@@ -357,9 +485,10 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  template<class REMAP>
   bool Mu2eProductMixer::mixEventIDs(std::vector<art::EventIDSequence const*> const &in,
                                      art::EventIDSequence& out,
-                                     art::PtrRemapper const&)
+                                     REMAP const&)
   {
     art::flattenCollections(in, out);
     return true;
@@ -86,7 +86,7 @@ namespace mu2e {
       }
       return result;
     }
-    size_t nSecondaries() const { return (size_t) 1; }
+    size_t nSecondaries() { return spm_.nSecondaries(1, urbg_); }
 
     void processEventIDs(const art::EventIDSequence& seq);
 
@@ -112,7 +112,7 @@ namespace mu2e {
 
   void ResamplingMixerDetail::processEventIDs(const art::EventIDSequence& seq) {
     if(writeEventIDs_) {
-      idseq_ = seq;
+      idseq_ = spm_.mixedEventIDs(seq);
     }
   }
 
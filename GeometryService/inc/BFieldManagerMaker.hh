@@ -41,6 +41,9 @@ namespace mu2e {
         // Hold the object while we are creating it. The GeometryService will take ownership.
         std::unique_ptr<BFieldManager> _bfmgr;
 
+        // Check the payload checksum of memory mapped maps.
+        bool _verifyMapChecksum;
+
         // Hold the types of the inner and outer maps (if they differ)
         std::vector<BFMapType> _innerTypes;
         std::vector<BFMapType> _outerTypes;
@@ -84,6 +87,13 @@ namespace mu2e {
         // Read a G4BL map that was stored using writeG4BLBinary.
         void readG4BLBinary(const std::string& headerFilename, BFGridMap& bfmap);
 
+        // Create a magnetic field map that uses a memory mapped .bfmap file in place.
+        void loadMapped(BFieldManager::MapContainerType* whichMap,
+                        const std::string& key,
+                        const std::string& resolvedFileName,
+                        double scaleFactor,
+                        BFInterpolationStyle interpStyle);
+
         // Read a CSV with values for parametric map.
         void readParamFile(const std::string& filename, BFParamMap& bfmap);
 
@@ -45,6 +45,11 @@ namespace mu2e {
         bfconf_->writeBinaries_ = config.getBool("bfield.writeG4BLBinaries", false);
         bfconf_->verbosityLevel_ = config.getInt("bfield.verbosityLevel");
         bfconf_->flipBFieldMaps_ = config.getBool("bfield.flipMaps", false);
+        bfconf_->batchGrid_ = config.getBool("bfield.batchGrid", false);
+        bfconf_->batchFloat_ = config.getBool("bfield.batchFloat", false);
+        bfconf_->writeMappedMaps_ = config.getBool("bfield.writeMappedMaps", false);
+        bfconf_->verifyMapChecksum_ = config.getBool("bfield.verifyMapChecksum", false);
+        bfconf_->compiledFloat_ = config.getBool("bfield.compiledFloat", false);
 
         bfconf_->scaleFactor_ = config.getDouble("bfield.scaleFactor", 1.0);
 
@@ -84,7 +89,8 @@ namespace mu2e {
             }
         }
 
-        if (format == "GMC" && style != BFInterpolationStyle::meco) {
+        if (format == "GMC" && style != BFInterpolationStyle::meco &&
+            style != BFInterpolationStyle::mecoCompiled) {
             throw cet::exception("GEOM")
                 << "The GMC magnetic field model must use the meco style interpolation: "
                 << " The specified interpolation style is " << bfconf_->interpolationStyle()
@@ -30,6 +30,7 @@
 
 // Includes from Mu2e
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/BFieldConfig.hh"
 #include "BFieldGeom/inc/BFieldManager.hh"
 #include "BFieldGeom/inc/DiskRecord.hh"
@@ -81,7 +82,9 @@ namespace mu2e {
     }
 
     BFieldManagerMaker::BFieldManagerMaker(const BFieldConfig& config)
-        : _resolveFullPath(), _bfmgr(new BFieldManager()) {
+        : _resolveFullPath(),
+          _bfmgr(new BFieldManager()),
+          _verifyMapChecksum(config.verifyMapChecksum()) {
         bfieldVerbosityLevel = config.verbosityLevel();
 
         // break potential mapTypeList into two vectors... kind of ugly right now.
@@ -121,8 +124,8 @@ namespace mu2e {
                 << "Unknown format of file with magnetic field maps: " << config.mapType() << "\n";
         }
 
-        _bfmgr->cm_.setMaps((const MapContainerType&)_bfmgr->innerMaps_,
-                            (const MapContainerType&)_bfmgr->outerMaps_);
+        _bfmgr->index_ = std::make_shared<BFMapIndex>((const MapContainerType&)_bfmgr->innerMaps_,
+                                                      (const MapContainerType&)_bfmgr->outerMaps_);
 
         // The field manager is fully initialized.
         // Some extra stuff that is convenient to do here:
@@ -138,6 +141,19 @@ namespace mu2e {
             }
         }
 
+        // Make the component separated grids for the batch interface (copies only on
+        // request, they double the memory of the maps), and the coefficients for the
+        // compiled interpolation styles.
+        // This must follow flipMap.
+        for (auto const* maps : {&_bfmgr->getInnerMaps(), &_bfmgr->getOuterMaps()}) {
+            for (auto const& m : *maps) {
+                if (auto grid = std::dynamic_pointer_cast<BFGridMap>(m)) {
+                    grid->fillSoA(config.batchFloat(), config.batchGrid());
+                    grid->compile(config.compiledFloat());
+                }
+            }
+        }
+
         if (config.writeBinaries()) {
             for (BFieldManager::MapContainerType::const_iterator i = _bfmgr->getInnerMaps().begin();
                  i != _bfmgr->getInnerMaps().end(); ++i) {
@@ -150,6 +166,17 @@ namespace mu2e {
             }
         }
 
+        if (config.writeMappedMaps()) {
+            for (auto const* maps : {&_bfmgr->getInnerMaps(), &_bfmgr->getOuterMaps()}) {
+                for (auto const& m : *maps) {
+                    if (auto grid = std::dynamic_pointer_cast<BFGridMap>(m)) {
+                        BFMapFile::write(*grid, grid->getKey() + ".bfmap", grid->getKey(),
+                                         config.batchFloat(), !config.batchFloat());
+                    }
+                }
+            }
+        }
+
         // For debug purposes: print the field in the target region
         if (bfieldVerbosityLevel > 0) {
             CLHEP::Hep3Vector b = _bfmgr->getBField(CLHEP::Hep3Vector(3900.0, 0.0, -6550.0));
@@ -404,6 +431,12 @@ namespace mu2e {
                                       const std::string& resolvedFileName,
                                       double scaleFactor,
                                       BFInterpolationStyle interpStyle) {
+        if (resolvedFileName.size() > 6 &&
+            resolvedFileName.compare(resolvedFileName.size() - 6, 6, ".bfmap") == 0) {
+            loadMapped(mapContainer, key, resolvedFileName, scaleFactor, interpStyle);
+            return;
+        }
+
         // Extract information from the header.
         vector<double> X0;
         vector<int> dim;
@@ -797,6 +830,34 @@ namespace mu2e {
 
     }  // end BFieldManagerMaker::readG4BLBinary
 
+    // The grid geometry, map type and symmetry come from the header of the file;
+    // the field values are not copied.
+    void BFieldManagerMaker::loadMapped(BFieldManager::MapContainerType* mapContainer,
+                                        const std::string& key,
+                                        const std::string& resolvedFileName,
+                                        double scaleFactor,
+                                        BFInterpolationStyle interpStyle) {
+        auto file = std::make_shared<const BFMapFile>(resolvedFileName, _verifyMapChecksum);
+        BFMapFileHeader const& h = file->header();
+
+        BFMapType::enum_type type = BFMapType::enum_type(h.mapType);
+        if (!BFMapType::isValid(type)) {
+            throw cet::exception("GEOM") << "BFieldManagerMaker:loadMapped unknown map type "
+                                         << h.mapType << " in " << resolvedFileName << "\n";
+        }
+
+        auto dsmap =
+            _bfmgr->addBFGridMap(mapContainer, key, h.nx, h.xmin, h.dx, h.ny, h.ymin, h.dy, h.nz,
+                                 h.zmin, h.dz, type, scaleFactor * h.scale, interpStyle);
+        dsmap->_flipy = file->flag(BFMapFileHeader::flipy);
+        dsmap->attach(file);
+
+        if (bfieldVerbosityLevel > 1) {
+            std::cout << "BFieldManagerMaker: memory mapped " << resolvedFileName << ", made from "
+                      << h.source << std::endl;
+        }
+    }
+
     //
     // Read one magnetic field parameter csv.
     //
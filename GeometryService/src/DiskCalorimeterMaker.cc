@@ -348,6 +348,8 @@ namespace mu2e {
             }
         }
 
+        //precompute the position lookup grids and the neighbor tables once all crystals are placed
+        calo_->lookup_.build(calo_->disks_, calo_->fullCrystalList_, calo_->geomUtil_);
 
 
     }
@@ -1,6 +1,12 @@
 #ifndef MCDataProducts_CaloShowerROStep_hh
 #define MCDataProducts_CaloShowerROStep_hh
-
+//
+// Photo-electrons seen by one readout from one CaloShowerStep.
+//
+// The PEs are stored either individually, with their times in PETime(), or in compact form as the 
+// number of PEs in consecutive time bins of width PEBinWidth(): bin i covers the times
+// [(PEFirstBin()+i)*PEBinWidth(), (PEFirstBin()+i+1)*PEBinWidth()). isBinned() tells which.
+//
 #include "MCDataProducts/inc/CaloShowerStep.hh"
 #include <vector>
 
@@ -10,16 +16,27 @@ namespace mu2e {
    class CaloShowerRO 
    {
        public:
-          CaloShowerRO(): SiPMID_(-1),step_() {}
+          CaloShowerRO(): SiPMID_(-1),step_(),PETime_(),PEBinWidth_(0),PEFirstBin_(0),PECounts_(),NPE_(0) {}
           
           CaloShowerRO(int SiPMID, const art::Ptr<CaloShowerStep>& step, const std::vector<float>& PETime) : 
-             SiPMID_(SiPMID),step_(step),PETime_(PETime) 
+             SiPMID_(SiPMID),step_(step),PETime_(PETime),PEBinWidth_(0),PEFirstBin_(0),PECounts_(),NPE_(0) 
+          {}
+
+          CaloShowerRO(int SiPMID, const art::Ptr<CaloShowerStep>& step, float PEBinWidth, int PEFirstBin, 
+                       const std::vector<unsigned>& PECounts, unsigned NPE) : 
+             SiPMID_(SiPMID),step_(step),PETime_(),PEBinWidth_(PEBinWidth),PEFirstBin_(PEFirstBin),PECounts_(PECounts),NPE_(NPE) 
           {}
 
           const art::Ptr<CaloShowerStep>&   caloShowerStep()  const {return step_;}
-          const std::vector<float>          PETime()          const {return PETime_;}
+          const std::vector<float>&         PETime()          const {return PETime_;}
           int                               SiPMID()          const {return SiPMID_;}
-          unsigned                          NPE()             const {return PETime_.size();}
+          unsigned                          NPE()             const {return isBinned() ? NPE_ : PETime_.size();}
+          
+          bool                              isBinned()        const {return PEBinWidth_ > 0;}
+          float                             PEBinWidth()      const {return PEBinWidth_;}
+          int                               PEFirstBin()      const {return PEFirstBin_;}
+          const std::vector<unsigned>&      PECounts()        const {return PECounts_;}
+          float                             PEBinTime(unsigned i) const {return (PEFirstBin_+int(i)+0.5f)*PEBinWidth_;}
           
           void setCaloShowerStep(const art::Ptr<CaloShowerStep>& step) {step_ = step;}
        
@@ -27,6 +44,10 @@ namespace mu2e {
           int                       SiPMID_;      
           art::Ptr<CaloShowerStep>  step_;
           std::vector<float>        PETime_;          
+          float                     PEBinWidth_;
+          int                       PEFirstBin_;
+          std::vector<unsigned>     PECounts_;
+          unsigned                  NPE_;
    };
 
    using CaloShowerROCollection = std::vector<mu2e::CaloShowerRO>;
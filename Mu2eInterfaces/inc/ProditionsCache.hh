@@ -6,12 +6,26 @@
 #include <set>
 #include <shared_mutex>
 #include <mutex>
+#include <atomic>
+#include <vector>
 #include <chrono>
 
 #include "canvas/Persistency/Provenance/EventID.h"
 #include "DbTables/inc/DbIoV.hh"
 #include "Mu2eInterfaces/inc/ProditionsEntity.hh"
 
+//
+// The entities which were made or found are also published, with
+// their interval of validity, in a short immutable list (an epoch).
+// A new epoch replaces the list each time an entity is published,
+// and update first looks in the current epoch, without a lock and
+// without the virtual calls, so only the first request for each
+// interval of validity goes through makeSet and the locked search.
+// The readers in an epoch are counted, and the epochs replaced are
+// deleted at the next publish when no reader is counted: a reader
+// which starts after the replacement only sees the new epoch.
+//
+
 namespace mu2e {
   class ProditionsCache {
 
@@ -31,7 +45,9 @@ namespace mu2e {
     typedef ProditionsEntity::set_t set_t;
 
     ProditionsCache(std::string name, int verbose=0):
-      _name(name),_verbose(verbose),_initialized(false) {}
+      _lockWaitTime(0),_lockTime(0),
+      _name(name),_verbose(verbose),_initialized(false),_epoch(nullptr),
+      _readers(0) {}
     virtual ~ProditionsCache() {}
 
     // the following are provided by the 
@@ -52,8 +68,17 @@ namespace mu2e {
     // this is the main call to the cache asking for an existing
     // entity, creating and cacheing a new entity as needed
     ret_t update(art::EventID const& eid) {
-      // do lazy initialization, don't bother with 
-      // read lock since a bool can't be partially constructed
+      // the entity may already be published for this run and subrun
+      ProditionsEntity::ptr p;
+      DbIoV iov;
+      if(findPublished(eid.run(),eid.subRun(),p,iov)) {
+	if(_verbose>1) {
+	  std::cout<< "ProditionsCache::update return published "<< name() << std::endl;
+	}
+	return std::make_tuple(p,iov);
+      }
+
+      // do lazy initialization
       if(!_initialized) {
 	//gain write lock
 	auto stime = std::chrono::high_resolution_clock::now();
@@ -75,25 +100,14 @@ namespace mu2e {
 	_lockTime += dt;  // time we spent write locked
       } // end initialize, write lock out of scope, released
 
-      // gain shared read lock to find what 
-      // set of tables are needed
+      // this is the first request for this interval of validity:
+      // find the set of tables needed, and the entity made from
+      // them, or make it.  makeSet and makeIov use the handles of
+      // the derived class, which are not safe to call from several
+      // threads at once, so this is all done under the write lock
       bool made = false;
       set_t cids;
-      ProditionsEntity::ptr p;
-      DbIoV iov;
-      { // start read lock scope
-	std::shared_lock lock(_mutex);
-	// get the set of nubers that identifies the data
-	cids = makeSet(eid);
-	// look for it in the cache
-	p = find(cids);
-	if(p) { // also grab the iov while under this read lock
-	  iov = makeIov(eid);
-	}
-      } // end read lock lifetime
-      
-      // if it was not found in cache, make it
-      if(!p) {
+      {
 	//gain write lock
 	auto stime = std::chrono::high_resolution_clock::now();
 	std::unique_lock lock(_mutex); // write lock
@@ -101,8 +115,9 @@ namespace mu2e {
 	auto dt = std::chrono::duration_cast<std::chrono::microseconds>
                                                ( mtime - stime );
 	 _lockWaitTime += dt;
-	 // need to check again in case another thread made it
-	 // between read lock and write lock
+	 // get the set of numbers that identifies the data
+	 cids = makeSet(eid);
+	 // look for it in the cache
 	 p = find(cids);
 	 if(!p) {
 	   p = makeEntity(eid); // make the data entity
@@ -117,7 +132,10 @@ namespace mu2e {
                                                ( etime - mtime );
 	_lockTime += dt;  // time we spent write locked
 
-      } // endif not in cache, write lock now destroyed
+      } // write lock now destroyed
+
+      // later requests in this interval will find it without a lock
+      if(iov.inInterval(eid.run(),eid.subRun())) publish(p,iov);
       
       if(_verbose>1) {
 	if(made) {
@@ -131,6 +149,25 @@ namespace mu2e {
 
     } // end update
 
+    // make, or find, the entity for this event and the following
+    // interval of validity in the same run, so they are ready before
+    // the events ask for them.  This can be called from a thread
+    // outside the event loop, at the start of a subrun.
+    void prefetch(art::EventID const& eid) {
+      ProditionsEntity::ptr p;
+      DbIoV iov;
+      std::tie(p,iov) = update(eid);
+      if(iov.endRun()!=eid.run() || iov.endSubrun()>=iov.maxSubrun()) return;
+      update(art::EventID(eid.run(),iov.endSubrun()+1,0));
+    }
+
+    // number of entities published so far, for monitoring
+    uint64_t epoch() const {
+      ReaderCount rc(_readers);
+      const Epoch* e = _epoch.load();
+      return e ? e->number : 0;
+    }
+
     // put this object, with dependent set of CID's, in the cache
     void push(ProditionsEntity::ptr const& p) {
       _cache.emplace_back(p);
@@ -146,10 +183,76 @@ namespace mu2e {
     }
     
   private:
+
+    // an immutable list of published entities, most recent first
+    struct Published {
+      DbIoV iov;
+      ProditionsEntity::ptr ptr;
+    };
+    struct Epoch {
+      uint64_t number;
+      std::vector<Published> entries;
+    };
+    // entities in one epoch, older ones are still in _cache
+    static constexpr std::size_t epochSize = 16;
+
+    // counts a reader of the epoch while in scope.  The counter and
+    // _epoch use sequentially consistent operations, so if publish
+    // sees no reader, any later reader loads the new epoch
+    struct ReaderCount {
+      explicit ReaderCount(std::atomic<unsigned>& n):_n(n) { _n.fetch_add(1); }
+      ~ReaderCount() { _n.fetch_sub(1); }
+      std::atomic<unsigned>& _n;
+    };
+
+    bool findPublished(uint32_t run, uint32_t subrun,
+		       ProditionsEntity::ptr& p, DbIoV& iov) const {
+      ReaderCount rc(_readers);
+      const Epoch* e = _epoch.load();
+      if(!e) return false;
+      for(auto const& ee : e->entries) {
+	if(ee.iov.inInterval(run,subrun)) {
+	  p = ee.ptr;
+	  iov = ee.iov;
+	  return true;
+	}
+      }
+      return false;
+    }
+
+    // replace the epoch with one starting with this entity
+    void publish(ProditionsEntity::ptr const& p, DbIoV const& iov) {
+      std::lock_guard lock(_publishMutex);
+      const Epoch* old = _epoch.load(std::memory_order_relaxed);
+      auto e = std::make_unique<Epoch>();
+      e->number = (old ? old->number+1 : 1);
+      e->entries.push_back({iov,p});
+      if(old) {
+	for(auto const& ee : old->entries) {
+	  if(e->entries.size()>=epochSize) break;
+	  // drop the entity if it was published with this interval
+	  if(ee.ptr==p && ee.iov.startRun()==iov.startRun()
+	     && ee.iov.startSubrun()==iov.startSubrun()) continue;
+	  e->entries.push_back(ee);
+	}
+      }
+      _epoch.store(e.get());
+      if(_current) _retired.emplace_back(std::move(_current));
+      _current = std::move(e);
+      // the replaced epochs can only be seen by the readers counted now
+      if(_readers.load()==0) _retired.clear();
+    }
+
     std::string _name;
     int _verbose;
-    bool _initialized;
+    std::atomic<bool> _initialized;
     std::vector<ProditionsEntity::ptr> _cache;
+    std::atomic<const Epoch*> _epoch;
+    mutable std::atomic<unsigned> _readers;
+    // the current epoch, and the replaced ones which may still be read
+    std::unique_ptr<const Epoch> _current;
+    std::vector<std::unique_ptr<const Epoch> > _retired;
+    std::mutex _publishMutex;
 
   };
 
@@ -16,19 +16,25 @@ namespace mu2e
     public:
       using Grad = ROOT::Math::SMatrix<double,3>; // field gradient: ie dBi/d(x,y,z)
     // construct from BField object and system translator.  
-    // This should be a single BField map valid in the detector system, to avoid making continuous translations FIXME!
-      KKBField(BFieldManager const& bfmgr, DetectorSystem const& det) : bfmgr_(bfmgr), det_(det) {}
+    // The detector system is a translation of the Mu2e system, so positions are converted by adding
+    // its origin, held here; the field and its gradient are the same in both systems.
+    // Each instance owns its own map lookup cache: use one instance per thread (or per fit)
+      KKBField(BFieldManager const& bfmgr, DetectorSystem const& det) : bfmgr_(bfmgr), origin_(det.getOrigin()), cm_(bfmgr.cacheManager()) {}
       virtual ~KKBField() {}
       // KinKal BField interface
       // return value of the field at a poin
       virtual VEC3 fieldVect(VEC3 const& position) const override;
-      // return BFieldMap gradient = dB_i/dx_j, at a given point
+      // return BFieldMap gradient: row j is dB/dx_j, at a given point.  From the interpolating polynomial
+      // of the map, one lookup
       virtual Grad fieldGrad(VEC3 const& position) const override;
       // return the BFieldMap derivative at a given point along a given velocity, WRT time
       virtual VEC3 fieldDeriv(VEC3 const& position, VEC3 const& velocity) const override;
     private:
+      // field and gradient at a point in detector coordinates
+      void fieldAndGrad(VEC3 const& position, CLHEP::Hep3Vector& field, CLHEP::Hep3Vector dBdx[3]) const;
       BFieldManager const& bfmgr_;
-      DetectorSystem const& det_;
+      CLHEP::Hep3Vector origin_; // detector system origin in mu2e coordinates
+      BFCacheManager cm_; // map lookup cache for this instance
   };
 }
 #endif
@@ -90,6 +90,8 @@ namespace mu2e {
       PDGCode::type fitParticle() const { return tpart_;}
       TrkFitDirection fitDirection() const { return tdir_;}
       bool addMaterial() const { return addmat_; }
+      // fill the cached tracker info used by addStraws.  Call this before fitting tracks concurrently
+      void prepare(Tracker const& tracker) const { if(addmat_ && needstrackerinfo_)fillTrackerInfo(tracker); }
     private:
       void fillTrackerInfo(Tracker const& tracker) const;
       PDGCode::type tpart_;
@@ -171,11 +173,11 @@ namespace mu2e {
 
   template <class KTRAJ> void KKFit<KTRAJ>::makeCaloHit(CCPtr const& cluster, Calorimeter const& calo, PKTRAJ const& ptraj, KKCALOHITCOL& hits) const {
     // move cluster COG into the tracker frame.  COG is at the front face of the disk
-    CLHEP::Hep3Vector cog = calo.geomUtil().mu2eToTracker(calo.geomUtil().diskFFToMu2e( cluster->diskID(), cluster->cog3Vector()));
+    auto const& lookup = calo.lookup();
+    CLHEP::Hep3Vector cog = lookup.diskFFToTracker(cluster->diskID(), cluster->cog3Vector());
     // project this along the crystal axis to the SIPM, which is at the back.  This is the point the time measurement corresponds to
     VEC3 ffcog(cog);
-    double lcrystal = calo.caloInfo().getDouble("crystalZLength");
-    VEC3 crystalF2B = VEC3(0.0,0.0,lcrystal); // this should come directly from the calogeometry, TODO
+    VEC3 crystalF2B(lookup.frontToBack(cluster->diskID()));
     VEC3 sipmcog = ffcog + crystalF2B;
     // create the Line trajectory from this information: signal goes towards the sipm
     Line caxis(sipmcog,ffcog,cluster->time()+caloDt_,caloPropSpeed_); 
@@ -306,13 +308,14 @@ namespace mu2e {
   template <class KTRAJ> void KKFit<KTRAJ>::addCaloHit(Calorimeter const& calo, KKTRK& kktrk, CCHandle cchandle, KKCALOHITCOL& hits) const {
     //extrapolate the track to the calorimeter region 
     //to understand on which disk the track is supposed to impact.  Stop
-    double crystalLength = calo.caloInfo().getDouble("crystalZLength");
+    auto const& lookup = calo.lookup();
+    double crystalLength = lookup.crystalZLength();
     auto const& ftraj = kktrk.fitTraj();
     unsigned idisk;
     double zt;
     bool trkextrap(false);
     for (idisk=0; idisk < calo.nDisk(); ++idisk){
-      auto ffpos = calo.geomUtil().mu2eToTracker(calo.disk(idisk).geomInfo().frontFaceCenter());
+      auto const& ffpos = lookup.frontFaceInTracker(idisk);
       double rmin = calo.disk(idisk).geomInfo().innerEnvelopeR();
       double rmax = calo.disk(idisk).geomInfo().outerEnvelopeR();
       // first check the front face
@@ -4,32 +4,34 @@ namespace mu2e {
   using SVEC3 = KinKal::SVEC3;
 
   VEC3 KKBField::fieldVect(VEC3 const& position) const {
-    // change coordinates to mu2e; the map should be native in detector coordinates FIXME!
-    CLHEP::Hep3Vector vpoint(position.x(),position.y(),position.z());
-    CLHEP::Hep3Vector vpoint_mu2e = det_.toMu2e(vpoint);
-    CLHEP::Hep3Vector field = bfmgr_.getBField(vpoint_mu2e);
+    // change coordinates to mu2e
+    CLHEP::Hep3Vector vpoint_mu2e(position.x()+origin_.x(),position.y()+origin_.y(),position.z()+origin_.z());
+    CLHEP::Hep3Vector field = bfmgr_.getBField(vpoint_mu2e,cm_);
     return VEC3(field.x(),field.y(),field.z());
   }
+
+  void KKBField::fieldAndGrad(VEC3 const& position, CLHEP::Hep3Vector& field, CLHEP::Hep3Vector dBdx[3]) const {
+    CLHEP::Hep3Vector vpoint_mu2e(position.x()+origin_.x(),position.y()+origin_.y(),position.z()+origin_.z());
+    bfmgr_.getBFieldWithGradient(vpoint_mu2e,cm_,field,dBdx);
+  }
       
   Grad KKBField::fieldGrad(VEC3 const& position) const {
     Grad retval;
-    auto dBdx = fieldDeriv(position,VEC3(1.0,0.0,0.0));
-    auto dBdy = fieldDeriv(position,VEC3(0.0,1.0,0.0));
-    auto dBdz = fieldDeriv(position,VEC3(0.0,0.0,1.0));
-    SVEC3 dBdxv(dBdx.X(),dBdx.Y(), dBdx.Z());
-    SVEC3 dBdyv(dBdy.X(),dBdy.Y(), dBdy.Z());
-    SVEC3 dBdzv(dBdz.X(),dBdz.Y(), dBdz.Z());
-    retval.Place_in_row(dBdxv,0,0);
-    retval.Place_in_row(dBdyv,1,0);
-    retval.Place_in_row(dBdzv,2,0);
+    CLHEP::Hep3Vector field, dBdx[3];
+    fieldAndGrad(position,field,dBdx);
+    for(int j=0;j<3;++j){
+      SVEC3 row(dBdx[j].x(),dBdx[j].y(),dBdx[j].z());
+      retval.Place_in_row(row,j,0);
+    }
     return retval;
   }
-// numerical derivatives for now: TODO!
+
+  // derivative along the velocity: the gradient projected on it
   VEC3 KKBField::fieldDeriv(VEC3 const& position, VEC3 const& velocity) const {
-    static double dt(0.01); // 10 psec
-    VEC3 start = fieldVect(position);
-    VEC3 end = fieldVect(position + velocity*dt);
-    return (end-start)/dt;
+    CLHEP::Hep3Vector field, dBdx[3];
+    fieldAndGrad(position,field,dBdx);
+    CLHEP::Hep3Vector deriv = dBdx[0]*velocity.x() + dBdx[1]*velocity.y() + dBdx[2]*velocity.z();
+    return VEC3(deriv.x(),deriv.y(),deriv.z());
   }
 
 }
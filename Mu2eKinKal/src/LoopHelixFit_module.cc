@@ -57,6 +57,11 @@
 // root
 #include "TH1F.h"
 #include "TTree.h"
+// tbb
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 // C++
 #include <iostream>
 #include <fstream>
@@ -119,6 +124,7 @@ namespace mu2e {
       fhicl::Atom<bool> saveAll { Name("SaveAllFits"), Comment("Save all fits, whether they suceed or not"),false };
       fhicl::Atom<bool> saveFull { Name("SaveFullFit"), Comment("Save all helix segments associated with the fit"), false};
       fhicl::Sequence<float> zsave { Name("ZSavePositions"), Comment("Z positions to sample and save the fit result helices"), std::vector<float>()};
+      fhicl::Atom<unsigned> nthreads { Name("NThreads"), Comment("Maximum number of threads fitting seeds concurrently (0 = no limit, 1 = serial)"), 1};
     };
 
     struct GlobalConfig {
@@ -138,8 +144,21 @@ namespace mu2e {
     void beginRun(art::Run& run) override;
     void produce(art::Event& event) override;
     private:
+    // one seed: the inputs, unwound from the event serially, and the fit result
+    struct SeedFit {
+      HelixSeed const* hseed;
+      HPtr hptr;
+      StrawHitIndexCollection strawHitIdxs;
+      std::unique_ptr<KKTRK> kktrk;
+      KalSeed kseed;
+      bool save;
+    };
     // utility functions
-    KTRAJ makeSeedTraj(HelixSeed const& hseed) const;
+    KTRAJ makeSeedTraj(HelixSeed const& hseed, KKBField const& kkbf) const;
+    // fit one seed.  This uses only the event data unwound into sfit, and the given field (and its cache),
+    // so seeds can be fit concurrently, each with its own field
+    void fitSeed(SeedFit& sfit, KKBField const& kkbf, Tracker const& tracker, StrawResponse const& strawresponse,
+	Calorimeter const& calo, ComboHitCollection const& chcol, CCHandle const& cc_H) const;
     // data payload
     std::vector<art::ProductToken<HelixSeedCollection>> hseedCols_;
     art::ProductToken<ComboHitCollection> chcol_T_;
@@ -159,6 +178,11 @@ namespace mu2e {
     std::unique_ptr<KKBField> kkbf_;
     Config config_; // initial fit configuration object
     Config exconfig_; // extension configuration object
+    unsigned nthreads_; // maximum number of threads fitting seeds
+    tbb::task_arena arena_;
+    // field (and its map lookup cache) for each thread fitting seeds.  The fitted tracks put into the event
+    // refer to these, so they live as long as the run
+    std::unique_ptr<tbb::enumerable_thread_specific<KKBField>> threadbf_;
   };
 
   LoopHelixFit::LoopHelixFit(const GlobalSettings& settings) : art::EDProducer{settings}, 
@@ -174,7 +198,9 @@ namespace mu2e {
     kkfit_(settings().mu2eFitSettings()),
     kkmat_(settings().matSettings()),
     config_(Mu2eKinKal::makeConfig(settings().kkFitSettings())),
-    exconfig_(Mu2eKinKal::makeConfig(settings().kkExtSettings()))
+    exconfig_(Mu2eKinKal::makeConfig(settings().kkExtSettings())),
+    nthreads_(settings().modSettings().nthreads()),
+    arena_(nthreads_ > 0 ? (int)nthreads_ : tbb::task_arena::automatic)
   {
     // test: only 1 of saveFull and zsave should be set
     if((savefull_ && zsave_.size() > 0) || ((!savefull_) && zsave_.size() == 0))
@@ -205,6 +231,7 @@ namespace mu2e {
     GeomHandle<BFieldManager> bfmgr;
     GeomHandle<DetectorSystem> det;
     kkbf_ = std::move(std::make_unique<KKBField>(*bfmgr,*det));
+    threadbf_ = std::make_unique<tbb::enumerable_thread_specific<KKBField>>(*kkbf_);
   }
 
   void LoopHelixFit::produce(art::Event& event ) {
@@ -223,107 +250,56 @@ namespace mu2e {
     unique_ptr<KalHelixAssns> kkseedassns(new KalHelixAssns());
     auto KalSeedCollectionPID = event.getProductID<KalSeedCollection>();
     auto KalSeedCollectionGetter = event.productGetter(KalSeedCollectionPID);
-    // find the helix seed collections
+    // find the helix seeds to fit.  The event is only accessed here, so that the fits themselves can run concurrently:
+    // unwind the combohits, and resolve the calo cluster Ptrs
+    std::vector<SeedFit> sfits;
     unsigned nhelix(0);
     for (auto const& hseedtag : hseedCols_) {
       auto const& hseedcol_h = event.getValidHandle<HelixSeedCollection>(hseedtag);
       auto const& hseedcol = *hseedcol_h;
       nhelix += hseedcol.size();
-      // loop over the seeds
       for(size_t iseed=0; iseed < hseedcol.size(); ++iseed) {
 	auto const& hseed = hseedcol[iseed];
-  	auto hptr = HPtr(hseedcol_h,iseed);
 	// check helicity.  The test on the charge and helicity 
 	if(hseed.status().hasAllProperties(goodhelix_) ){
-	  // construt the seed trajectory
-	  KTRAJ seedtraj = makeSeedTraj(hseed);
-	  // wrap the seed traj in a Piecewise traj: needed to satisfy PTOCA interface
-	  PKTRAJ pseedtraj(seedtraj);
-	  // first, we need to unwind the combohits.  We use this also to find the time range
-	  StrawHitIndexCollection strawHitIdxs;
+	  sfits.emplace_back();
+	  auto& sfit = sfits.back();
+	  sfit.hseed = &hseed;
+	  sfit.hptr = HPtr(hseedcol_h,iseed);
+	  sfit.save = false;
 	  auto const& hhits = hseed.hits();
-	  for(size_t ihit = 0; ihit < hhits.size(); ++ihit ){ hhits.fillStrawHitIndices(event,ihit,strawHitIdxs); }
-	  // next, build straw hits and materials from these
-	  KKSTRAWHITCOL strawhits; 
-	  KKSTRAWXINGCOL strawxings;
-	  strawhits.reserve(hhits.size());
-	  strawxings.reserve(hhits.size());
-	  kkfit_.makeStrawHits(*tracker, *strawresponse, *kkbf_, kkmat_.strawMaterial(), pseedtraj, chcol, strawHitIdxs, strawhits, strawxings);
-	  // optionally (and if present) add the CaloCluster hit
-	  // verify the cluster looks physically reasonable before adding it TODO!  Or, let the KKCaloHit updater do it
-	  KKCALOHITCOL calohits;
-	  if (kkfit_.useCalo() && hseed.caloCluster())kkfit_.makeCaloHit(hseed.caloCluster(),*calo_h, pseedtraj, calohits);
-	  // set the seed range given the hit TPOCA values
-	  seedtraj.range() = kkfit_.range(strawhits,calohits,strawxings);
-	  // create and fit the track  
-	  auto kktrk = make_unique<KKTRK>(config_,*kkbf_,seedtraj,kkfit_.fitParticle(),strawhits,calohits,strawxings);
-	  if(print_ > 1){
-	    std::cout << "Seed Helix parameters " << hseed.helix() << std::endl;
-	    seedtraj.print(std::cout,print_);
-	    std::cout << "KKTrk fit status " << kktrk->fitStatus() << " fitting " 
-	      << strawhits.size() << " StrawHits and " << calohits.size() << " CaloHits and " << strawxings.size() << " Straw Xings in fit" << std::endl;
-	    if(print_ > 2){
-	      for(auto const& strawhit : strawhits) strawhit->print(std::cout,2);
-	      for(auto const& calohit : calohits) calohit->print(std::cout,2);
-	      for(auto const& strawxing :strawxings) strawxing->print(std::cout,2);
-	    }
-	  }
-	  bool save(false);
-	  if(kktrk->fitStatus().usable()){
-	    // Check fit for physical consistency; fit can succeed but the result can have the wrong charge
-	    auto const& midtraj = kktrk->fitTraj().nearestPiece(kktrk->fitTraj().range().mid());
-	    save = midtraj.Q()*midtraj.rad() > 0;
-	    if(save && extend_) {
-	      KKSTRAWHITCOL addstrawhits;
-	      KKCALOHITCOL addcalohits;
-	      KKSTRAWXINGCOL addstrawxings;
-	      kkfit_.addStrawHits(*tracker, *strawresponse, *kkbf_, kkmat_.strawMaterial(), *kktrk, chcol, addstrawhits, addstrawxings );
-	      if(kkfit_.useCalo())kkfit_.addCaloHit(*calo_h, *kktrk, cc_H, addcalohits);
-	      if(kkfit_.addMaterial())kkfit_.addStraws(*tracker, kkmat_.strawMaterial(), *kktrk, addstrawxings);
-	      kktrk->extendTrack(exconfig_,addstrawhits,addcalohits,addstrawxings);
-	      save &= kktrk->fitStatus().usable();
-	      if(print_ > 1){
-	      	std::cout << "KKTrk fit extension status " << kktrk->fitStatus() << " from adding " 
-		  << addstrawhits.size() << " StrawHits and "
-		  << addcalohits.size() << " CaloHits and "
-		  << addstrawxings.size() << " Straw Xings" << std::endl;
-		if(print_ > 2) {
-		  for(auto const& strawhit : addstrawhits) strawhit->print(std::cout,2);
-		  for(auto const& strawxing :addstrawxings) strawxing->print(std::cout,2);
-		}
-	      }
-	    }
-	  }
-	  if(save || saveall_){
-	    // convert KKTrk into KalSeeds for persistence
-	    auto const& fittraj = kktrk->fitTraj();
-	    TrkFitFlag fitflag(hptr->status());
-	    fitflag.merge(TrkFitFlag::KKLoopHelix);
-	    // Decide which segments to save
-	    std::set<double> savetimes;
-	    if(savefull_){
-	      // loop over all pieces of the fit trajectory and record their times
-	      for (auto const& traj : fittraj.pieces() ) savetimes.insert(traj.range().mid());
-	    } else {
-	      for(auto zpos : zsave_ ) {
-		// compute the time the trajectory crosses this plane
-		double tz = kkfit_.zTime(fittraj,zpos);
-		// find the explicit trajectory piece at this time, and store the midpoint time.  This enforces uniqueness (no duplicates)
-		auto const& zpiece = fittraj.nearestPiece(tz);
-		savetimes.insert(zpiece.range().mid());
-	      }
-	    }
-	    kkseedcol->push_back(kkfit_.createSeed(*kktrk,fitflag,savetimes));
-	    // fill assns with the helix seed
-	    auto hptr = art::Ptr<HelixSeed>(hseedcol_h,iseed);
-	    auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kkseedcol->size()-1,KalSeedCollectionGetter);
-	    kkseedassns->addSingle(kseedptr,hptr);
-	    // save (unpersistable) KKTrk in the event
-	    kktrkcol->push_back(kktrk.release());
-	  }
+	  for(size_t ihit = 0; ihit < hhits.size(); ++ihit ){ hhits.fillStrawHitIndices(event,ihit,sfit.strawHitIdxs); }
+	  if (kkfit_.useCalo() && hseed.caloCluster()) hseed.caloCluster().get();
 	}
       }
     }
+    // fit the seeds.  Printout goes to a shared stream, so it requires serial processing
+    if(print_ > 0 || nthreads_ == 1 || sfits.size() < 2){
+      for(auto& sfit : sfits) fitSeed(sfit, *kkbf_, *tracker, *strawresponse, *calo_h, chcol, cc_H);
+    } else {
+      // fill the caches shared by the fits first
+      kkmat_.strawMaterial();
+      kkfit_.prepare(*tracker);
+      arena_.execute([&]() {
+	  tbb::parallel_for(tbb::blocked_range<size_t>(0,sfits.size(),1),
+	    [&](tbb::blocked_range<size_t> const& range) {
+	      KKBField const& kkbf = threadbf_->local();
+	      for(size_t isfit = range.begin(); isfit != range.end(); ++isfit)
+		fitSeed(sfits[isfit], kkbf, *tracker, *strawresponse, *calo_h, chcol, cc_H);
+	    });
+	  });
+    }
+    // merge in seed order
+    for(auto& sfit : sfits) {
+      if(sfit.save){
+	kkseedcol->push_back(std::move(sfit.kseed));
+	// fill assns with the helix seed
+	auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kkseedcol->size()-1,KalSeedCollectionGetter);
+	kkseedassns->addSingle(kseedptr,sfit.hptr);
+	// save (unpersistable) KKTrk in the event
+	kktrkcol->push_back(sfit.kktrk.release());
+      }
+    }
     // put the output products into the event
   if(print_ > 0) std::cout << "Fitted " << kktrkcol->size() << " tracks from " << nhelix << " Helices" << std::endl;
     event.put(move(kktrkcol));
@@ -331,7 +307,91 @@ namespace mu2e {
     event.put(move(kkseedassns));
   }
 
-  KTRAJ LoopHelixFit::makeSeedTraj(HelixSeed const& hseed) const {
+  void LoopHelixFit::fitSeed(SeedFit& sfit, KKBField const& kkbf, Tracker const& tracker, StrawResponse const& strawresponse,
+      Calorimeter const& calo, ComboHitCollection const& chcol, CCHandle const& cc_H) const {
+    auto const& hseed = *sfit.hseed;
+    // construt the seed trajectory
+    KTRAJ seedtraj = makeSeedTraj(hseed,kkbf);
+    // wrap the seed traj in a Piecewise traj: needed to satisfy PTOCA interface
+    PKTRAJ pseedtraj(seedtraj);
+    // build straw hits and materials from the straw hits of the seed
+    auto const& strawHitIdxs = sfit.strawHitIdxs;
+    KKSTRAWHITCOL strawhits; 
+    KKSTRAWXINGCOL strawxings;
+    strawhits.reserve(hseed.hits().size());
+    strawxings.reserve(hseed.hits().size());
+    kkfit_.makeStrawHits(tracker, strawresponse, kkbf, kkmat_.strawMaterial(), pseedtraj, chcol, strawHitIdxs, strawhits, strawxings);
+    // optionally (and if present) add the CaloCluster hit
+    // verify the cluster looks physically reasonable before adding it TODO!  Or, let the KKCaloHit updater do it
+    KKCALOHITCOL calohits;
+    if (kkfit_.useCalo() && hseed.caloCluster())kkfit_.makeCaloHit(hseed.caloCluster(),calo, pseedtraj, calohits);
+    // set the seed range given the hit TPOCA values
+    seedtraj.range() = kkfit_.range(strawhits,calohits,strawxings);
+    // create and fit the track  
+    auto kktrk = make_unique<KKTRK>(config_,kkbf,seedtraj,kkfit_.fitParticle(),strawhits,calohits,strawxings);
+    if(print_ > 1){
+      std::cout << "Seed Helix parameters " << hseed.helix() << std::endl;
+      seedtraj.print(std::cout,print_);
+      std::cout << "KKTrk fit status " << kktrk->fitStatus() << " fitting " 
+	<< strawhits.size() << " StrawHits and " << calohits.size() << " CaloHits and " << strawxings.size() << " Straw Xings in fit" << std::endl;
+      if(print_ > 2){
+	for(auto const& strawhit : strawhits) strawhit->print(std::cout,2);
+	for(auto const& calohit : calohits) calohit->print(std::cout,2);
+	for(auto const& strawxing :strawxings) strawxing->print(std::cout,2);
+      }
+    }
+    bool save(false);
+    if(kktrk->fitStatus().usable()){
+      // Check fit for physical consistency; fit can succeed but the result can have the wrong charge
+      auto const& midtraj = kktrk->fitTraj().nearestPiece(kktrk->fitTraj().range().mid());
+      save = midtraj.Q()*midtraj.rad() > 0;
+      if(save && extend_) {
+	KKSTRAWHITCOL addstrawhits;
+	KKCALOHITCOL addcalohits;
+	KKSTRAWXINGCOL addstrawxings;
+	kkfit_.addStrawHits(tracker, strawresponse, kkbf, kkmat_.strawMaterial(), *kktrk, chcol, addstrawhits, addstrawxings );
+	if(kkfit_.useCalo())kkfit_.addCaloHit(calo, *kktrk, cc_H, addcalohits);
+	if(kkfit_.addMaterial())kkfit_.addStraws(tracker, kkmat_.strawMaterial(), *kktrk, addstrawxings);
+	kktrk->extendTrack(exconfig_,addstrawhits,addcalohits,addstrawxings);
+	save &= kktrk->fitStatus().usable();
+	if(print_ > 1){
+	  std::cout << "KKTrk fit extension status " << kktrk->fitStatus() << " from adding " 
+	    << addstrawhits.size() << " StrawHits and "
+	    << addcalohits.size() << " CaloHits and "
+	    << addstrawxings.size() << " Straw Xings" << std::endl;
+	  if(print_ > 2) {
+	    for(auto const& strawhit : addstrawhits) strawhit->print(std::cout,2);
+	    for(auto const& strawxing :addstrawxings) strawxing->print(std::cout,2);
+	  }
+	}
+      }
+    }
+    if(save || saveall_){
+      // convert KKTrk into KalSeeds for persistence
+      auto const& fittraj = kktrk->fitTraj();
+      TrkFitFlag fitflag(hseed.status());
+      fitflag.merge(TrkFitFlag::KKLoopHelix);
+      // Decide which segments to save
+      std::set<double> savetimes;
+      if(savefull_){
+	// loop over all pieces of the fit trajectory and record their times
+	for (auto const& traj : fittraj.pieces() ) savetimes.insert(traj.range().mid());
+      } else {
+	for(auto zpos : zsave_ ) {
+	  // compute the time the trajectory crosses this plane
+	  double tz = kkfit_.zTime(fittraj,zpos);
+	  // find the explicit trajectory piece at this time, and store the midpoint time.  This enforces uniqueness (no duplicates)
+	  auto const& zpiece = fittraj.nearestPiece(tz);
+	  savetimes.insert(zpiece.range().mid());
+	}
+      }
+      sfit.kseed = kkfit_.createSeed(*kktrk,fitflag,savetimes);
+      sfit.kktrk = std::move(kktrk);
+      sfit.save = true;
+    }
+  }
+
+  KTRAJ LoopHelixFit::makeSeedTraj(HelixSeed const& hseed, KKBField const& kkbf) const {
     // compute the magnetic field at the helix center.  We only want the z compontent, as the helix fit assumes B points along Z
     auto const& shelix = hseed.helix();
     double zmin = std::numeric_limits<float>::max();
@@ -344,7 +404,7 @@ namespace mu2e {
     }
     float zcent = 0.5*(zmin+zmax);
     VEC3 center(shelix.centerx(), shelix.centery(),zcent);
-    auto bcent = kkbf_->fieldVect(center);
+    auto bcent = kkbf.fieldVect(center);
     VEC3 bnom(0.0,0.0,bcent.Z());
     // create a PKTRAJ from the helix fit result, to seed the KinKal fit.  First, translate the parameters
     // Note the sign adjustments; RobustHelix is a purely geometric helix, with slightly different conventions
@@ -14,6 +14,8 @@
 //
 // 1) digitizedPulse(hitTime) returns a waveform with hitTime corresponding to low edge of first bin 
 // 2) evaluate(deltaTime) return value of digitized bin at a given time difference with peak time value
+// 3) evaluate(deltaTime, derivative) also returns the derivative with respect to deltaTime, i.e. the slope 
+//    of the linear piece (0 outside the tabulated range) 
 //
 //  NOTE: uncomment the pline creation if the discontinuities in the second order derivative arising from the
 //        linear piecewise approxmiation are problematic for the minimization
@@ -32,6 +34,7 @@ namespace mu2e {
 
           const std::vector<double>& digitizedPulse  (double hitTime)        const;
           double                     evaluate        (double timeDifference) const;
+          double                     evaluate        (double timeDifference, double& derivative) const;
           double                     fromPeakToT0    (double timePeak)       const;
           void                       diag            (bool fullDiag=false)   const;
 
@@ -8,6 +8,7 @@
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOMDocument.hpp>
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -32,6 +33,12 @@ namespace mu2e
        void     initMVA();
        float    evalMVA(const std::vector<float>&,  const MVAMask& vmask=0xffffffff) const;
        float    evalMVA(const std::vector<double>&, const MVAMask& vmask=0xffffffff) const;
+
+       // Evaluate nrows input rows at once: row r is input[r*nvars] .. input[r*nvars+nvars-1], 
+       // its output goes to output[r]. The result for each row is identical to evalMVA on that row.
+       // All evalMVA overloads are reentrant and can be called concurrently on one instance.
+       void     evalMVA(const float* input, size_t nrows, size_t nvars, float* output, const MVAMask& vmask=0xffffffff) const;
+       void     evalMVA(const std::vector<float>& input, size_t nvars, std::vector<float>& output, const MVAMask& vmask=0xffffffff) const;
        void     showMVA() const;
        
        const std::vector<std::string>& titles() const { return title_;}     
@@ -45,11 +52,11 @@ namespace mu2e
        void   getOpts(xercesc::DOMDocument* xmlDoc);
        void   getNorm(xercesc::DOMDocument* xmlDoc);
        void   getWgts(xercesc::DOMDocument* xmlDoc);
-       float  activation(float arg) const;
+       void   activation(float* arg, size_t n) const;
+       void   evalBlock(const float* input, size_t nrows, size_t nvars, float* output, 
+                        const MVAMask& vmask, float* x, float* y) const;
 
-       mutable std::vector<float> x_;
-       mutable std::vector<float> y_;
-       mutable std::vector<float> fv_;      
+       static constexpr size_t    blockSize_ = 32;  // rows evaluated together in the batch evaluation
        std::vector<float>         wgts_;
        std::vector<unsigned>      links_;
        unsigned                   maxNeurons_;
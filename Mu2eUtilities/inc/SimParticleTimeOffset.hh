@@ -1,5 +1,6 @@
 // A helper class to apply MC time offsets to account for e.g. proton
 // pulse shape, or muon life time, to simulated particles.
+// The offsets are looked up in a SimParticleTimeTable, filled by updateMap.
 //
 // Andrei Gaponenko, 2014
 
@@ -17,6 +18,7 @@
 #include "canvas/Persistency/Common/Ptr.h"
 
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
+#include "Mu2eUtilities/inc/SimParticleTimeTable.hh"
 
 namespace art { class Event; }
 namespace fhicl { class ParameterSet; }
@@ -47,11 +49,12 @@ namespace mu2e {
     double timeWithOffsetsApplied(const StepPointMC& s) const;
     double timeWithOffsetsApplied(const StrawGasStep& s) const;
 
+    const std::vector<art::InputTag>& inputs() const { return inputs_; }
+    const SimParticleTimeTable& table() const { return table_; }
+
   private:
     std::vector<art::InputTag> inputs_;
-
-    typedef std::vector<SimParticleTimeMap> Maps;
-    mutable Maps offsets_;
+    SimParticleTimeTable table_;
   };
 }
 
@@ -0,0 +1,57 @@
+// The total time offset of every SimParticle of an event, from a set
+// of SimParticleTimeMap inputs, in one dense array per SimParticle
+// collection indexed by the map_vector key.  The table is filled once
+// per event, with the offsets of particles which are not in a map
+// already taken from their primary, so a lookup is an array access
+// and does not change the table: it can be used from several threads.
+//
+// The offsets are those of SimParticleTimeOffset: for each map, the
+// offset of the particle if it is in the map, otherwise the offset
+// of its primary, which must be in the map.
+
+#ifndef Mu2eUtilities_SimParticleTimeTable_hh
+#define Mu2eUtilities_SimParticleTimeTable_hh
+
+#include <vector>
+
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+#include "canvas/Utilities/InputTag.h"
+
+#include "MCDataProducts/inc/SimParticleTimeMap.hh"
+
+namespace art { class Event; }
+
+namespace mu2e {
+  class StepPointMC;
+  class StrawGasStep;
+
+  class SimParticleTimeTable {
+  public:
+
+    // tabulate the SimParticle collections the maps refer to
+    void fill(const art::Event& evt, const std::vector<art::InputTag>& inputs);
+
+    double totalTimeOffset(const art::Ptr<SimParticle>& p) const;
+    double timeWithOffsetsApplied(const StepPointMC& s) const;
+    double timeWithOffsetsApplied(const StrawGasStep& s) const;
+
+    // the number of maps the table was filled from
+    std::size_t nMaps() const { return maps_.size(); }
+
+  private:
+
+    struct Table {
+      art::ProductID id;
+      std::vector<double> offsets; // NaN if not known
+    };
+
+    // for particles of other collections: walk to the primary
+    double lookupMaps(art::Ptr<SimParticle> p) const;
+
+    std::vector<Table> tables_;
+    std::vector<const SimParticleTimeMap*> maps_;
+  };
+}
+
+#endif/*Mu2eUtilities_SimParticleTimeTable_hh*/
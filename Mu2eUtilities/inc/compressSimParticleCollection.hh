@@ -25,6 +25,8 @@
 //    3 - the input collection
 //    4 - the object that knows whether to keep or delete each item - see note 7.
 //    5 - the output collection.
+//    6 - optional: the map from the old to the new keys, when the SimParticles get new keys.
+//        KeyRemap works; any class with std::map's try_emplace and size will do.
 //
 // 6) The code will throw if you try to save a secondary particle without also saving its mother.
 //
@@ -55,28 +57,20 @@ namespace mu2e {
   typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
 
   // Pass in the old key to check if it's already added to keyRemap, if it hasn't been then use nextNewKey for the next key
-  cet::map_vector_key getNewKey(const cet::map_vector_key& oldKey, KeyRemap* keyRemap, const unsigned int& nextNewKey) {
-    cet::map_vector_key nextKey;
-
-    if ( keyRemap->find(oldKey) == keyRemap->end() ) { // might have already added the key since parents have a position reserved before they are added to the output
-      nextKey = cet::map_vector_key(nextNewKey);
-      keyRemap->insert( std::make_pair(oldKey, nextKey) ); // update the map
-    }
-    else {
-      nextKey = keyRemap->at(oldKey);
-    }
-
-    return nextKey;
+  // (might have already added the key since parents have a position reserved before they are added to the output)
+  template<typename KEYREMAP>
+  cet::map_vector_key getNewKey(const cet::map_vector_key& oldKey, KEYREMAP* keyRemap, const unsigned int& nextNewKey) {
+    return keyRemap->try_emplace(oldKey, cet::map_vector_key(nextNewKey)).first->second;
   }
 
 
-  template<typename SELECTOR, typename OUTCOLL>
+  template<typename SELECTOR, typename OUTCOLL, typename KEYREMAP = KeyRemap>
   void compressSimParticleCollection ( art::ProductID         const& newProductID,
                                        art::EDProductGetter   const* productGetter,
                                        SimParticleCollection  const& in,
                                        SELECTOR               const& keep,
                                        OUTCOLL&        out,
-				       KeyRemap* keyRemap = NULL){
+				       KEYREMAP* keyRemap = nullptr){
 
     unsigned int initial_out_size = out.size();
     for ( SimParticleCollection::const_iterator i=in.begin(), e=in.end(); i!=e; ++i ){
@@ -67,6 +67,19 @@ namespace mu2e {
        double t0bin = (ibin-nSteps_)*digiStep_; //t0 is located at nSteps_            
        return (pulseVec_[ibin+1]-pulseVec_[ibin])/digiStep_*(t-t0bin)+pulseVec_[ibin];                  
    }
+
+   //----------------------------------------------------------------------------
+   double CaloPulseShape::evaluate(double tDifference, double& derivative) const
+   {
+       double t = tDifference+deltaT_;          
+       int ibin = nSteps_ + int(t*nSteps_/digiStep_/nSteps_);
+
+       derivative = 0.0;
+       if (ibin < 0 || ibin >= int(pulseVec_.size()-1)) return 0.0;
+       double t0bin = (ibin-nSteps_)*digiStep_;
+       derivative = (pulseVec_[ibin+1]-pulseVec_[ibin])/digiStep_;
+       return derivative*(t-t0bin)+pulseVec_[ibin];                  
+   }
   
    //----------------------------------------------------------------------------
    double CaloPulseShape::fromPeakToT0(double timePeak) const
@@ -34,13 +34,15 @@
 
 using namespace xercesc;
 
+namespace {
+  // scratch space for a single row is small enough for the stack in all practical cases
+  constexpr unsigned maxStackNeurons(256);
+}
+
 namespace mu2e
 {
 
   MVATools::MVATools(const Config& config) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(),
     maxNeurons_(0),
     activeType_(aType::null),
@@ -59,9 +61,6 @@ namespace mu2e
   }
 
   MVATools::MVATools(fhicl::ParameterSet const& pset) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(),
     maxNeurons_(0),
     activeType_(aType::null),
@@ -80,9 +79,6 @@ namespace mu2e
   }
 
   MVATools::MVATools(const std::string& xmlfilename) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(), 
     maxNeurons_(0), 
     activeType_(aType::null),
@@ -372,8 +368,6 @@ namespace mu2e
       }
 
       maxNeurons_ = *std::max_element(links_.begin(),links_.end());
-      x_ = std::vector<float>(maxNeurons_,0.0f);
-      y_ = std::vector<float>(maxNeurons_,0.0f);
 
       XMLString::release(&ATT_INDEX);
       XMLString::release(&ATT_NSYNAPSES);
@@ -428,72 +422,163 @@ namespace mu2e
 
   float MVATools::evalMVA(const std::vector<double >& v, const MVAMask& mask) const
   {
-     for (size_t i=0;i<v.size();++i)  fv_[i] = static_cast<float>(v[i]);
-     return evalMVA(fv_,mask);
+      // convert on the stack as well, the input has fewer values than the first layer has neurons
+      if (maxNeurons_ <= maxStackNeurons && v.size() <= maxStackNeurons)
+      {
+         float fv[maxStackNeurons];
+         std::copy(v.begin(),v.end(),fv);
+         float work[2*maxStackNeurons];
+         float mvaout(0.0);
+         evalBlock(fv,1,v.size(),&mvaout,mask,work,work+maxNeurons_);
+         return mvaout;
+      }
+      std::vector<float> fv(v.begin(),v.end());
+      return evalMVA(fv,mask);
   }
 
   float MVATools::evalMVA(const std::vector<float>& v, const MVAMask& mask) const
   {
+      float mvaout(0.0);
+      if (maxNeurons_ <= maxStackNeurons)
+      {
+         float work[2*maxStackNeurons];
+         evalBlock(v.data(),1,v.size(),&mvaout,mask,work,work+maxNeurons_);
+      }
+      else
+      {
+         std::vector<float> work(2*maxNeurons_);
+         evalBlock(v.data(),1,v.size(),&mvaout,mask,work.data(),work.data()+maxNeurons_);
+      }
+      return mvaout;
+  }
+
+  void MVATools::evalMVA(const std::vector<float>& input, size_t nvars, std::vector<float>& output, const MVAMask& mask) const
+  {
+      if (nvars == 0 || input.size() % nvars != 0)
+	throw cet::exception("RECO")<<"mu2e::MVATools: input size " << input.size() << " is not a multiple of the number of variables " << nvars << std::endl;
+
+      output.resize(input.size()/nvars);
+      evalMVA(input.data(),output.size(),nvars,output.data(),mask);
+  }
+
+  void MVATools::evalMVA(const float* input, size_t nrows, size_t nvars, float* output, const MVAMask& mask) const
+  {
+      if (nrows == 0) return;
+
+      const size_t nblock = std::min(nrows,blockSize_);
+      std::vector<float> work(2*maxNeurons_*nblock);
+      float* x = work.data();
+      float* y = work.data()+maxNeurons_*nblock;
+
+      for (size_t irow=0; irow < nrows; irow += blockSize_)
+      {
+         const size_t nr = std::min(blockSize_,nrows-irow);
+         evalBlock(input+irow*nvars,nr,nvars,output+irow,mask,x,y);
+      }
+  }
+
+  // Feed forward calculation for a block of nrows rows, x and y hold maxNeurons_*nrows values each.
+  // The layer values are stored neuron by neuron, x[i*nrows+r] is neuron i of row r, so each layer 
+  // is a matrix product whose inner loop runs over contiguous rows and vectorizes. The operations on 
+  // each row are done in the same order as for a single row, so the results do not depend on nrows.
+  void MVATools::evalBlock(const float* input, size_t nrows, size_t nvars, float* output, 
+                           const MVAMask& mask, float* x, float* y) const
+  {
+      size_t nin(0);
+      for (size_t ivar=0; ivar < nvars; ivar++) if ( mask & (1<<ivar) ) ++nin;
+
+      if (nin != links_[0]-1)
+	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << nin << ") and network architecture (links_[0]-1 = " << links_[0]-1 << ")" << std::endl;
 
       // Normalize the input data and add the bias node, skip masked values
       size_t ival(0);
-      for (size_t ivar=0; ivar < v.size(); ivar++)
+      for (size_t ivar=0; ivar < nvars; ivar++)
       {
          if ( mask & (1<<ivar) )
          {
-	    x_[ival]= isNorm_ ? (v[ivar]-voffset_[ival])*vscale_[ival] - 1.0 : v[ivar];
-	    ++ival;
+            float* xi = x + ival*nrows;
+            for (size_t r=0;r<nrows;++r)
+            {
+               const float v = input[r*nvars+ivar];
+               xi[r] = isNorm_ ? (v-voffset_[ival])*vscale_[ival] - 1.0 : v;
+            }
+            ++ival;
          }
       }
-      x_[ival] = 1.0;
-
-      if (ival != links_[0]-1)
-	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << ival << ") and network architecture (links_[0]-1 = " << links_[0]-1 << ")" << std::endl;
-
+      std::fill(x+ival*nrows,x+(ival+1)*nrows,1.0f);
 
       //perform feed forward calculation up to the last hidden layer
       unsigned idxWeight(0);
       for (unsigned k=0;k<links_.size()-1;++k)
       {
           //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
-          for (unsigned j=0;j<links_[k+1]-1;++j)
+          const unsigned nout = links_[k+1]-1;
+          for (unsigned j=0;j<nout;++j)
           {
-	     y_[j]=0.0f;
-	     for (unsigned i=0;i<links_[k];++i) y_[j] += wgts_[i+idxWeight]*x_[i];
-             y_[j] = activation(y_[j]);
+             float* yj = y + j*nrows;
+             std::fill(yj,yj+nrows,0.0f);
+             for (unsigned i=0;i<links_[k];++i)
+             {
+                const float  w  = wgts_[i+idxWeight];
+                const float* xi = x + i*nrows;
+                for (size_t r=0;r<nrows;++r) yj[r] += w*xi[r];
+             }
              idxWeight += links_[k];
           }
-          x_.swap(y_);
-          x_[links_[k+1]-1] = 1.0f; //add bias neuron
+          activation(y,nout*nrows);
+          std::swap(x,y);
+          std::fill(x+nout*nrows,x+(nout+1)*nrows,1.0f); //add bias neuron
       }
 
       //calculate output neuron value
-      float yf(0.0);
-      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x_[i];
+      std::fill(output,output+nrows,0.0f);
+      for (unsigned i=0;i<links_.back();++i)
+      {
+         const float  w  = wgts_[i+idxWeight];
+         const float* xi = x + i*nrows;
+         for (size_t r=0;r<nrows;++r) output[r] += w*xi[r];
+      }
 
-      if (oldMVA_) return yf;
-      return  1.0/(1.0+expf(-yf));
+      if (oldMVA_) return;
+      for (size_t r=0;r<nrows;++r) output[r] = 1.0/(1.0+expf(-output[r]));
   }
 
 
 
 
-  float MVATools::activation(float arg) const
+  // Apply the activation function to n values. The loops have no branches so they vectorize.
+  // The tanh is a rational approximation, saturated beyond |arg| = 4.97.
+  void MVATools::activation(float* arg, size_t n) const
   {
      if (activeType_== aType::tanh)
      {
-       if (oldMVA_) return std::tanh(arg);
-       if (arg > 4.97) return 1.0;
-       if (arg < -4.97) return -1.0;
-       float arg2 = arg * arg;
-       float a = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
-       float b = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
-       return a/b;
+       if (oldMVA_)
+       {
+          for (size_t i=0;i<n;++i) arg[i] = std::tanh(arg[i]);
+          return;
+       }
+       for (size_t i=0;i<n;++i)
+       {
+          const float x  = arg[i];
+          const float x2 = x * x;
+          const float a  = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+          const float b  = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+          const float t  = a/b;
+          arg[i] = x > 4.97f ? 1.0f : (x < -4.97f ? -1.0f : t);
+       }
+       return;
      }
-     if (activeType_== aType::sigmoid) return 1.0/(1.0+expf(-arg));
-     if (activeType_== aType::relu) return std::max(0.0f,arg);
-
-     return -999.0;
+     if (activeType_== aType::sigmoid)
+     {
+       for (size_t i=0;i<n;++i) arg[i] = 1.0/(1.0+expf(-arg[i]));
+       return;
+     }
+     if (activeType_== aType::relu)
+     {
+       for (size_t i=0;i<n;++i) arg[i] = std::max(0.0f,arg[i]);
+       return;
+     }
+     std::fill(arg,arg+n,-999.0f);
   }
 
 
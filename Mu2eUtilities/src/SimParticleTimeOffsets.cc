@@ -50,57 +50,21 @@ namespace mu2e {
   }
 
   void SimParticleTimeOffset::updateMap(const art::Event& evt) {
-    offsets_.clear();
-    for(const auto& tag: inputs_) {
-      auto m = evt.getValidHandle<SimParticleTimeMap>(tag);
-      offsets_.emplace_back(*m);
-    }
+    table_.fill(evt, inputs_);
   }
 
   double SimParticleTimeOffset::totalTimeOffset(art::Ptr<SimParticle> p) const {
 
-    if(offsets_.size() != inputs_.size()) {
+    if(table_.nMaps() != inputs_.size()) {
       throw cet::exception("INVOCATION_ERROR")
         <<"SimParticleTimeOffset::totalTimeOffset():"
-        <<" the number of loaded time maps "<<offsets_.size()
+        <<" the number of loaded time maps "<<table_.nMaps()
         <<" does not match the number of requested maps "<<inputs_.size()
         <<". Did you forget to call SimParticleTimeOffset::updateMap()?\n"
         ;
     }
 
-    double dt = 0;
-
-    // Look up the particle in all the maps, and add up the offsets
-    for(auto& m : offsets_) {
-
-      auto it = m.find(p);
-
-      if(it == m.end()) { // no cached record for this particle
-
-        const auto orig(p);
-
-        // Navigate to the primary
-        while(p->parent()) {
-          p = p->parent();
-        }
-
-        it = m.find(p);
-        if(it != m.end()) {
-          // cache the result
-          m[orig] = it->second;
-        }
-        else { // The ultimate parent must be in the map
-          throw cet::exception("BADINPUTS")
-            <<"SimParticleTimeOffset::totalTimeOffset(): the primary "<<p
-            <<" is not in an input map\n";
-        }
-      } // caching
-
-      dt += it->second;
-
-    } // loop over offsets_ maps
-
-    return dt;
+    return table_.totalTimeOffset(p);
   }
 
   double SimParticleTimeOffset::totalTimeOffset(const StepPointMC& s) const {
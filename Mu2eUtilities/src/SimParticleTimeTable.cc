@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "MCDataProducts/inc/SimParticle.hh"
+#include "MCDataProducts/inc/StepPointMC.hh"
+#include "MCDataProducts/inc/StrawGasStep.hh"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "cetlib_except/exception.h"
+
+#include "Mu2eUtilities/inc/SimParticleTimeTable.hh"
+
+namespace mu2e {
+
+  void SimParticleTimeTable::fill(const art::Event& evt, const std::vector<art::InputTag>& inputs) {
+    tables_.clear();
+    maps_.clear();
+    for(const auto& tag: inputs) {
+      maps_.push_back(evt.getValidHandle<SimParticleTimeMap>(tag).product());
+    }
+
+    // the collections of the particles in the maps; the maps are
+    // ordered by product, so each product is one range of entries
+    std::vector<art::ProductID> ids;
+    for(const auto m: maps_) {
+      for(auto it = m->begin(); it != m->end(); ) {
+        const art::ProductID id = it->first.id();
+        if(std::find(ids.begin(), ids.end(), id) == ids.end()) {
+          ids.push_back(id);
+        }
+        it = m->lower_bound(art::Ptr<SimParticle>(id, std::numeric_limits<std::size_t>::max(), nullptr));
+      }
+    }
+
+    const double unknown = std::numeric_limits<double>::quiet_NaN();
+    for(const auto& id: ids) {
+      art::Handle<SimParticleCollection> h;
+      evt.get(id, h);
+      if(!h.isValid()) continue; // particles of this product use lookupMaps
+
+      const SimParticleCollection& sims = *h;
+      Table t;
+      t.id = id;
+      t.offsets.assign(sims.delta(), unknown);
+
+      // the key of the primary of each particle, or -1 if not known
+      // yet, or -2 if the primary is in another collection
+      std::vector<long> primary(sims.delta(), -1);
+      std::vector<std::size_t> chain;
+      for(const auto& entry: sims) {
+        std::size_t key = entry.first.asUint();
+        chain.clear();
+        long prim = -1;
+        while(prim == -1) {
+          if(primary[key] != -1) {
+            prim = primary[key];
+            break;
+          }
+          chain.push_back(key);
+          const auto* sim = sims.getOrNull(cet::map_vector_key(key));
+          const auto& parent = sim->parent();
+          if(parent.isNull()) {
+            prim = key;
+          } else if(parent.id() != id || parent.key() >= primary.size()
+                    || !sims.has(cet::map_vector_key(parent.key()))) {
+            prim = -2;
+          } else {
+            key = parent.key();
+          }
+        }
+        for(auto k: chain) primary[k] = prim;
+      }
+
+      for(const auto& entry: sims) {
+        const std::size_t key = entry.first.asUint();
+        if(primary[key] == -2) continue;
+        const art::Ptr<SimParticle> p(h, key);
+        const art::Ptr<SimParticle> pp(h, primary[key]);
+        double dt = 0;
+        bool known = true;
+        for(const auto m: maps_) {
+          auto it = m->find(p);
+          if(it == m->end()) {
+            it = m->find(pp);
+          }
+          if(it == m->end()) {
+            known = false;
+            break;
+          }
+          dt += it->second;
+        }
+        if(known) t.offsets[key] = dt;
+      }
+
+      tables_.emplace_back(std::move(t));
+    }
+  }
+
+  double SimParticleTimeTable::totalTimeOffset(const art::Ptr<SimParticle>& p) const {
+    for(const auto& t: tables_) {
+      if(t.id == p.id()) {
+        if(p.key() < t.offsets.size() && !std::isnan(t.offsets[p.key()])) {
+          return t.offsets[p.key()];
+        }
+        break;
+      }
+    }
+    return lookupMaps(p);
+  }
+
+  double SimParticleTimeTable::lookupMaps(art::Ptr<SimParticle> p) const {
+    double dt = 0;
+    art::Ptr<SimParticle> primary;
+    for(const auto m: maps_) {
+      auto it = m->find(p);
+      if(it == m->end()) {
+        if(primary.isNull()) {
+          // Navigate to the primary
+          primary = p;
+          while(primary->parent()) {
+            primary = primary->parent();
+          }
+        }
+        it = m->find(primary);
+        if(it == m->end()) { // The ultimate parent must be in the map
+          throw cet::exception("BADINPUTS")
+            <<"SimParticleTimeTable::totalTimeOffset(): the primary "<<primary
+            <<" is not in an input map\n";
+        }
+      }
+      dt += it->second;
+    }
+    return dt;
+  }
+
+  double SimParticleTimeTable::timeWithOffsetsApplied(const StepPointMC& s) const {
+    return s.time() + totalTimeOffset(s.simParticle());
+  }
+
+  double SimParticleTimeTable::timeWithOffsetsApplied(const StrawGasStep& s) const {
+    return s.time() + totalTimeOffset(s.simParticle());
+  }
+
+}
@@ -7,6 +7,8 @@
 //
 
 #include <string>
+#include <vector>
+#include <future>
 
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/Table.h"
@@ -16,6 +18,7 @@
 #include "art/Framework/Services/Registry/ActivityRegistry.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "art/Framework/Services/Registry/ServiceDeclarationMacros.h"
+#include "art/Framework/Principal/SubRun.h"
 #include "cetlib_except/exception.h"
 
 #include "Mu2eInterfaces/inc/ProditionsEntity.hh"
@@ -48,6 +51,10 @@ namespace mu2e {
       using Comment=fhicl::Comment;
       fhicl::Atom<int> verbose{Name("verbose"),
           Comment("verbosity 0 or 1"),0};
+      fhicl::Sequence<std::string> prefetch{Name("prefetch"),
+          Comment("entities to make in the background at the start of each subrun,\n"
+                  "for the subrun and the next interval of validity, like StrawResponse"),
+          std::vector<std::string>()};
       fhicl::Table<EventTimingConfig> eventTiming{
           Name("eventTiming"),
           Comment("Event timing configuration") };
@@ -102,6 +109,8 @@ namespace mu2e {
 
 
     //void postBeginJob();
+    void postBeginSubRun(art::SubRun const& subrun);
+    void postEndJob();
 
   private:
 
@@ -111,6 +120,10 @@ namespace mu2e {
 
     Config _config;
     std::map<std::string,ProditionsCache::ptr> _caches;
+
+    // the caches to prefetch, and the running prefetch
+    std::vector<ProditionsCache::ptr> _prefetch;
+    std::future<void> _prefetchDone;
   };
 
 }
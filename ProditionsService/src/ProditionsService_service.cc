@@ -71,6 +71,47 @@ namespace mu2e {
       }
     }
 
+    for( auto const& name : _config.prefetch()) {
+      auto cc = getCache(name);
+      if(!cc) {
+        throw cet::exception("PRODITIONS_NO_CACHE")
+          << "ProditionsService can't prefetch " << name
+          << ", there is no cache of that name\n";
+      }
+      _prefetch.push_back(cc);
+    }
+    if( !_prefetch.empty() ) {
+      iRegistry.sPostBeginSubRun.watch(this, &ProditionsService::postBeginSubRun);
+      iRegistry.sPostEndJob.watch(this, &ProditionsService::postEndJob);
+    }
+
+  }
+
+  // make the entities of the new subrun, and of the interval of
+  // validity following it, in another thread, so the event loop
+  // usually finds them already made
+  void ProditionsService::postBeginSubRun(art::SubRun const& subrun) {
+    // one prefetch at a time, the previous one is normally long done
+    if(_prefetchDone.valid()) _prefetchDone.wait();
+    art::EventID eid(subrun.id(),0);
+    int verbose = _config.verbose();
+    _prefetchDone = std::async(std::launch::async,[this,eid,verbose]() {
+        for( auto const& cc : _prefetch) {
+          try {
+            cc->prefetch(eid);
+          } catch (std::exception const& e) {
+            // not fatal here, the event which needs it will fail
+            if(verbose>0) cout << "ProditionsService prefetch of "
+                               << cc->name() << " failed: " << e.what() << endl;
+          }
+        }
+        if(verbose>1) cout << "ProditionsService prefetched run "
+                           << eid.run() << " subrun " << eid.subRun() << endl;
+      });
+  }
+
+  void ProditionsService::postEndJob() {
+    if(_prefetchDone.valid()) _prefetchDone.wait();
   }
 
 }
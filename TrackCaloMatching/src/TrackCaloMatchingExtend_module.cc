@@ -181,7 +181,7 @@ namespace mu2e {
 	   HepPoint          point       = trkIntersect.trk()->position(pathLength);
                       	            
            CLHEP::Hep3Vector posTrkInTracker(point.x(),point.y(),point.z());	     
-	   CLHEP::Hep3Vector posTrkInSectionFF = cal.geomUtil().mu2eToDiskFF(trkIntersect.diskId(),cal.geomUtil().trackerToMu2e(posTrkInTracker));
+	   CLHEP::Hep3Vector posTrkInSectionFF = cal.lookup().mu2eToDiskFF(trkIntersect.diskId(),cal.geomUtil().trackerToMu2e(posTrkInTracker));
 
 
            //needed to compute the trajectory inside the disk
@@ -286,7 +286,7 @@ namespace mu2e {
               int    crId((*it)->crystalID());
               double energy((*it)->energyDep());
 
-              CLHEP::Hep3Vector crystalPos = cal.geomUtil().mu2eToDiskFF(cal.crystal(crId).diskID(), cal.crystal(crId).position());
+              const CLHEP::Hep3Vector& crystalPos = cal.lookup().crystalPosFF(crId);
 
               double weight = energy - 4.939;
               //double weight = -5.45 + 2.63*log(energy);
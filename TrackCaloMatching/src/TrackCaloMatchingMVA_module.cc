@@ -199,7 +199,7 @@ namespace mu2e {
                       
 
 	   CLHEP::Hep3Vector posTrkInTracker(point.x(),point.y(),point.z());	     
-	   CLHEP::Hep3Vector posTrkInSectionFF = cal.geomUtil().mu2eToDiskFF(trkIntersect.diskId(),cal.geomUtil().trackerToMu2e(posTrkInTracker));
+	   CLHEP::Hep3Vector posTrkInSectionFF = cal.lookup().mu2eToDiskFF(trkIntersect.diskId(),cal.geomUtil().trackerToMu2e(posTrkInTracker));
 
  	   for (const auto& cluster : caloClusters)
            {
@@ -266,17 +266,15 @@ namespace mu2e {
    {
   
         const auto& hit0 = cluster.caloHitsPtrVector().at(0);
-        CLHEP::Hep3Vector center = cal.geomUtil().mu2eToDiskFF(cal.crystal(hit0->crystalID()).diskID(), cal.crystal(hit0->crystalID()).position());
+        CLHEP::Hep3Vector center = cal.lookup().crystalPosFF(hit0->crystalID());
         
-        std::vector<int> neighbors1 = cal.neighbors(hit0->crystalID(),true);
-        std::vector<int> neighbors2 = cal.nextNeighbors(hit0->crystalID(),true);
-        neighbors1.insert(neighbors1.end(), neighbors2.begin(), neighbors2.end());
-            
         double eCells(0);
         std::vector<double> evec;
         evec.push_back(hit0->energyDep());
 
-        for (auto& in : neighbors1)
+        // raw first and second rings, -1 for the positions without crystal
+        for (int ring=0; ring<2; ++ring)
+        for (int in : (ring==0) ? cal.lookup().neighbors(hit0->crystalID(),true) : cal.lookup().nextNeighbors(hit0->crystalID(),true))
         {
             if (in == -1){evec.push_back(-1);continue;}
 
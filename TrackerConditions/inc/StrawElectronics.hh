@@ -10,6 +10,7 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <algorithm>
 
 // Mu2e includes
 #include "DataProducts/inc/StrawId.hh"
@@ -46,6 +47,21 @@ namespace mu2e {
         _sigma(sigma), _t0(t0) {};
     };
 
+    // the time-independent part of the linear response to one cluster, for repeated evaluation.
+    // linearResponse and maxLinearResponse of a ClusterResponse are bitwise equal to the
+    // functions of the straw, charge and distance it was made from
+    struct ClusterResponse {
+      double _time; // cluster time
+      double _charge;
+      double _distFrac; // interpolation between wire distance points
+      double _reflectionTime; // delay of the reflected signal
+      double _reflectionScale;
+      double _maxResponse; // maxLinearResponse on the threshold path
+      double _maxResponseTime; // maxResponseTime on the threshold path
+      std::array<double,npaths> _dVdI;
+      size_t _distIndex;
+    };
+
     typedef std::shared_ptr<StrawElectronics> ptr_t;
     typedef std::shared_ptr<const StrawElectronics> cptr_t;
     constexpr static const char* cxname = {"StrawElectronics"};
@@ -109,6 +125,12 @@ namespace mu2e {
     // since those are cumulative and cannot be computed for individual charges
     double linearResponse(Straw const& straw, Path ipath, double time, double charge, double distance, bool forsaturation=false) const; // mvolts per pCoulomb
     double adcImpulseResponse(StrawId sid, double time, double charge) const;
+    // cached cluster response
+    void clusterResponse(Straw const& straw, double time, double charge, double distance, ClusterResponse& cresp) const;
+    inline double linearResponse(ClusterResponse const& cresp, Path ipath, double time, bool forsaturation=false) const; // time relative to the cluster
+    // add the linear response of a cluster, or the ADC impulse response of a charge at a given time, to values at n times
+    void addLinearResponse(ClusterResponse const& cresp, Path ipath, bool forsaturation, double const* times, size_t n, double* resp) const;
+    void addADCImpulseResponse(StrawId sid, double time, double charge, float const* times, size_t n, float* resp) const;
     // Given a (linear) total voltage, compute the saturated voltage
     double saturatedResponse(double lineearresponse) const;
     // relative time when linear response is maximal
@@ -193,9 +215,7 @@ namespace mu2e {
     void setPreampToAdc2Response(std::vector<double> preampToAdc2Response) {
       _preampToAdc2Response = preampToAdc2Response;
     }
-    void setwPoints(std::vector<WireDistancePoint> wPoints) {
-      _wPoints = wPoints;
-    }
+    void setwPoints(std::vector<WireDistancePoint> wPoints);
 
     // this is used to update values from the database
     void setOffsets( std::array<double, StrawId::_nupanels> timeOffsetPanel,
@@ -274,6 +294,9 @@ namespace mu2e {
     std::vector<double> _preampToAdc2Response;
     
     std::vector<WireDistancePoint> _wPoints;
+    // responses of all wire distance points in one array per path, the last is the threshold path for saturation
+    std::array<std::vector<double>,npaths+1> _responseTable;
+    inline int responseIndex(double time) const;
     
     double _clusterLookbackTime;
     
@@ -284,7 +307,22 @@ namespace mu2e {
     double _timeFromProtonsToDRMarker;
 
   };
-  
+
+  inline int StrawElectronics::responseIndex(double time) const {
+    int index = time*_sampleRate + _responseBins/2.;
+    return std::min(std::max(index,0),_responseBins-1);
+  }
+
+  inline double StrawElectronics::linearResponse(ClusterResponse const& cresp, Path ipath, double time, bool forsaturation) const {
+    int index = responseIndex(time);
+    int index_refl = responseIndex(time - cresp._reflectionTime);
+    double const* r0 = _responseTable[forsaturation && ipath == thresh ? npaths : ipath].data() + cresp._distIndex*_responseBins;
+    double const* r1 = r0 + _responseBins;
+    double p0 = r0[index] + r0[index_refl]*cresp._reflectionScale;
+    double p1 = r1[index] + r1[index_refl]*cresp._reflectionScale;
+    return cresp._charge * ( p0 * cresp._distFrac + p1 * (1 - cresp._distFrac)) * cresp._dVdI[ipath];
+  }
+
 }
 
 #endif
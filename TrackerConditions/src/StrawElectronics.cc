@@ -116,6 +116,68 @@ namespace mu2e {
     return charge * _preampToAdc2Response[index] * _saturationSampleFactor * _dVdI[adc][sid.uniqueStraw()]/_dVdI[thresh][sid.uniqueStraw()];
   }
  
+  void StrawElectronics::clusterResponse(Straw const& straw, double time, double charge, double distance, ClusterResponse& cresp) const {
+    // same expressions as linearResponse and maxLinearResponse
+    double straw_length = 2*straw.halfLength();
+    cresp._time = time;
+    cresp._charge = charge;
+    cresp._reflectionTime = _reflectionTimeShift + (2*straw_length-2*distance)/_reflectionVelocity;
+    cresp._reflectionScale = _reflectionFrac * exp(-(2*straw_length-2*distance)/_reflectionALength);
+    int  distIndex = 0;
+    for (size_t i=1;i<_wPoints.size()-1;i++){
+      if (distance < _wPoints[i]._distance)
+        break;
+      distIndex = i;
+    }
+    cresp._distIndex = distIndex;
+    cresp._distFrac = 1 - (distance - _wPoints[distIndex]._distance)/(_wPoints[distIndex+1]._distance - _wPoints[distIndex]._distance);
+    for (size_t ipath=0;ipath<npaths;ipath++)
+      cresp._dVdI[ipath] = _dVdI[ipath][straw.id().uniqueStraw()];
+    cresp._maxResponseTime = maxResponseTime(straw.id(),thresh,distance);
+    cresp._maxResponse = maxLinearResponse(straw.id(),thresh,distance,charge);
+  }
+
+  void StrawElectronics::addLinearResponse(ClusterResponse const& cresp, Path ipath, bool forsaturation, double const* times, size_t n, double* resp) const {
+    // the table lookup and interpolation of linearResponse, with the invariants hoisted so the loop vectorizes
+    double const* r0 = _responseTable[forsaturation && ipath == thresh ? npaths : ipath].data() + cresp._distIndex*_responseBins;
+    double const* r1 = r0 + _responseBins;
+    double const tclust = cresp._time, trefl = cresp._reflectionTime, rscale = cresp._reflectionScale;
+    double const charge = cresp._charge, frac = cresp._distFrac, dVdI = cresp._dVdI[ipath];
+    double const rate = _sampleRate, offset = _responseBins/2.;
+    int const imax = _responseBins-1;
+    for (size_t i=0;i<n;i++){
+      double time = times[i]-tclust;
+      int index = std::min(std::max(static_cast<int>(time*rate + offset),0),imax);
+      int index_refl = std::min(std::max(static_cast<int>((time - trefl)*rate + offset),0),imax);
+      double p0 = r0[index] + r0[index_refl]*rscale;
+      double p1 = r1[index] + r1[index_refl]*rscale;
+      resp[i] += charge * ( p0 * frac + p1 * (1 - frac)) * dVdI;
+    }
+  }
+
+  void StrawElectronics::addADCImpulseResponse(StrawId sid, double time, double charge, float const* times, size_t n, float* resp) const {
+    double const* r = _preampToAdc2Response.data();
+    double const factor = _saturationSampleFactor, dVdIadc = _dVdI[adc][sid.uniqueStraw()], dVdIthresh = _dVdI[thresh][sid.uniqueStraw()];
+    double const rate = _sampleRate, offset = _responseBins/2.;
+    int const imax = _responseBins-1;
+    for (size_t i=0;i<n;i++){
+      int index = std::min(std::max(static_cast<int>((times[i]-time)*rate + offset),0),imax);
+      resp[i] += charge * r[index] * factor * dVdIadc/dVdIthresh;
+    }
+  }
+
+  void StrawElectronics::setwPoints(std::vector<WireDistancePoint> wPoints) {
+    _wPoints = wPoints;
+    // flatten the responses for the cluster response functions
+    for (auto& table : _responseTable)
+      table.clear();
+    for (auto const& wp : _wPoints){
+      _responseTable[thresh].insert(_responseTable[thresh].end(),wp._preampResponse.begin(),wp._preampResponse.end());
+      _responseTable[adc].insert(_responseTable[adc].end(),wp._adcResponse.begin(),wp._adcResponse.end());
+      _responseTable[npaths].insert(_responseTable[npaths].end(),wp._preampToAdc1Response.begin(),wp._preampToAdc1Response.end());
+    }
+  }
+
   double StrawElectronics::saturatedResponse(double vlin) const {
     if (vlin < _vsat)
       return vlin;
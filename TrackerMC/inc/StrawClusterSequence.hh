@@ -1,21 +1,23 @@
 #ifndef TrackerMC_StrawClusterSequence_hh
 #define TrackerMC_StrawClusterSequence_hh
 //
-// StrawClusterSequence is a time-ordered sequence of StrawClusters
+// StrawClusterSequence is a time-ordered sequence of StrawClusters.  The clusters are stored
+// contiguously; they can be inserted one by one in time order, or appended in any order and
+// sorted once with sort().
 //
 // Original author David Brown, LBNL
 //
 
 // C++ includes
 #include <iostream>
-#include <list>
+#include <vector>
 // Mu2e includes
 #include "TrackerMC/inc/StrawCluster.hh"
 #include "DataProducts/inc/StrawId.hh"
 
 namespace mu2e {
   namespace TrackerMC {
-    typedef std::list<StrawCluster> StrawClusterList;
+    typedef std::vector<StrawCluster> StrawClusterList;
     class StrawClusterSequence {
       public:
 	// constructors
@@ -28,6 +30,12 @@ namespace mu2e {
 	StrawClusterList const& clustList() const { return _clist; }
 	// insert a new clust, in time order.
 	StrawClusterList::iterator insert(StrawCluster const& clust);
+	// append a new clust without ordering; sort() must be called before the sequence is used
+	void append(StrawCluster const& clust);
+	// restore time order after append.  Clusters with equal times end up as if inserted one by one
+	void sort();
+	// remove all clusts and assign a new straw end, keeping the storage
+	void reset(StrawId const& sid, StrawEnd end) { _strawId = sid; _end = end; _clist.clear(); }
 	StrawId const& strawId() const { return _strawId; }
 	StrawEnd const& strawEnd() const { return _end; }
       private:
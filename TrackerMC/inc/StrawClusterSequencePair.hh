@@ -17,6 +17,10 @@ namespace mu2e {
 	StrawClusterSequence& clustSequence(StrawEnd end) { return _scseq[end]; }
 	StrawClusterSequence const& clustSequence(StrawEnd end) const { return _scseq[end]; }
 	void insert(StrawClusterPair const& hpair);
+	// remove all clusts and assign a new straw, keeping the storage
+	void reset(StrawId sid);
+	// restore time order after appending clusts
+	void sort();
 	StrawId strawId() const { return _scseq[0].strawId(); }
       private:
 	StrawClusterSequence _scseq[2];
@@ -4,6 +4,9 @@
 // StrawWaveform integrates post-amplification voltage as a function of time at one end of a
 // a straw, over the time period of 1 microbunch.  It includes all physical and electronics
 // effects prior to digitization.
+// When it is given the cached responses of its clusts the waveform is evaluated with the
+// StrawElectronics batch functions, several times at once; otherwise it is evaluated cluster by
+// cluster (the reference).  Both give bitwise the same values.
 //
 // Original author David Brown, LBNL
 //
@@ -37,11 +40,15 @@ namespace mu2e {
       double _postamp; // scaling after amplificiation
     };
 
+    typedef std::vector<StrawElectronics::ClusterResponse> ClusterResponses;
+    // cache the responses of the clusts of a sequence
+    void fillClusterResponses(StrawElectronics const& strawele, Straw const& straw, StrawClusterSequence const& cseq, ClusterResponses& cresps);
+
     struct WFX;
     class StrawWaveform{
       public:
 	// construct from a clust sequence and response object.  Scale affects the voltage
-	StrawWaveform(Straw const& straw, StrawClusterSequence const& hseqq, XTalk const& xtalk);
+	StrawWaveform(Straw const& straw, StrawClusterSequence const& hseqq, XTalk const& xtalk, ClusterResponses const* cresps=0);
 	// disallow copy and assignment
 	StrawWaveform() = delete; // don't allow default constructor, references can't be assigned empty
 	StrawWaveform(StrawWaveform const& other);
@@ -51,6 +58,8 @@ namespace mu2e {
       bool crossesThreshold(StrawElectronics const& strawele, double threshold,WFX& wfx) const;
 	// sample the waveform at a given time, no saturation included.  Return value is in units of volts
 	double sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const;
+	// sample the waveform at n increasing times
+	void sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double const* times,size_t n,double* volts) const;
 	// sample the waveform at a series of points allowing saturation to occur after preamp stage
         // FIXME no cross talk yet
 	void sampleADCWaveform(StrawElectronics const& strawele,TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
@@ -63,6 +72,7 @@ namespace mu2e {
       private:
 	// clust sequence used in this waveform
 	StrawClusterSequence const& _cseq;
+	ClusterResponses const* _cresps; // cached responses of the clusts, null for the reference evaluation
 	XTalk _xtalk; // X-talk applied to all voltages
         Straw const& _straw;
 	// helper functions
@@ -70,6 +80,11 @@ namespace mu2e {
 	bool roughCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const;
 	bool fineCrossing(StrawElectronics const& strawele, double threshold, double vmax, WFX& wfx) const;
 	double maxLinearResponse(StrawElectronics const& strawele,StrawClusterList::const_iterator const& iclust) const;
+	double maxResponseTime(StrawElectronics const& strawele,StrawClusterList::const_iterator const& iclust) const;
+	void sampleSaturatedADCWaveform(StrawElectronics const& strawele,StrawClusterList::const_iterator iclust,
+	    TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
+	StrawElectronics::ClusterResponse const& clusterResponse(StrawClusterList::const_iterator const& iclust) const {
+	  return (*_cresps)[iclust-_cseq.clustList().begin()]; }
     };
 
     struct WFX { // waveform crossing
@@ -6,6 +6,7 @@
 // mu2e includes
 #include "TrackerMC/inc/StrawClusterSequence.hh"
 #include "cetlib_except/exception.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -53,18 +54,40 @@ namespace mu2e {
 	return retval;
       }
       if(_clist.empty()){
-	_clist.push_front(clust);
 	_strawId = clust.strawId();
 	_end = clust.strawEnd();
-	retval = _clist.begin();
-      } else {
-	// loop over the contents and insert in the correct place
-	StrawClusterList::iterator ibefore = _clist.begin();
-	while(ibefore != _clist.end() && ibefore->time() < clust.time())
-	  ++ibefore;
-	retval = _clist.insert(ibefore,clust);
       }
+      // insert before the first clust which is not earlier
+      auto ibefore = std::lower_bound(_clist.begin(),_clist.end(),clust,
+	  [](StrawCluster const& a, StrawCluster const& b){ return a.time() < b.time(); });
+      retval = _clist.insert(ibefore,clust);
       return retval;
     }
+
+    void StrawClusterSequence::append(StrawCluster const& clust) {
+      if(clust.type() == StrawCluster::unknown){
+	throw cet::exception("SIM")
+	  << "mu2e::StrawClusterSequence: tried to add unknown clust type"
+	  << endl;
+      }
+      if(!_clist.empty() && (clust.strawId() != strawId()
+	    || clust.strawEnd() != strawEnd())){
+	throw cet::exception("SIM")
+	  << "mu2e::StrawClusterSequence: tried to add clust from a different straw/end to a sequence"
+	  << endl;
+      }
+      if(_clist.empty()){
+	_strawId = clust.strawId();
+	_end = clust.strawEnd();
+      }
+      _clist.push_back(clust);
+    }
+
+    void StrawClusterSequence::sort() {
+      // insert() puts a clust in front of those with the same time, so the later one comes first
+      std::reverse(_clist.begin(),_clist.end());
+      std::stable_sort(_clist.begin(),_clist.end(),
+	  [](StrawCluster const& a, StrawCluster const& b){ return a.time() < b.time(); });
+    }
   }
 }
@@ -40,5 +40,15 @@ namespace mu2e {
       _scseq[StrawEnd::cal].insert(hpair[StrawEnd::cal]);
       _scseq[StrawEnd::hv].insert(hpair[StrawEnd::hv]);
     }
+
+    void StrawClusterSequencePair::reset(StrawId sid) {
+      _scseq[StrawEnd::cal].reset(sid,StrawEnd::cal);
+      _scseq[StrawEnd::hv].reset(sid,StrawEnd::hv);
+    }
+
+    void StrawClusterSequencePair::sort() {
+      _scseq[StrawEnd::cal].sort();
+      _scseq[StrawEnd::hv].sort();
+    }
   }
 }
@@ -0,0 +1,83 @@
+//
+// Check that two StrawDigi collections are identical, e.g. the outputs of StrawDigisFromStrawGasSteps
+// run with different numbers of threads and the same seed.  Digis are compared in order: straw id,
+// TDC, TOT and PMP values, and the ADC waveform.  The number of differences is printed at the end of the job.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include "RecoDataProducts/inc/StrawDigi.hh"
+
+#include <cstdio>
+
+
+namespace mu2e {
+
+  class StrawDigiCompare : public art::EDAnalyzer {
+    public:
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+      struct Config {
+	fhicl::Atom<art::InputTag> sdTag1{ Name("StrawDigiCollection1"), Comment("Reference StrawDigi and StrawDigiADCWaveform collections")};
+	fhicl::Atom<art::InputTag> sdTag2{ Name("StrawDigiCollection2"), Comment("StrawDigi and StrawDigiADCWaveform collections to compare")};
+	fhicl::Atom<int> debug{ Name("debugLevel"), Comment("Print the differences if > 0"), 0};
+      };
+
+      using Parameters = art::EDAnalyzer::Table<Config>;
+      explicit StrawDigiCompare(Parameters const& config);
+      void analyze(art::Event const& event) override;
+      void endJob() override;
+
+    private:
+      art::ProductToken<StrawDigiCollection> const _sdtoken1;
+      art::ProductToken<StrawDigiCollection> const _sdtoken2;
+      art::ProductToken<StrawDigiADCWaveformCollection> const _sdadctoken1;
+      art::ProductToken<StrawDigiADCWaveformCollection> const _sdadctoken2;
+      int _debug;
+      size_t _nevents, _ndigis, _ndiff;
+  };
+
+  StrawDigiCompare::StrawDigiCompare(Parameters const& config) :
+    art::EDAnalyzer{config},
+    _sdtoken1{consumes<StrawDigiCollection>(config().sdTag1())},
+    _sdtoken2{consumes<StrawDigiCollection>(config().sdTag2())},
+    _sdadctoken1{consumes<StrawDigiADCWaveformCollection>(config().sdTag1())},
+    _sdadctoken2{consumes<StrawDigiADCWaveformCollection>(config().sdTag2())},
+    _debug(config().debug()),
+    _nevents(0), _ndigis(0), _ndiff(0)
+  {}
+
+  void StrawDigiCompare::analyze(art::Event const& event) {
+    auto const& sdcol1 = *event.getValidHandle(_sdtoken1);
+    auto const& sdcol2 = *event.getValidHandle(_sdtoken2);
+    auto const& sdadccol1 = *event.getValidHandle(_sdadctoken1);
+    auto const& sdadccol2 = *event.getValidHandle(_sdadctoken2);
+    ++_nevents;
+    _ndigis += sdcol1.size();
+    if(sdcol1.size() != sdcol2.size() || sdadccol1.size() != sdadccol2.size()){
+      if(_debug > 0) std::printf("[StrawDigiCompare] event %u: %zu and %zu digis\n", event.event(), sdcol1.size(), sdcol2.size());
+      ++_ndiff;
+      return;
+    }
+    for(size_t isd = 0; isd < sdcol1.size(); ++isd){
+      StrawDigi const& sd1 = sdcol1[isd];
+      StrawDigi const& sd2 = sdcol2[isd];
+      if(sd1.strawId() != sd2.strawId() || sd1.TDC() != sd2.TDC() || sd1.TOT() != sd2.TOT() || sd1.PMP() != sd2.PMP()
+	  || sdadccol1[isd].samples() != sdadccol2[isd].samples()){
+	if(_debug > 0) std::printf("[StrawDigiCompare] event %u: digi %zu differs\n", event.event(), isd);
+	++_ndiff;
+      }
+    }
+  }
+
+  void StrawDigiCompare::endJob() {
+    std::printf("[StrawDigiCompare] %zu events, %zu digis, %zu differences\n", _nevents, _ndigis, _ndiff);
+  }
+
+}
+
+using mu2e::StrawDigiCompare;
+DEFINE_ART_MODULE(StrawDigiCompare);
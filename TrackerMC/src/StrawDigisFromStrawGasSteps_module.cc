@@ -2,6 +2,13 @@
 // module to convert G4 steps into straw digis.
 // It also builds the truth match
 //
+// The StrawGasSteps are first grouped by straw.  Each straw is then digitized on its own, from
+// the clusters to the digis, possibly concurrently with the others.  The random numbers for a
+// straw come from an engine seeded with the straw number and a per-event key drawn from the
+// module engine, so the digis do not depend on the number of threads.
+// The waveforms are evaluated from the cached responses of their clusters unless ReferenceWaveform
+// is set; the digis are the same either way.
+//
 // Original author David Brown, LBNL
 //
 // framework
@@ -31,7 +38,7 @@
 #include "GlobalConstantsService/inc/ParticleDataTable.hh"
 // utiliities
 #include "Mu2eUtilities/inc/TwoLinePCA.hh"
-#include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
+#include "Mu2eUtilities/inc/SimParticleTimeTable.hh"
 #include "DataProducts/inc/TrkTypes.hh"
 // persistent data
 #include "DataProducts/inc/EventWindowMarker.hh"
@@ -46,6 +53,7 @@
 #include "TrackerMC/inc/IonCluster.hh"
 #include "TrackerMC/inc/StrawPosition.hh"
 //CLHEP
+#include "CLHEP/Random/MixMaxRng.h"
 #include "CLHEP/Random/RandGaussQ.h"
 #include "CLHEP/Random/RandFlat.h"
 #include "CLHEP/Random/RandExponential.h"
@@ -58,6 +66,11 @@
 #include "TGraph.h"
 #include "TMarker.h"
 #include "TTree.h"
+// TBB
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 // C++
 #include <map>
 #include <algorithm>
@@ -82,6 +95,29 @@ namespace mu2e {
       float _wdist; // propagation distance from the point of collection to the end
     };
 
+    struct StrawStep { // StrawGasStep selected for digitization
+      art::Ptr<StrawGasStep> _sgsptr;
+      double _ctime; // microbunch time of the step, offsets applied
+    };
+
+    struct StrawRandom { // random numbers and scratch space used to digitize one straw
+      StrawRandom() : _randgauss(_engine), _randflat(_engine), _randP(_engine) {}
+      StrawRandom(StrawRandom const&) = delete;
+      StrawRandom& operator =(StrawRandom const&) = delete;
+      CLHEP::MixMaxRng _engine; // reseeded for every straw
+      CLHEP::RandGaussQ _randgauss;
+      CLHEP::RandFlat _randflat;
+      CLHEP::RandPoisson _randP;
+      vector<IonCluster> _clusters;
+      std::array<ClusterResponses,2> _cresps; // by straw end
+    };
+
+    struct StrawDigiOutput { // digis made by one straw, before they are merged into the event
+      StrawDigiCollection _digis;
+      StrawDigiADCWaveformCollection _digiadcs;
+      StrawDigiMCCollection _mcdigis;
+    };
+
     class StrawDigisFromStrawGasSteps : public art::EDProducer {
       public:
 	using Name=fhicl::Name;
@@ -116,12 +152,14 @@ namespace mu2e {
 	  fhicl::Atom<string> spinstance { Name("StrawGasStepInstance"), Comment("StrawGasStep Instance name"),""};
 	  fhicl::Atom<string> spmodule { Name("StrawGasStepModule"), Comment("StrawGasStep Module name"),""};
 	  fhicl::Sequence<art::InputTag> SPTO { Name("TimeOffsets"), Comment("Sim Particle Time Offset Maps")};
+	  fhicl::Atom<unsigned> nthreads { Name("NThreads"), Comment("Maximum number of threads digitizing straws (0 = no limit, 1 = serial)"),0};
+	  fhicl::Atom<bool> refwf { Name("ReferenceWaveform"), Comment("Evaluate the waveforms cluster by cluster, without cached responses (validation)"),false};
 
 	};
 
 	typedef art::Ptr<StrawGasStep> SGSPtr;
 	typedef art::Ptr<SimParticle> SPPtr;
-	typedef map<StrawId,StrawClusterSequencePair> StrawClusterMap;  // clusts by straw
+	typedef vector<StrawClusterSequencePair> StrawClusterMap;  // clusts by unique straw number
 	// work with pairs of waveforms, one for each straw end
 	typedef std::array<StrawWaveform,2> SWFP;
 	typedef std::array<WFX,2> WFXP;
@@ -162,12 +200,20 @@ namespace mu2e {
 	std::vector<uint16_t> _allPlanes;
 	unsigned _maxnclu;
 	StrawElectronics::Path _diagpath; 
-	// Random number distributions
+	// Random number distributions.  The module engine only provides the event-level numbers
 	art::RandomNumberGenerator::base_engine_t& _engine;
 	CLHEP::RandGaussQ _randgauss;
 	CLHEP::RandFlat _randflat;
-	CLHEP::RandExponential _randexp;
-	CLHEP::RandPoisson _randP;
+	uint64_t _eventSeed; // key for the straw engines of this event
+	// per-straw work
+	unsigned _nthreads;
+	bool _refwf;
+	tbb::task_arena _arena;
+	tbb::enumerable_thread_specific<StrawRandom> _random;
+	vector<vector<StrawStep>> _ssteps; // selected steps by unique straw number
+	StrawClusterMap _hmap;
+	vector<uint16_t> _straws; // unique numbers of the straws with selected steps, in StrawId order
+	vector<StrawDigiOutput> _sdout; // digis of the straws in _straws
 	// A category for the error logger.
 	const string _messageCategory;
 	// Give some informationation messages only on the first event.
@@ -176,7 +222,8 @@ namespace mu2e {
 	ProditionsHandle<StrawPhysics> _strawphys_h;
 	ProditionsHandle<StrawElectronics> _strawele_h;
 	art::Selector _selector;
-	SimParticleTimeOffset _toff; // time offsets
+	vector<art::InputTag> _toffInputs; // time offset maps
+	SimParticleTimeTable _toff; // time offsets
 	double _rstraw; // cache
 	// diagnostics
 	TTree* _swdiag;
@@ -218,45 +265,53 @@ namespace mu2e {
         double _digitizationEndFromMarker;
 
 	//  helper functions
-	void fillClusterMap(StrawPhysics const& strawphys,
-	    StrawElectronics const& strawele,Tracker const& tracker,
-	    art::Event const& event, StrawClusterMap & hmap);
+	void fillStrawSteps(StrawElectronics const& strawele,Tracker const& tracker,
+	    art::Event const& event);
+	void digitizeStraw(StrawPhysics const& strawphys,
+	    StrawElectronics const& strawele,
+	    Tracker const& tracker,
+	    uint16_t ustraw, StrawRandom& rand,
+	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
 	void addStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
-	    SGSPtr const& sgsptr,
+	    StrawStep const& sstep,
+	    StrawRandom& rand,
 	    StrawClusterSequencePair& shsp);
 	void divideStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
 	    StrawGasStep const& step, 
+	    StrawRandom& rand,
 	    vector<IonCluster>& clusters);
 	void driftCluster(StrawPhysics const& strawphys, Straw const& straw,
-	    IonCluster const& cluster, WireCharge& wireq);
+	    IonCluster const& cluster, StrawRandom& rand, WireCharge& wireq);
 	void propagateCharge(StrawPhysics const& strawphys, Straw const& straw,
 	    WireCharge const& wireq, StrawEnd end, WireEndCharge& weq);
 	double microbunchTime(StrawElectronics const& strawele, double globaltime) const;
 	void addGhosts(StrawElectronics const& strawele, StrawCluster const& clust,StrawClusterSequence& shs);
-	void addNoise(StrawClusterMap& hmap);
-	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings);
+	void addNoise(StrawClusterSequencePair& hsp, StrawRandom& rand);
+	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, StrawRandom& rand, WFXPList& xings);
 	void createDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
             Straw const& straw,
 	    StrawClusterSequencePair const& hsp,
 	    XTalk const& xtalk,
+	    StrawRandom& rand,
 	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
 	void fillDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
 	    WFXPList const& xings,SWFP const& swfp , StrawId sid,
+	    StrawRandom& rand,
 	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
-	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid, StrawDigiCollection* digis,
-            StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time);
+	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid, StrawRandom& rand,
+	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time);
 	void findCrossTalkStraws(Straw const& straw,vector<XTalk>& xtalk);
-	void fillClusterNe(StrawPhysics const& strawphys,std::vector<unsigned>& me);
-	void fillClusterPositions(StrawGasStep const& step, Straw const& straw, std::vector<StrawPosition>& cpos);
-	void fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, std::vector<unsigned>& me, std::vector<float>& cen);
+	void fillClusterNe(StrawPhysics const& strawphys, StrawRandom& rand, std::vector<unsigned>& me);
+	void fillClusterPositions(StrawGasStep const& step, Straw const& straw, StrawRandom& rand, std::vector<StrawPosition>& cpos);
+	void fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, StrawRandom& rand, std::vector<unsigned>& me, std::vector<float>& cen);
 	bool readAll(StrawId const& sid) const;
 	// diagnostic functions
 	void waveformHist(StrawElectronics const& strawele,
@@ -264,7 +319,7 @@ namespace mu2e {
 	void waveformDiag(StrawElectronics const& strawele,
 	    SWFP const& wf, WFXPList const& xings);
 	void digiDiag(StrawPhysics const& strawphys, SWFP const& wf, WFXP const& xpair, StrawDigi const& digi, StrawDigiADCWaveform const& digiadc, StrawDigiMC const& mcdigi);
-	void stepDiag(StrawPhysics const& strawphys, StrawElectronics const& strawele, StrawGasStep const& sgs);
+	void stepDiag(StrawPhysics const& strawphys, StrawElectronics const& strawele, StrawGasStep const& sgs, vector<IonCluster> const& clusters);
 	StrawPosition strawPosition( XYZVec const& cpos,Straw const& straw) const;
 	XYZVec strawPosition( StrawPosition const& cpos, Straw const& straw) const;
     };
@@ -300,13 +355,16 @@ namespace mu2e {
       _engine(createEngine( art::ServiceHandle<SeedService>()->getSeed())),
       _randgauss( _engine ),
       _randflat( _engine ),
-      _randexp( _engine),
-      _randP( _engine),
+      _nthreads(config().nthreads()),
+      _refwf(config().refwf()),
+      _arena(_nthreads > 0 ? (int)_nthreads : tbb::task_arena::automatic),
+      _ssteps(StrawId::_nustraws),
+      _hmap(StrawId::_nustraws),
       _messageCategory("HITS"),
       _firstEvent(true),      // Control some information messages.
       // This selector will select only data products with the given instance name.
       _selector{ art::ProductInstanceNameSelector(config().spinstance())},
-      _toff(config().SPTO())
+      _toffInputs(config().SPTO())
       {
         if (config().spmodule() != ""){
           _selector = art::Selector(_selector && art::ModuleLabelSelector(config().spmodule()));
@@ -439,7 +497,7 @@ namespace mu2e {
       StrawPhysics const& strawphys = _strawphys_h.get(event.id());
       StrawElectronics const& strawele = _strawele_h.get(event.id());
       const Tracker& tracker = *GeomHandle<Tracker>();
-      _toff.updateMap(event);
+      _toff.fill(event,_toffInputs);
       _mbtime = accPar->deBuncherPeriod;
       art::Handle<EventWindowMarker> ewMarkerHandle;
       event.getByLabel(_ewMarkerTag, ewMarkerHandle);
@@ -467,38 +525,44 @@ namespace mu2e {
       // make the microbunch buffer long enough to get the full waveform
       _mbbuffer = (strawele.nADCSamples() - strawele.nADCPreSamples())*strawele.adcPeriod();
       _adcbuffer = 0.01*strawele.adcPeriod();
+      // key for the straw random engines of this event
+      _eventSeed = (static_cast<uint64_t>(_randflat.fireInt(1L<<24))<<24) | static_cast<uint64_t>(_randflat.fireInt(1L<<24));
       // Containers to hold the output information.
       unique_ptr<StrawDigiCollection> digis(new StrawDigiCollection);
       unique_ptr<StrawDigiADCWaveformCollection> digiadcs(new StrawDigiADCWaveformCollection);
       unique_ptr<StrawDigiMCCollection> mcdigis(new StrawDigiMCCollection);
-      // create the StrawCluster map
-      // this is a map from straw ids to a list of all clusters on that straw from this event
-      StrawClusterMap hmap;
-      // fill this from the event
-      fillClusterMap(strawphys,strawele,tracker,event,hmap);
-      // add noise clusts
-      if(_addNoise)addNoise(hmap);
-      // loop over the clust sequences (i.e. loop over straws, and for each get their list of clusters)
-      for(auto ihsp=hmap.begin();ihsp!= hmap.end();++ihsp){
-	StrawClusterSequencePair const& hsp = ihsp->second;
-	Straw const& straw = tracker.getStraw(hsp.strawId());
-	// create primary digis from this clust sequence
-	XTalk self(hsp.strawId()); // this object represents the straws coupling to itself, ie 100%
-	createDigis(strawphys,strawele,tracker,straw,hsp,self,digis.get(),digiadcs.get(),mcdigis.get());
-	// if we're applying x-talk, look for nearby coupled straws
-	if(_addXtalk) {
-	  // only apply if the charge is above a threshold
-	  double totalCharge = 0;
-	  for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
-	    totalCharge += ih->charge();
-	  }
-	  if( totalCharge > _ctMinCharge){
-	    vector<XTalk> xtalk;
-	    findCrossTalkStraws(straw,xtalk);
-	    for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
-	      createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,digis.get(),digiadcs.get(),mcdigis.get());
-	    }
-	  }
+      // group the steps from this event by straw
+      fillStrawSteps(strawele,tracker,event);
+      // digitize the straws.  Diagnostics fill shared trees, so they require serial processing
+      if(_diag > 0 || _nthreads == 1){
+	for(auto ustraw : _straws)
+	  digitizeStraw(strawphys,strawele,tracker,ustraw,_random.local(),digis.get(),digiadcs.get(),mcdigis.get());
+      } else {
+	_sdout.resize(_straws.size());
+	_arena.execute([&]() {
+	    tbb::parallel_for(tbb::blocked_range<size_t>(0,_straws.size()),
+	      [&](tbb::blocked_range<size_t> const& range) {
+		StrawRandom& rand = _random.local();
+		for(size_t istraw = range.begin(); istraw != range.end(); ++istraw){
+		  StrawDigiOutput& sdout = _sdout[istraw];
+		  sdout._digis.clear();
+		  sdout._digiadcs.clear();
+		  sdout._mcdigis.clear();
+		  digitizeStraw(strawphys,strawele,tracker,_straws[istraw],rand,&sdout._digis,&sdout._digiadcs,&sdout._mcdigis);
+		}
+	      });
+	    });
+	// merge in straw order
+	size_t ndigi(0);
+	for(size_t istraw = 0; istraw < _straws.size(); ++istraw) ndigi += _sdout[istraw]._digis.size();
+	digis->reserve(ndigi);
+	digiadcs->reserve(ndigi);
+	mcdigis->reserve(ndigi);
+	for(size_t istraw = 0; istraw < _straws.size(); ++istraw){
+	  StrawDigiOutput& sdout = _sdout[istraw];
+	  std::move(sdout._digis.begin(),sdout._digis.end(),std::back_inserter(*digis));
+	  std::move(sdout._digiadcs.begin(),sdout._digiadcs.end(),std::back_inserter(*digiadcs));
+	  std::move(sdout._mcdigis.begin(),sdout._mcdigis.end(),std::back_inserter(*mcdigis));
 	}
       }
       // store the digis in the event
@@ -512,6 +576,49 @@ namespace mu2e {
 
     } // end produce
 
+    void StrawDigisFromStrawGasSteps::digitizeStraw(StrawPhysics const& strawphys,
+	StrawElectronics const& strawele,
+	Tracker const& tracker,
+	uint16_t ustraw, StrawRandom& rand,
+	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
+	StrawDigiMCCollection* mcdigis) {
+      // seed the engine from the event key and the straw number (splitmix64 finalizer)
+      uint64_t seed = _eventSeed + (static_cast<uint64_t>(ustraw)+1)*0x9E3779B97F4A7C15ULL;
+      seed = (seed ^ (seed >> 30))*0xBF58476D1CE4E5B9ULL;
+      seed = (seed ^ (seed >> 27))*0x94D049BB133111EBULL;
+      seed ^= seed >> 31;
+      rand._engine.setSeed(static_cast<long>(seed));
+      vector<StrawStep> const& ssteps = _ssteps[ustraw];
+      StrawId sid = ssteps.front()._sgsptr->strawId();
+      Straw const& straw = tracker.getStraw(sid);
+      // create the clusters of this straw from its steps
+      StrawClusterSequencePair& hsp = _hmap[ustraw];
+      hsp.reset(sid);
+      for(auto const& sstep : ssteps)
+	addStep(strawphys,strawele,straw,sstep,rand,hsp);
+      // add noise clusts
+      if(_addNoise)addNoise(hsp,rand);
+      hsp.sort();
+      // create primary digis from this clust sequence
+      XTalk self(sid); // this object represents the straws coupling to itself, ie 100%
+      createDigis(strawphys,strawele,tracker,straw,hsp,self,rand,digis,digiadcs,mcdigis);
+      // if we're applying x-talk, look for nearby coupled straws
+      if(_addXtalk) {
+	// only apply if the charge is above a threshold
+	double totalCharge = 0;
+	for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
+	  totalCharge += ih->charge();
+	}
+	if( totalCharge > _ctMinCharge){
+	  vector<XTalk> xtalk;
+	  findCrossTalkStraws(straw,xtalk);
+	  for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
+	    createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,rand,digis,digiadcs,mcdigis);
+	  }
+	}
+      }
+    }
+
     void StrawDigisFromStrawGasSteps::createDigis(
 	StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
@@ -519,23 +626,28 @@ namespace mu2e {
         Straw const& straw,
 	StrawClusterSequencePair const& hsp,
 	XTalk const& xtalk,
+	StrawRandom& rand,
 	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
         StrawDigiMCCollection* mcdigis) {
+      // cache the cluster responses; the cross-talk waveforms share those of the source straw
+      if(!_refwf && xtalk.self()){
+	fillClusterResponses(strawele,straw,hsp.clustSequence(StrawEnd::cal),rand._cresps[StrawEnd::cal]);
+	fillClusterResponses(strawele,straw,hsp.clustSequence(StrawEnd::hv),rand._cresps[StrawEnd::hv]);
+      }
       // instantiate waveforms for both ends of this straw
-      SWFP waveforms  ={ StrawWaveform(straw,hsp.clustSequence(StrawEnd::cal),xtalk),
-	StrawWaveform(straw,hsp.clustSequence(StrawEnd::hv),xtalk) };
+      SWFP waveforms  ={ StrawWaveform(straw,hsp.clustSequence(StrawEnd::cal),xtalk,_refwf ? 0 : &rand._cresps[StrawEnd::cal]),
+	StrawWaveform(straw,hsp.clustSequence(StrawEnd::hv),xtalk,_refwf ? 0 : &rand._cresps[StrawEnd::hv]) };
       // find the threshold crossing points for these waveforms
       WFXPList xings;
       // find the threshold crossings
-      findThresholdCrossings(strawele,waveforms,xings);
+      findThresholdCrossings(strawele,waveforms,rand,xings);
       // convert the crossing points into digis, and add them to the event data
-      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,digis,digiadcs,mcdigis);
+      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,rand,digis,digiadcs,mcdigis);
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterMap(StrawPhysics const& strawphys,
-	StrawElectronics const& strawele,
+    void StrawDigisFromStrawGasSteps::fillStrawSteps(StrawElectronics const& strawele,
 	const Tracker& tracker,
-	art::Event const& event, StrawClusterMap & hmap){
+	art::Event const& event){
       // Get all of the tracker StrawGasStep collections from the event:
       typedef vector< art::Handle<StrawGasStepCollection> > HandleVector;
       HandleVector stepsHandles = event.getMany<StrawGasStepCollection>( _selector);
@@ -552,6 +664,8 @@ namespace mu2e {
       if(stepsHandles.empty()){
 	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: No StrawGasStep collections found for tracker" << endl;
       }
+      for(auto ustraw : _straws) _ssteps[ustraw].clear();
+      _straws.clear();
 
       // Loop over StrawGasStep collections
       for ( auto const& sgsch : stepsHandles) {
@@ -559,38 +673,45 @@ namespace mu2e {
 	// Loop over the StrawGasSteps in this collection
 	for(size_t isgs = 0; isgs < steps.size(); isgs++){
 	  auto const& sgs = steps[isgs];
-	  // lookup straw here, to avoid having to find the tracker for every step
 	  StrawId const & sid = sgs.strawId();
-	  Straw const& straw = tracker.getStraw(sid);
 	  if(sgs.ionizingEdep() > _minstepE){
-	    auto sgsptr = SGSPtr(sgsch,isgs);
-	    // create a clust from this step, and add it to the clust map
-	    addStep(strawphys,strawele,straw,sgsptr,hmap[sid]);
+	    // apply time offsets, and take module with MB
+	    double ctime  = microbunchTime(strawele,sgs.time() + _toff.totalTimeOffset(sgs.simParticle()));
+	    // test if this step point is roughly in the digitization window
+	    if( (ctime > strawele.digitizationStartFromMarker() - strawele.electronicsTimeDelay() - _steptimebuf
+		  && ctime <  max(_mbtime,_digitizationEndFromMarker) - strawele.electronicsTimeDelay() + _steptimebuf) || readAll(sid)) {
+	      auto& ssteps = _ssteps[sid.uniqueStraw()];
+	      if(ssteps.empty())_straws.push_back(sid.uniqueStraw());
+	      ssteps.push_back(StrawStep{SGSPtr(sgsch,isgs),ctime});
+	    }
 	  }
 	}
       }
+      // the unique straw number follows the StrawId order
+      std::sort(_straws.begin(),_straws.end());
     }
 
     void StrawDigisFromStrawGasSteps::addStep(StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
 	Straw const& straw,
-	SGSPtr const& sgsptr,
+	StrawStep const& sstep,
+	StrawRandom& rand,
 	StrawClusterSequencePair& shsp) {
+      SGSPtr const& sgsptr = sstep._sgsptr;
       auto const& sgs = *sgsptr;
       StrawId sid = sgs.strawId();
-      // apply time offsets, and take module with MB
-      double ctime  = microbunchTime(strawele,sgs.time() + _toff.totalTimeOffset(sgs.simParticle()));
-      // test if this step point is roughly in the digitization window
-      if( (ctime > strawele.digitizationStartFromMarker() - strawele.electronicsTimeDelay() - _steptimebuf
-	    && ctime <  max(_mbtime,_digitizationEndFromMarker) - strawele.electronicsTimeDelay() + _steptimebuf) || readAll(sid)) {
+      // the time window was checked when selecting the step
+      double ctime = sstep._ctime;
+      {
 	// Subdivide the StrawGasStep into ionization clusters
-	_clusters.clear();
-	divideStep(strawphys,strawele,straw,sgs,_clusters);
+	vector<IonCluster>& clusters = rand._clusters;
+	clusters.clear();
+	divideStep(strawphys,strawele,straw,sgs,rand,clusters);
 	// check
 	// drift these clusters to the wire, and record the charge at the wire
-	for(auto iclu = _clusters.begin(); iclu != _clusters.end(); ++iclu){
+	for(auto iclu = clusters.begin(); iclu != clusters.end(); ++iclu){
 	  WireCharge wireq;
-	  driftCluster(strawphys,straw,*iclu,wireq);
+	  driftCluster(strawphys,straw,*iclu,rand,wireq);
 	  // propagate this charge to each end of the wire
 	  for(size_t iend=0;iend<2;++iend){
 	    StrawEnd end(static_cast<StrawEnd::End>(iend));
@@ -602,14 +723,14 @@ namespace mu2e {
 	    double gtime = ctime + wireq._time + weq._time;
 	    // create the clust
 	    StrawCluster clust(StrawCluster::primary,sid,end,(float)gtime,weq._charge,weq._wdist,wireq._pos,(float)wireq._time,(float)weq._time,sgsptr,(float)ctime);
-	    // add the clusts to the appropriate sequence.
-	    shsp.clustSequence(end).insert(clust);
+	    // add the clusts to the appropriate sequence; they are time-ordered once the straw is complete
+	    shsp.clustSequence(end).append(clust);
 	    // if required, add a 'ghost' copy of this clust
             if (_onSpill)
   	      addGhosts(strawele,clust,shsp.clustSequence(end));
 	  }
 	}
-	if(_diag > 0) stepDiag(strawphys, strawele, sgs);
+	if(_diag > 0) stepDiag(strawphys, strawele, sgs, clusters);
       }
     }
 
@@ -617,12 +738,13 @@ namespace mu2e {
 	StrawElectronics const& strawele,
 	Straw const& straw,
 	StrawGasStep const& sgs,
+	StrawRandom& rand,
 	vector<IonCluster>& clusters) {
       // single cluster
       if (sgs.stepType().shape() == StrawGasStep::StepType::point || sgs.stepLength() < strawphys.meanFreePath()){
 	float cen = sgs.ionizingEdep();
 	float fne = cen/strawphys.meanElectronEnergy();
-	unsigned ne = std::max( static_cast<unsigned>(_randP(fne)),(unsigned)1);
+	unsigned ne = std::max( static_cast<unsigned>(rand._randP(fne)),(unsigned)1);
 	auto spos = strawPosition(sgs.startPosition(),straw);
 	if(_drift1e){
 	  for (size_t i=0;i<ne;i++){
@@ -637,7 +759,7 @@ namespace mu2e {
 	// compute the number of clusters for this step from the mean free path
 	double fnc = sgs.stepLength()/strawphys.meanFreePath();
 	// use a truncated Poisson distribution; this keeps both the mean and variance physical
-	unsigned nc = std::max(static_cast<unsigned>(_randP.fire(fnc)),(unsigned)1);
+	unsigned nc = std::max(static_cast<unsigned>(rand._randP.fire(fnc)),(unsigned)1);
 	// if not minion, limit the number of steps geometrically
 	bool minion = (sgs.stepType().ionization()==StrawGasStep::StepType::minion);
 	if(!minion )nc = std::min(nc,_maxnclu);
@@ -645,17 +767,17 @@ namespace mu2e {
 	nc = std::min(nc,static_cast<unsigned>(floor(sgs.ionizingEdep()/strawphys.ionizationEnergy((unsigned)1))));
 	// generate random positions for the clusters
 	std::vector<StrawPosition> cposv(nc);
-	fillClusterPositions(sgs,straw,cposv);
+	fillClusterPositions(sgs,straw,rand,cposv);
 	// generate electron counts and energies for these clusters: minion model is more detailed
 	std::vector<unsigned> ne(nc);
 	std::vector<float> cen(nc);
 	if(minion){
-	  fillClusterMinion(strawphys,sgs,ne,cen);
+	  fillClusterMinion(strawphys,sgs,rand,ne,cen);
 	} else {
 	  // get Poisson distribution of # of electrons for the average energy
 	  double fne = sgs.ionizingEdep()/(nc*strawphys.meanElectronEnergy()); // average # of electrons/cluster for non-minion clusters
 	  for(unsigned ic=0;ic<nc;++ic){
-	    ne[ic] = static_cast<unsigned>(std::max(_randP.fire(fne),(long)1));
+	    ne[ic] = static_cast<unsigned>(std::max(rand._randP.fire(fne),(long)1));
 	    cen[ic] = ne[ic]*strawphys.meanElectronEnergy(); // average energy per electron, works for large numbers of electrons
 	  }
 	}
@@ -679,14 +801,14 @@ namespace mu2e {
 
     void StrawDigisFromStrawGasSteps::driftCluster(
 	StrawPhysics const& strawphys,Straw const& straw,
-	IonCluster const& cluster, WireCharge& wireq ) {
+	IonCluster const& cluster, StrawRandom& rand, WireCharge& wireq ) {
       // sample the gain for this cluster
-      double gain = strawphys.clusterGain(_randgauss, _randflat, cluster._ne);
+      double gain = strawphys.clusterGain(rand._randgauss, rand._randflat, cluster._ne);
       wireq._charge = cluster._charge*(gain);
       // compute drift time for this cluster
       double dt = strawphys.driftDistanceToTime(cluster._pos.Rho(),cluster._pos.Phi()); // this is now from the lorentz corrected r-component of the drift
       wireq._pos = cluster._pos;
-      wireq._time = _randgauss.fire(dt,strawphys.driftTimeSpread(cluster._pos.Rho()));
+      wireq._time = rand._randgauss.fire(dt,strawphys.driftTimeSpread(cluster._pos.Rho()));
     }
 
     void StrawDigisFromStrawGasSteps::propagateCharge(
@@ -721,19 +843,19 @@ namespace mu2e {
       // at this point cluster times are relative to marker and wrapped at 1695 (if onspill)
       // wrap from beginning of microbunch to times > 1695 to digitize ADCs for hits near end of event window
       if(clust.time() < _mbbuffer)
-	shs.insert(StrawCluster(clust,_mbtime));
+	shs.append(StrawCluster(clust,_mbtime));
       // wrap from end of microbunch to negative time to digitize ADCs for hits at tdc time=0
-      if(clust.time() > _mbtime - _mbbuffer) shs.insert(StrawCluster(clust,-_mbtime));
+      if(clust.time() > _mbtime - _mbbuffer) shs.append(StrawCluster(clust,-_mbtime));
     }
 
-    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings){
+    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, StrawRandom& rand, WFXPList& xings){
       //randomize the threshold to account for electronics noise; this includes parts that are coherent
       // for both ends (coming from the straw itself)
       // Keep track of crossings on each end to keep them in sequence
-      double strawnoise = _randgauss.fire(0,strawele.strawNoise());
+      double strawnoise = rand._randgauss.fire(0,strawele.strawNoise());
       // add specifics for each end
-      double thresh[2] = {_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
-	_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
+      double thresh[2] = {rand._randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
+	rand._randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
       // Initialize search when the electronics becomes enabled:
       double tstart =strawele.digitizationStartFromMarker() - _flashbuffer; 
       // for reading all hits, make sure we start looking for clusters at the minimum possible cluster time
@@ -756,14 +878,14 @@ namespace mu2e {
 	  if(std::min(wfx[0]._time,wfx[1]._time) > 0.0 )xings.push_back(wfx);
 	  // search for next crossing:
 	  // update threshold for straw noise
-	  strawnoise = _randgauss.fire(0,strawele.strawNoise());
+	  strawnoise = rand._randgauss.fire(0,strawele.strawNoise());
 	  for(unsigned iend=0;iend<2;++iend){
 	    // insure a minimum time buffer between crossings
 	    wfx[iend]._time += strawele.deadTimeAnalog();
 	    // skip to the next clust
 	    ++(wfx[iend]._iclust);
 	    // update threshold for incoherent noise
-	    thresh[iend] = _randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
+	    thresh[iend] = rand._randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
 	    // find next crossing
 	    crosses[iend] = swfp[iend].crossesThreshold(strawele,thresh[iend],wfx[iend]);
 	  }
@@ -782,6 +904,7 @@ namespace mu2e {
 	Tracker const& tracker,
 	WFXPList const& xings, SWFP const& wf,
 	StrawId sid,
+	StrawRandom& rand,
 	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
         StrawDigiMCCollection* mcdigis ) {
 	//
@@ -791,7 +914,7 @@ namespace mu2e {
       for(auto xpair : xings) {
 	// create a digi from this pair.  This also performs a finial test
 	// on whether the pair should make a digi
-	if(createDigi(strawele,xpair,wf,sid,digis,digiadcs,digitization_ready_time)){
+	if(createDigi(strawele,xpair,wf,sid,rand,digis,digiadcs,digitization_ready_time)){
 	  // fill associated MC truth matching. Only count the same step once
 	  StrawDigiMC::SGSPA sgspa;
 	  StrawDigiMC::PA cpos;
@@ -826,7 +949,7 @@ namespace mu2e {
     }
 
     bool StrawDigisFromStrawGasSteps::createDigi(StrawElectronics const& strawele, WFXP const& xpair, SWFP const& waveform,
-	StrawId sid, StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time){
+	StrawId sid, StrawRandom& rand, StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time){
       // initialize the float variables that we later digitize
       TDCTimes xtimes = {0.0,0.0};
       TrkTypes::TOTValues tot;
@@ -843,10 +966,10 @@ namespace mu2e {
 	WFX const& wfx = xpair[iend];
 	// record the crossing time for this end, including clock jitter  These already include noise effects
 	// add noise for TDC on each side
-	double tdc_jitter = _randgauss.fire(0.0,strawele.TDCResolution());
+	double tdc_jitter = rand._randgauss.fire(0.0,strawele.TDCResolution());
 	xtimes[iend] = wfx._time+dt+tdc_jitter;
 	// randomize threshold using the incoherent noise
-	double threshold = _randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
+	double threshold = rand._randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
 	// find TOT
 	tot[iend] = waveform[iend].digitizeTOT(strawele,threshold,wfx._time + dt);
 	// sample ADC
@@ -861,7 +984,7 @@ namespace mu2e {
       // add ends and add noise
       ADCVoltages wfsum; wfsum.reserve(adctimes.size());
       for(unsigned isamp=0;isamp<adctimes.size();++isamp){
-	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+_randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
+	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+rand._randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
       }
       // digitize, and make final test.  This call includes the clock error WRT the proton pulse
       TrkTypes::TDCValues tdcs;
@@ -910,28 +1033,28 @@ namespace mu2e {
 
     // functions that need implementing:: FIXME!!!!!!
     // Could also fold in beam-off random trigger hits from real data
-    void StrawDigisFromStrawGasSteps::addNoise(StrawClusterMap& hmap){
-      // create random noise clusts and add them to the sequences of random straws.
+    void StrawDigisFromStrawGasSteps::addNoise(StrawClusterSequencePair& hsp, StrawRandom& rand){
+      // create random noise clusts and add them to the sequences of this straw.  Straws without steps get no noise yet
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterPositions(StrawGasStep const& sgs, Straw const& straw, std::vector<StrawPosition>& cposv) {
+    void StrawDigisFromStrawGasSteps::fillClusterPositions(StrawGasStep const& sgs, Straw const& straw, StrawRandom& rand, std::vector<StrawPosition>& cposv) {
       // generate a random position between the start and end points.
       XYZVec path = sgs.endPosition() - sgs.startPosition();
       for(auto& cpos : cposv) {
-	XYZVec pos = sgs.startPosition() + _randflat.fire(1.0)*path;
+	XYZVec pos = sgs.startPosition() + rand._randflat.fire(1.0)*path;
       	// randomize the position by width.  This needs to be 2-d to avoid problems at the origin
 	if(_randrad){
 	  XYZVec sdir = Geom::toXYZVec(straw.getDirection());
 	  XYZVec p1 = path.Cross(sdir).Unit();
 	  XYZVec p2 = path.Cross(p1).Unit();
-	  pos += p1*_randgauss.fire()*sgs.width();
-	  pos += p2*_randgauss.fire()*sgs.width();
+	  pos += p1*rand._randgauss.fire()*sgs.width();
+	  pos += p2*rand._randgauss.fire()*sgs.width();
 	}
 	cpos = strawPosition(pos,straw);
       }
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, std::vector<unsigned>& ne, std::vector<float>& cen) {
+    void StrawDigisFromStrawGasSteps::fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, StrawRandom& rand, std::vector<unsigned>& ne, std::vector<float>& cen) {
       // Loop until we've assigned energy + electrons to every cluster
       unsigned mc(0);
       double esum(0.0);
@@ -940,7 +1063,7 @@ namespace mu2e {
       while(mc < nc){
 	std::vector<unsigned> me(nc);
 	// fill an array of random# of electrons according to the measured distribution. 
-	fillClusterNe(strawphys,me);
+	fillClusterNe(strawphys,rand,me);
 	// loop through these as long as there's enough energy to have at least 1 electron in each cluster.  If not, re-throw the # of electrons/cluster for the remainder
 	for(auto ie : me) {
 	  double emax = etot - esum - (nc -mc -1)*strawphys.ionizationEnergy((unsigned)1);
@@ -958,12 +1081,12 @@ namespace mu2e {
       // distribute any residual energy randomly to these clusters.  This models delta rays
       unsigned ns;
       do{
-	unsigned me = strawphys.nePerIon(_randflat.fire());
+	unsigned me = strawphys.nePerIon(rand._randflat.fire());
 	double emax = etot - esum;
 	double eele = strawphys.ionizationEnergy(me);
 	if(eele < emax){
 	  // choose a random cluster to assign this energy to
-	  unsigned mc = std::min(nc-1,static_cast<unsigned>(floor(_randflat.fire(nc))));
+	  unsigned mc = std::min(nc-1,static_cast<unsigned>(floor(rand._randflat.fire(nc))));
 	  ne[mc] += me;
 	  cen[mc] += eele;
 	  esum += eele;
@@ -973,9 +1096,9 @@ namespace mu2e {
       } while(ns > 0);
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterNe(StrawPhysics const& strawphys,std::vector<unsigned>& me) {
+    void StrawDigisFromStrawGasSteps::fillClusterNe(StrawPhysics const& strawphys, StrawRandom& rand, std::vector<unsigned>& me) {
       for(size_t ie=0;ie < me.size(); ++ie){
-	me[ie] = strawphys.nePerIon(_randflat.fire());
+	me[ie] = strawphys.nePerIon(rand._randflat.fire());
       }
     }
 
@@ -1210,7 +1333,8 @@ namespace mu2e {
     }//End of digiDiag
 
     void StrawDigisFromStrawGasSteps::stepDiag( StrawPhysics const& strawphys, StrawElectronics const& strawele,
-	StrawGasStep const& sgs) {
+	StrawGasStep const& sgs, vector<IonCluster> const& clusters) {
+      _clusters = clusters; // also written to the tree
       _steplen = sgs.stepLength();
       _stepE = sgs.ionizingEdep();
       _steptime = microbunchTime(strawele,sgs.time()+ _toff.totalTimeOffset(sgs.simParticle()));
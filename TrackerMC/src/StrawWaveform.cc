@@ -6,6 +6,7 @@
 // Original author David Brown, LBNL
 //
 #include "TrackerMC/inc/StrawWaveform.hh"
+#include <algorithm>
 #include <cmath>
 #include <boost/math/special_functions/binomial.hpp>
 
@@ -13,11 +14,18 @@ using namespace std;
 namespace mu2e {
   using namespace TrkTypes;
   namespace TrackerMC {
-    StrawWaveform::StrawWaveform(Straw const& straw, StrawClusterSequence const& hseq, XTalk const& xtalk) :
-      _cseq(hseq), _xtalk(xtalk), _straw(straw)
+    void fillClusterResponses(StrawElectronics const& strawele, Straw const& straw, StrawClusterSequence const& cseq, ClusterResponses& cresps) {
+      StrawClusterList const& hlist = cseq.clustList();
+      cresps.resize(hlist.size());
+      for(size_t iclust=0;iclust<hlist.size();++iclust)
+	strawele.clusterResponse(straw,hlist[iclust].time(),hlist[iclust].charge(),hlist[iclust].wireDistance(),cresps[iclust]);
+    }
+
+    StrawWaveform::StrawWaveform(Straw const& straw, StrawClusterSequence const& hseq, XTalk const& xtalk, ClusterResponses const* cresps) :
+      _cseq(hseq), _cresps(cresps), _xtalk(xtalk), _straw(straw)
     {}
 
-    StrawWaveform::StrawWaveform(StrawWaveform const& other) : _cseq(other._cseq),
+    StrawWaveform::StrawWaveform(StrawWaveform const& other) : _cseq(other._cseq), _cresps(other._cresps),
     _xtalk(other._xtalk), _straw(other._straw)
     {}
 
@@ -43,7 +51,7 @@ namespace mu2e {
 	    //// check if this clust could cross threshold
 	    //if(wfx._vstart + maxLinearResponse(wfx._iclust) > threshold){
 	      // check the actual response
-	      double maxtime = wfx._iclust->time()+strawele.maxResponseTime(_straw.id(),StrawElectronics::thresh,wfx._iclust->wireDistance());
+	      double maxtime = wfx._iclust->time()+maxResponseTime(strawele,wfx._iclust);
 	      double maxresp = sampleWaveform(strawele,StrawElectronics::thresh,maxtime);
 	      if(maxresp > threshold){
 		// interpolate to find the precise crossing
@@ -64,7 +72,7 @@ namespace mu2e {
     void StrawWaveform::returnCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const {
       while(wfx._iclust != _cseq.clustList().end() && wfx._vstart > threshold) {
 	// move forward in time at least as twice the time to the maxium for this clust
-	double time = wfx._iclust->time()+strawele.clusterLookbackTime() + 2*strawele.maxResponseTime(_straw.id(),StrawElectronics::thresh,wfx._iclust->wireDistance());
+	double time = wfx._iclust->time()+strawele.clusterLookbackTime() + 2*maxResponseTime(strawele,wfx._iclust);
 	while(wfx._iclust != _cseq.clustList().end() &&
 	    wfx._iclust->time()-strawele.clusterLookbackTime() < time){
 	  ++(wfx._iclust);
@@ -95,7 +103,7 @@ namespace mu2e {
     bool StrawWaveform::fineCrossing(StrawElectronics const& strawele, double threshold,double maxresp, WFX& wfx) const {
       static double timestep(0.020); // interpolation minimum to use linear threshold crossing calculation
       double pretime = wfx._iclust->time()-strawele.clusterLookbackTime();
-      double posttime = pretime + strawele.clusterLookbackTime() + strawele.maxResponseTime(_straw.id(),StrawElectronics::thresh,wfx._iclust->wireDistance());
+      double posttime = pretime + strawele.clusterLookbackTime() + maxResponseTime(strawele,wfx._iclust);
       double presample = wfx._vstart;
       double postsample = maxresp;
       static const unsigned maxstep(10); // 10 steps max
@@ -141,21 +149,33 @@ namespace mu2e {
 
     double StrawWaveform::maxLinearResponse(StrawElectronics const& strawele,StrawClusterList::const_iterator const& iclust) const {
       // ignore saturation effects
-      double linresp = strawele.maxLinearResponse(_straw.id(),StrawElectronics::thresh,iclust->wireDistance(),iclust->charge());
+      double linresp = _cresps ? clusterResponse(iclust)._maxResponse :
+	strawele.maxLinearResponse(_straw.id(),StrawElectronics::thresh,iclust->wireDistance(),iclust->charge());
       linresp *= (_xtalk._preamp + _xtalk._postamp);
       return linresp;
     }
 
+    double StrawWaveform::maxResponseTime(StrawElectronics const& strawele,StrawClusterList::const_iterator const& iclust) const {
+      return _cresps ? clusterResponse(iclust)._maxResponseTime :
+	strawele.maxResponseTime(_straw.id(),StrawElectronics::thresh,iclust->wireDistance());
+    }
+
     double StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
-      // loop over all clusts and add their response at this time
+      // loop over all clusts and add their response at this time.  The clusts are time-ordered, so
+      // the ones contributing are found by bisection
       StrawClusterList const& hlist = _cseq.clustList();
+      double tlook = strawele.clusterLookbackTime();
+      auto iend = std::partition_point(hlist.begin(),hlist.end(),
+	  [time,tlook](StrawCluster const& clust){ return clust.time()-tlook < time; });
       double linresp(0.0);
-      auto iclust = hlist.begin();
-      while(iclust != hlist.end() && iclust->time()-strawele.clusterLookbackTime() < time){
-	// compute the linear straw electronics response to this charge.  This is pre-saturation
-	linresp += strawele.linearResponse(_straw,ipath,time-iclust->time(),iclust->charge(),iclust->wireDistance());
-	// move to next clust
-	++iclust;
+      if(_cresps){
+	for(auto iclust = hlist.begin(); iclust != iend; ++iclust)
+	  linresp += strawele.linearResponse(clusterResponse(iclust),ipath,time-iclust->time());
+      } else {
+	for(auto iclust = hlist.begin(); iclust != iend; ++iclust){
+	  // compute the linear straw electronics response to this charge.  This is pre-saturation
+	  linresp += strawele.linearResponse(_straw,ipath,time-iclust->time(),iclust->charge(),iclust->wireDistance());
+	}
       }
       double totresp = linresp * _xtalk._postamp;
       if(_xtalk._preamp>0.0)
@@ -163,6 +183,33 @@ namespace mu2e {
       return totresp;
     }
 
+    void StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double const* times,size_t n,double* volts) const {
+      if(!_cresps){
+	for(size_t itime=0;itime<n;++itime)
+	  volts[itime] = sampleWaveform(strawele,ipath,times[itime]);
+	return;
+      }
+      // add the clusts in time order to all the times they contribute to.  Each time sums the same
+      // clusts in the same order as the single time evaluation
+      StrawClusterList const& hlist = _cseq.clustList();
+      double tlook = strawele.clusterLookbackTime();
+      std::fill(volts,volts+n,0.0);
+      size_t ifirst(0);
+      for(size_t iclust=0;iclust<hlist.size();++iclust){
+	double tclust = hlist[iclust].time()-tlook;
+	while(ifirst < n && !(tclust < times[ifirst]))++ifirst;
+	if(ifirst == n)break;
+	strawele.addLinearResponse((*_cresps)[iclust],ipath,false,times+ifirst,n-ifirst,volts+ifirst);
+      }
+      for(size_t itime=0;itime<n;++itime){
+	double linresp = volts[itime];
+	double totresp = linresp * _xtalk._postamp;
+	if(_xtalk._preamp>0.0)
+	  totresp += _xtalk._preamp*linresp;
+	volts[itime] = totresp;
+      }
+    }
+
     void StrawWaveform::sampleADCWaveform(StrawElectronics const& strawele,ADCTimes const& times,ADCVoltages& volts) const {
       volts.clear();
       volts.reserve(times.size());
@@ -199,6 +246,12 @@ namespace mu2e {
           volts.push_back(0);
         }
 
+        if(_cresps){
+          if(iclust != _cseq.clustList().end())
+            sampleSaturatedADCWaveform(strawele,iclust,times,volts);
+          return;
+        }
+
         int num_steps = (int)ceil((times[times.size()-1]-iclust->time()-strawele.clusterLookbackTime())/strawele.saturationTimeStep());
 
         for (int i=0;i<num_steps;i++){
@@ -218,6 +271,16 @@ namespace mu2e {
             volts[j] += strawele.adcImpulseResponse(_straw.id(),times[j]-time,sat_response);
           }
         }
+      }else if(_cresps){
+        // sample in blocks of ADC times, converted on the stack
+        static const size_t nblock(16);
+        std::array<double,nblock> btimes, bvolts;
+        for (size_t i0=0;i0<times.size();i0+=nblock){
+          size_t nt = std::min(nblock,times.size()-i0);
+          std::copy(times.begin()+i0,times.begin()+i0+nt,btimes.begin());
+          sampleWaveform(strawele,StrawElectronics::adc,btimes.data(),nt,bvolts.data());
+          volts.insert(volts.end(),bvolts.begin(),bvolts.begin()+nt);
+        }
       }else{
         for(auto itime=times.begin();itime!=times.end();++itime){
           volts.push_back(sampleWaveform(strawele,StrawElectronics::adc,*itime));
@@ -225,7 +288,48 @@ namespace mu2e {
       }
     }
 
+    void StrawWaveform::sampleSaturatedADCWaveform(StrawElectronics const& strawele,StrawClusterList::const_iterator iclust,
+	ADCTimes const& times,ADCVoltages& volts) const {
+      // sum the preamp response of the clusts on the saturation time grid, saturate it, then
+      // fold it with the ADC impulse response.  The grid and summation order are those of the
+      // reference evaluation
+      double tlook = strawele.clusterLookbackTime();
+      int num_steps = (int)ceil((times[times.size()-1]-iclust->time()-tlook)/strawele.saturationTimeStep());
+      if(num_steps <= 0)return;
+      std::vector<double> steptimes(num_steps), response(num_steps,0.0);
+      for (int i=0;i<num_steps;i++)
+        steptimes[i] = iclust->time()-tlook + i*strawele.saturationTimeStep();
+      size_t ifirst(0);
+      for(auto jclust = iclust;jclust != _cseq.clustList().end();++jclust){
+        double tclust = jclust->time()-tlook;
+        while(ifirst < steptimes.size() && !(tclust < steptimes[ifirst]))++ifirst;
+        if(ifirst == steptimes.size())break;
+        strawele.addLinearResponse(clusterResponse(jclust),StrawElectronics::thresh,true,
+            steptimes.data()+ifirst,steptimes.size()-ifirst,response.data()+ifirst);
+      }
+      for (int i=0;i<num_steps;i++){
+        double sat_response = strawele.saturatedResponse(response[i]);
+        strawele.addADCImpulseResponse(_straw.id(),steptimes[i],sat_response,times.data(),times.size(),volts.data());
+      }
+    }
+
   unsigned short StrawWaveform::digitizeTOT(StrawElectronics const& strawele, double threshold, double time) const {
+      if(_cresps){
+        // scan the waveform in blocks of TOT ticks
+        static const size_t nblock(16);
+        std::array<double,nblock> times, volts;
+        for (size_t i0=1;i0<strawele.maxTOT();i0+=nblock){
+          size_t nt = std::min(nblock,strawele.maxTOT()-i0);
+          for (size_t it=0;it<nt;it++)
+            times[it] = time + (i0+it)*strawele.totLSB();
+          sampleWaveform(strawele,StrawElectronics::thresh,times.data(),nt,volts.data());
+          for (size_t it=0;it<nt;it++){
+            if (volts[it] < threshold - strawele.triggerHysteresis())
+              return static_cast<unsigned short>(i0+it);
+          }
+        }
+        return static_cast<unsigned short>(strawele.maxTOT());
+      }
       for (size_t i=1;i<strawele.maxTOT();i++){
         if (sampleWaveform(strawele,StrawElectronics::thresh,time + i*strawele.totLSB()) < threshold - strawele.triggerHysteresis())
           return static_cast<unsigned short>(i);
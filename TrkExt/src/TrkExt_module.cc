@@ -197,7 +197,7 @@ namespace mu2e {
     _recordingStep(pset.get<double>("recordingStep", 10.0)),    // in mm
     _mcFlag(pset.get<bool>("mcFlag", false)),
     _useVirtualDetector(pset.get<bool>("useVirtualDetector", false)),
-    _bFieldGradientMode(pset.get<int>("bFieldGradientMode", 1)),
+    _bFieldGradientMode(pset.get<int>("bFieldGradientMode", 2)),
     _turnOnMultipleScattering(pset.get<bool>("turnOnMultipleScattering", true)),
     _debugLevel(pset.get<int>("debugLevel", 1)),
     _verbosity(pset.get<int>("verbosity", 1)),
@@ -274,9 +274,10 @@ namespace mu2e {
     }
 
     if (_bFieldGradientMode != 0 
-        && _bFieldGradientMode != 1) {
-      if (_verbosity>=0) cout << "TrkExt: bFieldGradientMode forced to 1" << endl;
-      _bFieldGradientMode = 1;
+        && _bFieldGradientMode != 1
+        && _bFieldGradientMode != 2) {
+      if (_verbosity>=0) cout << "TrkExt: bFieldGradientMode forced to 2" << endl;
+      _bFieldGradientMode = 2;
     }
 
     if (_verbosity>=1) cout << "TrkExt: extrapolationStep = " << _extrapolationStep << endl;
@@ -513,6 +514,28 @@ namespace mu2e {
                                       double & byx, double & byy, double & byz, 
                                       double & bzx, double & bzy, double & bzz) {
 
+    // mode 0 : no gradient
+    // mode 1 : central differences with 5 mm step, 7 lookups
+    // mode 2 : derivatives of the interpolating polynomial of the map, 1 lookup
+    if (_bFieldGradientMode == 2) {
+      Hep3Vector xx = x + _origin;
+      Hep3Vector B0, dB[3];
+      _bfMgr->getBFieldWithGradient(xx, B0, dB);
+      if (B0.mag() >10) {
+        if (_verbosity>=0) cout << "TrkExt: Crazy bfield : (" << B0.x() << ", " << B0.y() << ", " << B0.z() << ") at (" << xx.x() << ", " << xx.y() << ", " << xx.z() << ")" << endl;
+      }
+      bxx = dB[0].x();
+      bxy = dB[1].x();
+      bxz = dB[2].x();
+      byx = dB[0].y();
+      byy = dB[1].y();
+      byz = dB[2].y();
+      bzx = dB[0].z();
+      bzy = dB[1].z();
+      bzz = dB[2].z();
+      return B0;
+    }
+
     Hep3Vector B0 = getBField(x);
 
     if (_bFieldGradientMode == 1) {
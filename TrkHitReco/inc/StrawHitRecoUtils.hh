@@ -14,6 +14,13 @@
 namespace mu2e {
   class StrawHitRecoUtils {
     public: 
+      // pedestal, value and position (counted from the end of the presamples) of the first peak of a waveform
+      struct WaveformPeak {
+        float pedestal = 0.0;
+        float peak = 0.0;
+        unsigned peakpos = 0;
+      };
+
       StrawHitRecoUtils(double pbtOffset, mu2e::TrkHitReco::FitType fittype, unsigned npre, float invnpre, float invgainAvg, float* invgain, int diagLevel, TH1F* maxiter,
         mu2e::StrawIdMask mask, size_t nplanes, size_t npanels, bool writesh, float minT, float maxT, float minE, float maxE, bool filter, bool flagXT,
         float ctE, float ctMinT, float ctMaxT, bool usecc, float clusterDt, size_t numDigis) : 
@@ -38,10 +45,23 @@ namespace mu2e {
           mu2e::StrawId const& sid, mu2e::TrkTypes::TDCValues const& tdc, mu2e::TrkTypes::TOTValues const& tot,
           mu2e::TrkTypes::ADCValue const& pmp, mu2e::TrkTypes::ADCWaveform const& waveform,
           mu2e::TrackerStatus const& trackerStatus,  mu2e::StrawResponse const& srep, mu2e::Tracker const& tt);
+      // same, with the waveform peak already found (see peakPedBatch); wpeak is not used for firmwarepmp
+      bool createComboHit(std::unique_ptr<mu2e::ComboHitCollection> const& chCol,
+          std::unique_ptr<mu2e::StrawHitCollection> const& shCol,
+          const mu2e::CaloClusterCollection *caloClusters,
+          mu2e::StrawId const& sid, mu2e::TrkTypes::TDCValues const& tdc, mu2e::TrkTypes::TOTValues const& tot,
+          mu2e::TrkTypes::ADCValue const& pmp, WaveformPeak const& wpeak,
+          mu2e::TrackerStatus const& trackerStatus,  mu2e::StrawResponse const& srep, mu2e::Tracker const& tt);
+
+      // find the peaks of nwf waveforms, read in place
+      void peakPedBatch(mu2e::TrkTypes::ADCWaveform const* const* wfs, size_t nwf, WaveformPeak* wpeaks) const;
+      WaveformPeak peakPed(mu2e::TrkTypes::ADCWaveform const& adcData) const;
 
       float peakMinusPedAvg(mu2e::TrkTypes::ADCWaveform const& adcData) const;
       float peakMinusPed(mu2e::StrawId id, mu2e::TrkTypes::ADCWaveform const& adcData) const;
       float peakMinusPedFirmware(mu2e::StrawId id, mu2e::TrkTypes::ADCValue const& pmp) const;
+      float peakMinusPedAvg(WaveformPeak const& wpeak) const;
+      float peakMinusPed(mu2e::StrawId id, WaveformPeak const& wpeak) const;
 
     private:
       float _pbtOffset;
@@ -0,0 +1,84 @@
+//
+// Check that two ComboHit collections are identical, e.g. the outputs of MakeStereoHits with and without
+// the time index.  Hits are compared in order: straw id, number and indices of the combined hits,
+// position, time and quality.  The number of differences is printed at the end of the job.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include "RecoDataProducts/inc/ComboHit.hh"
+
+#include <cstdio>
+
+
+namespace mu2e {
+
+  class ComboHitCompare : public art::EDAnalyzer {
+    public:
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+      struct Config {
+	fhicl::Atom<art::InputTag> chTag1{ Name("ComboHitCollection1"), Comment("Reference ComboHit collection")};
+	fhicl::Atom<art::InputTag> chTag2{ Name("ComboHitCollection2"), Comment("ComboHit collection to compare")};
+	fhicl::Atom<int> debug{ Name("debugLevel"), Comment("Print the differences if > 0"), 0};
+      };
+
+      using Parameters = art::EDAnalyzer::Table<Config>;
+      explicit ComboHitCompare(Parameters const& config);
+      void analyze(art::Event const& event) override;
+      void endJob() override;
+
+    private:
+      bool same(ComboHit const& ch1, ComboHit const& ch2) const;
+
+      art::ProductToken<ComboHitCollection> const _chtoken1;
+      art::ProductToken<ComboHitCollection> const _chtoken2;
+      int _debug;
+      size_t _nevents, _nhits, _ndiff;
+  };
+
+  ComboHitCompare::ComboHitCompare(Parameters const& config) :
+    art::EDAnalyzer{config},
+    _chtoken1{consumes<ComboHitCollection>(config().chTag1())},
+    _chtoken2{consumes<ComboHitCollection>(config().chTag2())},
+    _debug(config().debug()),
+    _nevents(0), _nhits(0), _ndiff(0)
+  {}
+
+  bool ComboHitCompare::same(ComboHit const& ch1, ComboHit const& ch2) const {
+    if(ch1.strawId() != ch2.strawId() || ch1.nCombo() != ch2.nCombo() || ch1.nStrawHits() != ch2.nStrawHits())
+      return false;
+    for(size_t ich = 0; ich < ch1.nCombo(); ++ich)
+      if(ch1.index(ich) != ch2.index(ich)) return false;
+    return ch1.pos() == ch2.pos() && ch1.time() == ch2.time() && ch1.qual() == ch2.qual() && ch1.flag() == ch2.flag();
+  }
+
+  void ComboHitCompare::analyze(art::Event const& event) {
+    auto const& chcol1 = *event.getValidHandle(_chtoken1);
+    auto const& chcol2 = *event.getValidHandle(_chtoken2);
+    ++_nevents;
+    _nhits += chcol1.size();
+    if(chcol1.size() != chcol2.size()){
+      if(_debug > 0) std::printf("[ComboHitCompare] event %u: %zu and %zu hits\n", event.event(), chcol1.size(), chcol2.size());
+      ++_ndiff;
+      return;
+    }
+    for(size_t ich = 0; ich < chcol1.size(); ++ich){
+      if(!same(chcol1[ich],chcol2[ich])){
+	if(_debug > 0) std::printf("[ComboHitCompare] event %u: hit %zu differs\n", event.event(), ich);
+	++_ndiff;
+      }
+    }
+  }
+
+  void ComboHitCompare::endJob() {
+    std::printf("[ComboHitCompare] %zu events, %zu hits, %zu differences\n", _nevents, _nhits, _ndiff);
+  }
+
+}
+
+using mu2e::ComboHitCompare;
+DEFINE_ART_MODULE(ComboHitCompare);
@@ -82,7 +82,7 @@ namespace mu2e
          void classifyCluster(BkgClusterCollection& bkgccolFast, BkgClusterCollection& bkgccol, BkgQualCollection& bkgqcol, 
                               StrawHitFlagCollection& chfcol, const ComboHitCollection& chcol) const;
          void fillBkgQual(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
-         void fillMVA(        BkgQual& cqual) const;
+         void fillMVA(        std::vector<BkgQual>& cquals) const;
          void countHits(      const BkgCluster& cluster, unsigned& nactive, unsigned& nstereo, const ComboHitCollection& chcol) const;
          void countPlanes(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
          int  findClusterIdx( BkgClusterCollection& bkgccol, unsigned ich) const;
@@ -263,11 +263,14 @@ namespace mu2e
          for (const auto& chit : cluster.hits()) chfcol[chit] = flag;
       }      
       
-      for (auto& cluster : bkgccol)
+      std::vector<BkgQual> cquals(bkgccol.size());
+      for (size_t ic=0; ic < bkgccol.size(); ++ic) fillBkgQual(bkgccol[ic], cquals[ic], chcol);
+      fillMVA(cquals);
+
+      for (size_t ic=0; ic < bkgccol.size(); ++ic)
       {                
-           BkgQual cqual;
-           fillBkgQual(cluster, cqual, chcol);
-           fillMVA(cqual);
+           BkgCluster& cluster = bkgccol[ic];
+           BkgQual& cqual = cquals[ic];
 
            StrawHitFlag flag(StrawHitFlag::bkgclust);
            if (cqual.MVAOutput() > bkgMVAcut_)
@@ -323,22 +326,37 @@ namespace mu2e
   
   
   //----------------------------------------------
-  void FlagBkgHits::fillMVA(BkgQual& cqual) const
+  // score all the filled clusters of the event in one call
+  void FlagBkgHits::fillMVA(std::vector<BkgQual>& cquals) const
   {
-       if (cqual.status() == MVAStatus::unset) return;
-
-       std::vector<float> mvavars(7,0.0);
-       mvavars[0] = cqual.varValue(BkgQual::crho);
-       mvavars[1] = cqual.varValue(BkgQual::zmin);
-       mvavars[2] = cqual.varValue(BkgQual::zmax);
-       mvavars[3] = cqual.varValue(BkgQual::zgap);
-       mvavars[4] = cqual.varValue(BkgQual::np);
-       mvavars[5] = cqual.varValue(BkgQual::npfrac);
-       mvavars[6] = cqual.varValue(BkgQual::nhits);
-       float mvaout = bkgMVA_.evalMVA(mvavars);
-
-       cqual.setMVAValue(mvaout);
-       cqual.setMVAStatus(MVAStatus::calculated);
+       constexpr size_t nvars(7);
+       std::vector<size_t> iquals;
+       std::vector<float>  mvavars;
+       iquals.reserve(cquals.size());
+       mvavars.reserve(nvars*cquals.size());
+       for (size_t iq=0; iq < cquals.size(); ++iq)
+       {
+           const BkgQual& cqual = cquals[iq];
+           if (cqual.status() == MVAStatus::unset) continue;
+
+           iquals.push_back(iq);
+           mvavars.push_back(cqual.varValue(BkgQual::crho));
+           mvavars.push_back(cqual.varValue(BkgQual::zmin));
+           mvavars.push_back(cqual.varValue(BkgQual::zmax));
+           mvavars.push_back(cqual.varValue(BkgQual::zgap));
+           mvavars.push_back(cqual.varValue(BkgQual::np));
+           mvavars.push_back(cqual.varValue(BkgQual::npfrac));
+           mvavars.push_back(cqual.varValue(BkgQual::nhits));
+       }
+
+       std::vector<float> mvaout;
+       bkgMVA_.evalMVA(mvavars,nvars,mvaout);
+
+       for (size_t i=0; i < iquals.size(); ++i)
+       {
+           cquals[iquals[i]].setMVAValue(mvaout[i]);
+           cquals[iquals[i]].setMVAStatus(MVAStatus::calculated);
+       }
    }
 
 
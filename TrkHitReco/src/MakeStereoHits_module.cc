@@ -1,6 +1,12 @@
 //
 // A module to create simple stereo hits out of StrawHits. StrawHit selection is done by flagging in an upstream module
 //
+// By default the hits of each panel are indexed in time, so only the hits of an overlapping panel inside the
+// maxDt window are considered for a pair.  The pair cuts, including the wire crossing and the radius and
+// chisquared cuts, are first evaluated in single precision on the whole window in a loop over contiguous
+// arrays, with loose margins.  The exact cuts and POCA are then applied to the few pairs that pass, so the
+// stereo hits are identical to the exhaustive search, which is kept with UseTimeIndex : false.
+//
 // 
 //  Original Author: David Brown, LBNL
 //  
@@ -31,6 +37,7 @@
 #include <boost/accumulators/statistics/min.hpp>
 using namespace boost::accumulators;
 
+#include <algorithm>
 #include <iostream>
 #include <float.h>
 using namespace std;
@@ -47,6 +54,77 @@ namespace {
     float& _rho;  
     float& _ndof; 
   };
+
+  // quantities of a hit used by the pair preselection
+  struct HitRecord {
+    uint16_t _index, _panel;
+    float _time, _x, _y, _z, _wx, _wy, _wz, _ux, _uy, _uz, _werr2;
+  };
+
+  // loose versions of the pair cuts
+  struct PairCuts {
+    float _maxdt, _minddot, _maxdp2, _minr2, _maxr2, _maxchisq, _minsin2, _tfac;
+  };
+
+  // Selected hits binned in (panel, time), stored as arrays ordered by panel, time bin and index.  The bins
+  // are at least maxDt wide, so the partners of a hit are in its bin and the two neighbouring bins, which
+  // are contiguous in the arrays.
+  struct TimeIndex {
+    float _tmin, _binwidth;
+    int _nbins;
+    std::vector<unsigned> _offset; // first entry of each (panel, bin), with an end entry
+    std::vector<HitRecord> _records, _sorted; // selected hits in index order, and in (panel, bin, index) order
+    std::vector<uint16_t> _hits;
+    std::vector<float> _time, _x, _y, _z, _wx, _wy, _wz, _ux, _uy, _uz, _werr2;
+    int bin(float time) const { return (int)(std::min(std::max((time-_tmin)/_binwidth,-2.0f),(float)_nbins+1)+2.0f)-2; }
+    void preselect(PairCuts const& cuts, HitRecord const& hit, size_t lo, size_t nw, int* pass) const;
+  };
+
+  // Evaluate the cuts of hit with the entries [lo,lo+nw), including the wire crossing as in TwoLinePCA_XYZ.
+  // Everything is copied to locals, there are no branches and the result is an int so that the compiler can
+  // vectorize the loop.
+  void TimeIndex::preselect(PairCuts const& cuts, HitRecord const& hit, size_t lo, size_t nw, int* pass) const {
+    const float t1 = hit._time, x1 = hit._x, y1 = hit._y, z1 = hit._z;
+    const float wx1 = hit._wx, wy1 = hit._wy, wz1 = hit._wz;
+    const float ux1 = hit._ux, uy1 = hit._uy, uz1 = hit._uz, werr1 = hit._werr2;
+    const float maxdt = cuts._maxdt, minddot = cuts._minddot, maxdp2 = cuts._maxdp2;
+    const float minr2 = cuts._minr2, maxr2 = cuts._maxr2, maxchisq = cuts._maxchisq;
+    const float minsin2 = cuts._minsin2, tfac = cuts._tfac;
+    const float* tt = _time.data()+lo;
+    const float* xx = _x.data()+lo;
+    const float* yy = _y.data()+lo;
+    const float* zz = _z.data()+lo;
+    const float* wx = _wx.data()+lo;
+    const float* wy = _wy.data()+lo;
+    const float* wz = _wz.data()+lo;
+    const float* ux = _ux.data()+lo;
+    const float* uy = _uy.data()+lo;
+    const float* uz = _uz.data()+lo;
+    const float* werr = _werr2.data()+lo;
+    for(size_t k=0;k<nw;++k){
+      float dt = std::abs(t1-tt[k]);
+      float ddot = wx1*wx[k] + wy1*wy[k] + wz1*wz[k];
+      float dx = x1-xx[k];
+      float dy = y1-yy[k];
+      float dz = z1-zz[k];
+      float c = ux1*ux[k] + uy1*uy[k] + uz1*uz[k];
+      float sin2 = 1.0f-c*c;
+      float d1 = dx*ux1 + dy*uy1 + dz*uz1;
+      float d2 = dx*ux[k] + dy*uy[k] + dz*uz[k];
+      // (close to) parallel wires pass, whatever the crossing
+      float isin2 = 1.0f/sin2;
+      float s1 = (d2*c-d1)*isin2;
+      float s2 = (d2-d1*c)*isin2;
+      float px = x1 + ux1*s1;
+      float py = y1 + uy1*s1;
+      float rho2 = px*px+py*py;
+      float terr = tfac*dz;
+      float terr2 = terr*terr;
+      float chisq = s1*s1/(werr1+terr2) + s2*s2/(werr[k]+terr2);
+      bool cross = (sin2 < minsin2) | ((rho2 < maxr2) & (rho2 > minr2) & (chisq < maxchisq));
+      pass[k] = (dt < maxdt) & (ddot > minddot) & (dx*dx+dy*dy < maxdp2) & cross;
+    }
+  }
 }
 
 namespace mu2e {
@@ -59,6 +137,8 @@ namespace mu2e {
     private:
       typedef std::vector<uint16_t> ComboHits;
 
+      constexpr static int maxTimeBins = 256;
+
       int            _debug;
       art::InputTag  _shTag;
       art::InputTag  _chTag;
@@ -79,14 +159,25 @@ namespace mu2e {
       bool           _doMVA;      // do MVA eval or simply use chi2 cut
       unsigned      _maxfsep;	  // max face separation
       bool	    _testflag; // test the flag or not
+      bool          _useTimeIndex; // search pairs in the time bins of the overlapping panels
       StrawIdMask _smask; // define matches inside a station
 
       MVATools _mvatool;
       StereoMVA _vmva; 
 
       std::array<std::vector<StrawId>,StrawId::_nupanels > _panelOverlap;   // which panels overlap each other
+      TimeIndex _tindex;              // (panel, time) index of the selected hits, reused between events
+      std::vector<int> _pass;         // preselection result for the hits in the time window
+      std::vector<uint16_t> _cand;    // preselected hits of one panel
       void genMap();    
       void finalize(ComboHit& combohit);
+      float hitTime(ComboHit const& ch) const { return _useTOT ? ch.correctedTime() : ch.time(); }
+      bool selectHit(ComboHit const& ch) const;
+      void findPairsLegacy(std::vector<bool>& used, ComboHitCollection& chcol);
+      void buildTimeIndex();
+      void findPairsIndexed(std::vector<bool>& used, ComboHitCollection& chcol);
+      bool stereoPair(ComboHit const& ch1, ComboHit const& ch2, float& chisq, XYZVec& pos) const;
+      void addPair(ComboHit& combohit, size_t jhit, float chisq, XYZVec const& pos, std::vector<bool>& used) const;
   };
 
   MakeStereoHits::MakeStereoHits(fhicl::ParameterSet const& pset) :
@@ -106,6 +197,7 @@ namespace mu2e {
     _doMVA(pset.get<bool>(  "doMVA",false)),
     _maxfsep(pset.get<unsigned>("MaxFaceSeparation",3)), // max separation between faces in a station
     _testflag(pset.get<bool>("TestFlag")),
+    _useTimeIndex(pset.get<bool>("UseTimeIndex",true)),
     _smask("uniquepanel"),  // define the mask to select hits in the same unique panel
 
     _mvatool(pset.get<fhicl::ParameterSet>("MVATool",fhicl::ParameterSet()))
@@ -142,15 +234,29 @@ namespace mu2e {
     chcol->reserve(_chcol->size());
     // reference the parent in the new collection
     chcol->setParent(chH);
-    // sort hits by unique panel.  This should be built in by construction upstream FIXME!!
-    std::array<std::vector<uint16_t>,StrawId::_nupanels> phits;
     size_t nch = _chcol->size();
     if(_debug > 1)cout << "MakeStereoHits found " << nch << " Input hits" << endl;
     std::vector<bool> used(nch,false);
+    if(_useTimeIndex)
+      findPairsIndexed(used,*chcol);
+    else
+      findPairsLegacy(used,*chcol);
+    event.put(std::move(chcol));
+  } 
+
+  bool MakeStereoHits::selectHit(ComboHit const& ch) const {
+    return (!_testflag) ||( ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask)));
+  }
+
+  // exhaustive search over all the hits of the overlapping panels
+  void MakeStereoHits::findPairsLegacy(std::vector<bool>& used, ComboHitCollection& chcol) {
+    // sort hits by unique panel.  This should be built in by construction upstream FIXME!!
+    std::array<std::vector<uint16_t>,StrawId::_nupanels> phits;
+    size_t nch = _chcol->size();
     for(uint16_t ihit=0;ihit<nch;++ihit){
       ComboHit const& ch = (*_chcol)[ihit];
       // select hits based on flag
-      if( (!_testflag) ||( ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask))) ){
+      if(selectHit(ch)){
 	phits[ch.strawId().uniquePanel()].push_back(ihit);
       }
     }
@@ -176,63 +282,184 @@ namespace mu2e {
       for (auto sid : _panelOverlap[ch1.strawId().uniquePanel()]) {
       // loop over hits in the overlapping panel
 	for (auto jhit : phits[sid.uniquePanel()]) {
-	  const ComboHit& ch2 = (*_chcol)[jhit];
-	  if(_debug > 3) cout << " comparing hits " << ch1.strawId().uniquePanel() << " and " << ch2.strawId().uniquePanel();
 	  if (!used[jhit] ){
-            float dt;
-            if (_useTOT)
-	      dt = fabs(ch1.correctedTime()-ch2.correctedTime());
-            else
-	      dt = fabs(ch1.time()-ch2.time());
-	    if(_debug > 3) cout << " dt = " << dt;
-	    if (dt < _maxDt){
-	      float ddot = ch1.wdir().Dot(ch2.wdir());
-	      XYZVec dp = ch1.pos()-ch2.pos();
-	      float dperp = sqrt(dp.perp2());
-	      // negative crosings are in opposite quadrants and longitudinal separation isn't too big
-	      if(_debug > 3) cout << " ddot = " << ddot << " dperp = " << dperp;
-	      if (ddot > _minDdot && dperp < _maxDPerp ) {
-		// solve for the POCA.
-		TwoLinePCA_XYZ pca(ch1.pos(),ch1.wdir(),ch2.pos(),ch2.wdir());
-		if(pca.closeToParallel()){  
-		  cet::exception("RECO")<<"mu2e::StereoHit: parallel wires" << std::endl;
-		}
-		// check the points are inside the tracker active volume; these are all the same as the
-		float rho2 = pca.point1().Perp2();
-		if(_debug > 3) cout << " rho2 = " << rho2;
-		if(rho2 < _maxR2 && rho2 > _minR2 ){
-		  // compute chisquared; include error for particle angle
-		  // should be a cumulative linear regression FIXME!
-		  float terr = _tfac*fabs(ch1.pos().z()-ch2.pos().z());
-		  float terr2 = terr*terr;
-		  float dw1 = pca.s1();
-		  float dw2 = pca.s2();
-		  float chisq = dw1*dw1/(ch1.wireErr2()+terr2) + dw2*dw2/(ch2.wireErr2()+terr2);
-		  if(_debug > 3) cout << " chisq = " << chisq;
-		  if (chisq < _maxChisq){
-		    if(_debug > 3) cout << " added ";
-		    // if we get to here, try to add the hit
-		    // accumulate the chisquared
-		    if(combohit.addIndex(jhit)) {
-		      // average z 
-		      combohit._qual += chisq;
-		      combohit._pos += XYZVec(pca.point1().x(),pca.point1().y(),0.5*(pca.point1().z()+pca.point2().z()));	    
-		    } else
-		      std::cout << "MakeStereoHits can't add hit" << std::endl;
-		    used[jhit] = true;
-		  }	
-		}
-	      }
+	    float chisq;
+	    XYZVec pos;
+	    if(stereoPair(ch1,(*_chcol)[jhit],chisq,pos)) addPair(combohit,jhit,chisq,pos,used);
+	  }
+	}
+      }
+      finalize(combohit);
+      chcol.push_back(std::move(combohit));
+    }
+  }
+
+  void MakeStereoHits::buildTimeIndex() {
+    TimeIndex& ti = _tindex;
+    // read the input collection only once
+    size_t nch = _chcol->size();
+    ti._records.clear();
+    float tmin(FLT_MAX), tmax(-FLT_MAX);
+    for(uint16_t ihit=0;ihit<nch;++ihit){
+      ComboHit const& ch = (*_chcol)[ihit];
+      if(selectHit(ch)){
+	float time = hitTime(ch);
+	XYZVec udir = ch.wdir().unit();
+	ti._records.push_back(HitRecord{ihit,ch.strawId().uniquePanel(),time,
+	    ch.pos().x(),ch.pos().y(),ch.pos().z(),ch.wdir().x(),ch.wdir().y(),ch.wdir().z(),
+	    udir.x(),udir.y(),udir.z(),ch.wireErr2()});
+	tmin = std::min(tmin,time);
+	tmax = std::max(tmax,time);
+      }
+    }
+    ti._tmin = tmin;
+    // slightly wider than maxDt so that rounding cannot move a partner beyond the neighbouring bins
+    ti._binwidth = _maxDt*1.0001f;
+    if(tmax > tmin) ti._binwidth = std::max(ti._binwidth,(tmax-tmin)/(maxTimeBins-1));
+    ti._nbins = tmax >= tmin ? (int)std::floor((tmax-tmin)/ti._binwidth)+1 : 0;
+    // count the hits in each (panel, time) bin, then fill the arrays in index order
+    ti._offset.assign(StrawId::_nupanels*ti._nbins+1,0);
+    for(auto const& rec : ti._records) ++ti._offset[rec._panel*ti._nbins + ti.bin(rec._time) + 1];
+    for(size_t ibin=1;ibin<ti._offset.size();++ibin) ti._offset[ibin] += ti._offset[ibin-1];
+    size_t nsel = ti._records.size();
+    ti._sorted.resize(nsel);
+    for(auto const& rec : ti._records) ti._sorted[ti._offset[rec._panel*ti._nbins + ti.bin(rec._time)]++] = rec;
+    ti._hits.resize(nsel);
+    for(auto v : {&ti._time,&ti._x,&ti._y,&ti._z,&ti._wx,&ti._wy,&ti._wz,&ti._ux,&ti._uy,&ti._uz,&ti._werr2}) v->resize(nsel);
+    for(size_t k=0;k<nsel;++k){
+      HitRecord const& rec = ti._sorted[k];
+      ti._hits[k] = rec._index;
+      ti._time[k] = rec._time;
+      ti._x[k] = rec._x;
+      ti._y[k] = rec._y;
+      ti._z[k] = rec._z;
+      ti._wx[k] = rec._wx;
+      ti._wy[k] = rec._wy;
+      ti._wz[k] = rec._wz;
+      ti._ux[k] = rec._ux;
+      ti._uy[k] = rec._uy;
+      ti._uz[k] = rec._uz;
+      ti._werr2[k] = rec._werr2;
+    }
+    // the fill moved each offset to the end of its bin: shift back
+    for(size_t ibin=ti._offset.size()-1;ibin>0;--ibin) ti._offset[ibin] = ti._offset[ibin-1];
+    ti._offset[0] = 0;
+    if(_debug > 2){
+      for (unsigned ipan=0; ipan < StrawId::_nupanels; ++ipan) {
+	unsigned n = ti._offset[(ipan+1)*ti._nbins]-ti._offset[ipan*ti._nbins];
+	if(n > 0) cout << "Panel " << ipan << " has " << n << " hits "<< endl;
+      }
+    }
+  }
+
+  // search over the hits of the overlapping panels in the neighbouring time bins.  The candidates of each panel
+  // are processed in index order, as in the exhaustive search, so the output is the same.
+  void MakeStereoHits::findPairsIndexed(std::vector<bool>& used, ComboHitCollection& chcol) {
+    buildTimeIndex();
+    TimeIndex const& ti = _tindex;
+    size_t nch = _chcol->size();
+    // The preselection is looser than the cuts applied in stereoPair, to be insensitive to rounding.  Below
+    // minsin2 the single precision crossing is not accurate enough and only the time and direction cuts are used
+    const PairCuts cuts{_maxDt, _minDdot-1e-5f, 1.001f*_maxDPerp*_maxDPerp, 0.98f*_minR2, 1.02f*_maxR2, 1.1f*_maxChisq, 0.01f, _tfac};
+    for (size_t ihit=0;ihit<nch;++ihit) {
+      if(used[ihit])continue;
+      used[ihit] = true;
+      ComboHit const& ch1 = (*_chcol)[ihit];
+      ComboHit combohit;
+      combohit.init(ch1,ihit);
+      combohit._qual = 0.0;
+      combohit._pos = XYZVec(0.0,0.0,0.0);
+      const float t1 = hitTime(ch1);
+      int bin0 = std::max(ti.bin(t1)-1,0);
+      int bin1 = std::min(ti.bin(t1)+1,ti._nbins-1);
+      if(bin0 <= bin1){
+	XYZVec udir = ch1.wdir().unit();
+	const HitRecord hit1{(uint16_t)ihit,ch1.strawId().uniquePanel(),t1,
+	  ch1.pos().x(),ch1.pos().y(),ch1.pos().z(),ch1.wdir().x(),ch1.wdir().y(),ch1.wdir().z(),
+	  udir.x(),udir.y(),udir.z(),ch1.wireErr2()};
+	for (auto sid : _panelOverlap[ch1.strawId().uniquePanel()]) {
+	  unsigned lo = ti._offset[sid.uniquePanel()*ti._nbins + bin0];
+	  unsigned hi = ti._offset[sid.uniquePanel()*ti._nbins + bin1 + 1];
+	  if(lo >= hi)continue;
+	  size_t nw = hi-lo;
+	  if(_pass.size() < nw)_pass.resize(nw);
+	  ti.preselect(cuts,hit1,lo,nw,_pass.data());
+	  _cand.clear();
+	  for(size_t k=0;k<nw;++k)
+	    if(_pass[k])_cand.push_back(ti._hits[lo+k]);
+	  // bins are in index order, only their concatenation needs sorting
+	  if(bin1 > bin0) std::sort(_cand.begin(),_cand.end());
+	  for (auto jhit : _cand) {
+	    if (!used[jhit] ){
+	      float chisq;
+	      XYZVec pos;
+	      if(stereoPair(ch1,(*_chcol)[jhit],chisq,pos)) addPair(combohit,jhit,chisq,pos,used);
 	    }
 	  }
-	  if(_debug > 3) cout << endl;
 	}
       }
       finalize(combohit);
-      chcol->push_back(std::move(combohit));
+      chcol.push_back(std::move(combohit));
     }
-    event.put(std::move(chcol));
-  } 
+  }
+
+  // apply the pair cuts, and if they pass return the chisquared and the position of the stereo point
+  bool MakeStereoHits::stereoPair(ComboHit const& ch1, ComboHit const& ch2, float& chisq, XYZVec& pos) const {
+    bool retval(false);
+    if(_debug > 3) cout << " comparing hits " << ch1.strawId().uniquePanel() << " and " << ch2.strawId().uniquePanel();
+    float dt;
+    if (_useTOT)
+      dt = fabs(ch1.correctedTime()-ch2.correctedTime());
+    else
+      dt = fabs(ch1.time()-ch2.time());
+    if(_debug > 3) cout << " dt = " << dt;
+    if (dt < _maxDt){
+      float ddot = ch1.wdir().Dot(ch2.wdir());
+      XYZVec dp = ch1.pos()-ch2.pos();
+      float dperp = sqrt(dp.perp2());
+      // negative crosings are in opposite quadrants and longitudinal separation isn't too big
+      if(_debug > 3) cout << " ddot = " << ddot << " dperp = " << dperp;
+      if (ddot > _minDdot && dperp < _maxDPerp ) {
+	// solve for the POCA.
+	TwoLinePCA_XYZ pca(ch1.pos(),ch1.wdir(),ch2.pos(),ch2.wdir());
+	if(pca.closeToParallel()){  
+	  cet::exception("RECO")<<"mu2e::StereoHit: parallel wires" << std::endl;
+	}
+	// check the points are inside the tracker active volume; these are all the same as the
+	float rho2 = pca.point1().Perp2();
+	if(_debug > 3) cout << " rho2 = " << rho2;
+	if(rho2 < _maxR2 && rho2 > _minR2 ){
+	  // compute chisquared; include error for particle angle
+	  // should be a cumulative linear regression FIXME!
+	  float terr = _tfac*fabs(ch1.pos().z()-ch2.pos().z());
+	  float terr2 = terr*terr;
+	  float dw1 = pca.s1();
+	  float dw2 = pca.s2();
+	  chisq = dw1*dw1/(ch1.wireErr2()+terr2) + dw2*dw2/(ch2.wireErr2()+terr2);
+	  if(_debug > 3) cout << " chisq = " << chisq;
+	  if (chisq < _maxChisq){
+	    if(_debug > 3) cout << " added ";
+	    // average z 
+	    pos = XYZVec(pca.point1().x(),pca.point1().y(),0.5*(pca.point1().z()+pca.point2().z()));
+	    retval = true;
+	  }	
+	}
+      }
+    }
+    if(_debug > 3) cout << endl;
+    return retval;
+  }
+
+  void MakeStereoHits::addPair(ComboHit& combohit, size_t jhit, float chisq, XYZVec const& pos, std::vector<bool>& used) const {
+    // if we get to here, try to add the hit
+    // accumulate the chisquared
+    if(combohit.addIndex(jhit)) {
+      combohit._qual += chisq;
+      combohit._pos += pos;
+    } else
+      std::cout << "MakeStereoHits can't add hit" << std::endl;
+    used[jhit] = true;
+  }
 
   void MakeStereoHits::finalize(ComboHit& combohit) {
     combohit._mask = _smask;
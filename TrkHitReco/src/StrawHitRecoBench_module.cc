@@ -0,0 +1,171 @@
+//
+// Benchmark of the StrawHit reconstruction: digis per second of the legacy per-digi path, which copies
+// each waveform and finds its peak with a copy of the original StrawHitRecoUtils peak finder, and of
+// the path used by StrawHitReco, which finds all the waveform peaks in place with
+// StrawHitRecoUtils::peakPedBatch before making the hits.
+// Both paths make the ComboHits of every digi (no filtering) and the module checks that the peaks
+// and the hit energies agree.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include "ProditionsService/inc/ProditionsHandle.hh"
+#include "TrackerConditions/inc/StrawResponse.hh"
+#include "TrackerConditions/inc/TrackerStatus.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+#include "TrkHitReco/inc/PeakFit.hh"
+#include "TrkHitReco/inc/StrawHitRecoUtils.hh"
+#include "RecoDataProducts/inc/StrawDigi.hh"
+#include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/StrawHit.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+
+namespace mu2e {
+  using namespace TrkTypes;
+
+  namespace {
+    // copy of the peak finding of StrawHitRecoUtils::peakMinusPed before the in-place batch, as the reference.
+    // The only change is that the rising edge search stops at the last sample instead of reading past it
+    StrawHitRecoUtils::WaveformPeak legacyPeakPed(ADCWaveform const& adcData, unsigned npre, float invnpre) {
+      StrawHitRecoUtils::WaveformPeak wpeak;
+      auto wfstart = adcData.begin() + npre;
+      wpeak.pedestal = std::accumulate(adcData.begin(), wfstart, 0)*invnpre;
+      auto maxIter = wfstart;
+      while(maxIter+1 < adcData.end() && *(maxIter+1) > *maxIter)
+        ++maxIter;
+      wpeak.peak = maxIter != adcData.end() ? *maxIter : wpeak.pedestal;
+      wpeak.peakpos = std::distance(wfstart,maxIter);
+      return wpeak;
+    }
+  }
+
+  class StrawHitRecoBench : public art::EDAnalyzer {
+    public:
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+      struct Config {
+	fhicl::Atom<int> fittype { Name( "FitType"), Comment("Waveform Fit Type: 1 peakminuspedavg, 2 peakminusped"), 1};
+	fhicl::Atom<art::InputTag> sdcTag{ Name("StrawDigiCollectionTag"), Comment("StrawDigiCollection producer")};
+        fhicl::Atom<art::InputTag> sdadcTag{ Name("StrawDigiADCWaveformCollectionTag"), Comment("StrawDigiADCWaveformCollection producer")};
+      };
+
+      using Parameters = art::EDAnalyzer::Table<Config>;
+      explicit StrawHitRecoBench(Parameters const& config);
+      void beginRun(art::Run const& run) override;
+      void analyze(art::Event const& event) override;
+      void endJob() override;
+
+    private:
+      TrkHitReco::FitType _fittype;
+      float _invnpre;
+      float _invgainAvg;
+      float _invgain[96];
+      unsigned _npre;
+      art::ProductToken<StrawDigiCollection> const _sdctoken;
+      art::ProductToken<StrawDigiADCWaveformCollection> const _sdadctoken;
+      ProditionsHandle<StrawResponse> _strawResponse_h;
+      ProditionsHandle<TrackerStatus> _trackerStatus_h;
+      ProditionsHandle<Tracker> _alignedTracker_h;
+
+      std::vector<ADCWaveform const*> _wfptrs;
+      std::vector<StrawHitRecoUtils::WaveformPeak> _wpeaks, _refpeaks;
+      size_t _ndigis, _npeakmismatch, _nmismatch;
+      double _tlegacy, _tbatch;
+  };
+
+  StrawHitRecoBench::StrawHitRecoBench(Parameters const& config) :
+    art::EDAnalyzer{config},
+    _fittype((TrkHitReco::FitType) config().fittype()),
+    _sdctoken{consumes<StrawDigiCollection>(config().sdcTag())},
+    _sdadctoken{consumes<StrawDigiADCWaveformCollection>(config().sdadcTag())},
+    _ndigis(0), _npeakmismatch(0), _nmismatch(0), _tlegacy(0), _tbatch(0)
+  {
+    if (_fittype != TrkHitReco::FitType::peakminusped && _fittype != TrkHitReco::FitType::peakminuspedavg)
+      throw cet::exception("RECO")<<"StrawHitRecoBench: FitType " << _fittype << " does not use the waveform" << std::endl;
+  }
+
+  void StrawHitRecoBench::beginRun(art::Run const& run)
+  {
+    auto const& srep = _strawResponse_h.get(run.id());
+    _npre = srep.nADCPreSamples();
+    _invnpre = 1.0/(float)_npre;
+    _invgainAvg = srep.adcLSB()*srep.peakMinusPedestalEnergyScale()/srep.strawGain();
+    for (int i=0;i<96;i++){
+      StrawId dummyId(0,0,i);
+      _invgain[i] = srep.adcLSB()*srep.peakMinusPedestalEnergyScale(dummyId)/srep.strawGain();
+    }
+  }
+
+  void StrawHitRecoBench::analyze(art::Event const& event)
+  {
+    typedef std::chrono::steady_clock Clock;
+    const Tracker& tt = _alignedTracker_h.get(event.id());
+    auto const& srep = _strawResponse_h.get(event.id());
+    TrackerStatus const& trackerStatus = _trackerStatus_h.get(event.id());
+    const StrawDigiCollection& sdcol = *event.getValidHandle(_sdctoken);
+    const StrawDigiADCWaveformCollection& sdadccol = *event.getValidHandle(_sdadctoken);
+
+    // no filtering, no cross-talk flagging: every digi makes a hit
+    StrawHitRecoUtils shrUtils(0.0, _fittype, _npre, _invnpre, _invgainAvg, _invgain,
+        0, nullptr, StrawIdMask(StrawIdMask::uniquestraw), tt.nPlanes(), tt.getPlane(0).nPanels(), true,
+        -1e9, 1e9, -1e9, 1e9, false, false, 0, 0, 0, false, 0, sdcol.size());
+
+    std::unique_ptr<StrawHitCollection> shLegacy(new StrawHitCollection), shBatch(new StrawHitCollection);
+    std::unique_ptr<ComboHitCollection> chLegacy(new ComboHitCollection), chBatch(new ComboHitCollection);
+    shLegacy->reserve(sdcol.size()); shBatch->reserve(sdcol.size());
+    chLegacy->reserve(sdcol.size()); chBatch->reserve(sdcol.size());
+
+    _refpeaks.resize(sdcol.size());
+    auto t0 = Clock::now();
+    StrawDigiADCWaveform adcwaveform;
+    for (size_t isd=0;isd<sdcol.size();++isd) {
+      const StrawDigi& digi = sdcol[isd];
+      adcwaveform = sdadccol.at(isd);
+      _refpeaks[isd] = legacyPeakPed(adcwaveform.samples(), _npre, _invnpre);
+      shrUtils.createComboHit(chLegacy, shLegacy, nullptr, digi.strawId(), digi.TDC(), digi.TOT(), digi.PMP(), _refpeaks[isd],
+          trackerStatus, srep, tt);
+    }
+
+    auto t1 = Clock::now();
+    _wfptrs.clear();
+    for (auto const& sdadc : sdadccol) _wfptrs.push_back(&sdadc.samples());
+    _wpeaks.resize(_wfptrs.size());
+    shrUtils.peakPedBatch(_wfptrs.data(), _wfptrs.size(), _wpeaks.data());
+    for (size_t isd=0;isd<sdcol.size();++isd) {
+      const StrawDigi& digi = sdcol[isd];
+      shrUtils.createComboHit(chBatch, shBatch, nullptr, digi.strawId(), digi.TDC(), digi.TOT(), digi.PMP(), _wpeaks[isd],
+          trackerStatus, srep, tt);
+    }
+    auto t2 = Clock::now();
+
+    _tlegacy += std::chrono::duration<double>(t1-t0).count();
+    _tbatch  += std::chrono::duration<double>(t2-t1).count();
+    _ndigis  += sdcol.size();
+    for (size_t i=0;i<sdcol.size();++i)
+      if (_refpeaks[i].pedestal != _wpeaks[i].pedestal || _refpeaks[i].peak != _wpeaks[i].peak ||
+          _refpeaks[i].peakpos != _wpeaks[i].peakpos) ++_npeakmismatch;
+    for (size_t i=0;i<chLegacy->size() && i<chBatch->size();++i)
+      if ((*chLegacy)[i].energyDep() != (*chBatch)[i].energyDep()) ++_nmismatch;
+    if (chLegacy->size() != chBatch->size()) ++_nmismatch;
+  }
+
+  void StrawHitRecoBench::endJob()
+  {
+    std::printf("[StrawHitRecoBench] %zu digis, digis per second: legacy %.3g, in place %.3g, peak mismatches %zu, energy mismatches %zu\n",
+        _ndigis, _tlegacy > 0 ? _ndigis/_tlegacy : 0., _tbatch > 0 ? _ndigis/_tbatch : 0., _npeakmismatch, _nmismatch);
+  }
+
+}
+
+using mu2e::StrawHitRecoBench;
+DEFINE_ART_MODULE(StrawHitRecoBench);
@@ -5,6 +5,7 @@
 
 #include "DataProducts/inc/StrawEnd.hh"
 
+#include <algorithm>
 #include <numeric>
 
 #include "TrkHitReco/inc/StrawHitRecoUtils.hh"
@@ -28,28 +29,46 @@ namespace mu2e {
     }
   }
 
-  float StrawHitRecoUtils::peakMinusPedAvg(mu2e::TrkTypes::ADCWaveform const& adcData) const {
-    auto wfstart = adcData.begin() + _npre;
-    float pedestal = std::accumulate(adcData.begin(), wfstart, 0)*_invnpre;
+  StrawHitRecoUtils::WaveformPeak StrawHitRecoUtils::peakPed(mu2e::TrkTypes::ADCWaveform const& adcData) const {
+    WaveformPeak wpeak;
+    auto wfstart = adcData.begin() + std::min(size_t(_npre),adcData.size());
+    wpeak.pedestal = std::accumulate(adcData.begin(), wfstart, 0)*_invnpre;
+    if (wfstart == adcData.end()) {
+      wpeak.peak = wpeak.pedestal;
+      return wpeak;
+    }
     //    auto maxIter = std::max_element(wfstart,adcData.end());
+    // follow the rising edge, at most up to the last sample
     auto maxIter = wfstart;
-    while(maxIter != adcData.end() && *(maxIter+1) > *maxIter)
+    while(maxIter+1 != adcData.end() && *(maxIter+1) > *maxIter)
       ++maxIter;
-    float peak = *maxIter;
-    if(_diagLevel > 0)_maxiter->Fill(std::distance(wfstart,maxIter));
-    return (peak-pedestal)*_invgainAvg;
+    wpeak.peak = *maxIter;
+    wpeak.peakpos = std::distance(wfstart,maxIter);
+    return wpeak;
+  }
+
+  void StrawHitRecoUtils::peakPedBatch(mu2e::TrkTypes::ADCWaveform const* const* wfs, size_t nwf, WaveformPeak* wpeaks) const {
+    // Processing the waveforms of a block in lockstep (samples transposed across waveforms) was measured to be
+    // slower than this loop for the ~15-sample waveforms: the transpose costs more than the early exit saves.
+    for (size_t i=0;i<nwf;++i) wpeaks[i] = peakPed(*wfs[i]);
+  }
+
+  float StrawHitRecoUtils::peakMinusPedAvg(WaveformPeak const& wpeak) const {
+    if(_diagLevel > 0)_maxiter->Fill(wpeak.peakpos);
+    return (wpeak.peak-wpeak.pedestal)*_invgainAvg;
+  }
+
+  float StrawHitRecoUtils::peakMinusPed(mu2e::StrawId id, WaveformPeak const& wpeak) const {
+    if(_diagLevel > 0)_maxiter->Fill(wpeak.peakpos);
+    return (wpeak.peak-wpeak.pedestal)*_invgain[id.getStraw()];
+  }
+
+  float StrawHitRecoUtils::peakMinusPedAvg(mu2e::TrkTypes::ADCWaveform const& adcData) const {
+    return peakMinusPedAvg(peakPed(adcData));
   }
 
   float StrawHitRecoUtils::peakMinusPed(mu2e::StrawId id, mu2e::TrkTypes::ADCWaveform const& adcData) const {
-    auto wfstart = adcData.begin() + _npre;
-    float pedestal = std::accumulate(adcData.begin(), wfstart, 0)*_invnpre;
-    //    auto maxIter = std::max_element(wfstart,adcData.end());
-    auto maxIter = wfstart;
-    while(maxIter != adcData.end() && *(maxIter+1) > *maxIter)
-      ++maxIter;
-    float peak = *maxIter;
-    if(_diagLevel > 0)_maxiter->Fill(std::distance(wfstart,maxIter));
-    return (peak-pedestal)*_invgain[id.getStraw()];
+    return peakMinusPed(id,peakPed(adcData));
   }
 
   float StrawHitRecoUtils::peakMinusPedFirmware(mu2e::StrawId id, mu2e::TrkTypes::ADCValue const& pmp) const {
@@ -61,6 +80,16 @@ namespace mu2e {
       mu2e::StrawId const& sid, mu2e::TrkTypes::TDCValues const& tdc,
       mu2e::TrkTypes::TOTValues const& tot, mu2e::TrkTypes::ADCValue const& pmp, mu2e::TrkTypes::ADCWaveform const& waveform,
       mu2e::TrackerStatus const& trackerStatus, mu2e::StrawResponse const& srep, mu2e::Tracker const& tt){
+    WaveformPeak wpeak;
+    if (_fittype != mu2e::TrkHitReco::FitType::firmwarepmp) wpeak = peakPed(waveform);
+    return createComboHit(chCol, shCol, caloClusters, sid, tdc, tot, pmp, wpeak, trackerStatus, srep, tt);
+  }
+
+  bool StrawHitRecoUtils::createComboHit(std::unique_ptr<mu2e::ComboHitCollection> const& chCol,
+      std::unique_ptr<mu2e::StrawHitCollection> const& shCol, const mu2e::CaloClusterCollection* caloClusters,
+      mu2e::StrawId const& sid, mu2e::TrkTypes::TDCValues const& tdc,
+      mu2e::TrkTypes::TOTValues const& tot, mu2e::TrkTypes::ADCValue const& pmp, WaveformPeak const& wpeak,
+      mu2e::TrackerStatus const& trackerStatus, mu2e::StrawResponse const& srep, mu2e::Tracker const& tt){
 
     // flag digis that shouldn't be here or we don't want
     mu2e::StrawHitFlag flag;
@@ -96,10 +125,10 @@ namespace mu2e {
     //extract energy from waveform
     float energy(0.0);
     if (_fittype == mu2e::TrkHitReco::FitType::peakminuspedavg){
-      float charge = peakMinusPedAvg(waveform);
+      float charge = peakMinusPedAvg(wpeak);
       energy = srep.ionizationEnergy(charge);
     } else if (_fittype == mu2e::TrkHitReco::FitType::peakminusped){
-      float charge = peakMinusPed(sid,waveform);
+      float charge = peakMinusPed(sid,wpeak);
       energy = srep.ionizationEnergy(charge);
     } else if (_fittype == mu2e::TrkHitReco::FitType::firmwarepmp){
       float charge = peakMinusPedFirmware(sid, pmp);
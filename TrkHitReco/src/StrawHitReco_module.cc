@@ -107,6 +107,8 @@ namespace mu2e {
       art::ProductToken<CaloClusterCollection> const _ccctoken;
       art::ProductToken<ProtonBunchTime> const _pbttoken; // name of the module that makes eventwindowmarkers
       std::unique_ptr<TrkHitReco::PeakFit> _pfit; // peak fitting algorithm
+      std::vector<TrkTypes::ADCWaveform const*> _wfptrs; // buffers reused across events
+      std::vector<StrawHitRecoUtils::WaveformPeak> _wpeaks;
       // diagnostic
       TH1F* _maxiter;
       // helper function
@@ -188,7 +190,6 @@ namespace mu2e {
         auto sdawH = event.getValidHandle(_sdadctoken);
         sdadccol = sdawH.product();
       }
-      StrawDigiADCWaveform adcwaveform;
 
       const CaloClusterCollection* caloClusters(0);
       if(_usecc){
@@ -218,13 +219,19 @@ namespace mu2e {
           _diagLevel, _maxiter, _mask, nplanes, npanels, _writesh, _minT, _maxT, _minE, _maxE, _filter, _flagXT,
           _ctE, _ctMinT, _ctMaxT, _usecc, _clusterDt, sdcol.size());
 
+      // find the waveform peaks of all digis at once, reading the waveforms in place
+      _wpeaks.assign(sdcol.size(),StrawHitRecoUtils::WaveformPeak());
+      if (_fittype != TrkHitReco::FitType::firmwarepmp) {
+        if (sdadccol->size() != sdcol.size())
+          throw cet::exception("RECO")<<"StrawHitReco: " << sdcol.size() << " StrawDigis but " << sdadccol->size() << " waveforms" << std::endl;
+        _wfptrs.clear();
+        for (auto const& sdadc : *sdadccol) _wfptrs.push_back(&sdadc.samples());
+        shrUtils.peakPedBatch(_wfptrs.data(), _wfptrs.size(), _wpeaks.data());
+      }
+
       for (size_t isd=0;isd<sdcol.size();++isd) {
 	const StrawDigi& digi = sdcol[isd];
-
-        if (_fittype != TrkHitReco::FitType::firmwarepmp)
-          adcwaveform = sdadccol->at(isd);
-
-        shrUtils.createComboHit(chCol, shCol, caloClusters, digi.strawId(), digi.TDC(), digi.TOT(), digi.PMP(), adcwaveform.samples(),
+        shrUtils.createComboHit(chCol, shCol, caloClusters, digi.strawId(), digi.TDC(), digi.TOT(), digi.PMP(), _wpeaks[isd],
           trackerStatus,  srep, tt);
       }
       //flag straw and electronic cross-talk
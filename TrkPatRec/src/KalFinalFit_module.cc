@@ -52,6 +52,10 @@
 // root
 #include "TH1F.h"
 #include "TTree.h"
+// tbb
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 // C++
 #include <iostream>
 #include <fstream>
@@ -59,6 +63,7 @@
 #include <functional>
 #include <float.h>
 #include <vector>
+#include <memory>
 using namespace std;
 using CLHEP::Hep3Vector;
 using CLHEP::HepVector;
@@ -83,6 +88,7 @@ namespace mu2e
     int _printfreq;
     int _cprmode;
     bool _saveall,_addhits;
+    unsigned _nthreads; // maximum number of threads fitting seeds
     vector<double> _zsave;
     // event object tokens
     art::ProductToken<ComboHitCollection> const _shToken;
@@ -108,17 +114,34 @@ namespace mu2e
     const CaloClusterCollection* _clCol;
     // Kalman fitter
     KalFit _kfit;
-    KalFitData _result;
+    // Kalman fitters for fitting seeds concurrently, one for each slot of the arena.  A KalFit keeps
+    // state during a fit, so a fitter can't be shared between threads
+    tbb::task_arena _arena;
+    std::vector<std::unique_ptr<KalFit>> _kfits;
 
     // diagnostic
     Data_t                                _data;
     std::unique_ptr<ModuleHistToolBase>   _hmanager;
 
+    // one seed: the inputs, resolved from the event serially, and the fit result.  A successful
+    // fit leaves its KalRep in result, for produce to put into the event
+    struct SeedFit {
+      KalFitData result;
+      art::Ptr<CaloCluster> ccPtr;
+      KalSeed fseed;
+      bool save;
+      bool tchDiag; // result.diag was filled
+    };
+
     // helper functions
     bool findData(const art::Event& e);
-    void findMissingHits(KalFitData&kalData);
-    void findMissingHits_cpr(StrawResponse::cptr_t srep, KalFitData&kalData);
-    bool hasTrkCaloHit(KalFitData&kalData);
+    // fit one seed.  This uses only the event data resolved into sfit, and the given fitter, so
+    // seeds can be fit concurrently, each with its own fitter
+    void fitSeed(SeedFit& sfit, KalFit& kfit, StrawResponse::cptr_t srep, Mu2eDetector::cptr_t detmodel,
+	art::ValidHandle<CaloClusterCollection> const& clH) const;
+    void findMissingHits(KalFitData&kalData) const;
+    void findMissingHits_cpr(StrawResponse::cptr_t srep, KalFitData&kalData) const;
+    bool hasTrkCaloHit(KalFitData&kalData) const;
 
     ProditionsHandle<StrawResponse> _strawResponse_h;
     ProditionsHandle<Mu2eDetector> _mu2eDetector_h;
@@ -134,6 +157,7 @@ namespace mu2e
     _cprmode(pset.get<int>("cprmode",0)),
     _saveall(pset.get<bool>("saveall", false)),
     _addhits(pset.get<bool>("addhits", true)),
+    _nthreads(pset.get<unsigned>("NThreads", 1)),
     _zsave(pset.get<vector<double>>("ZSavePositions", vector<double>{-1522.0,0.0,1522.0})), // front, middle and back of the tracker
     _shToken{consumes<ComboHitCollection>(pset.get<art::InputTag>("ComboHitCollection"))},
     _shfTag{pset.get<art::InputTag>("StrawHitFlagCollection", "none")},
@@ -150,8 +174,13 @@ namespace mu2e
     _tpart((TrkParticle::type)(pset.get<int>("fitparticle", TrkParticle::e_minus))),
     _fdir((TrkFitDirection::FitDirection)(pset.get<int>("fitdirection", TrkFitDirection::downstream))),
     _kfit(pset.get<fhicl::ParameterSet>("KalFit", {})),
-    _result()
+    _arena(_nthreads > 0 ? (int)_nthreads : tbb::task_arena::automatic)
   {
+    // NThreads: 0 = no limit, 1 = serial (the default): fit with _kfit
+    if(_nthreads != 1){
+      for(int islot = 0; islot < _arena.max_concurrency(); ++islot)
+	_kfits.push_back(std::make_unique<KalFit>(pset.get<fhicl::ParameterSet>("KalFit", {})));
+    }
 
     produces<KalRepCollection>();
     produces<KalRepPtrCollection>();
@@ -161,8 +190,6 @@ namespace mu2e
 //-----------------------------------------------------------------------------
 // provide for interactive diagnostics
 //-----------------------------------------------------------------------------
-    _data.result    = &_result;
-
     if (_diag != 0) {
       _hmanager = art::make_tool<ModuleHistToolBase>(pset.get<fhicl::ParameterSet>("diagPlugin"));
       fhicl::ParameterSet ps1 = pset.get<fhicl::ParameterSet>("KalFit.DoubletAmbigResolver");
@@ -192,6 +219,13 @@ namespace mu2e
 
     _kfit.setCalorimeter (_data.calorimeter);
     _kfit.setCaloGeom();
+    // the concurrent fitters are set up here, as that accesses services.  This includes
+    // creating their BField, which KalFit otherwise does lazily
+    for(auto& kfit : _kfits){
+      kfit->setCalorimeter (_data.calorimeter);
+      kfit->setCaloGeom();
+      kfit->bField();
+    }
   }
 
 
@@ -202,6 +236,7 @@ namespace mu2e
 
     _data.tracker = _alignedTracker_h.getPtr(event.id()).get();
     _kfit.setTracker(_data.tracker);
+    for(auto& kfit : _kfits) kfit->setTracker(_data.tracker);
 
     // event printout
     _iev=event.id().event();
@@ -233,212 +268,249 @@ namespace mu2e
     if (_diag!=0){
       _data.event  = &event;
       _data.eventNumber = event.event();
-      _data.result = &_result;
       _data.tracks = krcol.get();
       _data.kscol  = kscol.get();
     }
 
-    _result.fitType        = 1;
-    _result.event          = &event ;
-    _result.chcol          = _chcol ;
-    _result.shfcol         = _shfcol ;
-    if (_kfit.useTrkCaloHit()) _result.caloClusterCol = _clCol;
-    //    _result.tpart       = _tpart ;
-    _result.fdir           = _fdir  ;
-
-    // loop over the seed fits.  I need an index loop here to build the Ptr
+    // prepare the seed fits.  The event is only accessed here, so that the fits themselves can run concurrently:
+    // resolve the CaloCluster Ptrs the fit follows
+    std::vector<SeedFit> sfits(_kscol->size());
     for(size_t ikseed=0; ikseed < _kscol->size(); ++ikseed) {
       KalSeed const& kseed(_kscol->at(ikseed));
-      _result.kalSeed = & kseed;
-      auto hptr = (*_khassns)[ikseed].second; // Ptr to the original HelixSeed
-      //      _result.tpart   = kseed.particle();
+      SeedFit& sfit = sfits[ikseed];
+      sfit.save = false;
+      sfit.tchDiag = false;
+      sfit.result.fitType        = 1;
+      sfit.result.event          = &event ;
+      sfit.result.chcol          = _chcol ;
+      sfit.result.shfcol         = _shfcol ;
+      if (_kfit.useTrkCaloHit()) sfit.result.caloClusterCol = _clCol;
+      //    sfit.result.tpart       = _tpart ;
+      sfit.result.fdir           = _fdir  ;
+      sfit.result.kalSeed        = & kseed;
+      sfit.result.caloCluster    = 0;
       // create a Ptr for possible added CaloCluster
-      art::Ptr<CaloCluster> ccPtr;
       if (kseed.caloCluster()){
-	_result.caloCluster = kseed.caloCluster().get(); // should not be using KalFitData as a common block FIXME!
-	ccPtr = kseed.caloCluster(); // remember the Ptr for creating the TrkCaloHitSeed and KalSeed Ptr
+	sfit.result.caloCluster = kseed.caloCluster().get();
+	sfit.ccPtr = kseed.caloCluster(); // remember the Ptr for creating the TrkCaloHitSeed and KalSeed Ptr
       }
+    }
 
-      // only process fits which meet the requirements
-      if(kseed.status().hasAllProperties(_goodseed)) {
-	// check the seed has the same basic parameters as this module expects
-
-	// if(kseed.particle() != _tpart || kseed.fitDirection() != _fdir ) {
-	//   throw cet::exception("RECO")<<"mu2e::KalFinalFit: wrong particle or direction"<< endl;
-	// }
+    // fit the seeds, concurrently if so configured.  Printout and diagnostics need the fits in order
+    if(_debug > 0 || _diag > 0 || _kfits.empty() || sfits.size() < 2){
+      for(size_t ikseed=0; ikseed < sfits.size(); ++ikseed)
+	fitSeed(sfits[ikseed],_kfit,srep,detmodel,clH);
+    } else {
+      _arena.execute([&]{
+	  tbb::parallel_for(tbb::blocked_range<size_t>(0,sfits.size(),1),
+	    [&](tbb::blocked_range<size_t> const& range) {
+	      KalFit& kfit = *_kfits[tbb::this_task_arena::current_thread_index()];
+	      for(size_t ikseed=range.begin(); ikseed != range.end(); ++ikseed)
+		fitSeed(sfits[ikseed],kfit,srep,detmodel,clH);
+	    });
+	  });
+    }
 
-	// seed should have at least 1 segment
-	if(kseed.segments().size() < 1){
-	  throw cet::exception("RECO")<<"mu2e::KalFinalFit: no segments"<< endl;
+    // collect the results in seed order
+    for(size_t ikseed=0; ikseed < sfits.size(); ++ikseed) {
+      SeedFit& sfit = sfits[ikseed];
+      if(!sfit.save) continue;
+      auto hptr = (*_khassns)[ikseed].second; // Ptr to the original HelixSeed
+      // flg all hits as belonging to a track.  Doesn't work for TrkCaloHit FIXME!
+      if(ikseed<StrawHitFlag::_maxTrkId){
+	for(auto ihit=sfit.result.krep->hitVector().begin();ihit != sfit.result.krep->hitVector().end();++ihit){
+	  TrkStrawHit* tsh = dynamic_cast<TrkStrawHit*>(*ihit);
+	  if((*ihit)->isActive() && tsh != 0)shfcol->at(tsh->index()).merge(StrawHitFlag::track);
 	}
-	// build a Kalman rep around this seed
-	//fill the KalFitData variable
-	// _result.kalSeed = &kseed;
-
-	// _kfit.makeTrack(_shcol,kseed,krep);
-	_result.init();
-	_kfit.makeTrack(srep,detmodel,_result);
-
-	// KalRep *krep = _result.stealTrack();
-
-	if(_debug > 1){
-	  if(_result.krep == 0)
-	    cout << "No Final fit produced " << endl;
-	  else{
-	    cout << "Seed Fit HelixTraj parameters " << _result.krep->seedTrajectory()->parameters()->parameter()
-	      << " covariance " << _result.krep->seedTrajectory()->parameters()->covariance()
-	      << " NDOF = " << _result.krep->nDof()
-	      << " Final Fit status " << _result.krep->fitStatus()  << endl;
-	  }
+      }
+      // save successful kalman fits in the event
+      KalRep *krep = sfit.result.stealTrack();
+      krcol->push_back(krep);
+
+      int index = krcol->size()-1;
+      krPtrcol->emplace_back(kalRepsID, index, event.productGetter(kalRepsID));
+      // save KalSeed for this track
+      kscol->push_back(sfit.fseed);
+      // fill assns with the helix seed
+      auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kscol->size()-1,KalSeedCollectionGetter);
+      kfhassns->addSingle(kseedptr,hptr);
+
+      if (_diag > 0) {
+	if (sfit.tchDiag) {
+	  _data.tchDiskId  = sfit.result.diag.diskId;
+	  _data.tchAdded   = sfit.result.diag.added;
+	  _data.tchDepth   = sfit.result.diag.depth;
+	  _data.tchDOCA    = sfit.result.diag.doca;
+	  _data.tchDt      = sfit.result.diag.dt;
+	  _data.tchTrkPath = sfit.result.diag.trkPath;
+	  _data.tchEnergy  = sfit.result.diag.energy;
 	}
-	// if successfull, try to add missing hits
-	if(_addhits && _result.krep != 0 && _result.krep->fitStatus().success()){
-	    // first, add back the hits on this track
-	  //	  _result.nunweediter = 0;
-	  _kfit.unweedHits(_result,_maxaddchi);
-	  if (_debug > 0) _kfit.printUtils()->printTrack(&event,_result.krep,"banner+data+hits","CalTrkFit::produce after unweedHits");
-
-	  if (_cprmode){
-	    findMissingHits_cpr(srep,_result);
-	  }else {
-	    findMissingHits(_result);
-	  }
-	  //check the presence of a TrkCaloHit; if it's not present, add it
-	  if (_kfit.useTrkCaloHit() ){
-	    if (!hasTrkCaloHit(_result)){
-	      int icc = _kfit.addTrkCaloHit(detmodel, _result);
-	      if(icc >=0){
-	      // set the CaloCluster Ptr for the TrkCaloHitSeed.
-		ccPtr = art::Ptr<CaloCluster>(clH,(size_t)icc);
-	      }
-	    }
-	    if ( hasTrkCaloHit(_result)) _kfit.weedTrkCaloHit(_result);
-	    if (_diag!=0) {
-	      _kfit.fillTchDiag(_result);
-	      _data.tchDiskId  = _result.diag.diskId;
-	      _data.tchAdded   = _result.diag.added;
-	      _data.tchDepth   = _result.diag.depth;
-	      _data.tchDOCA    = _result.diag.doca;
-	      _data.tchDt      = _result.diag.dt;
-	      _data.tchTrkPath = _result.diag.trkPath;
-	      _data.tchEnergy  = _result.diag.energy;
+	_data.result = &sfit.result;
+	_hmanager->fillHistograms(&_data);
+      }
+    }
+
+    // if (_diag > 0) _hmanager->fillHistograms(&_data);
+
+    // put the output products into the event
+    event.put(move(krcol));
+    event.put(move(krPtrcol));
+    event.put(move(kscol));
+    event.put(move(kfhassns));
+    event.put(move(shfcol));
+  }
+
+  void KalFinalFit::fitSeed(SeedFit& sfit, KalFit& kfit, StrawResponse::cptr_t srep, Mu2eDetector::cptr_t detmodel,
+      art::ValidHandle<CaloClusterCollection> const& clH) const {
+    KalFitData& result = sfit.result;
+    KalSeed const& kseed(*result.kalSeed);
+    art::Ptr<CaloCluster>& ccPtr = sfit.ccPtr;
 
+    // only process fits which meet the requirements
+    if(kseed.status().hasAllProperties(_goodseed)) {
+      // check the seed has the same basic parameters as this module expects
+
+      // if(kseed.particle() != _tpart || kseed.fitDirection() != _fdir ) {
+      //   throw cet::exception("RECO")<<"mu2e::KalFinalFit: wrong particle or direction"<< endl;
+      // }
+
+      // seed should have at least 1 segment
+      if(kseed.segments().size() < 1){
+	throw cet::exception("RECO")<<"mu2e::KalFinalFit: no segments"<< endl;
+      }
+      // build a Kalman rep around this seed
+      //fill the KalFitData variable
+      // result.kalSeed = &kseed;
+
+      // kfit.makeTrack(_shcol,kseed,krep);
+      result.init();
+      kfit.makeTrack(srep,detmodel,result);
+
+      // KalRep *krep = result.stealTrack();
+
+      if(_debug > 1){
+	if(result.krep == 0)
+	  cout << "No Final fit produced " << endl;
+	else{
+	  cout << "Seed Fit HelixTraj parameters " << result.krep->seedTrajectory()->parameters()->parameter()
+	    << " covariance " << result.krep->seedTrajectory()->parameters()->covariance()
+	    << " NDOF = " << result.krep->nDof()
+	    << " Final Fit status " << result.krep->fitStatus()  << endl;
+	}
+      }
+      // if successfull, try to add missing hits
+      if(_addhits && result.krep != 0 && result.krep->fitStatus().success()){
+	  // first, add back the hits on this track
+	//	  result.nunweediter = 0;
+	kfit.unweedHits(result,_maxaddchi);
+	if (_debug > 0) kfit.printUtils()->printTrack(result.event,result.krep,"banner+data+hits","CalTrkFit::produce after unweedHits");
+
+	if (_cprmode){
+	  findMissingHits_cpr(srep,result);
+	}else {
+	  findMissingHits(result);
+	}
+	//check the presence of a TrkCaloHit; if it's not present, add it
+	if (kfit.useTrkCaloHit() ){
+	  if (!hasTrkCaloHit(result)){
+	    int icc = kfit.addTrkCaloHit(detmodel, result);
+	    if(icc >=0){
+	    // set the CaloCluster Ptr for the TrkCaloHitSeed.
+	      ccPtr = art::Ptr<CaloCluster>(clH,(size_t)icc);
 	    }
 	  }
-
-	  if(_result.missingHits.size() > 0){
-	    _kfit.addHits(srep,detmodel,_result,_maxaddchi);
-	  }else if (_cprmode){
-	    int last_iteration  = -1;
-	    _kfit.fitIteration(detmodel,_result,last_iteration);
+	  if ( hasTrkCaloHit(result)) kfit.weedTrkCaloHit(result);
+	  if (_diag!=0) {
+	    kfit.fillTchDiag(result);
+	    sfit.tchDiag = true;
 	  }
-	  if(_debug > 1)
-	    cout << "AddHits Fit result " << _result.krep->fitStatus()
-	    << " NDOF = " << _result.krep->nDof() << endl;
+	}
+
+	if(result.missingHits.size() > 0){
+	  kfit.addHits(srep,detmodel,result,_maxaddchi);
+	}else if (_cprmode){
+	  int last_iteration  = -1;
+	  kfit.fitIteration(detmodel,result,last_iteration);
+	}
+	if(_debug > 1)
+	  cout << "AddHits Fit result " << result.krep->fitStatus()
+	  << " NDOF = " << result.krep->nDof() << endl;
 
 //-----------------------------------------------------------------------------
 // and weed hits again to insure that addHits doesn't add junk
 //-----------------------------------------------------------------------------
-	  int last_iteration  = -1;
-	  if (_cprmode) _kfit.weedHits(_result,last_iteration);
-	}
-	// put successful fits into the event
-	if(_result.krep != 0 && (_result.krep->fitStatus().success() || _saveall)){
+	int last_iteration  = -1;
+	if (_cprmode) kfit.weedHits(result,last_iteration);
+      }
+      // keep successful fits for the event
+      if(result.krep != 0 && (result.krep->fitStatus().success() || _saveall)){
 //-----------------------------------------------------------------------------
 // now evaluate the T0 and its error using the straw hits
 //-----------------------------------------------------------------------------
 //	  int last_iteration  = -1;
-//	  if (_cprmode)	_kfit.updateT0(_result, last_iteration);
-
-	  // warning about 'fit current': this is not an error
-	  if(!_result.krep->fitCurrent()){
-	    cout << "Fit not current! " << endl;
-	    _result.deleteTrack();
-	  } else {
-	    // flg all hits as belonging to a track.  Doesn't work for TrkCaloHit FIXME!
-	    if(ikseed<StrawHitFlag::_maxTrkId){
-	      for(auto ihit=_result.krep->hitVector().begin();ihit != _result.krep->hitVector().end();++ihit){
-		TrkStrawHit* tsh = dynamic_cast<TrkStrawHit*>(*ihit);
-		if((*ihit)->isActive() && tsh != 0)shfcol->at(tsh->index()).merge(StrawHitFlag::track);
-	      }
-	    }
-
-
-	    // save successful kalman fits in the event
-	    KalRep *krep = _result.stealTrack();
-	    krcol->push_back(krep);
-
-	    int index = krcol->size()-1;
-	    krPtrcol->emplace_back(kalRepsID, index, event.productGetter(kalRepsID));
-	    // convert successful fits into 'seeds' for persistence
-	    TrkFitFlag fflag(kseed.status());
-	    fflag.merge(TrkFitFlag::KFF);
-	    if(krep->fitStatus().success()) fflag.merge(TrkFitFlag::kalmanOK);
-	    if(krep->fitStatus().success()==1) fflag.merge(TrkFitFlag::kalmanConverged);
-	    //	  KalSeed fseed(_tpart,_fdir,krep->t0(),krep->flt0(),kseed.status());
-	    KalSeed fseed(PDGCode::type(krep->particleType().particleType()),_fdir,fflag,krep->flt0());
-	    // fill with new information
-	    fseed._flt0 = krep->flt0();
-	    // global fit information
-	    fseed._chisq = krep->chisq();
-	    // compute the fit consistency.  Note our fit has effectively 6 parameters as t0 is allowed to float and its error is propagated to the chisquared
-	    fseed._fitcon =  TrkUtilities::chisqConsistency(krep);
-	    fseed._nseg = krep->pieceTraj().localTrajectory().size();
-	    TrkUtilities::fillStrawHitSeeds(krep,*_chcol,fseed._hits);
-	    TrkUtilities::fillStraws(krep,fseed._straws);
-	    // sample the fit at the requested z positions.  Need options here to define a set of
-	    // standard points, or to sample each unique segment on the fit FIXME!
-	    for(auto zpos : _zsave) {
-	      // compute the flightlength for this z
-	      double fltlen = krep->pieceTraj().zFlight(zpos);
-	      // sample the momentum at this flight.  This belongs in a separate utility FIXME
-	      BbrVectorErr momerr = krep->momentumErr(fltlen);
-	      // sample the helix
-	      double locflt(0.0);
-	      const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(krep->localTrajectory(fltlen,locflt));
-	      // fill the segment
-	      KalSegment kseg;
-	      TrkUtilities::fillSegment(*htraj,locflt,fltlen,krep->t0(),_tpart.mass(),(int)_tpart.charge(),_kfit.bField(),kseg);
-	      fseed._segments.push_back(kseg);
-	    }
-	    // see if there's a TrkCaloHit
-	    const TrkCaloHit* tch = TrkUtilities::findTrkCaloHit(krep);
-	    if(tch != 0){
-	      TrkUtilities::fillCaloHitSeed(tch,fseed._chit);
-	      // set the Ptr using the helix: this could be more direct FIXME!
-	      fseed._chit._cluster = ccPtr;
-	      // create a helix segment at the TrkCaloHit
-	      KalSegment kseg;
-	      // sample the momentum at this flight.  This belongs in a separate utility FIXME
-	      BbrVectorErr momerr = krep->momentumErr(tch->fltLen());
-	      double locflt(0.0);
-	      const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(krep->localTrajectory(tch->fltLen(),locflt));
-	      TrkUtilities::fillSegment(*htraj,locflt,tch->fltLen(),krep->t0(),_tpart.mass(),(int)_tpart.charge(),_kfit.bField(),kseg);
-	      fseed._segments.push_back(kseg);
-	    }
-	    // save KalSeed for this track
-	    kscol->push_back(fseed);
-	    // fill assns with the helix seed
-	    auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kscol->size()-1,KalSeedCollectionGetter);
-	    kfhassns->addSingle(kseedptr,hptr);
-
-	    if (_diag > 0) _hmanager->fillHistograms(&_data);
+//	  if (_cprmode)	kfit.updateT0(result, last_iteration);
+
+	// warning about 'fit current': this is not an error
+	if(!result.krep->fitCurrent()){
+	  cout << "Fit not current! " << endl;
+	  result.deleteTrack();
+	} else {
+	  KalRep* krep = result.krep;
+	  // convert successful fits into 'seeds' for persistence
+	  TrkFitFlag fflag(kseed.status());
+	  fflag.merge(TrkFitFlag::KFF);
+	  if(krep->fitStatus().success()) fflag.merge(TrkFitFlag::kalmanOK);
+	  if(krep->fitStatus().success()==1) fflag.merge(TrkFitFlag::kalmanConverged);
+	  //	  KalSeed fseed(_tpart,_fdir,krep->t0(),krep->flt0(),kseed.status());
+	  KalSeed fseed(PDGCode::type(krep->particleType().particleType()),_fdir,fflag,krep->flt0());
+	  // fill with new information
+	  fseed._flt0 = krep->flt0();
+	  // global fit information
+	  fseed._chisq = krep->chisq();
+	  // compute the fit consistency.  Note our fit has effectively 6 parameters as t0 is allowed to float and its error is propagated to the chisquared
+	  fseed._fitcon =  TrkUtilities::chisqConsistency(krep);
+	  fseed._nseg = krep->pieceTraj().localTrajectory().size();
+	  TrkUtilities::fillStrawHitSeeds(krep,*_chcol,fseed._hits);
+	  TrkUtilities::fillStraws(krep,fseed._straws);
+	  // sample the fit at the requested z positions.  Need options here to define a set of
+	  // standard points, or to sample each unique segment on the fit FIXME!
+	  for(auto zpos : _zsave) {
+	    // compute the flightlength for this z
+	    double fltlen = krep->pieceTraj().zFlight(zpos);
+	    // sample the momentum at this flight.  This belongs in a separate utility FIXME
+	    BbrVectorErr momerr = krep->momentumErr(fltlen);
+	    // sample the helix
+	    double locflt(0.0);
+	    const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(krep->localTrajectory(fltlen,locflt));
+	    // fill the segment
+	    KalSegment kseg;
+	    TrkUtilities::fillSegment(*htraj,locflt,fltlen,krep->t0(),_tpart.mass(),(int)_tpart.charge(),kfit.bField(),kseg);
+	    fseed._segments.push_back(kseg);
+	  }
+	  // see if there's a TrkCaloHit
+	  const TrkCaloHit* tch = TrkUtilities::findTrkCaloHit(krep);
+	  if(tch != 0){
+	    TrkUtilities::fillCaloHitSeed(tch,fseed._chit);
+	    // set the Ptr using the helix: this could be more direct FIXME!
+	    fseed._chit._cluster = ccPtr;
+	    // create a helix segment at the TrkCaloHit
+	    KalSegment kseg;
+	    // sample the momentum at this flight.  This belongs in a separate utility FIXME
+	    BbrVectorErr momerr = krep->momentumErr(tch->fltLen());
+	    double locflt(0.0);
+	    const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(krep->localTrajectory(tch->fltLen(),locflt));
+	    TrkUtilities::fillSegment(*htraj,locflt,tch->fltLen(),krep->t0(),_tpart.mass(),(int)_tpart.charge(),kfit.bField(),kseg);
+	    fseed._segments.push_back(kseg);
 	  }
-	} else {// fit failure
-	  _result.deleteTrack();
-	  //	  delete krep;
+	  // produce puts the KalRep and this KalSeed into the event
+	  sfit.fseed = fseed;
+	  sfit.save = true;
 	}
+      } else {// fit failure
+	result.deleteTrack();
+	//	  delete krep;
       }
     }
-
-    // if (_diag > 0) _hmanager->fillHistograms(&_data);
-
-    // put the output products into the event
-    event.put(move(krcol));
-    event.put(move(krPtrcol));
-    event.put(move(kscol));
-    event.put(move(kfhassns));
-    event.put(move(shfcol));
   }
 
   // find the input data objects
@@ -471,7 +543,7 @@ namespace mu2e
 //-----------------------------------------------------------------------------
 //
 //-----------------------------------------------------------------------------
-  void KalFinalFit::findMissingHits_cpr(StrawResponse::cptr_t srep, KalFitData& KRes) {
+  void KalFinalFit::findMissingHits_cpr(StrawResponse::cptr_t srep, KalFitData& KRes) const {
 
     const char* oname = "KalFinalFit::findMissingHits_cpr";
 
@@ -632,7 +704,7 @@ namespace mu2e
     }
   }
 
-  void KalFinalFit::findMissingHits(KalFitData&kalData) {
+  void KalFinalFit::findMissingHits(KalFitData&kalData) const {
     KalRep* krep = kalData.krep;
 
     //clear the array
@@ -688,7 +760,7 @@ namespace mu2e
 //--------------------------------------------------------------------------------
 // function to check the presence of a TrkCaloHit in the KalRep
 //--------------------------------------------------------------------------------
-  bool KalFinalFit::hasTrkCaloHit(KalFitData&kalData){
+  bool KalFinalFit::hasTrkCaloHit(KalFitData&kalData) const {
     bool retval(false);
 
     TrkHitVector *thv      = &(kalData.krep->hitVector());
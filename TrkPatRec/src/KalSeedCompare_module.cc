@@ -0,0 +1,94 @@
+//
+// Check that two KalSeed collections are identical, e.g. the outputs of KalSeedFit, KalFinalFit or LoopHelixFit
+// run with different numbers of threads on the same input.  Seeds are compared in order: particle, status,
+// chisquared, consistency, t0 flight, the hit indices and the segment times, momenta and positions.  The number
+// of differences is printed at the end of the job.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+
+#include "RecoDataProducts/inc/KalSeed.hh"
+
+#include <cstdio>
+
+
+namespace mu2e {
+
+  class KalSeedCompare : public art::EDAnalyzer {
+    public:
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+      struct Config {
+	fhicl::Atom<art::InputTag> ksTag1{ Name("KalSeedCollection1"), Comment("Reference KalSeed collection")};
+	fhicl::Atom<art::InputTag> ksTag2{ Name("KalSeedCollection2"), Comment("KalSeed collection to compare")};
+	fhicl::Atom<int> debug{ Name("debugLevel"), Comment("Print the differences if > 0"), 0};
+      };
+
+      using Parameters = art::EDAnalyzer::Table<Config>;
+      explicit KalSeedCompare(Parameters const& config);
+      void analyze(art::Event const& event) override;
+      void endJob() override;
+
+    private:
+      bool same(KalSeed const& ks1, KalSeed const& ks2) const;
+      art::ProductToken<KalSeedCollection> const _kstoken1;
+      art::ProductToken<KalSeedCollection> const _kstoken2;
+      int _debug;
+      size_t _nevents, _nseeds, _ndiff;
+  };
+
+  KalSeedCompare::KalSeedCompare(Parameters const& config) :
+    art::EDAnalyzer{config},
+    _kstoken1{consumes<KalSeedCollection>(config().ksTag1())},
+    _kstoken2{consumes<KalSeedCollection>(config().ksTag2())},
+    _debug(config().debug()),
+    _nevents(0), _nseeds(0), _ndiff(0)
+  {}
+
+  bool KalSeedCompare::same(KalSeed const& ks1, KalSeed const& ks2) const {
+    if(ks1.particle() != ks2.particle() || !(ks1.status() == ks2.status())
+	|| ks1.chisquared() != ks2.chisquared() || ks1.fitConsistency() != ks2.fitConsistency()
+	|| ks1.flt0() != ks2.flt0() || ks1.hits().size() != ks2.hits().size()
+	|| ks1.segments().size() != ks2.segments().size() || ks1.hasCaloCluster() != ks2.hasCaloCluster())
+      return false;
+    for(size_t ihit = 0; ihit < ks1.hits().size(); ++ihit){
+      if(ks1.hits()[ihit].index() != ks2.hits()[ihit].index()) return false;
+    }
+    for(size_t iseg = 0; iseg < ks1.segments().size(); ++iseg){
+      KalSegment const& seg1 = ks1.segments()[iseg];
+      KalSegment const& seg2 = ks2.segments()[iseg];
+      if(seg1.tmin() != seg2.tmin() || seg1.tmax() != seg2.tmax() || seg1.mom() != seg2.mom()
+	  || seg1.position3() != seg2.position3()) return false;
+    }
+    return true;
+  }
+
+  void KalSeedCompare::analyze(art::Event const& event) {
+    auto const& kscol1 = *event.getValidHandle(_kstoken1);
+    auto const& kscol2 = *event.getValidHandle(_kstoken2);
+    ++_nevents;
+    _nseeds += kscol1.size();
+    if(kscol1.size() != kscol2.size()){
+      if(_debug > 0) std::printf("[KalSeedCompare] event %u: %zu and %zu seeds\n", event.event(), kscol1.size(), kscol2.size());
+      ++_ndiff;
+      return;
+    }
+    for(size_t iks = 0; iks < kscol1.size(); ++iks){
+      if(!same(kscol1[iks],kscol2[iks])){
+	if(_debug > 0) std::printf("[KalSeedCompare] event %u: seed %zu differs\n", event.event(), iks);
+	++_ndiff;
+      }
+    }
+  }
+
+  void KalSeedCompare::endJob() {
+    std::printf("[KalSeedCompare] %zu events, %zu seeds, %zu differences\n", _nevents, _nseeds, _ndiff);
+  }
+
+}
+
+using mu2e::KalSeedCompare;
+DEFINE_ART_MODULE(KalSeedCompare);
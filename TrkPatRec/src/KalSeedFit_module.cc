@@ -58,6 +58,10 @@
 // root
 #include "TH1F.h"
 #include "TTree.h"
+// tbb
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 // C++
 #include <iostream>
 #include <fstream>
@@ -65,6 +69,7 @@
 #include <functional>
 #include <float.h>
 #include <vector>
+#include <memory>
 using namespace std;
 using CLHEP::Hep3Vector;
 using CLHEP::HepVector;
@@ -90,6 +95,7 @@ namespace mu2e
     int _printfreq;
     bool _saveall;
     bool _checkhelicity;
+    unsigned _nthreads; // maximum number of threads fitting seeds
     // event object tags
     art::ProductToken<ComboHitCollection> const _shToken;
     art::ProductToken<HelixSeedCollection> const _hsToken;
@@ -116,7 +122,10 @@ namespace mu2e
     // ouptut collections
     // Kalman fitter.  This will be configured for a least-squares fit (no material or BField corrections).
     KalFit _kfit;
-    KalFitData _result;
+    // Kalman fitters for fitting seeds concurrently, one for each slot of the arena.  A KalFit keeps
+    // state during a fit, so a fitter can't be shared between threads
+    tbb::task_arena _arena;
+    std::vector<std::unique_ptr<KalFit>> _kfits;
     const Tracker* _tracker;     // straw tracker geometry
 
     ProditionsHandle<StrawResponse> _strawResponse_h;
@@ -128,10 +137,22 @@ namespace mu2e
     Data_t                                _data;
     std::unique_ptr<ModuleHistToolBase>   _hmanager;
 
+    // one seed: the inputs, unwound from the event serially, and the fit result
+    struct SeedFit {
+      KalFitData result;
+      std::vector<StrawHitIndex> strawHitIdxs;
+      KalSeed kseed;
+      bool save;
+    };
+
     // helper functions
     bool findData(const art::Event& e);
-    void filterOutliers(TrkDef& trkdef);
-    void findMissingHits(KalFitData&kalData);
+    // fit one seed.  This uses only the event data unwound into sfit, and the given fitter, so
+    // seeds can be fit concurrently, each with its own fitter
+    void fitSeed(HelixSeed const& hseed, SeedFit& sfit, KalFit& kfit,
+	StrawResponse::cptr_t srep, Mu2eDetector::cptr_t detmodel) const;
+    void filterOutliers(TrkDef& trkdef) const;
+    void findMissingHits(KalFitData&kalData) const;
   };
 
   KalSeedFit::KalSeedFit(fhicl::ParameterSet const& pset) :
@@ -141,6 +162,7 @@ namespace mu2e
     _printfreq(pset.get<int>("printFrequency",101)),
     _saveall(pset.get<bool>("saveall",false)),
     _checkhelicity(pset.get<bool>("CheckHelicity",true)),
+    _nthreads(pset.get<unsigned>("NThreads",1)),
     _shToken{consumes<ComboHitCollection>(pset.get<art::InputTag>("ComboHitCollection"))},
     _hsToken{consumes<HelixSeedCollection>(pset.get<art::InputTag>("SeedCollection"))},
     _seedflag(pset.get<vector<string> >("HelixFitFlag",vector<string>{"HelixOK"})),
@@ -158,7 +180,7 @@ namespace mu2e
     _downz(pset.get<double>("DownstreamZ",1500)),
     _ksf(TrkFitFlag::KSF),
     _kfit(pset.get<fhicl::ParameterSet>("KalFit",fhicl::ParameterSet())),
-    _result()
+    _arena(_nthreads > 0 ? (int)_nthreads : tbb::task_arena::automatic)
   {
     // This following consumesMany call is necessary because
     // ComboHitCollection::fillStrawHitIndices calls getManyByType
@@ -175,11 +197,15 @@ namespace mu2e
       _hcovar(ipar+1,ipar+1) = _perr[ipar]*_perr[ipar]; // clhep indexing starts a 1
     }
 
+    // NThreads: 0 = no limit, 1 = serial (the default): fit with _kfit
+    if(_nthreads != 1){
+      for(int islot = 0; islot < _arena.max_concurrency(); ++islot)
+	_kfits.push_back(std::make_unique<KalFit>(pset.get<fhicl::ParameterSet>("KalFit",fhicl::ParameterSet())));
+    }
+
 //-----------------------------------------------------------------------------
 // provide for interactive disanostics
 //-----------------------------------------------------------------------------
-    _data.result    = &_result;
-
 
     if (_diag != 0) _hmanager = art::make_tool<ModuleHistToolBase>(pset.get<fhicl::ParameterSet>("diagPlugin"));
     else            _hmanager = std::make_unique<ModuleHistToolBase>();
@@ -196,6 +222,12 @@ namespace mu2e
     _mu2eMaterial_h.get(run.id());
 
     _kfit.setCaloGeom();
+    // the concurrent fitters are set up here, as that accesses services.  This includes
+    // creating their BField, which KalFit otherwise does lazily
+    for(auto& kfit : _kfits){
+      kfit->setCaloGeom();
+      kfit->bField();
+    }
 
     // change coordinates to mu2e
     CLHEP::Hep3Vector vpoint(0.0,0.0,0.0);
@@ -215,6 +247,7 @@ namespace mu2e
 
     _tracker = _alignedTracker_h.getPtr(event.id()).get();
     _kfit.setTracker(_tracker);
+    for(auto& kfit : _kfits) kfit->setTracker(_tracker);
 
     // create output collection
     unique_ptr<KalSeedCollection> kscol(new KalSeedCollection());
@@ -230,194 +263,231 @@ namespace mu2e
     }
     if (_diag){
       _data.event  = &event;
-      _data.result = &_result;
       _data.nrescued.clear();
       // _data.mom.clear();
       _data.tracks = kscol.get();
     }
 
-    _result.fitType     = 0;
-    _result.event       = &event ;
-    _result.chcol       = _chcol ;
-    //    _result.tpart       = _tpart ;
-    _result.fdir        = _fdir  ;
-
-    // loop over the Helices
+    // prepare the Helices.  The event is only accessed here, so that the fits themselves can run concurrently:
+    // unwind the straw hits and resolve the Ptrs the fit follows
+    std::vector<SeedFit> sfits(_hscol->size());
     for (size_t iseed=0; iseed<_hscol->size(); ++iseed) {
-      // convert the HelixSeed to a TrkDef
       HelixSeed const& hseed(_hscol->at(iseed));
+      SeedFit& sfit = sfits[iseed];
+      sfit.save = false;
+      sfit.result.fitType     = 0;
+      sfit.result.event       = &event ;
+      sfit.result.chcol       = _chcol ;
+      //    sfit.result.tpart       = _tpart ;
+      sfit.result.fdir        = _fdir  ;
+      sfit.result.helixSeed   = &hseed;
+      sfit.result.caloCluster = hseed.caloCluster() ? hseed.caloCluster().get() : 0;
+      if(hseed.status().hasAllProperties(_seedflag)){
+	// findMissingHits follows the TimeCluster Ptr
+	if(_rescueHits) hseed.timeCluster().get();
+	// build a time cluster: exclude the outlier hits
+	for(uint16_t ihit=0;ihit < hseed.hits().size(); ++ihit){
+	  ComboHit const& ch = hseed.hits()[ihit];
+	  if((!_fhoutliers) || (!ch.flag().hasAnyProperty(StrawHitFlag::outlier)))
+	    hseed.hits().fillStrawHitIndices(event,ihit,sfit.strawHitIdxs);
+	}
+      }
+    }
+
+    // fit the Helices, concurrently if so configured.  Printout and diagnostics need the fits in order
+    if(_debug > 0 || _diag > 0 || _kfits.empty() || sfits.size() < 2){
+      for (size_t iseed=0; iseed<sfits.size(); ++iseed) {
+	if (_diag) _data.result = &sfits[iseed].result;
+	fitSeed(_hscol->at(iseed),sfits[iseed],_kfit,srep,detmodel);
+      }
+    } else {
+      _arena.execute([&]{
+	  tbb::parallel_for(tbb::blocked_range<size_t>(0,sfits.size(),1),
+	    [&](tbb::blocked_range<size_t> const& range) {
+	      KalFit& kfit = *_kfits[tbb::this_task_arena::current_thread_index()];
+	      for(size_t iseed=range.begin(); iseed != range.end(); ++iseed)
+		fitSeed(_hscol->at(iseed),sfits[iseed],kfit,srep,detmodel);
+	    });
+	  });
+    }
+
+    // collect the results in Helix order
+    auto hsH = event.getValidHandle(_hsToken);
+    for (size_t iseed=0; iseed<sfits.size(); ++iseed) {
+      if(!sfits[iseed].save) continue;
+      // push this seed into the collection
+      kscol->push_back(sfits[iseed].kseed);
+      // fill assns with the helix seed
+      auto hptr = art::Ptr<HelixSeed>(hsH,iseed);
+      auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kscol->size()-1,KalSeedCollectionGetter);
+      ksha->addSingle(kseedptr,hptr);
+    }
+    // put the tracks into the event
+    event.put(move(kscol));
+    event.put(move(ksha));
+  }
 
-      if (hseed.caloCluster()) _result.caloCluster = hseed.caloCluster().get();
-      _result.helixSeed = &hseed;
+  void KalSeedFit::fitSeed(HelixSeed const& hseed, SeedFit& sfit, KalFit& kfit,
+      StrawResponse::cptr_t srep, Mu2eDetector::cptr_t detmodel) const {
+    KalFitData& result = sfit.result;
 //-----------------------------------------------------------------------------
 // 2018-12-08 PM : allow list of helices to contain helices of different
 // helicities and corresponding to particles of opposite signs. Assume that the
 // PDG particle coding scheme is used such that the particle and antiparticle
 // PDG codes have opposite signs
 //-----------------------------------------------------------------------------
-      TrkParticle tpart(_tpart);
-      if(_helicity != hseed.helix().helicity()) {
-	if(_checkhelicity) throw cet::exception("RECO")<<"mu2e::KalSeedFit: helicity doesn't match configuration" << endl;
-	TrkParticle::type t = (TrkParticle::type) (-(int) _tpart.particleType());
-	tpart = TrkParticle(t);
+    TrkParticle tpart(_tpart);
+    if(_helicity != hseed.helix().helicity()) {
+      if(_checkhelicity) throw cet::exception("RECO")<<"mu2e::KalSeedFit: helicity doesn't match configuration" << endl;
+      TrkParticle::type t = (TrkParticle::type) (-(int) _tpart.particleType());
+      tpart = TrkParticle(t);
+    }
+
+    double amsign   = copysign(1.0,-tpart.charge()*_bz000);
+
+    HepVector hpvec(HelixTraj::NHLXPRM);
+    // verify the fit meets requirements and can be translated
+    // to a fit trajectory.  This accounts for the physical particle direction
+    // helicity.  This could be wrong due to FP effects, so don't treat it as an exception
+    if(hseed.status().hasAllProperties(_seedflag) &&
+       //	 _helicity == hseed.helix().helicity() &&
+       TrkUtilities::RobustHelix2Traj(hseed._helix,hpvec,amsign)){
+      HelixTraj hstraj(hpvec,_hcovar);
+      // update the covariance matrix
+      if(_debug > 1)
+	//	  hstraj.printAll(cout);
+	cout << "Seed Fit HelixTraj parameters " << hstraj.parameters()->parameter()
+	     << "and covariance " << hstraj.parameters()->covariance() <<  endl;
+      // build a time cluster from the hits unwound in produce
+      TimeCluster tclust;
+      tclust._t0 = hseed._t0;
+      tclust._strawHitIdxs = std::move(sfit.strawHitIdxs);
+      // create a TrkDef; it should be possible to build a fit from the helix seed directly FIXME!
+      //	TrkDef seeddef(tclust,hstraj,_tpart,_fdir);
+      TrkDef seeddef(tclust,hstraj,tpart,_fdir);
+      // filter outliers; this doesn't use drift information, just straw positions
+      if(_foutliers)filterOutliers(seeddef);
+      const HelixTraj* htraj = &seeddef.helix();
+      double           flt0  = htraj->zFlight(0.0);
+      double           mom   = TrkMomCalculator::vecMom(*htraj, kfit.bField(), flt0).mag();
+      double           vflt  = seeddef.particle().beta(mom)*CLHEP::c_light;
+      double           helt0 = hseed.t0().t0();
+
+      KalSeed kf(PDGCode::type(tpart.particleType()),_fdir, hseed.status(), flt0 );
+      // extract the hits from the rep and put the hitseeds into the KalSeed
+      int nsh = seeddef.strawHitIndices().size();//tclust._strawHitIdxs.size();
+      for (int i=0; i< nsh; ++i){
+	size_t          istraw   = seeddef.strawHitIndices().at(i);
+	const ComboHit& strawhit(_chcol->at(istraw));
+	const Straw&    straw    = _tracker->getStraw(strawhit.strawId());
+	double          fltlen   = htraj->zFlight(straw.getMidPoint().z());
+	double          propTime = (fltlen-flt0)/vflt;
+
+	//fill the TrkStrwaHitSeed info
+	TrkStrawHitSeed tshs;
+	tshs._index  = istraw;
+	tshs._t0     = TrkT0(helt0 + propTime, hseed.t0().t0Err());
+	tshs._trklen = fltlen;
+	kf._hits.push_back(tshs);
       }
 
-      double amsign   = copysign(1.0,-tpart.charge()*_bz000);
-
-      HepVector hpvec(HelixTraj::NHLXPRM);
-      // verify the fit meets requirements and can be translated
-      // to a fit trajectory.  This accounts for the physical particle direction
-      // helicity.  This could be wrong due to FP effects, so don't treat it as an exception
-      if(hseed.status().hasAllProperties(_seedflag) &&
-	 //	 _helicity == hseed.helix().helicity() &&
-	 TrkUtilities::RobustHelix2Traj(hseed._helix,hpvec,amsign)){
-	HelixTraj hstraj(hpvec,_hcovar);
-	// update the covariance matrix
-	if(_debug > 1)
-	  //	  hstraj.printAll(cout);
-	  cout << "Seed Fit HelixTraj parameters " << hstraj.parameters()->parameter()
-	       << "and covariance " << hstraj.parameters()->covariance() <<  endl;
-	// build a time cluster: exclude the outlier hits
-	TimeCluster tclust;
-	tclust._t0 = hseed._t0;
-	for(uint16_t ihit=0;ihit < hseed.hits().size(); ++ihit){
-	  ComboHit const& ch = hseed.hits()[ihit];
-	  if((!_fhoutliers) || (!ch.flag().hasAnyProperty(StrawHitFlag::outlier)))
-	    hseed.hits().fillStrawHitIndices(event,ihit,tclust._strawHitIdxs);
-	}
-	// create a TrkDef; it should be possible to build a fit from the helix seed directly FIXME!
-	//	TrkDef seeddef(tclust,hstraj,_tpart,_fdir);
-	TrkDef seeddef(tclust,hstraj,tpart,_fdir);
-	// filter outliers; this doesn't use drift information, just straw positions
-	if(_foutliers)filterOutliers(seeddef);
-	const HelixTraj* htraj = &seeddef.helix();
-	double           flt0  = htraj->zFlight(0.0);
-	double           mom   = TrkMomCalculator::vecMom(*htraj, _kfit.bField(), flt0).mag();
-	double           vflt  = seeddef.particle().beta(mom)*CLHEP::c_light;
-	double           helt0 = hseed.t0().t0();
-
-	KalSeed kf(PDGCode::type(tpart.particleType()),_fdir, hseed.status(), flt0 );
-	// extract the hits from the rep and put the hitseeds into the KalSeed
-	int nsh = seeddef.strawHitIndices().size();//tclust._strawHitIdxs.size();
-	for (int i=0; i< nsh; ++i){
-	  size_t          istraw   = seeddef.strawHitIndices().at(i);
-          const ComboHit& strawhit(_chcol->at(istraw));
-	  const Straw&    straw    = _tracker->getStraw(strawhit.strawId());
-	  double          fltlen   = htraj->zFlight(straw.getMidPoint().z());
-	  double          propTime = (fltlen-flt0)/vflt;
-
-	  //fill the TrkStrwaHitSeed info
-	  TrkStrawHitSeed tshs;
-	  tshs._index  = istraw;
-	  tshs._t0     = TrkT0(helt0 + propTime, hseed.t0().t0Err());
-	  tshs._trklen = fltlen;
-	  kf._hits.push_back(tshs);
+      if(kf._hits.size() >= _minnhits) kf._status.merge(TrkFitFlag::hitsOK);
+      // extract the helix trajectory from the fit (there is just 1)
+      // use this to create segment.  This will be the only segment in this track
+      if(htraj != 0){
+	KalSegment kseg;
+	// sample the momentum at this point
+	TrkUtilities::fillSegment(*htraj,0.0,0.0,hseed.t0(),_tpart.mass(),(int)_tpart.charge(),kfit.bField(),kseg);
+	kf._segments.push_back(kseg);
+      } else {
+	throw cet::exception("RECO")<<"mu2e::KalSeedFit: Can't extract helix traj from seed fit" << endl;
+      }
+
+      // now, fit the seed helix from the filtered hits
+
+      //fill the KalFitData variable
+      result.kalSeed = &kf;
+
+      kfit.makeTrack(srep,detmodel,result);
+
+      if(_debug > 1){
+	if(result.krep == 0)
+	  cout << "No Seed fit produced " << endl;
+	else
+	  cout << "Seed Fit result " << result.krep->fitStatus()  << endl;
+      }
+      if(result.krep != 0 && (result.krep->fitStatus().success() || _saveall)){
+	if (_rescueHits) {
+	  int nrescued = 0;
+	  findMissingHits(result);
+	  nrescued = result.missingHits.size();
+	  if (nrescued > 0) {
+	    kfit.addHits(srep,detmodel,result, _maxAddChi);
+	  }
 	}
 
-	if(kf._hits.size() >= _minnhits) kf._status.merge(TrkFitFlag::hitsOK);
+	//	  KalRep *krep = result.stealTrack();
+
+	// convert the status into a FitFlag
+	// create a KalSeed object from this fit, recording the particle and fit direction
+	//	  KalSeed kseed(_tpart,_fdir,result.krep->t0(),result.krep->flt0(),seedok);
+
+	KalSeed kseed(PDGCode::type(result.krep->particleType().particleType()),_fdir,kf.status(), result.krep->flt0());
+	kseed._status.merge(_ksf);
+	if(result.krep->fitStatus().success())kseed._status.merge(TrkFitFlag::kalmanOK);
+	// add CaloCluster if present
+	kseed._chit._cluster = hseed.caloCluster();
+	// extract the hits from the rep and put the hitseeds into the KalSeed
+	TrkUtilities::fillStrawHitSeeds(result.krep,*_chcol,kseed._hits);
+	if(result.krep->fitStatus().success())kseed._status.merge(TrkFitFlag::seedOK);
+	if(result.krep->fitStatus().success()==1)kseed._status.merge(TrkFitFlag::seedConverged);
+	if(kseed._hits.size() >= _minnhits)kseed._status.merge(TrkFitFlag::hitsOK);
+	kseed._chisq = result.krep->chisq();
+	// use the default consistency calculation, as t0 is not fit here
+	kseed._fitcon = result.krep->chisqConsistency().significanceLevel();
 	// extract the helix trajectory from the fit (there is just 1)
+	double locflt;
+	const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(result.krep->localTrajectory(result.krep->flt0(),locflt));
 	// use this to create segment.  This will be the only segment in this track
 	if(htraj != 0){
 	  KalSegment kseg;
 	  // sample the momentum at this point
-	  TrkUtilities::fillSegment(*htraj,0.0,0.0,hseed.t0(),_tpart.mass(),(int)_tpart.charge(),_kfit.bField(),kseg);
-	  kf._segments.push_back(kseg);
-	} else {
-	  throw cet::exception("RECO")<<"mu2e::KalSeedFit: Can't extract helix traj from seed fit" << endl;
-	}
-
-	// now, fit the seed helix from the filtered hits
-
-	//fill the KalFitData variable
-	_result.kalSeed = &kf;
-
-	_kfit.makeTrack(srep,detmodel,_result);
-
-	if(_debug > 1){
-	  if(_result.krep == 0)
-	    cout << "No Seed fit produced " << endl;
-	  else
-	    cout << "Seed Fit result " << _result.krep->fitStatus()  << endl;
-	}
-	if(_result.krep != 0 && (_result.krep->fitStatus().success() || _saveall)){
-	  if (_rescueHits) {
-	    int nrescued = 0;
-	    findMissingHits(_result);
-	    nrescued = _result.missingHits.size();
-	    if (nrescued > 0) {
-	      _kfit.addHits(srep,detmodel,_result, _maxAddChi);
-	    }
-	  }
-
-	  //	  KalRep *krep = _result.stealTrack();
-
-	  // convert the status into a FitFlag
-	  // create a KalSeed object from this fit, recording the particle and fit direction
-	  //	  KalSeed kseed(_tpart,_fdir,_result.krep->t0(),_result.krep->flt0(),seedok);
-
-	  KalSeed kseed(PDGCode::type(_result.krep->particleType().particleType()),_fdir,kf.status(), _result.krep->flt0());
-	  kseed._status.merge(_ksf);
-	  if(_result.krep->fitStatus().success())kseed._status.merge(TrkFitFlag::kalmanOK);
-	  // add CaloCluster if present
-	  kseed._chit._cluster = hseed.caloCluster();
-	  // extract the hits from the rep and put the hitseeds into the KalSeed
-	  TrkUtilities::fillStrawHitSeeds(_result.krep,*_chcol,kseed._hits);
-	  if(_result.krep->fitStatus().success())kseed._status.merge(TrkFitFlag::seedOK);
-	  if(_result.krep->fitStatus().success()==1)kseed._status.merge(TrkFitFlag::seedConverged);
-	  if(kseed._hits.size() >= _minnhits)kseed._status.merge(TrkFitFlag::hitsOK);
-	  kseed._chisq = _result.krep->chisq();
-	  // use the default consistency calculation, as t0 is not fit here
-	  kseed._fitcon = _result.krep->chisqConsistency().significanceLevel();
-	  // extract the helix trajectory from the fit (there is just 1)
-	  double locflt;
-	  const HelixTraj* htraj = dynamic_cast<const HelixTraj*>(_result.krep->localTrajectory(_result.krep->flt0(),locflt));
-	  // use this to create segment.  This will be the only segment in this track
-	  if(htraj != 0){
-	    KalSegment kseg;
-	    // sample the momentum at this point
-	    BbrVectorErr momerr = _result.krep->momentumErr(_result.krep->flt0());
-	    TrkUtilities::fillSegment(*htraj,locflt,_result.krep->flt0(),_result.krep->t0(),_tpart.mass(),(int)_tpart.charge(),_kfit.bField(),kseg);
-	    // extend the segment
-	    double upflt(0.0), downflt(0.0);
-	    TrkHelixUtils::findZFltlen(*htraj,_upz,upflt);
-	    TrkHelixUtils::findZFltlen(*htraj,_downz,downflt);
-	    double tup = kseg.fltToTime(upflt); 
-	    double tdown = kseg.fltToTime(downflt); 
-	    if(_fdir == TrkFitDirection::downstream){
-	      kseg._tmin = tup;
-	      kseg._tmax = tdown;
-	    } else {
-	      kseg._tmax = tup;
-	      kseg._tmin = tdown;
-	    }
-	    kseed._segments.push_back(kseg);
-	    // push this seed into the collection
-	    kscol->push_back(kseed);
-	    // fill assns with the helix seed
-	    auto hsH = event.getValidHandle(_hsToken);
-	    auto hptr = art::Ptr<HelixSeed>(hsH,iseed);
-	    auto kseedptr = art::Ptr<KalSeed>(KalSeedCollectionPID,kscol->size()-1,KalSeedCollectionGetter);
-	    ksha->addSingle(kseedptr,hptr);
-	    if(_debug > 1){
-	      cout << "Seed fit segment parameters " << endl;
-	      for(size_t ipar=0;ipar<5;++ipar) cout << kseg.helix()._pars[ipar] << " ";
-	      cout << " covariance " << endl;
-	      for(size_t ipar=0;ipar<15;++ipar)
-		cout << kseg.covar()._cov[ipar] << " ";
-	      cout << endl;
-	    }
+	  BbrVectorErr momerr = result.krep->momentumErr(result.krep->flt0());
+	  TrkUtilities::fillSegment(*htraj,locflt,result.krep->flt0(),result.krep->t0(),_tpart.mass(),(int)_tpart.charge(),kfit.bField(),kseg);
+	  // extend the segment
+	  double upflt(0.0), downflt(0.0);
+	  TrkHelixUtils::findZFltlen(*htraj,_upz,upflt);
+	  TrkHelixUtils::findZFltlen(*htraj,_downz,downflt);
+	  double tup = kseg.fltToTime(upflt); 
+	  double tdown = kseg.fltToTime(downflt); 
+	  if(_fdir == TrkFitDirection::downstream){
+	    kseg._tmin = tup;
+	    kseg._tmax = tdown;
 	  } else {
-	    throw cet::exception("RECO")<<"mu2e::KalSeedFit: Can't extract helix traj from seed fit" << endl;
+	    kseg._tmax = tup;
+	    kseg._tmin = tdown;
+	  }
+	  kseed._segments.push_back(kseg);
+	  // keep this seed; produce puts it into the collection
+	  sfit.kseed = kseed;
+	  sfit.save = true;
+	  if(_debug > 1){
+	    cout << "Seed fit segment parameters " << endl;
+	    for(size_t ipar=0;ipar<5;++ipar) cout << kseg.helix()._pars[ipar] << " ";
+	    cout << " covariance " << endl;
+	    for(size_t ipar=0;ipar<15;++ipar)
+	      cout << kseg.covar()._cov[ipar] << " ";
+	    cout << endl;
 	  }
+	} else {
+	  throw cet::exception("RECO")<<"mu2e::KalSeedFit: Can't extract helix traj from seed fit" << endl;
 	}
-	// cleanup the seed fit KalRep.  Optimally the krep should be a data member of this module
-	// and get reused to avoid thrashing memory, but the BTrk code doesn't support that, FIXME!
-        _result.deleteTrack();
       }
+      // cleanup the seed fit KalRep.  Optimally the krep should be a data member of this module
+      // and get reused to avoid thrashing memory, but the BTrk code doesn't support that, FIXME!
+      result.deleteTrack();
+      result.kalSeed = 0;
     }
-    // put the tracks into the event
-    event.put(move(kscol));
-    event.put(move(ksha));
   }
 
 
@@ -434,7 +504,7 @@ namespace mu2e
     return _chcol != 0 && _hscol != 0;
   }
 
-  void KalSeedFit::filterOutliers(TrkDef& mydef){
+  void KalSeedFit::filterOutliers(TrkDef& mydef) const {
     // for now filter on DOCA.  In future this shoudl be an MVA using time and position FIXME!
     //  Trajectory info
     Hep3Vector tdir;
@@ -476,7 +546,7 @@ namespace mu2e
   // look at all hits included into the corresponding time cluster
   // first reactivate already associated hits
   //-----------------------------------------------------------------------------
-  void KalSeedFit::findMissingHits(KalFitData&kalData){
+  void KalSeedFit::findMissingHits(KalFitData&kalData) const {
 
     const char* oname = "KalSeedFit::findMissingHits";
 
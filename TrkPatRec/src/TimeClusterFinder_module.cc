@@ -446,40 +446,56 @@ namespace mu2e {
   }
 
   void TimeClusterFinder::recoverHits(TimeCluster& tc){
+    // candidates are scored in blocks.  Without a calo cluster, adding a hit moves the cluster time,
+    // so the rest of the block is dropped and the candidates after the added hit are collected again
+    constexpr size_t nblock(64);
+    const size_t nvars = _pmva._pars.size();
+    const MVATools& mva = tc.hasCaloCluster() ? _tcCaloMVA : _tcMVA;
+    std::vector<size_t> cands;
+    std::vector<float> mvavars, mvaout;
     bool changed(true);
     while (changed) {
       changed = false;
       float pphi = polyAtan2(tc._pos.y(), tc._pos.x());
-      for(size_t ich=0;ich < _chcol->size(); ++ich){
-	if ((!_testflag) || goodHit((*_shfcol)[ich])) {
-	  if(std::find(tc._strawHitIdxs.begin(),tc._strawHitIdxs.end(),ich) == tc._strawHitIdxs.end()){
-	    ComboHit const& ch = (*_chcol)[ich];
-	    float cht = _ttcalc.comboHitTime(ch,_pitch);
-	    _pmva._dt = fabs(cht - tc._t0._t0);
-	    if(_pmva._dt < _maxdt+tc._t0._t0err){
-	      float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
-	      float dphi = fabs(Angles::deltaPhi(phi,pphi));
-	      if(dphi < _maxdPhi){ 
-		_pmva._dphi = dphi;
-		_pmva._rho = ch.pos().Perp2();
-		_pmva._nsh = ch.nStrawHits();
-		_pmva._plane = ch.strawId().plane();
-		_pmva._werr = ch.wireRes();
-		_pmva._wdist = fabs(ch.wireDist());
-
-		float mvaout(-1.0);
-		if (tc.hasCaloCluster())
-		  mvaout = _tcCaloMVA.evalMVA(_pmva._pars);
-		else
-		  mvaout = _tcMVA.evalMVA(_pmva._pars);
-		if (mvaout > _minaddmva) {
-		  addHit(tc,ich);
-		  changed = true;
+      size_t ich(0);
+      while (ich < _chcol->size()) {
+	cands.clear();
+	mvavars.clear();
+	for(;ich < _chcol->size() && cands.size() < nblock; ++ich){
+	  if ((!_testflag) || goodHit((*_shfcol)[ich])) {
+	    if(std::find(tc._strawHitIdxs.begin(),tc._strawHitIdxs.end(),ich) == tc._strawHitIdxs.end()){
+	      ComboHit const& ch = (*_chcol)[ich];
+	      float cht = _ttcalc.comboHitTime(ch,_pitch);
+	      _pmva._dt = fabs(cht - tc._t0._t0);
+	      if(_pmva._dt < _maxdt+tc._t0._t0err){
+		float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
+		float dphi = fabs(Angles::deltaPhi(phi,pphi));
+		if(dphi < _maxdPhi){ 
+		  _pmva._dphi = dphi;
+		  _pmva._rho = ch.pos().Perp2();
+		  _pmva._nsh = ch.nStrawHits();
+		  _pmva._plane = ch.strawId().plane();
+		  _pmva._werr = ch.wireRes();
+		  _pmva._wdist = fabs(ch.wireDist());
+		  cands.push_back(ich);
+		  mvavars.insert(mvavars.end(),_pmva._pars.begin(),_pmva._pars.end());
 		}
 	      }
 	    }
 	  }
 	}
+
+	mva.evalMVA(mvavars,nvars,mvaout);
+	for(size_t ic=0;ic < cands.size(); ++ic){
+	  if (mvaout[ic] > _minaddmva) {
+	    addHit(tc,cands[ic]);
+	    changed = true;
+	    if (!tc.hasCaloCluster()) {
+	      ich = cands[ic]+1;
+	      break;
+	    }
+	  }
+	}
       }
     }
   }
@@ -550,12 +566,17 @@ namespace mu2e {
 
   void TimeClusterFinder::refineCluster(TimeCluster& tc) {
     // mva filtering; remove worst hit iteratively
+    const size_t nvars = _pmva._pars.size();
+    const MVATools& mva = tc.hasCaloCluster() ? _tcCaloMVA : _tcMVA;
+    std::vector<float> mvavars, mvaout;
     bool changed = true;
     while (changed) {
       changed = false;
       auto iworst = tc._strawHitIdxs.end();
       float worstmva(100.0);
       float pphi = polyAtan2(tc._pos.y(), tc._pos.x());
+      // score all the hits of the cluster in one call
+      mvavars.clear();
       for (auto ips=tc._strawHitIdxs.begin();ips != tc._strawHitIdxs.end();++ips) {
         ComboHit const& ch = (*_chcol)[*ips];
         float cht = _ttcalc.comboHitTime(ch,_pitch);
@@ -569,15 +590,13 @@ namespace mu2e {
 	_pmva._plane = ch.strawId().plane();
 	_pmva._werr = ch.wireRes();
 	_pmva._wdist = fabs(ch.wireDist());
-
-	float mvaout(-1.0);
-	if (tc.hasCaloCluster())
-	   mvaout = _tcCaloMVA.evalMVA(_pmva._pars);
-	else
-	  mvaout = _tcMVA.evalMVA(_pmva._pars);
-	if (mvaout < worstmva) {
-	  worstmva = mvaout;
-	  iworst = ips;
+	mvavars.insert(mvavars.end(),_pmva._pars.begin(),_pmva._pars.end());
+      }
+      mva.evalMVA(mvavars,nvars,mvaout);
+      for (size_t ih=0;ih < mvaout.size();++ih) {
+	if (mvaout[ih] < worstmva) {
+	  worstmva = mvaout[ih];
+	  iworst = tc._strawHitIdxs.begin()+ih;
         }
       }
 